@@ -64,6 +64,7 @@
 #include "i_sound.h"
 #include "i_video.h"
 #include "g_game.h"
+#include "g_benchmark.h"
 #include "hu_stuff.h"
 #include "wi_stuff.h"
 #include "st_stuff.h"
@@ -104,6 +105,8 @@
 #include <hwrenderer\utility\hw_vrmodes.h>
 #include "s_music.h"
 #include "swrenderer/r_swcolormaps.h"
+#include "texturecache.h"
+#include "r_data/models/models.h"
 
 EXTERN_CVAR(Bool, hud_althud)
 EXTERN_CVAR(Int, vr_mode)
@@ -2788,6 +2791,7 @@ static int D_DoomMain_Internal (void)
 		if (!restart)
 		{
 			// start the apropriate game based on parms
+			G_InitChecksums();
 			v = Args->CheckValue ("-record");
 
 			if (v)
@@ -2909,6 +2913,7 @@ int D_DoomMain()
 	// Unless something really bad happened, the game should only exit through this single point in the code.
 	// No more 'exit', please.
 	// Todo: Move all engine cleanup here instead of using exit handlers and replace the scattered 'exit' calls with a special exception.
+	G_FinishPendingSave();
 	D_Cleanup();
 	CloseNetwork();
 	GC::FinalGC = true;
@@ -2960,6 +2965,8 @@ void D_Cleanup()
 	
 	// delete all data that cannot be left until reinitialization
 	if (screen) screen->CleanForRestart();
+	FTextureDiskCache::Flush();
+	FlushModelDiskCache();
 	V_ClearFonts();					// must clear global font pointers
 	ColorSets.Clear();
 	PainFlashes.Clear();
@@ -0,0 +1,392 @@
+/*
+** g_benchmark.cpp
+** Machine readable timedemo reports
+**
+**---------------------------------------------------------------------------
+** Copyright 2019 GZDoom maintainers and contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** -timedemo <demo> -benchmark <report.json> writes the per-tic timings
+** collected from the existing cycle counters instead of only printing the
+** total fps. -nodraw and -benchsw select the null video backend, so nothing
+** gets presented and the playsim can be measured on machines without a
+** display or a usable GPU. -benchsw additionally runs the software renderer
+** into an offscreen canvas once per tic so that its passes can be measured
+** the same way.
+**
+** -checksums <report.txt> writes one checksum of the playsim state per tic
+** when a demo ends or its recording is stopped, so two runs of the same
+** demo can be compared tic by tic.
+**
+*/
+
+#define RAPIDJSON_HAS_CXX11_RVALUE_REFS 1
+#define RAPIDJSON_HAS_CXX11_RANGE_FOR 1
+
+#include "rapidjson/rapidjson.h"
+#include "rapidjson/prettywriter.h"
+#include "rapidjson/stringbuffer.h"
+#include <memory>
+#include "g_benchmark.h"
+#include "templates.h"
+#include "doomstat.h"
+#include "d_player.h"
+#include "m_argv.h"
+#include "files.h"
+#include "v_video.h"
+#include "r_utility.h"
+#include "swrenderer/r_renderer.h"
+#include "swrenderer/scene/r_scene.h"
+#include "g_levellocals.h"
+#include "actor.h"
+#include "m_random.h"
+#include "m_crc32.h"
+
+extern cycle_t VMCycles[10];
+extern FString defdemoname;
+
+bool benchmarking;
+bool checksumming;
+
+struct FBenchmarkTic
+{
+	float Playsim;
+	float Think;
+	float VM;
+	float Frame;
+	float Walls;
+	float Planes;
+	float Masked;
+	float Drawers;
+};
+
+struct FBenchmarkStat
+{
+	double Total = 0;
+	double Peak = 0;
+};
+
+static TArray<FBenchmarkTic> BenchTics;
+static FBenchmarkStat BenchStatnums[MAX_STATNUM + 1];
+static cycle_t PlaysimCycles;
+static double VMStartTime;
+static FString BenchReport;
+static DCanvas *BenchCanvas;
+
+//==========================================================================
+//
+// G_BeginBenchmark
+//
+// Called by G_TimeDemo. Does nothing unless -benchmark was given.
+//
+//==========================================================================
+
+void G_BeginBenchmark()
+{
+	const char *report = Args->CheckValue("-benchmark");
+	benchmarking = report != nullptr;
+	ThinkerStatTiming = benchmarking;
+	if (!benchmarking) return;
+
+	BenchReport = report;
+	BenchTics.Clear();
+	for (auto &stat : BenchStatnums) stat = {};
+	for (auto &cycles : ThinkerStatCycles) cycles.Reset();
+
+	delete BenchCanvas;
+	BenchCanvas = nullptr;
+	if (Args->CheckParm("-benchsw"))
+	{
+		int width = 640, height = 400;
+		const char *res = Args->CheckValue("-benchres");
+		if (res != nullptr && sscanf(res, "%dx%d", &width, &height) != 2)
+		{
+			width = 640;
+			height = 400;
+		}
+		BenchCanvas = new DCanvas(clamp(width, 320, 8192), clamp(height, 200, 8192), false);
+	}
+}
+
+//==========================================================================
+//
+// G_BenchmarkStartTic / G_BenchmarkEndTic
+//
+// Bracket the playsim part of G_Ticker.
+//
+//==========================================================================
+
+void G_BenchmarkStartTic()
+{
+	PlaysimCycles.Reset();
+	PlaysimCycles.Clock();
+	// VMCycles belongs to the VM stat, which resets it itself, so only take the difference.
+	VMStartTime = VMCycles[0].TimeMS();
+}
+
+void G_BenchmarkEndTic()
+{
+	PlaysimCycles.Unclock();
+
+	FBenchmarkTic tic = {};
+	tic.Playsim = (float)PlaysimCycles.TimeMS();
+	tic.Think = (float)ThinkCycles.TimeMS();
+	tic.VM = (float)(VMCycles[0].TimeMS() - VMStartTime);
+
+	for (int i = 0; i <= MAX_STATNUM; i++)
+	{
+		double time = ThinkerStatCycles[i].TimeMS();
+		BenchStatnums[i].Total += time;
+		BenchStatnums[i].Peak = MAX(BenchStatnums[i].Peak, time);
+		ThinkerStatCycles[i].Reset();
+	}
+
+	auto player = &players[consoleplayer];
+	if (BenchCanvas != nullptr && SWRenderer != nullptr && player->mo != nullptr)
+	{
+		if (player->camera == nullptr)
+		{
+			player->camera = player->mo;
+		}
+		cycle_t frame;
+		frame.Reset();
+		frame.Clock();
+		SWRenderer->RenderOffscreen(player, BenchCanvas);
+		frame.Unclock();
+		tic.Frame = (float)frame.TimeMS();
+		tic.Walls = (float)swrenderer::WallCycles.TimeMS();
+		tic.Planes = (float)swrenderer::PlaneCycles.TimeMS();
+		tic.Masked = (float)swrenderer::MaskedCycles.TimeMS();
+		tic.Drawers = (float)swrenderer::DrawerWaitCycles.TimeMS();
+	}
+	BenchTics.Push(tic);
+}
+
+//==========================================================================
+//
+// G_EndBenchmark
+//
+// Writes the report. The per-tic array is the raw data, the summary
+// section is what a CI job is expected to compare against a baseline.
+//
+//==========================================================================
+
+template<class W>
+static void WriteSummary(W &w, const char *key, float FBenchmarkTic::*field)
+{
+	double total = 0, peak = 0;
+	for (auto &tic : BenchTics)
+	{
+		total += tic.*field;
+		peak = MAX<double>(peak, tic.*field);
+	}
+	w.Key(key);
+	w.StartObject();
+	w.Key("total_ms"); w.Double(total);
+	w.Key("mean_ms"); w.Double(BenchTics.Size() ? total / BenchTics.Size() : 0.);
+	w.Key("peak_ms"); w.Double(peak);
+	w.EndObject();
+}
+
+void G_EndBenchmark(int gametics, int realtics)
+{
+	if (!benchmarking) return;
+	benchmarking = false;
+	ThinkerStatTiming = false;
+
+	rapidjson::StringBuffer buffer;
+	rapidjson::PrettyWriter<rapidjson::StringBuffer> w(buffer);
+	w.SetFormatOptions(rapidjson::kFormatSingleLineArray);
+
+	w.StartObject();
+	w.Key("demo"); w.String(defdemoname.GetChars());
+	w.Key("renderer"); w.String(BenchCanvas != nullptr ? "software" : nodrawers ? "none" : "screen");
+	if (BenchCanvas != nullptr)
+	{
+		w.Key("width"); w.Int(BenchCanvas->GetWidth());
+		w.Key("height"); w.Int(BenchCanvas->GetHeight());
+	}
+	w.Key("gametics"); w.Int(gametics);
+	w.Key("realtics"); w.Int(realtics);
+	w.Key("fps"); w.Double(realtics > 0 ? (double)gametics / realtics * TICRATE : 0.);
+
+	w.Key("summary");
+	w.StartObject();
+	WriteSummary(w, "playsim", &FBenchmarkTic::Playsim);
+	WriteSummary(w, "think", &FBenchmarkTic::Think);
+	WriteSummary(w, "vm", &FBenchmarkTic::VM);
+	if (BenchCanvas != nullptr)
+	{
+		WriteSummary(w, "frame", &FBenchmarkTic::Frame);
+		WriteSummary(w, "walls", &FBenchmarkTic::Walls);
+		WriteSummary(w, "planes", &FBenchmarkTic::Planes);
+		WriteSummary(w, "masked", &FBenchmarkTic::Masked);
+		WriteSummary(w, "drawers", &FBenchmarkTic::Drawers);
+	}
+	w.EndObject();
+
+	w.Key("statnums");
+	w.StartObject();
+	for (int i = 0; i <= MAX_STATNUM; i++)
+	{
+		if (BenchStatnums[i].Total <= 0) continue;
+		FString key;
+		key.Format("%d", i);
+		w.Key(key.GetChars());
+		w.StartObject();
+		w.Key("total_ms"); w.Double(BenchStatnums[i].Total);
+		w.Key("peak_ms"); w.Double(BenchStatnums[i].Peak);
+		w.EndObject();
+	}
+	w.EndObject();
+
+	w.Key("tic_fields");
+	w.StartArray();
+	for (auto name : { "playsim", "think", "vm", "frame", "walls", "planes", "masked", "drawers" })
+	{
+		w.String(name);
+		if (BenchCanvas == nullptr && !strcmp(name, "vm")) break;
+	}
+	w.EndArray();
+
+	w.Key("tics");
+	w.StartArray();
+	for (auto &tic : BenchTics)
+	{
+		w.StartArray();
+		w.Double(tic.Playsim);
+		w.Double(tic.Think);
+		w.Double(tic.VM);
+		if (BenchCanvas != nullptr)
+		{
+			w.Double(tic.Frame);
+			w.Double(tic.Walls);
+			w.Double(tic.Planes);
+			w.Double(tic.Masked);
+			w.Double(tic.Drawers);
+		}
+		w.EndArray();
+	}
+	w.EndArray();
+	w.EndObject();
+
+	std::unique_ptr<FileWriter> f(FileWriter::Open(BenchReport));
+	if (f == nullptr || f->Write(buffer.GetString(), buffer.GetSize()) != buffer.GetSize())
+	{
+		Printf("Could not write benchmark report %s\n", BenchReport.GetChars());
+	}
+	else
+	{
+		Printf("Benchmark report written to %s\n", BenchReport.GetChars());
+	}
+
+	BenchTics.Reset();
+	delete BenchCanvas;
+	BenchCanvas = nullptr;
+}
+
+//==========================================================================
+//
+// World checksums
+//
+// One CRC per tic over the RNG seeds, every actor's movement state and the
+// sector and side state that map thinkers change. The file is written when
+// a demo ends or when its recording is stopped, so the checksums of a
+// recording and its playback, or of two playbacks with different settings,
+// can be compared to find the first tic where they diverge.
+//
+//==========================================================================
+
+static FString ChecksumReport;
+static TArray<uint32_t> TicChecksums;
+
+void G_InitChecksums()
+{
+	const char *report = Args->CheckValue("-checksums");
+	checksumming = report != nullptr;
+	if (checksumming) ChecksumReport = report;
+}
+
+template<class T>
+static uint32_t AddChecksum(uint32_t crc, const T &value)
+{
+	return AddCRC32(crc, (const uint8_t *)&value, sizeof(value));
+}
+
+void G_ChecksumTic()
+{
+	auto Level = primaryLevel;
+	uint32_t crc = AddChecksum(0, Level->maptime);
+	crc = AddChecksum(crc, FRandom::StaticSumSeeds());
+
+	auto it = Level->GetThinkerIterator<AActor>();
+	AActor *mo;
+	while ((mo = it.Next()) != nullptr)
+	{
+		crc = AddChecksum(crc, mo->Pos());
+		crc = AddChecksum(crc, mo->Vel);
+		crc = AddChecksum(crc, mo->Angles.Yaw.Degrees);
+		crc = AddChecksum(crc, mo->health);
+		crc = AddChecksum(crc, mo->tics);
+		crc = AddChecksum(crc, mo->flags);
+	}
+	for (auto &sec : Level->sectors)
+	{
+		crc = AddChecksum(crc, sec.floorplane.fD());
+		crc = AddChecksum(crc, sec.ceilingplane.fD());
+		crc = AddChecksum(crc, sec.lightlevel);
+		crc = AddChecksum(crc, sec.GetXOffset(sector_t::floor));
+		crc = AddChecksum(crc, sec.GetXOffset(sector_t::ceiling));
+	}
+	for (auto &side : Level->sides)
+	{
+		crc = AddChecksum(crc, side.GetTextureXOffset(side_t::mid));
+	}
+	TicChecksums.Push(crc);
+}
+
+void G_WriteChecksums()
+{
+	if (!checksumming || TicChecksums.Size() == 0) return;
+
+	FString text;
+	for (auto crc : TicChecksums)
+	{
+		text.AppendFormat("%08x\n", crc);
+	}
+	TicChecksums.Clear();
+
+	std::unique_ptr<FileWriter> f(FileWriter::Open(ChecksumReport));
+	if (f == nullptr || f->Write(text.GetChars(), text.Len()) != text.Len())
+	{
+		Printf("Could not write checksums %s\n", ChecksumReport.GetChars());
+	}
+	else
+	{
+		Printf("Checksums written to %s\n", ChecksumReport.GetChars());
+	}
+}
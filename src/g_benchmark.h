@@ -0,0 +1,24 @@
+#ifndef __G_BENCHMARK_H__
+#define __G_BENCHMARK_H__
+
+#include "stats.h"
+#include "dthinker.h"
+
+// Timers fed by the playsim that are only read by the benchmark report.
+extern bool ThinkerStatTiming;
+extern cycle_t ThinkerStatCycles[MAX_STATNUM + 1];
+extern cycle_t ThinkCycles;
+
+extern bool benchmarking;
+extern bool checksumming;
+
+void G_BeginBenchmark();
+void G_BenchmarkStartTic();
+void G_BenchmarkEndTic();
+void G_EndBenchmark(int gametics, int realtics);
+
+void G_InitChecksums();
+void G_ChecksumTic();
+void G_WriteChecksums();
+
+#endif
@@ -27,6 +27,7 @@
 #include <stdio.h>
 #include <stddef.h>
 #include <memory>
+#include <functional>
 
 #include "i_time.h"
 #include "templates.h"
@@ -55,6 +56,7 @@
 #include "gstrings.h"
 #include "r_sky.h"
 #include "g_game.h"
+#include "g_benchmark.h"
 #include "sbar.h"
 #include "m_png.h"
 #include "a_keys.h"
@@ -78,6 +80,7 @@
 #include "g_hub.h"
 #include "g_levellocals.h"
 #include "events.h"
+#include "jobsystem.h"
 
 
 static FRandom pr_dmspawn ("DMSpawn");
@@ -99,18 +102,21 @@ void	G_DoAutoSave ();
 void	G_DoQuickSave ();
 
 void STAT_Serialize(FSerializer &file);
-bool WriteZip(const char *filename, TArray<FString> &filenames, TArray<FCompressedBuffer> &content);
+bool WriteZip(const char *filename, TArray<FString> &filenames, TArray<FCompressedBuffer> &content, bool sync = false);
 
 FIntCVar gameskill ("skill", 2, CVAR_SERVERINFO|CVAR_LATCH);
 CVAR(Bool, save_formatted, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// use formatted JSON for saves (more readable but a larger files and a bit slower.
+CVAR(Bool, save_binary, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// use the binary format for game state and snapshots. Much faster than JSON, which is still used if save_formatted is on.
 CVAR (Int, deathmatch, 0, CVAR_SERVERINFO|CVAR_LATCH);
 CVAR (Bool, chasedemo, false, 0);
 CVAR (Bool, storesavepic, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 CVAR (Bool, longsavemessages, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 CVAR (String, save_dir, "", CVAR_ARCHIVE|CVAR_GLOBALCONFIG);
 CVAR (Bool, cl_waitforsave, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
+CVAR (Bool, save_async, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);	// compress and write savegames on a worker thread
 CVAR (Bool, enablescriptscreenshot, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 EXTERN_CVAR (Float, con_midtime);
+EXTERN_CVAR (Bool, genreject)
 
 //==========================================================================
 //
@@ -1020,6 +1026,8 @@ void G_Ticker ()
 	int i;
 	gamestate_t	oldgamestate;
 
+	G_FinishPendingSave(false);
+
 	// do player reborns if needed
 	for (i = 0; i < MAXPLAYERS; i++)
 	{
@@ -1197,7 +1205,10 @@ void G_Ticker ()
 	switch (gamestate)
 	{
 	case GS_LEVEL:
+		if (benchmarking) G_BenchmarkStartTic();
 		P_Ticker ();
+		if (benchmarking) G_BenchmarkEndTic();
+		if (checksumming) G_ChecksumTic();
 		primaryLevel->automap->Ticker ();
 		break;
 
@@ -1807,6 +1818,8 @@ void G_DoLoadGame ()
 {
 	bool hidecon;
 
+	G_FinishPendingSave();
+
 	if (gameaction != ga_autoloadgame)
 	{
 		demoplayback = false;
@@ -2149,6 +2162,52 @@ static void PutSaveComment (FSerializer &arc)
 	arc.AddString("Comment", comment);
 }
 
+//==========================================================================
+//
+// A savepic that only captures the image when it gets written to, so
+// that the PNG can be encoded later by the save thread.
+//
+//==========================================================================
+
+class FSavePicWriter : public BufferWriter
+{
+public:
+	TArray<uint8_t> Pixels;
+	PalEntry Palette[256];
+	ESSType Format = SS_RGB;
+	int Width = 0, Height = 0;
+	float PicGamma = 1.f;
+	TArray<FString> Text;	// keyword/text pairs
+
+	void Capture(ESSType ssformat, const uint8_t *scr, int pitch, const PalEntry *pal, int width, int height, float gamma)
+	{
+		int pixelsize = ssformat == SS_RGB ? 3 : 1;
+		Format = ssformat;
+		Width = width;
+		Height = height;
+		PicGamma = gamma;
+		if (pal != nullptr) memcpy(Palette, pal, sizeof(Palette));
+		Pixels.Resize(width * height * pixelsize);
+		for (int y = 0; y < height; y++)
+		{
+			memcpy(&Pixels[y * width * pixelsize], scr + y * pitch, width * pixelsize);
+		}
+	}
+
+	void Encode()
+	{
+		if (Pixels.Size() > 0)
+		{
+			M_CreatePNG(this, Pixels.Data(), Format == SS_PAL ? Palette : nullptr, Format, Width, Height, Width * (Format == SS_RGB ? 3 : 1), PicGamma);
+		}
+		for (unsigned i = 0; i + 1 < Text.Size(); i += 2)
+		{
+			M_AppendPNGText(this, Text[i], Text[i + 1]);
+		}
+		M_FinishPNG(this);
+	}
+};
+
 void DoWriteSavePic(FileWriter *file, ESSType ssformat, uint8_t *scr, int width, int height, sector_t *viewsector, bool upsidedown)
 {
 	PalEntry palette[256];
@@ -2196,6 +2255,12 @@ void DoWriteSavePic(FileWriter *file, ESSType ssformat, uint8_t *scr, int width,
 		pitch *= -1;
 	}
 
+	auto deferred = dynamic_cast<FSavePicWriter*>(file);
+	if (deferred != nullptr)
+	{
+		deferred->Capture(ssformat, scr, pitch, ssformat == SS_PAL ? palette : nullptr, width, height, Gamma);
+		return;
+	}
 	M_CreatePNG(file, scr, ssformat == SS_PAL? palette : nullptr, ssformat, width, height, pitch, Gamma);
 }
 
@@ -2214,11 +2279,77 @@ static void PutSavePic (FileWriter *file, int width, int height)
 	}
 }
 
-void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, const char *description)
+//==========================================================================
+//
+// Savegames are written in two phases. Everything that needs the game
+// state is captured into memory inside the tic. Compressing all that,
+// encoding the savepic and writing the zip is done by FSaveJob, on a
+// worker thread if save_async is on. Only one save can be pending,
+// starting another one waits for it first.
+//
+//==========================================================================
+
+struct FSaveJob
+{
+	FString Filename;
+	FSavePicWriter SavePic;
+	TArray<FString> Filenames;
+	TArray<FCompressedBuffer> Content;	// all owned by the job. The savepic gets added by Run.
+	bool Succeeded = false;
+	std::function<void(bool)> OnComplete;	// always called on the main thread
+
+	FJobGroup Job;
+
+	~FSaveJob()
+	{
+		for (auto &c : Content) c.Clean();
+	}
+
+	void Run()
+	{
+		SavePic.Encode();
+		auto picdata = SavePic.GetBuffer();
+		FCompressedBuffer bufpng = { picdata->Size(), picdata->Size(), METHOD_STORED, 0, static_cast<unsigned int>(crc32(0, picdata->Data(), picdata->Size())), new char[picdata->Size()] };
+		memcpy(bufpng.mBuffer, picdata->Data(), picdata->Size());
+		Content.Insert(0, bufpng);
+		Filenames.Insert(0, "savepic.png");
+
+		for (auto &c : Content) c.Compress();
+
+		// Write to a temporary file first so that a failed save never destroys an existing one.
+		// It must be on the disk before the rename, or a crash could leave the save truncated.
+		FString tempname = Filename + ".tmp";
+		if (WriteZip(tempname, Filenames, Content, true))
+		{
+			Succeeded = RenameFile(tempname, Filename);
+		}
+	}
+};
+
+static FSaveJob *PendingSave;
+
+//==========================================================================
+//
+// G_FinishPendingSave
+//
+// Completes a save that was started earlier. Without wait, this only
+// does something if the save job is already done.
+//
+//==========================================================================
+
+void G_FinishPendingSave(bool wait)
 {
-	TArray<FCompressedBuffer> savegame_content;
-	TArray<FString> savegame_filenames;
+	if (PendingSave == nullptr || (!wait && !PendingSave->Job.IsDone())) return;
 
+	auto job = PendingSave;
+	PendingSave = nullptr;
+	job->Job.Wait();
+	if (job->OnComplete) job->OnComplete(job->Succeeded);
+	delete job;
+}
+
+void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, const char *description)
+{
 	char buf[100];
 
 	// Do not even try, if we're not in a level. (Can happen after
@@ -2233,13 +2364,16 @@ void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, c
 		filename = G_BuildSaveName ("demosave." SAVEGAME_EXT, -1);
 	}
 
+	// A previous save may still be writing, possibly to the same file.
+	G_FinishPendingSave();
+
 	if (cl_waitforsave)
 		I_FreezeTime(true);
 
 	insave = true;
 	try
 	{
-		level.SnapshotLevel();
+		level.SnapshotLevel(false);
 	}
 	catch(CRecoverableError &err)
 	{
@@ -2261,21 +2395,27 @@ void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, c
 		throw;
 	}
 
-	BufferWriter savepic;
+	// Owned here until it is handed over to PendingSave, so that nothing leaks if writing the data throws.
+	auto job = std::make_unique<FSaveJob>();
+	job->Filename = filename;
+
 	FSerializer savegameinfo(nullptr);		// this is for displayable info about the savegame
 	FSerializer savegameglobals(nullptr);	// and this for non-level related info that must be saved.
 
 	savegameinfo.OpenWriter(true);
-	savegameglobals.OpenWriter(save_formatted);
+	if (save_binary && !save_formatted) savegameglobals.OpenBinaryWriter();
+	else savegameglobals.OpenWriter(save_formatted);
 
 	SaveVersion = SAVEVER;
-	PutSavePic(&savepic, SAVEPICWIDTH, SAVEPICHEIGHT);
+	PutSavePic(&job->SavePic, SAVEPICWIDTH, SAVEPICHEIGHT);
 	mysnprintf(buf, countof(buf), GAMENAME " %s", GetVersionString());
 	// put some basic info into the PNG so that this isn't lost when the image gets extracted.
-	M_AppendPNGText(&savepic, "Software", buf);
-	M_AppendPNGText(&savepic, "Title", description);
-	M_AppendPNGText(&savepic, "Current Map", primaryLevel->MapName);
-	M_FinishPNG(&savepic);
+	job->SavePic.Text.Push("Software");
+	job->SavePic.Text.Push(buf);
+	job->SavePic.Text.Push("Title");
+	job->SavePic.Text.Push(description);
+	job->SavePic.Text.Push("Current Map");
+	job->SavePic.Text.Push(primaryLevel->MapName);
 
 	int ver = SAVEVER;
 	savegameinfo.AddString("Software", buf)
@@ -2311,58 +2451,74 @@ void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, c
 		savegameglobals("nextskill", NextSkill);
 	}
 
-	auto picdata = savepic.GetBuffer();
-	FCompressedBuffer bufpng = { picdata->Size(), picdata->Size(), METHOD_STORED, 0, static_cast<unsigned int>(crc32(0, &(*picdata)[0], picdata->Size())), (char*)&(*picdata)[0] };
+	job->Content.Push(savegameinfo.GetStoredOutput());
+	job->Filenames.Push("info.json");
+	job->Content.Push(savegameglobals.GetStoredOutput());
+	job->Filenames.Push("globals.json");
 
-	savegame_content.Push(bufpng);
-	savegame_filenames.Push("savepic.png");
-	savegame_content.Push(savegameinfo.GetCompressedOutput());
-	savegame_filenames.Push("info.json");
-	savegame_content.Push(savegameglobals.GetCompressedOutput());
-	savegame_filenames.Push("globals.json");
+	// The job needs its own copy of all snapshots because they can go away before it is done.
+	// The current level's one is only needed for the save so it can be handed over.
+	unsigned first = job->Content.Size();
+	G_WriteSnapshots (job->Filenames, job->Content);
+	for (unsigned i = first; i < job->Content.Size(); i++)
+	{
+		auto &snapshot = job->Content[i];
+		if (snapshot.mBuffer == level.info->Snapshot.mBuffer)
+		{
+			level.info->Snapshot.mBuffer = nullptr;
+		}
+		else
+		{
+			char *copy = new char[snapshot.mCompressedSize];
+			memcpy(copy, snapshot.mBuffer, snapshot.mCompressedSize);
+			snapshot.mBuffer = copy;
+		}
+	}
 
-	G_WriteSnapshots (savegame_filenames, savegame_content);
-	
+	// We don't need the snapshot any longer.
+	level.info->Snapshot.Clean();
+		
+	insave = false;
 
-	bool succeeded = false;
+	if (cl_waitforsave)
+		I_FreezeTime(false);
 
-	if (WriteZip(filename, savegame_filenames, savegame_content))
+	FString desc = description;
+	job->OnComplete = [=](bool succeeded)
 	{
-		// Check whether the file is ok by trying to open it.
-		FResourceFile *test = FResourceFile::OpenResourceFile(filename, true);
-		if (test != nullptr)
+		if (succeeded)
 		{
+			// Check whether the file is ok by trying to open it.
+			FResourceFile *test = FResourceFile::OpenResourceFile(filename, true);
+			succeeded = test != nullptr;
 			delete test;
-			succeeded = true;
 		}
-	}
 
-	if (succeeded)
-	{
-		savegameManager.NotifyNewSave(filename, description, okForQuicksave, forceQuicksave);
-		BackupSaveName = filename;
+		if (succeeded)
+		{
+			savegameManager.NotifyNewSave(filename, desc, okForQuicksave, forceQuicksave);
+			BackupSaveName = filename;
 
-		if (longsavemessages) Printf("%s (%s)\n", GStrings("GGSAVED"), filename.GetChars());
-		else Printf("%s\n", GStrings("GGSAVED"));
+			if (longsavemessages) Printf("%s (%s)\n", GStrings("GGSAVED"), filename.GetChars());
+			else Printf("%s\n", GStrings("GGSAVED"));
+		}
+		else
+		{
+			Printf(PRINT_HIGH, "%s\n", GStrings("TXT_SAVEFAILED"));
+		}
+	};
+
+	FSaveJob *pending = job.release();
+	PendingSave = pending;
+	if (save_async)
+	{
+		pending->Job.Run([=]() { pending->Run(); });
 	}
 	else
 	{
-		Printf(PRINT_HIGH, "%s\n", GStrings("TXT_SAVEFAILED"));
+		pending->Run();
+		G_FinishPendingSave();
 	}
-
-
-	// delete the JSON buffers we created just above. Everything else will
-	// either still be needed or taken care of automatically.
-	savegame_content[1].Clean();
-	savegame_content[2].Clean();
-
-	// We don't need the snapshot any longer.
-	level.info->Snapshot.Clean();
-		
-	insave = false;
-
-	if (cl_waitforsave)
-		I_FreezeTime(false);
 }
 
 
@@ -2679,6 +2835,8 @@ bool G_ProcessIFFDemo (FString &mapname)
 			break;
 
 		case VARS_ID:
+			// Older versions played maps without a REJECT lump without one.
+			if (demover < 0x222) genreject = false;
 			C_ReadCVars (&demo_p);
 			break;
 
@@ -2841,10 +2999,11 @@ void G_DoPlayDemo (void)
 //
 void G_TimeDemo (const char* name)
 {
-	nodrawers = !!Args->CheckParm ("-nodraw");
+	nodrawers = nodrawers || Args->CheckParm ("-nodraw");
 	noblit = !!Args->CheckParm ("-noblit");
 	timingdemo = true;
 	singletics = true;
+	G_BeginBenchmark();
 
 	defdemoname = name;
 	gameaction = (gameaction == ga_loadgame) ? ga_loadgameplaydemo : ga_playdemo;
@@ -2863,6 +3022,8 @@ void G_TimeDemo (const char* name)
 
 bool G_CheckDemoStatus (void)
 {
+	G_WriteChecksums();
+
 	if (!demorecording)
 	{ // [RH] Restore the player's userinfo settings.
 		D_SetupUserInfo();
@@ -2897,6 +3058,7 @@ bool G_CheckDemoStatus (void)
 		{
 			if (timingdemo)
 			{
+				G_EndBenchmark(gametic, endtime);
 				// Trying to get back to a stable state after timing a demo
 				// seems to cause problems. I don't feel like fixing that
 				// right now.
@@ -85,6 +85,9 @@ void G_SaveGame (const char *filename, const char *description);
 // Called by messagebox
 void G_DoQuickSave ();
 
+// Completes a savegame that is still being written in the background
+void G_FinishPendingSave (bool wait = true);
+
 // Only called by startup code.
 void G_RecordDemo (const char* name);
 
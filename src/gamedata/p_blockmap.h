@@ -6,22 +6,35 @@
 class AActor;
 
 // [RH] Like msecnode_t, but for the blockmap
+// Only records which blocks an actor is linked into. The actors of a block
+// are stored contiguously in FBlockmap::blocklinks.
 struct FBlockNode
 {
 	AActor *Me;						// actor this node references
 	int BlockIndex;					// index into blocklinks for the block this node is in
-	int Group;						// portal group this link belongs to (can be different than the actor's own group
-	FBlockNode **PrevActor;			// previous actor in this block
-	FBlockNode *NextActor;			// next actor in this block
-	FBlockNode **PrevBlock;			// previous block this actor is in
+	int Position;					// index of this node's entry inside the block
 	FBlockNode *NextBlock;			// next block this actor is in
 
-	static FBlockNode *Create (AActor *who, int x, int y, int group = -1);
+	static FBlockNode *Create (AActor *who, int x, int y);
 	void Release ();
 
 	static FBlockNode *FreeBlocks;
 };
 
+// Me is null for actors that were unlinked. These entries stay in place until
+// the block is compacted at the start of the next tic, so indices never shift
+// while something iterates over a block.
+struct FBlockEntry
+{
+	AActor *Me;
+	FBlockNode *Node;
+	bool SingleBlock;				// actor is not linked into any other block, so iterators can skip the duplicate check
+};
+
+// The most recently linked actor is at the end of the array. Iteration goes
+// from back to front, which is the order the old linked lists had.
+typedef TArray<FBlockEntry> FBlockLinks;
+
 // BLOCKMAP
 // Created from axis aligned bounding box
 // of the map, a rectangular array of
@@ -39,7 +52,8 @@ struct FBlockmap
 	int					bmapheight; 	// in mapblocks
 	double				bmaporgx;
 	double				bmaporgy;		// origin of block map
-	FBlockNode**		blocklinks; 	// for thing chains
+	FBlockLinks*		blocklinks; 	// for thing chains
+	TArray<int>			unlinkedblocks;	// blocks with unlinked entries, to be compacted
 
 	// mapblocks are used to check movement
 	// against lines and things
@@ -75,6 +89,30 @@ struct FBlockmap
 
 	bool VerifyBlockMap(int count, unsigned numlines);
 
+	void LinkActor(FBlockNode *node)
+	{
+		node->Position = blocklinks[node->BlockIndex].Push({ node->Me, node, false });
+	}
+
+	void UnlinkActor(FBlockNode *node)
+	{
+		auto &entry = blocklinks[node->BlockIndex][node->Position];
+		entry.Me = nullptr;
+		entry.Node = nullptr;
+		unlinkedblocks.Push(node->BlockIndex);
+	}
+
+	// Puts an actor back to where UnlinkActor took it from. The block must
+	// not have been compacted in between.
+	void RestoreActor(FBlockNode *node, bool singleblock)
+	{
+		auto &entry = blocklinks[node->BlockIndex][node->Position];
+		assert(entry.Me == nullptr);
+		entry = { node->Me, node, singleblock };
+	}
+
+	void Compact();
+
 	void Clear()
 	{
 		if (blockmaplump != nullptr)
@@ -87,6 +125,7 @@ struct FBlockmap
 			delete[] blocklinks;
 			blocklinks = nullptr;
 		}
+		unlinkedblocks.Clear();
 	}
 
 	~FBlockmap()
@@ -1087,8 +1087,17 @@ public:
 	int GetOppositePortalGroup(int plane);
 	void CheckOverlap();
 
+	// Vertices are shared with neighbouring sectors, so thinkers ticking concurrently
+	// collect their sectors here and the main thread marks them afterward.
+	static thread_local TArray<sector_t *> *DeferredVertexUpdates;
+
 	void SetVerticesDirty()
 	{
+		if (DeferredVertexUpdates != nullptr)
+		{
+			DeferredVertexUpdates->Push(this);
+			return;
+		}
 		for (unsigned i = 0; i < e->vertices.Size(); i++) e->vertices[i]->dirty = true;
 	}
 
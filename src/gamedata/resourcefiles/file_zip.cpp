@@ -34,6 +34,7 @@
 */
 
 #include <time.h>
+#include <zlib.h>
 #include "file_zip.h"
 #include "cmdlib.h"
 #include "templates.h"
@@ -109,6 +110,61 @@ bool FCompressedBuffer::Decompress(char *destbuffer)
 	return UncompressZipLump(destbuffer, mr, mMethod, mSize, mCompressedSize, mZipFlags);
 }
 
+//==========================================================================
+//
+// Deflates a stored buffer in place and calculates its CRC, so that it
+// can be written to a Zip. If compression does not work out the buffer
+// remains stored.
+//
+//==========================================================================
+
+void FCompressedBuffer::Compress()
+{
+	if (mMethod != METHOD_STORED) return;
+
+	mCRC32 = crc32(0, (const Bytef*)mBuffer, mSize);
+
+	uint8_t *compressbuf = new uint8_t[mSize + 1];
+
+	z_stream stream;
+	int err;
+
+	stream.next_in = (Bytef *)mBuffer;
+	stream.avail_in = mSize;
+	stream.next_out = (Bytef*)compressbuf;
+	stream.avail_out = mSize;
+	stream.zalloc = (alloc_func)0;
+	stream.zfree = (free_func)0;
+	stream.opaque = (voidpf)0;
+
+	// create output in zip-compatible form
+	err = deflateInit2(&stream, 8, Z_DEFLATED, -15, 9, Z_DEFAULT_STRATEGY);
+	if (err != Z_OK)
+	{
+		delete[] compressbuf;
+		return;
+	}
+
+	err = deflate(&stream, Z_FINISH);
+	if (err != Z_STREAM_END)
+	{
+		deflateEnd(&stream);
+		delete[] compressbuf;
+		return;
+	}
+
+	err = deflateEnd(&stream);
+	if (err == Z_OK)
+	{
+		mCompressedSize = stream.total_out;
+		mMethod = METHOD_DEFLATE;
+		delete[] mBuffer;
+		mBuffer = new char[mCompressedSize];
+		memcpy(mBuffer, compressbuf, mCompressedSize);
+	}
+	delete[] compressbuf;
+}
+
 //-----------------------------------------------------------------------
 //
 // Finds the central directory end record in the end of the file.
@@ -610,7 +666,7 @@ int AppendCentralDirectory(FileWriter *zip_file, const char *filename, FCompress
 	return 0;
 }
 
-bool WriteZip(const char *filename, TArray<FString> &filenames, TArray<FCompressedBuffer> &content)
+bool WriteZip(const char *filename, TArray<FString> &filenames, TArray<FCompressedBuffer> &content, bool sync)
 {
 	// try to determine local time
 	struct tm *ltime;
@@ -658,7 +714,7 @@ bool WriteZip(const char *filename, TArray<FString> &filenames, TArray<FCompress
 		dirend.DirectoryOffset = LittleLong(dirofs);
 		dirend.DirectorySize = LittleLong((uint32_t)(f->Tell() - dirofs));
 		dirend.ZipCommentLength = 0;
-		if (f->Write(&dirend, sizeof(dirend)) != sizeof(dirend))
+		if (f->Write(&dirend, sizeof(dirend)) != sizeof(dirend) || (sync && !f->Sync()))
 		{
 			delete f;
 			remove(filename);
@@ -252,6 +252,28 @@ void *FResourceLump::CacheLump()
 	return Cache;
 }
 
+//==========================================================================
+//
+// Returns a pointer to the lump's data inside its file's buffer, which
+// exists for memory mapped and in-memory files. The pointer is not
+// reference counted and stays valid for as long as the file is open.
+// Lumps that first have to be read, decompressed or decrypted return NULL.
+//
+//==========================================================================
+
+const void *FResourceLump::GetView()
+{
+	if (Cache == NULL && LumpSize > 0 && !(Flags & (LUMPF_BLOODCRYPT | LUMPF_COMPRESSED)))
+	{
+		FileReader *reader = GetReader();
+		if (reader != NULL && reader->GetBuffer() != NULL)
+		{
+			FillCache();
+		}
+	}
+	return RefCount < 0 ? Cache : NULL;
+}
+
 //==========================================================================
 //
 // Decrements reference counter and frees lump if counter reaches 0
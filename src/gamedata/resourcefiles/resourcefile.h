@@ -19,6 +19,7 @@ struct FCompressedBuffer
 	char *mBuffer;
 
 	bool Decompress(char *destbuffer);
+	void Compress();
 	void Clean()
 	{
 		mSize = mCompressedSize = 0;
@@ -72,6 +73,7 @@ struct FResourceLump
 
 	void *CacheLump();
 	int ReleaseCache();
+	const void *GetView();
 
 protected:
 	virtual int FillCache() { return -1; }
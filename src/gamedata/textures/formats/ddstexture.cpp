@@ -49,12 +49,14 @@
 */
 
 #include "doomtype.h"
+#include "templates.h"
 #include "files.h"
 #include "w_wad.h"
 #include "bitmap.h"
 #include "v_video.h"
 #include "imagehelpers.h"
 #include "image.h"
+#include "textures.h"
 
 // Since we want this to compile under Linux too, we need to define this
 // stuff ourselves instead of including a DirectX header.
@@ -165,9 +167,11 @@ public:
 	FDDSTexture (FileReader &lump, int lumpnum, void *surfdesc);
 
 	TArray<uint8_t> CreatePalettedPixels(int conversion) override;
+	int GetCompressedBlocks(FTextureBuffer *buffer) override;
 
 protected:
 	uint32_t Format;
+	int MipLevels;
 
 	uint32_t RMask, GMask, BMask, AMask;
 	uint8_t RShiftL, GShiftL, BShiftL, AShiftL;
@@ -290,6 +294,7 @@ FDDSTexture::FDDSTexture (FileReader &lump, int lumpnum, void *vsurfdesc)
 	bMasked = false;
 	Width = uint16_t(surf->Width);
 	Height = uint16_t(surf->Height);
+	MipLevels = (surf->Flags & DDSD_MIPMAPCOUNT) && surf->MipMapCount > 1 ? surf->MipMapCount : 1;
 
 	if (surf->PixelFormat.Flags & DDPF_FOURCC)
 	{
@@ -400,6 +405,52 @@ TArray<uint8_t> FDDSTexture::CreatePalettedPixels(int conversion)
 	return Pixels;
 }
 
+//==========================================================================
+//
+// DXT1, DXT3 and DXT5 are BC1, BC2 and BC3, so their blocks can be handed to
+// the hardware as they are, along with whatever mip levels the file has.
+// The premultiplied variants still need to be decoded.
+//
+//==========================================================================
+
+int FDDSTexture::GetCompressedBlocks(FTextureBuffer *buffer)
+{
+	int format = Format == ID_DXT1 ? TBF_BC1 : Format == ID_DXT3 ? TBF_BC2 : Format == ID_DXT5 ? TBF_BC3 : TBF_BGRA8;
+	if (format == TBF_BGRA8 || buffer == nullptr) return format;
+
+	auto lump = OpenSourceLump();
+	long available = lump.GetLength() - long(sizeof(DDSURFACEDESC2) + 4);
+
+	// Only keep the levels that are completely present.
+	long size = 0;
+	int levels = 0;
+	for (int w = Width, h = Height; levels < MipLevels; w = MAX(w >> 1, 1), h = MAX(h >> 1, 1))
+	{
+		long levelsize = GetCompressedLevelSize(format, w, h);
+		if (size + levelsize > available) break;
+		size += levelsize;
+		levels++;
+		if (w == 1 && h == 1) break;
+	}
+	if (levels == 0) return TBF_BGRA8;
+
+	auto blocks = new uint8_t[size];
+	lump.Seek(sizeof(DDSURFACEDESC2) + 4, FileReader::SeekSet);
+	if (lump.Read(blocks, size) != size)
+	{
+		delete[] blocks;
+		return TBF_BGRA8;
+	}
+
+	if (buffer->mBuffer) delete[] buffer->mBuffer;
+	buffer->mBuffer = blocks;
+	buffer->mWidth = Width;
+	buffer->mHeight = Height;
+	buffer->mFormat = format;
+	buffer->mLevels = levels;
+	return format;
+}
+
 //==========================================================================
 //
 // Note that pixel size == 8 is column-major, but 32 is row-major!
@@ -51,6 +51,7 @@ class FFlatTexture : public FImageSource
 public:
 	FFlatTexture (int lumpnum);
 	TArray<uint8_t> CreatePalettedPixels(int conversion) override;
+	bool IsCacheable() const override { return true; }
 };
 
 
@@ -171,7 +171,15 @@ void JPEG_OutputMessage (j_common_ptr cinfo)
 	char buffer[JMSG_LENGTH_MAX];
 
 	(*cinfo->err->format_message) (cinfo, buffer);
-	Printf (TEXTCOLOR_ORANGE "JPEG failure: %s\n", buffer);
+	auto image = (const FImageSource *)cinfo->client_data;
+	if (image != nullptr)
+	{
+		image->ReportDecodeError(FStringf("JPEG failure: %s", buffer));
+	}
+	else
+	{
+		Printf (TEXTCOLOR_ORANGE "JPEG failure: %s\n", buffer);
+	}
 }
 
 //==========================================================================
@@ -187,6 +195,8 @@ public:
 
 	int CopyPixels(FBitmap *bmp, int conversion) override;
 	TArray<uint8_t> CreatePalettedPixels(int conversion) override;
+	bool IsCacheable() const override { return true; }
+	bool CanPrefetch() const override { return true; }
 };
 
 //==========================================================================
@@ -275,6 +285,7 @@ TArray<uint8_t> FJPEGTexture::CreatePalettedPixels(int conversion)
 	cinfo.err->output_message = JPEG_OutputMessage;
 	cinfo.err->error_exit = JPEG_ErrorExit;
 	jpeg_create_decompress(&cinfo);
+	cinfo.client_data = this;
 
 	FLumpSourceMgr sourcemgr(&lump, &cinfo);
 	try
@@ -286,7 +297,7 @@ TArray<uint8_t> FJPEGTexture::CreatePalettedPixels(int conversion)
 			(cinfo.out_color_space == JCS_YCbCr && cinfo.num_components == 3) ||
 			(cinfo.out_color_space == JCS_GRAYSCALE && cinfo.num_components == 1)))
 		{
-			Printf(TEXTCOLOR_ORANGE "Unsupported color format in %s\n", Wads.GetLumpFullPath(SourceLump).GetChars());
+			ReportDecodeError("Unsupported color format");
 		}
 		else
 		{
@@ -363,7 +374,7 @@ TArray<uint8_t> FJPEGTexture::CreatePalettedPixels(int conversion)
 	}
 	catch (int)
 	{
-		Printf(TEXTCOLOR_ORANGE "JPEG error in %s\n", Wads.GetLumpFullPath(SourceLump).GetChars());
+		ReportDecodeError("JPEG error");
 	}
 	jpeg_destroy_decompress(&cinfo);
 	if (buff != NULL)
@@ -386,7 +397,7 @@ int FJPEGTexture::CopyPixels(FBitmap *bmp, int conversion)
 {
 	PalEntry pe[256];
 
-	auto lump = Wads.OpenLumpReader (SourceLump);
+	auto lump = OpenSourceLump();
 
 	jpeg_decompress_struct cinfo;
 	jpeg_error_mgr jerr;
@@ -395,6 +406,7 @@ int FJPEGTexture::CopyPixels(FBitmap *bmp, int conversion)
 	cinfo.err->output_message = JPEG_OutputMessage;
 	cinfo.err->error_exit = JPEG_ErrorExit;
 	jpeg_create_decompress(&cinfo);
+	cinfo.client_data = this;
 
 	FLumpSourceMgr sourcemgr(&lump, &cinfo);
 	try
@@ -406,7 +418,7 @@ int FJPEGTexture::CopyPixels(FBitmap *bmp, int conversion)
 			(cinfo.out_color_space == JCS_YCbCr && cinfo.num_components == 3) ||
 			(cinfo.out_color_space == JCS_GRAYSCALE && cinfo.num_components == 1)))
 		{
-			Printf(TEXTCOLOR_ORANGE "Unsupported color format in %s\n", Wads.GetLumpFullPath(SourceLump).GetChars());
+			ReportDecodeError("Unsupported color format");
 		}
 		else
 		{
@@ -454,7 +466,7 @@ int FJPEGTexture::CopyPixels(FBitmap *bmp, int conversion)
 	}
 	catch (int)
 	{
-		Printf(TEXTCOLOR_ORANGE "JPEG error in %s\n", Wads.GetLumpFullPath(SourceLump).GetChars());
+		ReportDecodeError("JPEG error");
 	}
 	jpeg_destroy_decompress(&cinfo);
 	return 0;
@@ -66,6 +66,7 @@ public:
 	FPatchTexture (int lumpnum, patch_t *header, bool isalphatex);
 	TArray<uint8_t> CreatePalettedPixels(int conversion) override;
 	int CopyPixels(FBitmap *bmp, int conversion) override;
+	bool IsCacheable() const override { return !isalpha; }	// alpha textures use a remap that is not part of the lump.
 	void DetectBadPatches();
 };
 
@@ -55,6 +55,8 @@ public:
 
 	int CopyPixels(FBitmap *bmp, int conversion) override;
 	TArray<uint8_t> CreatePalettedPixels(int conversion) override;
+	bool IsCacheable() const override { return true; }
+	bool CanPrefetch() const override { return true; }
 
 protected:
 	void ReadAlphaRemap(FileReader *lump, uint8_t *alpharemap);
@@ -456,7 +458,7 @@ int FPNGTexture::CopyPixels(FBitmap *bmp, int conversion)
 	FileReader *lump;
 	FileReader lfr;
 
-	lfr = Wads.OpenLumpReader(SourceLump);
+	lfr = OpenSourceLump();
 	lump = &lfr;
 
 	lump->Seek(33, FileReader::SeekSet);
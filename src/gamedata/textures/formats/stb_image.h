@@ -873,8 +873,8 @@ static void    *stbi__pnm_load(stbi__context *s, int *x, int *y, int *comp, int
 static int      stbi__pnm_info(stbi__context *s, int *x, int *y, int *comp);
 #endif
 
-// this is not threadsafe
-static const char *stbi__g_failure_reason;
+// thread local, because images get decoded on the job system while precaching
+static thread_local const char *stbi__g_failure_reason;
 
 STBIDEF const char *stbi_failure_reason(void)
 {
@@ -71,6 +71,8 @@ public:
 	FStbTexture (int lumpnum, int w, int h);
 	TArray<uint8_t> CreatePalettedPixels(int conversion) override;
 	int CopyPixels(FBitmap *bmp, int conversion) override;
+	bool IsCacheable() const override { return true; }
+	bool CanPrefetch() const override { return true; }
 };
 
 
@@ -160,7 +162,7 @@ TArray<uint8_t> FStbTexture::CreatePalettedPixels(int conversion)
 
 int FStbTexture::CopyPixels(FBitmap *bmp, int conversion)
 {
-	auto lump = Wads.OpenLumpReader (SourceLump); 
+	auto lump = OpenSourceLump();
 	int x, y, chan;
 	auto image = stbi_load_from_callbacks(&callbacks, &lump, &x, &y, &chan, STBI_rgb_alpha); 	
 	if (image)
@@ -358,8 +358,10 @@ int FTexture::CheckExternalFile(bool & hascolorkey)
 //
 //==========================================================================
 
-bool FTexture::LoadHiresTexture(FTextureBuffer &texbuffer, bool checkonly)
+bool FTexture::LoadHiresTexture(FTextureBuffer &texbuffer, int flags)
 {
+	bool checkonly = !!(flags & CTF_CheckOnly);
+
 	if (HiresLump == -1)
 	{
 		bHiresHasColorKey = false;
@@ -374,6 +376,8 @@ bool FTexture::LoadHiresTexture(FTextureBuffer &texbuffer, bool checkonly)
 	}
 	if (HiresTexture != nullptr)
 	{
+		if ((flags & CTF_AllowCompressed) && HiresTexture->LoadCompressedTexBuffer(texbuffer, checkonly)) return true;
+
 		int w = HiresTexture->GetWidth();
 		int h = HiresTexture->GetHeight();
 
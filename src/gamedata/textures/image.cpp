@@ -38,7 +38,16 @@
 #include "bitmap.h"
 #include "image.h"
 #include "w_wad.h"
+#include "v_text.h"
 #include "files.h"
+#include "c_cvars.h"
+#include "stats.h"
+#include "jobsystem.h"
+#include "texturecache.h"
+#include "resourcefiles/resourcefile.h"
+
+// Upper limit for decoded images waiting to be uploaded while precaching, in MB. 0 decodes everything on the main thread.
+CVAR(Int, gl_precache_memory, 256, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
 
 FMemArena FImageSource::ImageArena(32768);
 TArray<FImageSource *>FImageSource::ImageForLump;
@@ -64,6 +73,47 @@ struct PrecacheDataRgba
 TArray<PrecacheDataPaletted> precacheDataPaletted;
 TArray<PrecacheDataRgba> precacheDataRgba;
 
+struct PrefetchEntry
+{
+	FImageSource *Image;
+	const char *View;		// points into a memory mapped file if the lump can be read in place.
+	FCompressedBuffer Raw;	// otherwise the lump's data as stored in the file, read on the main thread.
+	FBitmap Pixels;
+	int TransInfo;
+	TArray<FString> Errors;	// printed on the main thread once the batch is installed.
+
+	// For textures whose hardware buffer gets built and block compressed right after decoding.
+	FTexture *Texture;
+	bool FindHoles;
+	int Translucent;
+	FPostProcessInfo PostProcess;
+	FTextureBuffer *Finished;
+};
+
+// The data a prefetch job decodes from, for OpenSourceLump.
+struct PrefetchSource
+{
+	const FImageSource *Image;
+	const char *Data;
+	long Size;
+	TArray<FString> *Errors;
+};
+
+static TArray<FImageSource *> prefetchQueue;
+static TMap<int, FTexture *> prefetchTextures;
+static TArray<PrefetchEntry> prefetchEntries;
+static TArray<unsigned> prefetchBatchStart;
+static TMap<int, unsigned> prefetchBatchOf;
+static unsigned prefetchInstalled, prefetchLaunched;
+static FJobGroup &prefetchJobs(unsigned batch)	// drained by ClearImages
+{
+	static FJobGroup jobs[2];
+	return jobs[batch & 1];
+}
+static size_t prefetchBytes;
+static cycle_t prefetchTime, prefetchReadTime, prefetchWaitTime;
+static thread_local PrefetchSource *prefetchDecoding;
+
 //===========================================================================
 // 
 // the default just returns an empty texture.
@@ -216,6 +266,7 @@ FBitmap FImageSource::GetCachedBitmap(PalEntry *remap, int conversion, int *ptra
 	else
 	{
 		if (conversion == luminance) conversion = normal;	// luminance has no meaning for true color.
+		if (conversion == normal && prefetchBatchOf.CountUsed() > 0) WaitForPrefetch(imageID);
 		// Do we have this image in the cache?
 		unsigned index = conversion != normal? UINT_MAX : precacheDataRgba.FindEx([=](PrecacheDataRgba &entry) { return entry.ImageID == imageID; });
 		if (index < precacheDataRgba.Size())
@@ -295,20 +346,303 @@ void FImageSource::CollectForPrecache(PrecacheInfo &info, bool requiretruecolor)
 	}
 }
 
+void FImageSource::ClearImages()
+{
+	EndPrecaching();	// prefetch jobs may still be decoding into the arena
+	ImageArena.FreeAll();
+	ImageForLump.Clear();
+	NextID = 0;
+}
+
 void FImageSource::BeginPrecaching()
 {
 	precacheInfo.Clear();
+	prefetchQueue.Clear();
+	prefetchTextures.Clear();
 }
 
 void FImageSource::EndPrecaching()
 {
+	if (prefetchEntries.Size() > 0)
+	{
+		prefetchJobs(0).Wait();
+		prefetchJobs(1).Wait();
+		prefetchTime.Unclock();
+		DPrintf(DMSG_NOTIFY, "Prefetched %u images (%zu MB) in %.3f ms, %.3f ms reading, %.3f ms waiting for decoders\n",
+			prefetchEntries.Size(), prefetchBytes >> 20, prefetchTime.TimeMS(), prefetchReadTime.TimeMS(), prefetchWaitTime.TimeMS());
+
+		for (auto &entry : prefetchEntries)
+		{
+			entry.Raw.Clean();
+			delete entry.Finished;	// the backend could not use it after all.
+		}
+		prefetchEntries.Reset();
+		prefetchBatchStart.Reset();
+		prefetchBatchOf.Clear();
+	}
+	prefetchQueue.Clear();
+	prefetchTextures.Clear();
 	precacheDataPaletted.Clear();
 	precacheDataRgba.Clear();
 }
 
-void FImageSource::RegisterForPrecache(FImageSource *img)
+void FImageSource::RegisterForPrecache(FImageSource *img, FTexture *tex)
 {
+	if (precacheInfo.CheckKey(img->ImageID) == nullptr) prefetchQueue.Push(img);
 	img->CollectForPrecache(precacheInfo);
+	// The first texture that is going to be uploaded from the image may get its buffer built by the prefetch job.
+	if (tex != nullptr && prefetchTextures.CheckKey(img->ImageID) == nullptr) prefetchTextures.Insert(img->ImageID, tex);
+}
+
+//==========================================================================
+//
+// FImageSource :: StartPrefetch
+//
+// Splits the registered images that can be decoded off the main thread
+// into batches, in the order they were registered which is the order the
+// precacher is going to request them in. One batch gets decoded while the
+// previous one is being uploaded, so the budget is split between two.
+//
+//==========================================================================
+
+void FImageSource::StartPrefetch()
+{
+	size_t budget = (size_t)MAX<int>(gl_precache_memory, 0) << 19;
+	if (budget == 0 || prefetchEntries.Size() > 0) return;
+
+	prefetchBytes = 0;
+	size_t batchbytes = 0;
+	for (auto img : prefetchQueue)
+	{
+		auto info = precacheInfo.CheckKey(img->ImageID);
+		if (info == nullptr || info->first == 0 || !img->CanPrefetch() || img->SourceLump < 0) continue;
+		if (FTextureDiskCache::HasImage(img)) continue;	// most likely never decoded at all.
+
+		size_t size = (size_t)img->Width * img->Height * 4 + Wads.LumpLength(img->SourceLump);
+		if (prefetchBatchStart.Size() == 0 || (batchbytes > 0 && batchbytes + size > budget))
+		{
+			prefetchBatchStart.Push(prefetchEntries.Size());
+			batchbytes = 0;
+		}
+		batchbytes += size;
+		prefetchBytes += size;
+		prefetchBatchOf.Insert(img->ImageID, prefetchBatchStart.Size() - 1);
+		auto &entry = prefetchEntries[prefetchEntries.Reserve(1)];
+		entry.Image = img;
+		entry.View = nullptr;
+		entry.TransInfo = 0;
+		entry.Texture = nullptr;
+		entry.Finished = nullptr;
+		auto tex = prefetchTextures.CheckKey(img->ImageID);
+		if (tex != nullptr && (*tex)->CanCompressOnPrefetch(entry.Translucent, entry.PostProcess, entry.FindHoles))
+		{
+			entry.Texture = *tex;
+		}
+	}
+	prefetchQueue.Clear();
+	if (prefetchEntries.Size() == 0) return;
+	prefetchBatchStart.Push(prefetchEntries.Size());
+
+	prefetchTime.Reset();
+	prefetchReadTime.Reset();
+	prefetchWaitTime.Reset();
+	prefetchTime.Clock();
+	prefetchInstalled = prefetchLaunched = 0;
+	LaunchPrefetch(0);
+}
+
+//==========================================================================
+//
+// FImageSource :: LaunchPrefetch
+//
+// All lump access happens here on the main thread. The file readers are
+// shared and not thread safe, so the jobs only get a pointer into a mapped
+// file or a copy of the raw, possibly still compressed data.
+//
+//==========================================================================
+
+void FImageSource::LaunchPrefetch(unsigned batch)
+{
+	prefetchReadTime.Clock();
+	auto &jobs = prefetchJobs(batch);
+	for (unsigned i = prefetchBatchStart[batch]; i < prefetchBatchStart[batch + 1]; i++)
+	{
+		auto entry = &prefetchEntries[i];
+		int lump = entry->Image->SourceLump;
+		entry->View = (const char *)Wads.LumpView(lump);
+		if (entry->View == nullptr)
+		{
+			// Only zips return their entries still compressed. Everything else
+			// gets unpacked through the lump cache here.
+			entry->Raw = Wads.GetLumpRecord(lump)->GetRawData();
+		}
+
+		long size = Wads.LumpLength(lump);
+
+		jobs.Run([=]()
+		{
+			TArray<uint8_t> buffer;
+			PrefetchSource source = { entry->Image, entry->View, size, &entry->Errors };
+			if (source.Data == nullptr)
+			{
+				source.Data = entry->Raw.mBuffer;
+				if (entry->Raw.mMethod != METHOD_STORED)
+				{
+					buffer.Resize(entry->Raw.mSize);
+					if (!entry->Raw.Decompress((char *)buffer.Data()))
+					{
+						entry->Errors.Push("Could not decompress the lump");
+						return;
+					}
+					source.Data = (const char *)buffer.Data();
+				}
+			}
+
+			prefetchDecoding = &source;
+			entry->Pixels.Create(entry->Image->Width, entry->Image->Height);
+			entry->TransInfo = entry->Image->CopyPixels(&entry->Pixels, normal);
+			prefetchDecoding = nullptr;
+			entry->Raw.Clean();
+
+			if (entry->Texture != nullptr)
+			{
+				entry->Finished = new FTextureBuffer;
+				FTexture::CreatePrefetchedTexBuffer(entry->Pixels, entry->TransInfo, entry->FindHoles, *entry->Finished, entry->Translucent, entry->PostProcess);
+			}
+		});
+	}
+	prefetchLaunched = batch + 1;
+	prefetchReadTime.Unclock();
+}
+
+//==========================================================================
+//
+// FImageSource :: InstallPrefetch
+//
+// Moves the oldest batch into the precache and starts decoding the next.
+//
+//==========================================================================
+
+void FImageSource::InstallPrefetch()
+{
+	unsigned batch = prefetchInstalled;
+	prefetchWaitTime.Clock();
+	prefetchJobs(batch).Wait();
+	prefetchWaitTime.Unclock();
+
+	for (unsigned i = prefetchBatchStart[batch]; i < prefetchBatchStart[batch + 1]; i++)
+	{
+		auto &entry = prefetchEntries[i];
+		for (auto &error : entry.Errors)
+		{
+			entry.Image->ReportDecodeError(error);
+		}
+		entry.Errors.Reset();
+
+		auto info = precacheInfo.CheckKey(entry.Image->ImageID);
+		// The texture that takes the finished buffer is not going to ask for the pixels.
+		if (entry.Finished != nullptr && info != nullptr && info->first > 0) info->first--;
+		if (entry.Pixels.GetPixels() != nullptr && info != nullptr && info->first > 0)
+		{
+			PrecacheDataRgba *pdr = &precacheDataRgba[precacheDataRgba.Reserve(1)];
+			pdr->ImageID = entry.Image->ImageID;
+			pdr->RefCount = info->first;
+			pdr->TransInfo = entry.TransInfo;
+			pdr->Pixels = std::move(entry.Pixels);
+			info->first = 0;
+		}
+		entry.Pixels.Destroy();
+	}
+	prefetchInstalled++;
+
+	if (prefetchLaunched < prefetchBatchStart.Size() - 1)
+	{
+		LaunchPrefetch(prefetchLaunched);
+	}
+}
+
+void FImageSource::WaitForPrefetch(int imageID)
+{
+	auto batch = prefetchBatchOf.CheckKey(imageID);
+	if (batch == nullptr) return;
+	while (prefetchInstalled <= *batch)
+	{
+		InstallPrefetch();
+	}
+}
+
+//==========================================================================
+//
+// FImageSource :: TakePrefetchedTexBuffer
+//
+// Hands out the buffer a prefetch job built for this texture, see
+// FTexture::CanCompressOnPrefetch.
+//
+//==========================================================================
+
+bool FImageSource::TakePrefetchedTexBuffer(FTexture *tex, FTextureBuffer &buffer, int &translucent, FPostProcessInfo &info)
+{
+	auto image = tex->GetImage();
+	auto batch = image == nullptr ? nullptr : prefetchBatchOf.CheckKey(image->ImageID);
+	if (batch == nullptr) return false;
+	WaitForPrefetch(image->ImageID);
+
+	for (unsigned i = prefetchBatchStart[*batch]; i < prefetchBatchStart[*batch + 1]; i++)
+	{
+		auto &entry = prefetchEntries[i];
+		if (entry.Texture == tex && entry.Finished != nullptr)
+		{
+			buffer = std::move(*entry.Finished);
+			translucent = entry.Translucent;
+			info = entry.PostProcess;
+			delete entry.Finished;
+			entry.Finished = nullptr;
+			return true;
+		}
+	}
+	return false;
+}
+
+//==========================================================================
+//
+// FImageSource :: OpenSourceLump
+//
+// While a prefetch job decodes this image the data comes from the buffer
+// prepared for it instead of the shared file reader.
+//
+//==========================================================================
+
+FileReader FImageSource::OpenSourceLump() const
+{
+	if (prefetchDecoding != nullptr && prefetchDecoding->Image == this)
+	{
+		FileReader fr;
+		fr.OpenMemory(prefetchDecoding->Data, prefetchDecoding->Size);
+		return fr;
+	}
+	return Wads.OpenLumpReader(SourceLump);
+}
+
+//==========================================================================
+//
+// FImageSource :: ReportDecodeError
+//
+// Decoders report broken data through this. A prefetch job keeps the
+// message for InstallPrefetch, because the console and the lump directory
+// may only be used on the main thread.
+//
+//==========================================================================
+
+void FImageSource::ReportDecodeError(const char *message) const
+{
+	if (prefetchDecoding != nullptr && prefetchDecoding->Image == this)
+	{
+		prefetchDecoding->Errors->Push(message);
+	}
+	else
+	{
+		Printf(TEXTCOLOR_ORANGE "%s in %s\n", message, Wads.GetLumpFullPath(SourceLump).GetChars());
+	}
 }
 
 //==========================================================================
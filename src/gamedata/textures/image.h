@@ -4,8 +4,12 @@
 #include "tarray.h"
 #include "textures/bitmap.h"
 #include "memarena.h"
+#include "files.h"
 
 class FImageSource;
+class FTexture;
+struct FTextureBuffer;
+struct FPostProcessInfo;
 using PrecacheInfo = TMap<int, std::pair<int, int>>;
 
 struct PalettedPixels
@@ -45,6 +49,13 @@ protected:
 	virtual int CopyPixels(FBitmap *bmp, int conversion);			// This will always ignore 'luminance'.
 	int CopyTranslatedPixels(FBitmap *bmp, PalEntry *remap);
 
+	FileReader OpenSourceLump() const;
+
+private:
+	static void LaunchPrefetch(unsigned batch);
+	static void InstallPrefetch();
+	static void WaitForPrefetch(int imageID);
+
 
 public:
 
@@ -78,7 +89,7 @@ public:
 	// Unlile for paletted images there is no variant here that returns a persistent bitmap, because all users have to process the returned image into another format.
 	FBitmap GetCachedBitmap(PalEntry *remap, int conversion, int *trans = nullptr);
 
-	static void ClearImages() { ImageArena.FreeAll(); ImageForLump.Clear(); NextID = 0; }
+	static void ClearImages();
 	static FImageSource * GetImage(int lumpnum, ETextureType usetype);
 
 
@@ -130,10 +141,28 @@ public:
 		return bUseGamePalette;
 	}
 
+	// True if the pixels depend on nothing but the source lump's contents and the game palette,
+	// which allows the texture disk cache to identify them.
+	virtual bool IsCacheable() const { return false; }
+
+	// Image formats whose CopyPixels only reads through OpenSourceLump and touches no global state
+	// return true here. Those get decoded on the job system ahead of use while precaching.
+	virtual bool CanPrefetch() const { return false; }
+
+	// Decoders report broken data through this. The message gets printed with the lump's name.
+	void ReportDecodeError(const char *message) const;
+
+	// Images that are stored in a GPU block compression format return it here (see ETextureBufferFormat)
+	// so that the hardware renderer can upload the blocks as they are. With a buffer the blocks of all
+	// stored mip levels are read into it. 0 means the image can only be decoded.
+	virtual int GetCompressedBlocks(FTextureBuffer *buffer) { return 0; }
+
 	virtual void CollectForPrecache(PrecacheInfo &info, bool requiretruecolor = false);
 	static void BeginPrecaching();
 	static void EndPrecaching();
-	static void RegisterForPrecache(FImageSource *img);
+	static void RegisterForPrecache(FImageSource *img, FTexture *tex = nullptr);
+	static void StartPrefetch();
+	static bool TakePrefetchedTexBuffer(FTexture *tex, FTextureBuffer &buffer, int &translucent, FPostProcessInfo &info);
 };
 
 //==========================================================================
@@ -0,0 +1,443 @@
+/*
+** texcompress.cpp
+** Block compression of texture buffers for the hardware renderers
+**
+**---------------------------------------------------------------------------
+** Copyright 2019 GZDoom maintainers and contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** With gl_texture_compress the finished BGRA buffer of a hardware texture
+** is converted to BC1 (opaque) or BC3 (anything with alpha) before it is
+** uploaded, which after upscaling saves a lot of video memory. Compressed
+** textures cannot be mipmapped by the GPU, so the whole mip chain is built
+** and encoded here.
+**
+** The encoder is the usual real-time bounding box fit: the endpoints are
+** the inset extremes of the block and every pixel is projected onto the
+** line between them. That is far from optimal but fast enough to run at
+** load time, spread over the job system.
+**
+*/
+
+#include <typeinfo>
+#include "templates.h"
+#include "c_cvars.h"
+#include "textures.h"
+#include "image.h"
+#include "parallel_for.h"
+
+#ifndef NO_SSE
+#include <emmintrin.h>
+#endif
+
+CUSTOM_CVAR(Bool, gl_texture_compress, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG | CVAR_NOINITCALL)
+{
+	TexMan.FlushAll();
+}
+
+//===========================================================================
+//
+// Copies a 4x4 block out of a BGRA image, repeating the last row and
+// column for blocks that extend past the edge.
+//
+//===========================================================================
+
+static void FetchBlock(const uint8_t *src, int width, int height, int bx, int by, uint8_t *block)
+{
+	for (int y = 0; y < 4; y++)
+	{
+		int sy = MIN(by * 4 + y, height - 1);
+		for (int x = 0; x < 4; x++)
+		{
+			int sx = MIN(bx * 4 + x, width - 1);
+			memcpy(block + (y * 4 + x) * 4, src + (sy * width + sx) * 4, 4);
+		}
+	}
+}
+
+static void GetBlockExtents(const uint8_t *block, uint8_t *minc, uint8_t *maxc)
+{
+#ifndef NO_SSE
+	__m128i r0 = _mm_loadu_si128((const __m128i*)block);
+	__m128i r1 = _mm_loadu_si128((const __m128i*)(block + 16));
+	__m128i r2 = _mm_loadu_si128((const __m128i*)(block + 32));
+	__m128i r3 = _mm_loadu_si128((const __m128i*)(block + 48));
+	__m128i mn = _mm_min_epu8(_mm_min_epu8(r0, r1), _mm_min_epu8(r2, r3));
+	__m128i mx = _mm_max_epu8(_mm_max_epu8(r0, r1), _mm_max_epu8(r2, r3));
+	mn = _mm_min_epu8(mn, _mm_shuffle_epi32(mn, _MM_SHUFFLE(2, 3, 0, 1)));
+	mx = _mm_max_epu8(mx, _mm_shuffle_epi32(mx, _MM_SHUFFLE(2, 3, 0, 1)));
+	mn = _mm_min_epu8(mn, _mm_shuffle_epi32(mn, _MM_SHUFFLE(1, 0, 3, 2)));
+	mx = _mm_max_epu8(mx, _mm_shuffle_epi32(mx, _MM_SHUFFLE(1, 0, 3, 2)));
+	uint32_t mnv = _mm_cvtsi128_si32(mn);
+	uint32_t mxv = _mm_cvtsi128_si32(mx);
+	memcpy(minc, &mnv, 4);
+	memcpy(maxc, &mxv, 4);
+#else
+	memcpy(minc, block, 4);
+	memcpy(maxc, block, 4);
+	for (int i = 1; i < 16; i++)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			minc[c] = MIN(minc[c], block[i * 4 + c]);
+			maxc[c] = MAX(maxc[c], block[i * 4 + c]);
+		}
+	}
+#endif
+}
+
+//===========================================================================
+//
+// Encodes the color part of a block. Always uses the four color mode,
+// which is the only one BC3 knows and is opaque in BC1.
+//
+//===========================================================================
+
+static inline uint16_t To565(const int *bgr)
+{
+	return uint16_t(((bgr[2] >> 3) << 11) | ((bgr[1] >> 2) << 5) | (bgr[0] >> 3));
+}
+
+static void EncodeColorBlock(const uint8_t *block, const uint8_t *minc, const uint8_t *maxc, uint8_t *out)
+{
+	int lo[3], hi[3];
+	for (int c = 0; c < 3; c++)
+	{
+		// Move the endpoints inwards a bit. The extremes are usually
+		// outliers and the interpolated colors get closer to the rest.
+		int inset = (maxc[c] - minc[c]) >> 4;
+		lo[c] = minc[c] + inset;
+		hi[c] = maxc[c] - inset;
+	}
+	uint16_t c0 = To565(hi);
+	uint16_t c1 = To565(lo);
+	out[0] = uint8_t(c0);
+	out[1] = uint8_t(c0 >> 8);
+	out[2] = uint8_t(c1);
+	out[3] = uint8_t(c1 >> 8);
+
+	if (c0 == c1)
+	{
+		// Index 0 for everything. 3 would be transparent in BC1.
+		out[4] = out[5] = out[6] = out[7] = 0;
+		return;
+	}
+
+	// Project on the line between the endpoints as the hardware decodes them.
+	int e0[3] = { (c0 & 31) << 3 | (c0 & 31) >> 2, ((c0 >> 5) & 63) << 2 | ((c0 >> 5) & 63) >> 4, (c0 >> 11) << 3 | (c0 >> 11) >> 2 };
+	int e1[3] = { (c1 & 31) << 3 | (c1 & 31) >> 2, ((c1 >> 5) & 63) << 2 | ((c1 >> 5) & 63) >> 4, (c1 >> 11) << 3 | (c1 >> 11) >> 2 };
+	int dir[3] = { e0[0] - e1[0], e0[1] - e1[1], e0[2] - e1[2] };
+	int start = e1[0] * dir[0] + e1[1] * dir[1] + e1[2] * dir[2];
+	int length = e0[0] * dir[0] + e0[1] * dir[1] + e0[2] * dir[2] - start;
+
+	// Steps along the line from c1 to c0 map to the indices 1, 3, 2, 0.
+	static const uint32_t remap[4] = { 1, 3, 2, 0 };
+	uint32_t indices = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		const uint8_t *p = block + i * 4;
+		int pos = 6 * (p[0] * dir[0] + p[1] * dir[1] + p[2] * dir[2] - start) + length;
+		int step = pos <= 0 ? 0 : MIN(pos / (2 * length), 3);
+		indices |= remap[step] << (i * 2);
+	}
+	out[4] = uint8_t(indices);
+	out[5] = uint8_t(indices >> 8);
+	out[6] = uint8_t(indices >> 16);
+	out[7] = uint8_t(indices >> 24);
+}
+
+//===========================================================================
+//
+// Encodes the alpha part of a BC3 block with the 8 value mode.
+//
+//===========================================================================
+
+static void EncodeAlphaBlock(const uint8_t *block, int amin, int amax, uint8_t *out)
+{
+	out[0] = uint8_t(amax);
+	out[1] = uint8_t(amin);
+
+	uint64_t indices = 0;
+	if (amax > amin)
+	{
+		// Steps 0 and 7 are the endpoints (indices 1 and 0), 1..6 are indices 7..2.
+		int range = amax - amin;
+		for (int i = 0; i < 16; i++)
+		{
+			int step = ((block[i * 4 + 3] - amin) * 14 + range) / (2 * range);
+			uint64_t index = step == 7 ? 0 : step == 0 ? 1 : 8 - step;
+			indices |= index << (i * 3);
+		}
+	}
+	for (int i = 0; i < 6; i++)
+	{
+		out[2 + i] = uint8_t(indices >> (i * 8));
+	}
+}
+
+//===========================================================================
+//
+// Encodes one mip level
+//
+//===========================================================================
+
+static void EncodeLevel(const uint8_t *src, int width, int height, int format, uint8_t *dest)
+{
+	int blocksx = (width + 3) >> 2;
+	int blocksy = (height + 3) >> 2;
+	int blocksize = format == TBF_BC1 ? 8 : 16;
+
+	auto encoderows = [=](int first, int last)
+	{
+		uint8_t block[64], minc[4], maxc[4];
+		for (int by = first; by < last; by++)
+		{
+			uint8_t *out = dest + by * blocksx * blocksize;
+			for (int bx = 0; bx < blocksx; bx++)
+			{
+				FetchBlock(src, width, height, bx, by, block);
+				GetBlockExtents(block, minc, maxc);
+				if (format == TBF_BC3)
+				{
+					EncodeAlphaBlock(block, minc[3], maxc[3], out);
+					out += 8;
+				}
+				EncodeColorBlock(block, minc, maxc, out);
+				out += 8;
+			}
+		}
+	};
+
+	// About 64 KB of source pixels per job.
+	const int rowsperjob = MAX(1, 1024 / blocksx);
+	if (blocksy > rowsperjob)
+	{
+		parallel_for(0, blocksy, rowsperjob, [&](int by)
+		{
+			encoderows(by, MIN(by + rowsperjob, blocksy));
+		});
+	}
+	else
+	{
+		encoderows(0, blocksy);
+	}
+}
+
+//===========================================================================
+//
+// Box filters a BGRA image to half its size
+//
+//===========================================================================
+
+static void Downsample(const uint8_t *src, int width, int height, uint8_t *dest)
+{
+	int dw = MAX(width >> 1, 1);
+	int dh = MAX(height >> 1, 1);
+	for (int y = 0; y < dh; y++)
+	{
+		const uint8_t *row0 = src + MIN(y * 2, height - 1) * width * 4;
+		const uint8_t *row1 = src + MIN(y * 2 + 1, height - 1) * width * 4;
+		for (int x = 0; x < dw; x++)
+		{
+			int x0 = MIN(x * 2, width - 1) * 4;
+			int x1 = MIN(x * 2 + 1, width - 1) * 4;
+			for (int c = 0; c < 4; c++)
+			{
+				*dest++ = uint8_t((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+			}
+		}
+	}
+}
+
+//===========================================================================
+//
+// Whether CompressTextureBuffer is going to compress this buffer
+//
+//===========================================================================
+
+bool FTexture::CanCompress(const FTextureBuffer &texbuffer) const
+{
+	if (!gl_texture_compress || texbuffer.mFormat != TBF_BGRA8) return false;
+
+	// Small textures save next to nothing and font characters would suffer the most from the artifacts.
+	return texbuffer.mWidth >= 16 && texbuffer.mHeight >= 16 && UseType != ETextureType::FontChar && !bHasCanvas && !bNoCompress;
+}
+
+//===========================================================================
+//
+// Replaces the BGRA data of texbuffer with BC1 or BC3 blocks for all mip
+// levels. Like CreateUpsampledTextureBuffer it only sets the content ID
+// when 'checkonly' is true.
+//
+//===========================================================================
+
+void FTexture::CompressTextureBuffer(FTextureBuffer &texbuffer, bool checkonly)
+{
+	if (!CanCompress(texbuffer)) return;
+
+	FContentIdBuilder builder;
+	builder.id = texbuffer.mContentId;
+	builder.compressed = 1;
+	texbuffer.mContentId = builder.id;
+	if (checkonly || texbuffer.mBuffer == nullptr) return;
+
+	EncodeTextureBuffer(texbuffer);
+}
+
+//===========================================================================
+//
+// The encoding itself, which depends on nothing but the buffer
+//
+//===========================================================================
+
+void FTexture::EncodeTextureBuffer(FTextureBuffer &texbuffer)
+{
+	int width = texbuffer.mWidth;
+	int height = texbuffer.mHeight;
+	const uint8_t *pixels = texbuffer.mBuffer;
+	int format = TBF_BC1;
+	for (int i = 0; i < width * height; i++)
+	{
+		if (pixels[i * 4 + 3] != 255)
+		{
+			format = TBF_BC3;
+			break;
+		}
+	}
+
+	int levels = 1;
+	int size = GetCompressedLevelSize(format, width, height);
+	for (int w = width, h = height; w > 1 || h > 1; levels++)
+	{
+		w = MAX(w >> 1, 1);
+		h = MAX(h >> 1, 1);
+		size += GetCompressedLevelSize(format, w, h);
+	}
+
+	auto blocks = new uint8_t[size];
+	TArray<uint8_t> mip((MAX(width >> 1, 1)) * (MAX(height >> 1, 1)) * 4, true);
+	TArray<uint8_t> nextmip(mip.Size(), true);
+
+	uint8_t *dest = blocks;
+	int w = width, h = height;
+	for (int level = 0; level < levels; level++)
+	{
+		if (level > 0)
+		{
+			Downsample(pixels, w, h, nextmip.Data());
+			mip.Swap(nextmip);
+			pixels = mip.Data();
+			w = MAX(w >> 1, 1);
+			h = MAX(h >> 1, 1);
+		}
+		EncodeLevel(pixels, w, h, format, dest);
+		dest += GetCompressedLevelSize(format, w, h);
+	}
+
+	delete[] texbuffer.mBuffer;
+	texbuffer.mBuffer = blocks;
+	texbuffer.mFormat = format;
+	texbuffer.mLevels = levels;
+}
+
+//===========================================================================
+//
+// Whether the hardware buffer of this texture can be built by the job that
+// decodes its image while precaching: an untranslated image texture that
+// gets block compressed as it is, without upscaling or a hires replacement.
+// Those are exactly the steps CreatePrefetchedTexBuffer can do, which gets
+// the texture's state from here because it must not look at the texture.
+//
+//===========================================================================
+
+bool FTexture::CanCompressOnPrefetch(int &translucent, FPostProcessInfo &info, bool &findholes)
+{
+	auto image = GetImage();
+	if (!gl_texture_compress || image == nullptr || typeid(*this) != typeid(FImageTexture) || bNoRemap0 || HiresTexture != nullptr) return false;
+	if (image->GetCompressedBlocks(nullptr) != 0 || GetWidth() != image->GetWidth() || GetHeight() != image->GetHeight()) return false;
+
+	FTextureBuffer probe;
+	probe.mWidth = GetWidth();
+	probe.mHeight = GetHeight();
+	CreateUpsampledTextureBuffer(probe, true, true);
+	FContentIdBuilder builder;
+	builder.id = probe.mContentId;
+	if (builder.scaler != 0 || !CanCompress(probe)) return false;
+
+	translucent = bTranslucent;
+	info.Masked = bMasked;
+	findholes = areacount == 0 && UseType != ETextureType::Flat;
+	return true;
+}
+
+//===========================================================================
+//
+// Runs on a prefetch job: the part of CreateTexBuffer that follows decoding
+// for a texture CanCompressOnPrefetch accepted. The texture itself is not
+// touched. 'translucent' and 'info.Masked' come in with the texture's state
+// and go out with what CheckTrans and ProcessData would have set.
+//
+//===========================================================================
+
+void FTexture::CreatePrefetchedTexBuffer(const FBitmap &pixels, int trans, bool findholes, FTextureBuffer &texbuffer, int &translucent, FPostProcessInfo &info)
+{
+	int w = pixels.GetWidth();
+	int h = pixels.GetHeight();
+	texbuffer.mBuffer = new uint8_t[w * (h + 1) * 4];
+	memset(texbuffer.mBuffer, 0, w * (h + 1) * 4);
+	texbuffer.mWidth = w;
+	texbuffer.mHeight = h;
+	FBitmap bmp(texbuffer.mBuffer, w * 4, w, h);
+	bmp.Blit(0, 0, pixels);
+
+	if (translucent == -1)
+	{
+		translucent = trans;
+		if (trans == -1)
+		{
+			const uint32_t *dwbuf = (const uint32_t *)texbuffer.mBuffer;
+			translucent = 0;
+			for (int i = 0; i < w * h; i++)
+			{
+				uint32_t alpha = dwbuf[i] >> 24;
+				if (alpha != 0xff && alpha != 0)
+				{
+					translucent = 1;
+					break;
+				}
+			}
+		}
+	}
+
+	info.AreaCount = 0;
+	if (info.Masked)
+	{
+		info.Masked = SmoothEdges(texbuffer.mBuffer, w, h);
+		if (info.Masked && findholes) info.AreaCount = FindHoleAreas(texbuffer.mBuffer, w, h, info.Areas);
+	}
+	EncodeTextureBuffer(texbuffer);
+}
@@ -34,6 +34,7 @@
 **
 */
 
+#include <mutex>
 #include "doomtype.h"
 #include "files.h"
 #include "w_wad.h"
@@ -50,6 +51,7 @@
 #include "swrenderer/textures/r_swtexture.h"
 #include "imagehelpers.h"
 #include "image.h"
+#include "texturecache.h"
 #include "formats/multipatchtexture.h"
 #include "g_levellocals.h"
 
@@ -478,6 +480,36 @@ void FTexture::GetGlowColor(float *data)
 //===========================================================================
 
 bool FTexture::FindHoles(const unsigned char * buffer, int w, int h)
+{
+	// already done!
+	if (areacount) return false;
+	if (UseType == ETextureType::Flat) return false;	// flats don't have transparent parts
+
+	float gaps[5][2];
+	areacount = FindHoleAreas(buffer, w, h, gaps);
+	if (areacount <= 0) return false;
+
+	FloatRect * rcs = new FloatRect[areacount];
+	for (int x = 0; x < areacount; x++)
+	{
+		// gaps are stored as texture (u/v) coordinates
+		rcs[x].width = rcs[x].left = -1.0f;
+		rcs[x].top = gaps[x][0];
+		rcs[x].height = gaps[x][1];
+	}
+	areas = rcs;
+	return true;
+}
+
+//===========================================================================
+// 
+// The search itself. Returns the number of areas, or -1 if the texture
+// cannot be split into any. Touches no texture state, so prefetch jobs
+// can use it, too.
+//
+//===========================================================================
+
+int FTexture::FindHoleAreas(const unsigned char * buffer, int w, int h, float areas[5][2])
 {
 	const unsigned char * li;
 	int y, x;
@@ -485,14 +517,8 @@ bool FTexture::FindHoles(const unsigned char * buffer, int w, int h)
 	int gaps[5][2];
 	int gapc = 0;
 
-
-	// already done!
-	if (areacount) return false;
-	if (UseType == ETextureType::Flat) return false;	// flats don't have transparent parts
-	areacount = -1;	//whatever happens next, it shouldn't be done twice!
-
 							// large textures are excluded for performance reasons
-	if (h>512) return false;
+	if (h>512) return -1;
 
 	startdraw = -1;
 	lendraw = 0;
@@ -518,7 +544,7 @@ bool FTexture::FindHoles(const unsigned char * buffer, int w, int h)
 					startdraw = gaps[gapc][0];
 					lendraw = y - startdraw;
 				}
-				if (gapc == 4) return false;	// too many splits - this isn't worth it
+				if (gapc == 4) return -1;	// too many splits - this isn't worth it
 			}
 			lendraw++;
 		}
@@ -539,25 +565,51 @@ bool FTexture::FindHoles(const unsigned char * buffer, int w, int h)
 		gaps[gapc][1] = lendraw;
 		gapc++;
 	}
-	if (startdraw == 0 && lendraw == h) return false;	// nothing saved so don't create a split list
+	if (startdraw == 0 && lendraw == h) return -1;	// nothing saved so don't create a split list
 
-	if (gapc > 0)
+	for (x = 0; x < gapc; x++)
 	{
-		FloatRect * rcs = new FloatRect[gapc];
+		areas[x][0] = (float)gaps[x][0] / (float)h;
+		areas[x][1] = (float)gaps[x][1] / (float)h;
+	}
+	return gapc;
+}
+
+//===========================================================================
+// 
+// Block compressed buffers skip ProcessData when they are reused, so what
+// it found out gets recorded along with them.
+//
+//===========================================================================
+
+void FTexture::GetPostProcessInfo(FPostProcessInfo &info) const
+{
+	info.Masked = bMasked;
+	info.AreaCount = areacount;
+	for (int i = 0; i < areacount; i++)
+	{
+		info.Areas[i][0] = areas[i].top;
+		info.Areas[i][1] = areas[i].height;
+	}
+}
 
-		for (x = 0; x < gapc; x++)
+void FTexture::SetPostProcessInfo(const FPostProcessInfo &info)
+{
+	bMasked = !!info.Masked;
+	if (areacount != 0 || info.AreaCount == 0) return;
+
+	areacount = MIN(info.AreaCount, 5);
+	if (areacount > 0)
+	{
+		FloatRect * rcs = new FloatRect[areacount];
+		for (int x = 0; x < areacount; x++)
 		{
-			// gaps are stored as texture (u/v) coordinates
 			rcs[x].width = rcs[x].left = -1.0f;
-			rcs[x].top = (float)gaps[x][0] / (float)h;
-			rcs[x].height = (float)gaps[x][1] / (float)h;
+			rcs[x].top = info.Areas[x][0];
+			rcs[x].height = info.Areas[x][1];
 		}
 		areas = rcs;
 	}
-	else areas = nullptr;
-	areacount = gapc;
-
-	return true;
 }
 
 //----------------------------------------------------------------------------
@@ -694,13 +746,65 @@ FTextureBuffer FTexture::CreateTexBuffer(int translation, int flags)
 	if (flags & CTF_CheckHires)
 	{
 		// No image means that this cannot be checked,
-		if (GetImage() && LoadHiresTexture(result, checkonly)) return result;
+		if (GetImage() && LoadHiresTexture(result, flags))
+		{
+			if (flags & CTF_AllowCompressed) CompressTextureBuffer(result, checkonly);
+			return result;
+		}
 	}
 	int exx = !!(flags & CTF_Expand);
 
+	// Images that already are block compressed go to the hardware as they are.
+	if ((flags & CTF_AllowCompressed) && !exx && translation <= 0 && LoadCompressedTexBuffer(result, checkonly)) return result;
+
 	W = GetWidth() + 2 * exx;
 	H = GetHeight() + 2 * exx;
 
+	// Buffers for hardware textures may come from the disk cache, already upscaled and possibly block compressed.
+	FTextureDiskCache::FKey cachekey;
+	FTextureDiskCache::FEntryInfo cacheinfo;
+	bool usecache = !checkonly && translation <= 0 && (flags & CTF_ProcessData) && FTextureDiskCache::MakeKey(this, exx, !!(flags & CTF_AllowCompressed), cachekey);
+	if (usecache && FTextureDiskCache::Load(cachekey, result, cacheinfo))
+	{
+		if (bTranslucent == -1) bTranslucent = cacheinfo.Translucent;
+
+		FContentIdBuilder builder;
+		builder.id = 0;
+		builder.imageID = GetImage()->GetId();
+		builder.expand = exx;
+		builder.scaler = cacheinfo.Scaler;
+		builder.scalefactor = cacheinfo.ScaleFactor;
+		if (result.mFormat == TBF_BGRA8)
+		{
+			// Buffers that would have been compressed are never stored uncompressed, so this is done.
+			ProcessData(result.mBuffer, result.mWidth, result.mHeight, false);
+		}
+		else
+		{
+			SetPostProcessInfo(cacheinfo.PostProcess);
+			builder.compressed = 1;
+		}
+		result.mContentId = builder.id;
+		return result;
+	}
+
+	// While precaching, the blocks may already have been encoded by the job that decoded the image.
+	if (!checkonly && translation <= 0 && exx == 0 && (flags & (CTF_ProcessData | CTF_AllowCompressed)) == (CTF_ProcessData | CTF_AllowCompressed) &&
+		FImageSource::TakePrefetchedTexBuffer(this, result, cacheinfo.Translucent, cacheinfo.PostProcess))
+	{
+		cacheinfo.Scaler = cacheinfo.ScaleFactor = 0;
+		if (bTranslucent == -1) bTranslucent = cacheinfo.Translucent;
+		SetPostProcessInfo(cacheinfo.PostProcess);
+
+		FContentIdBuilder builder;
+		builder.id = 0;
+		builder.imageID = GetImage()->GetId();
+		builder.compressed = 1;
+		result.mContentId = builder.id;
+		if (usecache) FTextureDiskCache::Store(cachekey, result, cacheinfo);
+		return result;
+	}
+
 	if (!checkonly)
 	{
 		buffer = new unsigned char[W*(H + 1) * 4];
@@ -744,12 +848,65 @@ FTextureBuffer FTexture::CreateTexBuffer(int translation, int flags)
 	if (GetImage() && flags & CTF_ProcessData) 
 	{
 		CreateUpsampledTextureBuffer(result, !!isTransparent, checkonly);
+
+		FContentIdBuilder builder;
+		builder.id = result.mContentId;
+		// Decoding a Doom format image is about as fast as reading it back, so only upscaled
+		// textures, compressed image formats and block compressed buffers are worth storing.
+		// Uncompressed buffers are stored before post-processing, which runs again after loading,
+		// block compressed ones after it because it cannot work on the blocks.
+		bool compress = (flags & CTF_AllowCompressed) && CanCompress(result);
+		bool store = usecache && (builder.scaler != 0 || compress || GetImage()->CanPrefetch());
+		cacheinfo.Translucent = isTransparent;
+		cacheinfo.Scaler = builder.scaler;
+		cacheinfo.ScaleFactor = builder.scalefactor;
+		if (store && !compress) FTextureDiskCache::Store(cachekey, result, cacheinfo);
 		if (!checkonly) ProcessData(result.mBuffer, result.mWidth, result.mHeight, false);
+		if (compress)
+		{
+			CompressTextureBuffer(result, checkonly);
+			if (store)
+			{
+				GetPostProcessInfo(cacheinfo.PostProcess);
+				FTextureDiskCache::Store(cachekey, result, cacheinfo);
+			}
+		}
 	}
 
 	return result;
 }
 
+//===========================================================================
+// 
+//	Reads the blocks of an image that is stored block compressed
+//
+//===========================================================================
+
+bool FTexture::LoadCompressedTexBuffer(FTextureBuffer &texbuffer, bool checkonly)
+{
+	auto image = GetImage();
+	int format = image == nullptr ? TBF_BGRA8 : image->GetCompressedBlocks(nullptr);
+	if (format == TBF_BGRA8) return false;
+
+	if (checkonly)
+	{
+		texbuffer.mWidth = image->GetWidth();
+		texbuffer.mHeight = image->GetHeight();
+		texbuffer.mFormat = format;
+	}
+	else if (image->GetCompressedBlocks(&texbuffer) == TBF_BGRA8)
+	{
+		return false;
+	}
+
+	FContentIdBuilder builder;
+	builder.id = 0;
+	builder.imageID = image->GetId();
+	builder.compressed = 1;
+	texbuffer.mContentId = builder.id;
+	return true;
+}
+
 //===========================================================================
 // 
 // Dummy texture for the 0-entry.
@@ -760,6 +917,13 @@ bool FTexture::GetTranslucency()
 {
 	if (bTranslucent == -1)
 	{
+		// The hardware renderer's BSP workers may get here at the same time.
+		static std::mutex mutex;
+		std::lock_guard<std::mutex> lock(mutex);
+		if (bTranslucent != -1)
+		{
+			return !!bTranslucent;
+		}
 		if (!bHasCanvas)
 		{
 			// This will calculate all we need, so just discard the result.
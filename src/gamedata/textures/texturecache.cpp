@@ -0,0 +1,379 @@
+/*
+** texturecache.cpp
+** Disk cache for decoded and upscaled textures
+**
+**---------------------------------------------------------------------------
+** Copyright 2019 GZDoom maintainers and contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** Each entry is one deflated file in <cache path>/textures, named after the
+** key. It holds either BGRA pixels or the blocks of all mip levels of a block
+** compressed buffer. The key hashes the raw lump data (still compressed for zips, so the
+** lump does not have to be unpacked just to find out that it is cached), the
+** image class, the game palette and every setting that goes into upscaling
+** and compression.
+** The cache index (see diskcache.h) tags every entry with the digest of its
+** source lump, for HasImage.
+**
+*/
+
+#include <memory>
+#include <zlib.h>
+#include <typeinfo>
+#include "texturecache.h"
+#include "textures.h"
+#include "image.h"
+#include "w_wad.h"
+#include "md5.h"
+#include "files.h"
+#include "diskcache.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "v_palette.h"
+
+CVAR(Bool, gl_texture_diskcache, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+CVAR(Int, gl_texture_diskcache_size, 1024, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// in MB
+
+EXTERN_CVAR(Bool, gl_texture_compress)
+EXTERN_CVAR(Int, gl_texture_hqresizemode)
+EXTERN_CVAR(Int, gl_texture_hqresizemult)
+EXTERN_CVAR(Int, gl_texture_hqresize_maxinputsize)
+EXTERN_CVAR(Int, gl_texture_hqresize_targets)
+EXTERN_CVAR(Int, xbrz_colorformat)
+EXTERN_CVAR(Float, xbrz_luminanceweight)
+EXTERN_CVAR(Float, xbrz_equalcolortolerance)
+EXTERN_CVAR(Float, xbrz_centerdirectionbias)
+EXTERN_CVAR(Float, xbrz_dominantdirectionthreshold)
+EXTERN_CVAR(Float, xbrz_steepdirectionthreshold)
+
+static const char CacheMagic[4] = { 'G', 'Z', 'T', 'C' };
+static const uint32_t CacheVersion = 2;
+
+static TMap<FString, int> CachedImages;
+static TMap<int, FTextureDiskCache::FDigest> ImageDigests;
+
+// Counts the cached textures of each image.
+class FTextureCacheIndex : public FDiskCacheIndex
+{
+public:
+	FTextureCacheIndex() : FDiskCacheIndex("textures", ".gztc", gl_texture_diskcache_size) {}
+
+protected:
+	void EntryAdded(const FEntry &entry) override
+	{
+		CachedImages[entry.Tag]++;
+	}
+
+	void EntryRemoved(const FEntry &entry) override
+	{
+		if (--CachedImages[entry.Tag] <= 0) CachedImages.Remove(entry.Tag);
+	}
+};
+
+static FTextureCacheIndex CacheIndex;
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static FString HexDigest(const uint8_t *digest)
+{
+	FString hex;
+	for (int i = 0; i < 16; i++) hex.AppendFormat("%02x", digest[i]);
+	return hex;
+}
+
+//==========================================================================
+//
+// Hashes the lump the image is made from, once per image.
+//
+//==========================================================================
+
+static bool GetImageDigest(FImageSource *img, uint8_t *digest)
+{
+	if (!img->IsCacheable() || img->LumpNum() < 0) return false;
+
+	auto known = ImageDigests.CheckKey(img->GetId());
+	if (known != nullptr)
+	{
+		memcpy(digest, known->Digest, 16);
+		return true;
+	}
+
+	Wads.GetLumpDigest(img->LumpNum(), digest);
+	memcpy(ImageDigests[img->GetId()].Digest, digest, 16);
+	return true;
+}
+
+//==========================================================================
+//
+// FTextureDiskCache :: MakeKey
+//
+// Only image textures whose pixels depend on nothing but the source lump
+// and the game palette can be identified by a key. For everything else
+// this returns false.
+//
+//==========================================================================
+
+bool FTextureDiskCache::MakeKey(FTexture *tex, int expand, bool allowcompressed, FKey &key)
+{
+	if (!gl_texture_diskcache || tex->GetImage() == nullptr || typeid(*tex) != typeid(FImageTexture)) return false;
+
+	if (!GetImageDigest(tex->GetImage(), key.Image)) return false;
+
+	MD5Context md5;
+	auto add = [&](const auto &value) { md5.Update((const uint8_t *)&value, sizeof(value)); };
+
+	md5.Update(key.Image, 16);
+	add(CacheVersion);
+	const char *imagetype = typeid(*tex->GetImage()).name();
+	md5.Update((const uint8_t *)imagetype, (unsigned)strlen(imagetype));
+	for (auto &pe : GPalette.BaseColors)
+	{
+		add(uint32_t(pe.d & 0xffffff));	// the alpha of the base palette is not constant.
+	}
+
+	add(tex->GetWidth());
+	add(tex->GetHeight());
+	add(expand);
+	add(tex->GetUseType());
+	add(tex->isCanvas());
+	add(tex->Scale.X >= 2 && tex->Scale.Y >= 2);
+
+	// Whether and how the texture gets upscaled.
+	add(*gl_texture_hqresizemode);
+	add(*gl_texture_hqresizemult);
+	add(*gl_texture_hqresize_maxinputsize);
+	add(*gl_texture_hqresize_targets);
+	add(*xbrz_colorformat);
+	add(*xbrz_luminanceweight);
+	add(*xbrz_equalcolortolerance);
+	add(*xbrz_centerdirectionbias);
+	add(*xbrz_dominantdirectionthreshold);
+	add(*xbrz_steepdirectionthreshold);
+
+	// Whether it gets block compressed.
+	add(allowcompressed && gl_texture_compress);
+#ifdef HAVE_MMX
+	add(true);
+#endif
+	md5.Final(key.Digest);
+	return true;
+}
+
+//==========================================================================
+//
+// FTextureDiskCache :: Load
+//
+//==========================================================================
+
+static bool ReadEntry(const FString &name, FTextureBuffer &buffer, FTextureDiskCache::FEntryInfo &info)
+{
+	FileReader fr;
+	if (!fr.OpenFile(CacheIndex.EntryPath(name))) return false;
+
+	char magic[4];
+	if (fr.Read(magic, 4) != 4 || memcmp(magic, CacheMagic, 4) || fr.ReadUInt32() != CacheVersion) return false;
+
+	int width = fr.ReadInt32();
+	int height = fr.ReadInt32();
+	info.Translucent = fr.ReadInt32();
+	info.Scaler = fr.ReadUInt8();
+	info.ScaleFactor = fr.ReadUInt8();
+	int format = fr.ReadUInt8();
+	int levels = fr.ReadUInt8();
+	info.PostProcess.Masked = fr.ReadUInt8();
+	info.PostProcess.AreaCount = (int8_t)fr.ReadUInt8();
+	for (auto &area : info.PostProcess.Areas)
+	{
+		uint32_t bits[2] = { fr.ReadUInt32(), fr.ReadUInt32() };
+		memcpy(area, bits, 8);
+	}
+	uLongf compressedsize = fr.ReadUInt32();
+	if (width <= 0 || height <= 0 || width > 16384 || height > 16384 || format > TBF_BC3 || levels < 1 || levels > 15) return false;
+	if (info.PostProcess.AreaCount > 5) return false;
+
+	TArray<uint8_t> compressed(compressedsize, true);
+	if (fr.Read(compressed.Data(), compressedsize) != (long)compressedsize) return false;
+
+	uLongf expected;
+	uint8_t *data;
+	if (format == TBF_BGRA8)
+	{
+		// The same padding row as FTexture::CreateTexBuffer adds.
+		expected = width * height * 4;
+		data = new uint8_t[width * (height + 1) * 4];
+		memset(data + expected, 0, width * 4);
+		levels = 1;
+	}
+	else
+	{
+		expected = 0;
+		for (int level = 0, w = width, h = height; level < levels; level++, w = MAX(w >> 1, 1), h = MAX(h >> 1, 1))
+		{
+			expected += GetCompressedLevelSize(format, w, h);
+		}
+		data = new uint8_t[expected];
+	}
+
+	uLongf size = expected;
+	if (uncompress(data, &size, compressed.Data(), compressedsize) != Z_OK || size != expected)
+	{
+		delete[] data;
+		return false;
+	}
+
+	if (buffer.mBuffer) delete[] buffer.mBuffer;
+	buffer.mBuffer = data;
+	buffer.mWidth = width;
+	buffer.mHeight = height;
+	buffer.mFormat = format;
+	buffer.mLevels = levels;
+	return true;
+}
+
+bool FTextureDiskCache::Load(const FKey &key, FTextureBuffer &buffer, FEntryInfo &info)
+{
+	FString name = HexDigest(key.Digest);
+	auto entry = CacheIndex.Find(name);
+	if (entry == nullptr) return false;
+
+	if (!ReadEntry(name, buffer, info))
+	{
+		// Deleted or damaged. Forget about it so that it gets stored again.
+		CacheIndex.Remove(name);
+		return false;
+	}
+	CacheIndex.Use(entry);
+	return true;
+}
+
+//==========================================================================
+//
+// FTextureDiskCache :: Store
+//
+//==========================================================================
+
+void FTextureDiskCache::Store(const FKey &key, const FTextureBuffer &buffer, const FEntryInfo &info)
+{
+	FString name = HexDigest(key.Digest);
+	if (CacheIndex.Find(name) != nullptr) return;
+
+	uLong size = 0;
+	if (buffer.mFormat == TBF_BGRA8)
+	{
+		size = buffer.mWidth * buffer.mHeight * 4;
+	}
+	else
+	{
+		for (int level = 0, w = buffer.mWidth, h = buffer.mHeight; level < buffer.mLevels; level++, w = MAX(w >> 1, 1), h = MAX(h >> 1, 1))
+		{
+			size += GetCompressedLevelSize(buffer.mFormat, w, h);
+		}
+	}
+	uLongf compressedsize = compressBound(size);
+	TArray<uint8_t> compressed(compressedsize, true);
+	// Texture data is usually consumed right away, so favor speed over size.
+	if (compress2(compressed.Data(), &compressedsize, buffer.mBuffer, size, 1) != Z_OK) return;
+
+	CacheIndex.Path(true);
+	FString path = CacheIndex.EntryPath(name);
+	std::unique_ptr<FileWriter> fw(FileWriter::Open(path));
+	if (fw == nullptr) return;
+
+	// Uncompressed buffers get post-processed again after loading, so their areas are never needed.
+	FPostProcessInfo post = {};
+	if (buffer.mFormat != TBF_BGRA8) post = info.PostProcess;
+	uint32_t areas[10];
+	for (int i = 0; i < 5; i++)
+	{
+		memcpy(&areas[i * 2], &post.Areas[i][0], 4);
+		memcpy(&areas[i * 2 + 1], &post.Areas[i][1], 4);
+	}
+	for (auto &a : areas) a = LittleLong(a);
+
+	uint32_t header[4] = { LittleLong(CacheVersion), LittleLong(uint32_t(buffer.mWidth)), LittleLong(uint32_t(buffer.mHeight)), LittleLong(uint32_t(info.Translucent)) };
+	uint8_t settings[6] = { uint8_t(info.Scaler), uint8_t(info.ScaleFactor), uint8_t(buffer.mFormat), uint8_t(buffer.mLevels), uint8_t(post.Masked), uint8_t(post.AreaCount) };
+	uint32_t csize = LittleLong(uint32_t(compressedsize));
+	bool ok = fw->Write(CacheMagic, 4) == 4 && fw->Write(header, 16) == 16 && fw->Write(settings, 6) == 6 &&
+		fw->Write(areas, 40) == 40 && fw->Write(&csize, 4) == 4 && fw->Write(compressed.Data(), compressedsize) == compressedsize;
+	fw.reset();
+	if (!ok)
+	{
+		remove(path);
+		return;
+	}
+
+	CacheIndex.Add(name, 4 + 16 + 6 + 40 + 4 + compressedsize, HexDigest(key.Image));
+	CacheIndex.Evict();
+}
+
+//==========================================================================
+//
+// FTextureDiskCache :: HasImage
+//
+// True if any texture made from this image has been cached. The
+// precacher uses this to avoid decoding images that may not be needed.
+//
+//==========================================================================
+
+bool FTextureDiskCache::HasImage(FImageSource *img)
+{
+	if (!gl_texture_diskcache) return false;
+	CacheIndex.Load();
+
+	uint8_t digest[16];
+	return CachedImages.CountUsed() > 0 && GetImageDigest(img, digest) && CachedImages.CheckKey(HexDigest(digest)) != nullptr;
+}
+
+//==========================================================================
+//
+// FTextureDiskCache :: Flush
+//
+// Writes the index. Called after precaching and on shutdown.
+//
+//==========================================================================
+
+void FTextureDiskCache::Flush()
+{
+	ImageDigests.Clear();	// the image IDs are not stable across restarts.
+	CacheIndex.Flush();
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+CCMD(cleartexturecache)
+{
+	Printf("%u textures removed from the cache\n", CacheIndex.Clear());
+	ImageDigests.Clear();
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include "textures.h"
+
+// Keeps the final, possibly upscaled or block compressed texture buffers in the cache directory
+// so that a later run can skip decoding and upscaling. Entries are named after
+// a hash of the source lump's contents and every setting that affects the
+// result, so nothing ever needs to be invalidated explicitly.
+class FTextureDiskCache
+{
+public:
+	struct FDigest
+	{
+		uint8_t Digest[16];
+	};
+
+	struct FKey
+	{
+		uint8_t Digest[16];		// the entry
+		uint8_t Image[16];		// the source lump's contents
+	};
+
+	struct FEntryInfo
+	{
+		int Translucent;
+		int Scaler;
+		int ScaleFactor;
+		FPostProcessInfo PostProcess;	// only for block compressed entries
+	};
+
+	static bool MakeKey(FTexture *tex, int expand, bool allowcompressed, FKey &key);
+	static bool Load(const FKey &key, FTextureBuffer &buffer, FEntryInfo &info);
+	static void Store(const FKey &key, const FTextureBuffer &buffer, const FEntryInfo &info);
+	static bool HasImage(FImageSource *img);
+	static void Flush();
+};
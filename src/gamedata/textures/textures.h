@@ -111,6 +111,31 @@ enum ECreateTexBufferFlags
 	CTF_Expand = 2,			// create buffer with a one-pixel wide border
 	CTF_ProcessData = 4,	// run postprocessing on the generated buffer. This is only needed when using the data for a hardware texture.
 	CTF_CheckOnly = 8,		// Only runs the code to get a content ID but does not create a texture. Can be used to access a caching system for the hardware textures.
+	CTF_AllowCompressed = 16,	// the caller can upload block compressed buffers (see ETextureBufferFormat)
+};
+
+enum ETextureBufferFormat
+{
+	TBF_BGRA8,		// 4 bytes per pixel, followed by one row of padding
+	TBF_BC1,		// 8 bytes per 4x4 block, all mip levels
+	TBF_BC2,		// 16 bytes per 4x4 block with explicit alpha, all mip levels
+	TBF_BC3,		// 16 bytes per 4x4 block with interpolated alpha, all mip levels
+};
+
+// Number of bytes one mip level of a block compressed buffer occupies.
+inline int GetCompressedLevelSize(int format, int width, int height)
+{
+	return ((width + 3) >> 2) * ((height + 3) >> 2) * (format == TBF_BC1 ? 8 : 16);
+}
+
+// What ProcessData found out about a texture. Block compressed buffers can only
+// be post-processed before they are encoded, so this travels along with them
+// when they are built on a prefetch job or read from the disk cache.
+struct FPostProcessInfo
+{
+	int Masked;
+	int AreaCount;			// as FTexture::areacount: 0 if the holes have not been searched for, -1 if there are none
+	float Areas[5][2];		// top and height of each area, in texture coordinates
 };
 
 
@@ -237,6 +262,7 @@ union FContentIdBuilder
 		unsigned expand : 1;
 		unsigned scaler : 4;
 		unsigned scalefactor : 4;
+		unsigned compressed : 1;
 	};
 };
 
@@ -245,6 +271,8 @@ struct FTextureBuffer
 	uint8_t *mBuffer = nullptr;
 	int mWidth = 0;
 	int mHeight = 0;
+	int mFormat = TBF_BGRA8;
+	int mLevels = 1;			// only block compressed buffers contain more than the first mip level
 	uint64_t mContentId = 0;	// unique content identifier. (Two images created from the same image source with the same settings will return the same value.)
 
 	FTextureBuffer() = default;
@@ -260,15 +288,20 @@ struct FTextureBuffer
 		mBuffer = other.mBuffer;
 		mWidth = other.mWidth;
 		mHeight = other.mHeight;
+		mFormat = other.mFormat;
+		mLevels = other.mLevels;
 		mContentId = other.mContentId;
 		other.mBuffer = nullptr;
 	}
 
 	FTextureBuffer& operator=(FTextureBuffer &&other)
 	{
+		if (mBuffer) delete[] mBuffer;
 		mBuffer = other.mBuffer;
 		mWidth = other.mWidth;
 		mHeight = other.mHeight;
+		mFormat = other.mFormat;
+		mLevels = other.mLevels;
 		mContentId = other.mContentId;
 		other.mBuffer = nullptr;
 		return *this;
@@ -304,6 +337,7 @@ class FTexture
 	friend class FBrightmapTexture;
 	friend class FFont;
 	friend class FSpecialFont;
+	friend class FTextureDiskCache;
 
 
 public:
@@ -312,6 +346,9 @@ public:
 	virtual FImageSource *GetImage() const { return nullptr; }
 	void AddAutoMaterials();
 	void CreateUpsampledTextureBuffer(FTextureBuffer &texbuffer, bool hasAlpha, bool checkonly);
+	void CompressTextureBuffer(FTextureBuffer &texbuffer, bool checkonly);
+	bool CanCompressOnPrefetch(int &translucent, FPostProcessInfo &info, bool &findholes);
+	static void CreatePrefetchedTexBuffer(const FBitmap &pixels, int trans, bool findholes, FTextureBuffer &texbuffer, int &translucent, FPostProcessInfo &info);
 
 	// These are mainly meant for 2D code which only needs logical information about the texture to position it properly.
 	int GetDisplayWidth() { return GetScaledWidth(); }
@@ -352,6 +389,9 @@ public:
 	bool isFullbright() const { return bFullbright; }
 	void CreateDefaultBrightmap();
 	bool FindHoles(const unsigned char * buffer, int w, int h);
+	static int FindHoleAreas(const unsigned char * buffer, int w, int h, float areas[5][2]);
+	void GetPostProcessInfo(FPostProcessInfo &info) const;
+	void SetPostProcessInfo(const FPostProcessInfo &info);
 	void SetUseType(ETextureType type) { UseType = type; }
 	ETextureType GetUseType() const { return UseType; }
 
@@ -504,7 +544,10 @@ public:
 private:
 	int CheckDDPK3();
 	int CheckExternalFile(bool & hascolorkey);
-	bool LoadHiresTexture(FTextureBuffer &texbuffer, bool checkonly);
+	bool LoadHiresTexture(FTextureBuffer &texbuffer, int flags);
+	bool LoadCompressedTexBuffer(FTextureBuffer &texbuffer, bool checkonly);
+	bool CanCompress(const FTextureBuffer &texbuffer) const;
+	static void EncodeTextureBuffer(FTextureBuffer &texbuffer);
 
 	bool bSWSkyColorDone = false;
 	PalEntry FloorSkyColor;
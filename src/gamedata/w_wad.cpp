@@ -44,6 +44,7 @@
 #include "m_argv.h"
 #include "cmdlib.h"
 #include "c_dispatch.h"
+#include "c_cvars.h"
 #include "w_wad.h"
 #include "m_crc32.h"
 #include "v_text.h"
@@ -79,6 +80,10 @@ static void PrintLastError ();
 
 FWadCollection Wads;
 
+// Map archives into memory instead of reading them. Uncompressed lumps are
+// then accessed in place. Only affects files opened after it was changed.
+CVAR(Bool, file_mmap, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
 // PRIVATE DATA DEFINITIONS ------------------------------------------------
 
 // CODE --------------------------------------------------------------------
@@ -220,7 +225,7 @@ void FWadCollection::AddFile (const char *filename, FileReader *wadr)
 
 		if (!isdir)
 		{
-			if (!wadreader.OpenFile(filename))
+			if (!(file_mmap && wadreader.OpenFileMapped(filename)) && !wadreader.OpenFile(filename))
 			{ // Didn't find file
 				Printf (TEXTCOLOR_RED "%s: File not found\n", filename);
 				PrintLastError ();
@@ -1425,6 +1430,13 @@ unsigned FWadCollection::GetLumpsInFolder(const char *inpath, TArray<FolderEntry
 
 void FWadCollection::ReadLump (int lump, void *dest)
 {
+	auto view = LumpView(lump);
+	if (view != nullptr)
+	{
+		memcpy(dest, view, LumpInfo[lump].lump->LumpSize);
+		return;
+	}
+
 	auto lumpr = OpenLumpReader (lump);
 	auto size = lumpr.GetLength ();
 	auto numread = lumpr.Read (dest, size);
@@ -1481,6 +1493,55 @@ DEFINE_ACTION_FUNCTION(_Wads, ReadLump)
 	ACTION_RETURN_STRING(isLumpValid ? Wads.ReadLump(lump).GetString() : FString());
 }
 
+//==========================================================================
+//
+// LumpView
+//
+// Gives direct access to a lump of a memory mapped file. Compressed or
+// encrypted lumps and those of files that are read normally return NULL,
+// callers then have to use one of the functions above.
+//
+//==========================================================================
+
+const void *FWadCollection::LumpView(int lump)
+{
+	if ((unsigned)lump >= (unsigned)LumpInfo.Size())
+	{
+		I_Error("LumpView: %u >= NumLumps", lump);
+	}
+	return LumpInfo[lump].lump->GetView();
+}
+
+//==========================================================================
+//
+// GetLumpDigest
+//
+// Hashes the lump the way it is stored in its file. Mapped lumps are hashed
+// in place, compressed ones without unpacking them. The storage method is
+// part of the hash so that the same data stored differently never matches.
+//
+//==========================================================================
+
+void FWadCollection::GetLumpDigest(int lump, uint8_t *digest)
+{
+	MD5Context md5;
+	auto view = (const uint8_t *)LumpView(lump);
+	if (view != nullptr)
+	{
+		int method = METHOD_STORED;	// same as what GetRawData would return.
+		md5.Update((const uint8_t *)&method, sizeof(method));
+		md5.Update(view, LumpLength(lump));
+	}
+	else
+	{
+		auto raw = LumpInfo[lump].lump->GetRawData();
+		md5.Update((const uint8_t *)&raw.mMethod, sizeof(raw.mMethod));
+		md5.Update((const uint8_t *)raw.mBuffer, raw.mCompressedSize);
+		raw.Clean();
+	}
+	md5.Final(digest);
+}
+
 //==========================================================================
 //
 // OpenLumpReader
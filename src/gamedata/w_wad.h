@@ -162,6 +162,9 @@ public:
 	FMemLump ReadLump (int lump);
 	FMemLump ReadLump (const char *name) { return ReadLump (GetNumForName (name)); }
 
+	const void *LumpView(int lump);	// read-only pointer into the containing file's buffer, NULL if the lump needs to be copied.
+	void GetLumpDigest(int lump, uint8_t *digest);	// MD5 of the lump as it is stored, so compressed lumps do not need unpacking.
+
 	FileReader OpenLumpReader(int lump);		// opens a reader that redirects to the containing file's one.
 	FileReader ReopenLumpReader(int lump, bool alwayscache = false);		// opens an independent reader.
 
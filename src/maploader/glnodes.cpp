@@ -60,9 +60,14 @@
 #include "g_levellocals.h"
 #include "i_time.h"
 #include "maploader.h"
+#include "g_game.h"
+#include "v_text.h"
+#include "jobsystem.h"
+#include "stats.h"
 
 EXTERN_CVAR(Bool, gl_cachenodes)
 EXTERN_CVAR(Float, gl_cachetime)
+EXTERN_CVAR(Bool, nodebuilder_mt)
 
 // fixed 32 bit gl_vert format v2.0+ (glBsp 1.91)
 struct mapglvertex_t
@@ -997,7 +1002,7 @@ bool MapLoader::CheckNodes(MapData * map, bool rebuilt, int buildtime)
 typedef TArray<uint8_t> MemFile;
 
 
-static FString CreateCacheName(MapData *map, bool create)
+static FString CreateCacheName(MapData *map, bool create, const char *ext = ".gzc")
 {
 	FString path = M_GetCachePath(create);
 	FString lumpname = Wads.GetLumpFullPath(map->lumpnum);
@@ -1007,7 +1012,7 @@ static FString CreateCacheName(MapData *map, bool create)
 
 	lumpname.ReplaceChars('/', '%');
 	lumpname.ReplaceChars(':', '$');
-	path << '/' << lumpname.Right(lumpname.Len() - separator - 1) << ".gzc";
+	path << '/' << lumpname.Right(lumpname.Len() - separator - 1) << ext;
 	return path;
 }
 
@@ -1196,6 +1201,83 @@ bool MapLoader::CheckCachedNodes(MapData *map)
 	return true;
 }
 
+//==========================================================================
+//
+// Generated rejects are cached next to the nodes. The file holds the sector
+// count and the map's checksum followed by the compressed matrix.
+//
+//==========================================================================
+
+void MapLoader::CreateCachedReject(MapData *map)
+{
+	uLongf outlen = compressBound(Level->rejectmatrix.Size());
+	TArray<Bytef> compressed;
+	const int offset = 4 + 4 + 16;
+
+	compressed.Resize(outlen + offset);
+	if (compress(compressed.Data() + offset, &outlen, Level->rejectmatrix.Data(), Level->rejectmatrix.Size()) != Z_OK)
+	{
+		return;
+	}
+
+	memcpy(compressed.Data(), "REJC", 4);
+	uint32_t len = LittleLong(Level->sectors.Size());
+	memcpy(&compressed[4], &len, 4);
+	map->GetChecksum(&compressed[8]);
+
+	FString path = CreateCacheName(map, true, ".gzr");
+	FileWriter *fw = FileWriter::Open(path);
+
+	if (fw != nullptr)
+	{
+		const size_t length = outlen + offset;
+		if (fw->Write(compressed.Data(), length) != length)
+		{
+			Printf("Error saving reject to file %s\n", path.GetChars());
+		}
+		delete fw;
+	}
+	else
+	{
+		Printf("Cannot open reject file %s for writing\n", path.GetChars());
+	}
+}
+
+bool MapLoader::CheckCachedReject(MapData *map)
+{
+	char magic[4] = {0,0,0,0};
+	uint8_t md5[16];
+	uint8_t md5map[16];
+	uint32_t numsec;
+
+	FString path = CreateCacheName(map, false, ".gzr");
+	FileReader fr;
+
+	if (!fr.OpenFile(path)) return false;
+
+	if (fr.Read(magic, 4) != 4) return false;
+	if (memcmp(magic, "REJC", 4))  return false;
+
+	if (fr.Read(&numsec, 4) != 4) return false;
+	numsec = LittleLong(numsec);
+	if (numsec != Level->sectors.Size()) return false;
+
+	if (fr.Read(md5, 16) != 16) return false;
+	map->GetChecksum(md5map);
+	if (memcmp(md5, md5map, 16)) return false;
+
+	auto data = fr.Read();
+	uLongf rejectsize = (numsec * numsec + 7) / 8;
+	Level->rejectmatrix.Resize(rejectsize);
+	if (uncompress(Level->rejectmatrix.Data(), &rejectsize, data.Data(), data.Size()) != Z_OK ||
+		rejectsize != Level->rejectmatrix.Size())
+	{
+		Level->rejectmatrix.Reset();
+		return false;
+	}
+	return true;
+}
+
 UNSAFE_CCMD(clearnodecache)
 {
 	TArray<FFileList> list;
@@ -1225,6 +1307,64 @@ UNSAFE_CCMD(clearnodecache)
 		
 }
 
+//==========================================================================
+//
+// Rebuilds the current map's nodes without touching the level, once with
+// nodebuilder_mt off and once with it on, and prints the wall time of both.
+// The checksums must match since threading only affects how the splitter
+// candidates get scored.
+//
+//==========================================================================
+
+static double BenchNodeBuild(FLevelLocals *Level, int passes, uint32_t &checksum)
+{
+	cycle_t timer;
+	timer.Reset();
+	for (int i = 0; i < passes; i++)
+	{
+		// The node builder rewrites the lines' vertex pointers into indices.
+		TArray<line_t> lines = Level->lines;
+		TArray<FNodeBuilder::FPolyStart> polyspots, anchors;
+		FNodeBuilder::FLevel leveldata =
+		{
+			&Level->vertexes[0], (int)Level->vertexes.Size(),
+			&Level->sides[0], (int)Level->sides.Size(),
+			&lines[0], (int)lines.Size(),
+			0, 0, 0, 0
+		};
+		leveldata.FindMapBounds();
+
+		timer.Clock();
+		FNodeBuilder builder(leveldata, polyspots, anchors, true);
+		timer.Unclock();
+		checksum = builder.Checksum();
+	}
+	return timer.TimeMS() / passes;
+}
+
+CCMD(benchnodes)
+{
+	if (gamestate != GS_LEVEL)
+	{
+		Printf("Not in a level\n");
+		return;
+	}
+
+	int passes = argv.argc() > 1 ? MAX(1, atoi(argv[1])) : 3;
+	bool threaded = nodebuilder_mt;
+	uint32_t serialsum, threadedsum;
+
+	nodebuilder_mt = false;
+	double serial = BenchNodeBuild(primaryLevel, passes, serialsum);
+	nodebuilder_mt = true;
+	double parallel = BenchNodeBuild(primaryLevel, passes, threadedsum);
+	nodebuilder_mt = threaded;
+
+	Printf("%s: %u lines, %d passes\n", primaryLevel->MapName.GetChars(), primaryLevel->lines.Size(), passes);
+	Printf("serial %.3f ms, threaded %.3f ms (%d threads), %.2fx%s\n", serial, parallel, FJobSystem::NumThreads(),
+		parallel > 0 ? serial / parallel : 0., serialsum == threadedsum ? "" : TEXTCOLOR_RED " - trees differ!");
+}
+
 //==========================================================================
 //
 // Keep both the original nodes from the WAD and the GL nodes created here.
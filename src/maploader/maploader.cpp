@@ -2660,8 +2660,7 @@ void MapLoader::LoadBlockMap (MapData * map)
 
 	// clear out mobj chains
 	count = Level->blockmap.bmapwidth*Level->blockmap.bmapheight;
-	Level->blockmap.blocklinks = new FBlockNode *[count];
-	memset (Level->blockmap.blocklinks, 0, count*sizeof(*Level->blockmap.blocklinks));
+	Level->blockmap.blocklinks = new FBlockLinks[count];
 	Level->blockmap.blockmap = Level->blockmap.blockmaplump+4;
 }
 
@@ -2830,6 +2829,7 @@ void MapLoader::LoadReject (MapData * map, bool junk)
 				neededsize-rejectsize==1?"":"s");
 		}
 		Level->rejectmatrix.Reset();
+		RejectPending = true;
 	}
 	else
 	{
@@ -2861,8 +2861,10 @@ void MapLoader::LoadReject (MapData * map, bool junk)
 				return;
 		}
 
-		// Reject has no data, so pretend it isn't there.
+		// Reject has no data, so pretend it isn't there and generate one
+		// once portals and polyobjects are known.
 		Level->rejectmatrix.Reset();
+		RejectPending = true;
 	}
 }
 
@@ -3257,7 +3259,10 @@ void MapLoader::LoadLevel(MapData *map, const char *lumpname, int position)
 
 	InitRenderInfo();				// create hardware independent renderer resources for the level. This must be done BEFORE the PolyObj Spawn!!!
 	Level->ClearDynamic3DFloorData();	// CreateVBO must be run on the plain 3D floor data.
-	screen->mVertexData->CreateVBO(Level->sectors);
+	if (screen->mVertexData != nullptr)	// not present with the null video backend
+	{
+		screen->mVertexData->CreateVBO(Level->sectors);
+	}
 
 	for (auto &sec : Level->sectors)
 	{
@@ -3272,5 +3277,6 @@ void MapLoader::LoadLevel(MapData *map, const char *lumpname, int position)
 	PO_Init();				// Initialize the polyobjs
 	if (!Level->IsReentering())
 		Level->FinalizePortals();	// finalize line portals after polyobjects have been initialized. This info is needed for properly flagging them.
+	if (RejectPending) BuildReject(map);
 }
 
@@ -115,6 +115,7 @@ private:
 	TMap<unsigned, unsigned>  MapThingsUserDataIndex;	// from mapthing idx -> user data idx
 	TArray<FUDMFKey> MapThingsUserData;
 	int sidecount = 0;
+	bool RejectPending = false;	// the map has no usable REJECT lump
 	TArray<int>		linemap;
 	TArray<sidei_t> sidetemp;
 public:	// for the scripted compatibility system these two members need to be public.
@@ -166,6 +167,7 @@ private:
 	bool LoadNodes(FileReader &lump);
 	bool DoLoadGLNodes(FileReader * lumps);
 	void CreateCachedNodes(MapData *map);
+	void CreateCachedReject(MapData *map);
 
 	// Render info
 	void PrepareSectorData();
@@ -280,6 +282,8 @@ public:
 	template<class nodetype, class subsectortype> bool LoadNodes(MapData * map);
 	bool LoadGLNodes(MapData * map);
 	bool CheckCachedNodes(MapData *map);
+	bool CheckCachedReject(MapData *map);
+	void BuildReject(MapData *map);
 	bool CheckNodes(MapData * map, bool rebuilt, int buildtime);
 	bool CheckForGLNodes();
 
@@ -0,0 +1,572 @@
+/*
+** reject.cpp
+** Builds a REJECT matrix for maps that come without one
+**
+**---------------------------------------------------------------------------
+** Copyright 2019 GZDoom maintainers and contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** A sight trace is blocked by the first one-sided line it crosses, so two
+** sectors can only see each other if a straight line leaves the first one
+** and reaches the second one through two-sided lines alone. For every
+** sector this follows the two-sided lines outward in 2D, narrowing the set
+** of possible lines at each step, the same way portal flow works for a
+** PVS. Heights, doors and lifts are ignored, so the result only ever says
+** 'cannot see' when no movement in the map could change that.
+**
+** The result depends on sectors being closed and not overlapping. Maps
+** where this is not the case, or where lines reference the same sector on
+** both sides, are left without a reject.
+**
+*/
+
+#include <algorithm>
+#include "templates.h"
+#include "doomstat.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "g_levellocals.h"
+#include "maploader.h"
+#include "parallel_for.h"
+#include "memarena.h"
+#include "i_time.h"
+
+// Sight checks against an invisible target consume a random number after the
+// reject check, so this changes the random sequence. As a server setting it
+// is stored in demos; older demos are played back with it off.
+CVAR(Bool, genreject, true, CVAR_SERVERINFO | CVAR_GLOBALCONFIG)
+
+EXTERN_CVAR(Bool, gl_cachenodes)
+EXTERN_CVAR(Float, gl_cachetime)
+
+namespace
+{
+	const double EPSILON = 1 / 256.;
+	const double PORTAL_EXTEND = 1 / 16.;
+
+	// Past these a sector is assumed to see everything it is connected to.
+	const int MAX_FLOW_STEPS = 65536;
+	const int MAX_FLOW_DEPTH = 512;
+
+	struct FRejectSeg
+	{
+		DVector2 v1, v2;
+	};
+
+	// One direction of a two-sided line.
+	struct FRejectPortal
+	{
+		FRejectSeg Seg;
+		DVector2 Normal;	// points into Sector
+		double Dist;
+		int Line;
+		int Sector;			// the sector this portal leads into
+	};
+
+	//==========================================================================
+	//
+	// Keeps the part of seg on the positive side of the plane. With 'cross'
+	// a part lying on the plane itself does not count, since a line cannot
+	// pass through a portal that is collinear with the previous one.
+	//
+	//==========================================================================
+
+	bool ClipToPlane(FRejectSeg &seg, const DVector2 &normal, double dist, bool cross)
+	{
+		double d1 = (normal | seg.v1) - dist;
+		double d2 = (normal | seg.v2) - dist;
+		double limit = cross ? EPSILON : -EPSILON;
+
+		if (d1 < limit && d2 < limit)
+		{
+			return false;
+		}
+		if (d1 < -EPSILON)
+		{
+			seg.v1 = seg.v1 + (seg.v2 - seg.v1) * ((d1 + EPSILON) / (d1 - d2));
+		}
+		else if (d2 < -EPSILON)
+		{
+			seg.v2 = seg.v2 + (seg.v1 - seg.v2) * ((d2 + EPSILON) / (d2 - d1));
+		}
+		return true;
+	}
+
+	//==========================================================================
+	//
+	// Clips target to where a line through source and then pass can go.
+	// That area is bounded by the lines through one end of each which have
+	// the other ends on opposite sides. Degenerate cases are skipped, which
+	// only ever keeps more of the target.
+	//
+	//==========================================================================
+
+	bool ClipToSeparators(const FRejectSeg &source, const FRejectSeg &pass, FRejectSeg &target)
+	{
+		const DVector2 *src[2] = { &source.v1, &source.v2 };
+		const DVector2 *pas[2] = { &pass.v1, &pass.v2 };
+
+		for (int i = 0; i < 2; i++)
+		{
+			for (int j = 0; j < 2; j++)
+			{
+				DVector2 dir = *pas[j] - *src[i];
+				double len = dir.Length();
+				if (len < EPSILON)
+				{
+					continue;
+				}
+				DVector2 normal(-dir.Y / len, dir.X / len);
+				double dist = normal | *src[i];
+				double sside = (normal | *src[1 - i]) - dist;
+				double pside = (normal | *pas[1 - j]) - dist;
+
+				if (pside > EPSILON && sside < -EPSILON)
+				{
+					if (!ClipToPlane(target, normal, dist, false)) return false;
+				}
+				else if (pside < -EPSILON && sside > EPSILON)
+				{
+					if (!ClipToPlane(target, -normal, -dist, false)) return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// State of the sector one thread is working on.
+	struct FFlowState
+	{
+		uint8_t *Visible;
+		int Steps;
+	};
+
+	class FRejectBuilder
+	{
+	public:
+		FRejectBuilder(FLevelLocals *level, int maxsteps = MAX_FLOW_STEPS) : Level(level), MaxFlowSteps(maxsteps) {}
+		bool Build(TArray<uint8_t> &reject);
+
+	private:
+		bool CollectPortals();
+		void BuildSector(int sector, uint8_t *visible);
+		void Flow(FFlowState &state, const FRejectSeg &source, const FRejectPortal &sp, const FRejectSeg &pass, const FRejectPortal &pp, int depth);
+		void Flood(int sector, uint8_t *visible);
+
+		FLevelLocals *Level;
+		int MaxFlowSteps;
+		TArray<FRejectPortal> Portals;
+		TArray<TArray<int>> SectorPortals;	// portals leading out of each sector
+	};
+}
+
+//==========================================================================
+//
+// FRejectBuilder :: CollectPortals
+//
+// Also checks that every sector is closed: around each vertex a sector must
+// have as many sides leading in as leading out.
+//
+//==========================================================================
+
+bool FRejectBuilder::CollectPortals()
+{
+	struct FVertexUse
+	{
+		int Sector;
+		int X, Y;
+		int Delta;
+
+		bool operator<(const FVertexUse &other) const
+		{
+			if (Sector != other.Sector) return Sector < other.Sector;
+			if (X != other.X) return X < other.X;
+			return Y < other.Y;
+		}
+	};
+	TArray<FVertexUse> uses;
+
+	SectorPortals.Resize(Level->sectors.Size());
+	for (auto &line : Level->lines)
+	{
+		sector_t *front = line.frontsector;
+		sector_t *back = line.backsector;
+		if (front == nullptr || front == back)
+		{
+			return false;
+		}
+
+		int fs = int(front - &Level->sectors[0]);
+		uses.Push({ fs, line.v1->fixX(), line.v1->fixY(), 1 });
+		uses.Push({ fs, line.v2->fixX(), line.v2->fixY(), -1 });
+		if (back == nullptr)
+		{
+			continue;
+		}
+		int bs = int(back - &Level->sectors[0]);
+		uses.Push({ bs, line.v2->fixX(), line.v2->fixY(), 1 });
+		uses.Push({ bs, line.v1->fixX(), line.v1->fixY(), -1 });
+
+		DVector2 dir = line.v2->fPos() - line.v1->fPos();
+		double len = dir.Length();
+		if (len < EPSILON)
+		{
+			continue;
+		}
+		dir /= len;
+
+		// Made a bit longer so that lines passing exactly through a vertex are not lost.
+		FRejectSeg seg = { line.v1->fPos() - dir * PORTAL_EXTEND, line.v2->fPos() + dir * PORTAL_EXTEND };
+		DVector2 toback(-dir.Y, dir.X);
+		int index = int(&line - &Level->lines[0]);
+
+		SectorPortals[fs].Push(Portals.Size());
+		Portals.Push({ seg, toback, toback | seg.v1, index, bs });
+		SectorPortals[bs].Push(Portals.Size());
+		Portals.Push({ seg, -toback, -toback | seg.v1, index, fs });
+	}
+
+	std::sort(uses.begin(), uses.end());
+	for (unsigned i = 0; i < uses.Size();)
+	{
+		int balance = 0;
+		unsigned j = i;
+		for (; j < uses.Size() && !(uses[i] < uses[j]); j++)
+		{
+			balance += uses[j].Delta;
+		}
+		if (balance != 0)
+		{
+			return false;
+		}
+		i = j;
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// FRejectBuilder :: Flow
+//
+// A line that came through source and pass continues into the sector
+// behind pass. Every portal out of that sector which such a line can still
+// reach is visible and narrows the set further.
+//
+//==========================================================================
+
+void FRejectBuilder::Flow(FFlowState &state, const FRejectSeg &source, const FRejectPortal &sp, const FRejectSeg &pass, const FRejectPortal &pp, int depth)
+{
+	if (++state.Steps > MaxFlowSteps || depth > MAX_FLOW_DEPTH)
+	{
+		state.Steps = MaxFlowSteps + 1;
+		return;
+	}
+
+	for (int q : SectorPortals[pp.Sector])
+	{
+		const FRejectPortal &qp = Portals[q];
+		if (qp.Line == pp.Line || qp.Line == sp.Line)
+		{
+			continue;
+		}
+
+		FRejectSeg target = qp.Seg;
+		if (!ClipToPlane(target, pp.Normal, pp.Dist, true) ||
+			!ClipToPlane(target, sp.Normal, sp.Dist, true) ||
+			!ClipToSeparators(source, pass, target))
+		{
+			continue;
+		}
+		state.Visible[qp.Sector] = 1;
+
+		// Only the part of the source that can see the target through pass matters from here on.
+		FRejectSeg newsource = source;
+		if (!ClipToSeparators(target, pass, newsource))
+		{
+			continue;
+		}
+		Flow(state, newsource, sp, target, qp, depth + 1);
+		if (state.Steps > MaxFlowSteps)
+		{
+			return;
+		}
+	}
+}
+
+//==========================================================================
+//
+// FRejectBuilder :: Flood
+//
+// Fallback for sectors where the flow took too long. Everything the flow
+// marked so far is dropped: a marked sector never gets expanded, so the
+// sectors only reachable through it would stay rejected.
+//
+//==========================================================================
+
+void FRejectBuilder::Flood(int sector, uint8_t *visible)
+{
+	memset(visible, 0, Level->sectors.Size());
+
+	// Every sector gets pushed at most once.
+	int *stack = (int *)FJobSystem::Scratch().Alloc(Level->sectors.Size() * sizeof(int));
+	int top = 0;
+	stack[top++] = sector;
+	visible[sector] = 1;
+	while (top > 0)
+	{
+		int sec = stack[--top];
+		for (int p : SectorPortals[sec])
+		{
+			int next = Portals[p].Sector;
+			if (!visible[next])
+			{
+				visible[next] = 1;
+				stack[top++] = next;
+			}
+		}
+	}
+}
+
+//==========================================================================
+//
+// FRejectBuilder :: BuildSector
+//
+//==========================================================================
+
+void FRejectBuilder::BuildSector(int sector, uint8_t *visible)
+{
+	FFlowState state = { visible, 0 };
+	visible[sector] = 1;
+
+	for (int s : SectorPortals[sector])
+	{
+		const FRejectPortal &sp = Portals[s];
+		visible[sp.Sector] = 1;
+
+		for (int p : SectorPortals[sp.Sector])
+		{
+			const FRejectPortal &pp = Portals[p];
+			if (pp.Line == sp.Line)
+			{
+				continue;
+			}
+			FRejectSeg pass = pp.Seg;
+			if (!ClipToPlane(pass, sp.Normal, sp.Dist, true))
+			{
+				continue;
+			}
+			visible[pp.Sector] = 1;
+			Flow(state, sp.Seg, sp, pass, pp, 1);
+			if (state.Steps > MaxFlowSteps)
+			{
+				Flood(sector, visible);
+				return;
+			}
+		}
+	}
+}
+
+//==========================================================================
+//
+// FRejectBuilder :: Build
+//
+// A sector pair is rejected if neither can see the other.
+//
+//==========================================================================
+
+bool FRejectBuilder::Build(TArray<uint8_t> &reject)
+{
+	if (!CollectPortals())
+	{
+		return false;
+	}
+
+	const int numsectors = Level->sectors.Size();
+	const int rowbytes = (numsectors + 7) >> 3;
+	TArray<uint8_t> rows(numsectors * rowbytes, true);
+	memset(rows.Data(), 0, rows.Size());
+
+	const int step = 16;
+	parallel_for(0, numsectors, step, [&](int first)
+	{
+		uint8_t *visible = (uint8_t *)FJobSystem::Scratch().Alloc(numsectors);
+		for (int sec = first; sec < MIN(first + step, numsectors); sec++)
+		{
+			memset(visible, 0, numsectors);
+			BuildSector(sec, visible);
+
+			uint8_t *row = &rows[sec * rowbytes];
+			for (int i = 0; i < numsectors; i++)
+			{
+				if (visible[i]) row[i >> 3] |= 1 << (i & 7);
+			}
+		}
+	});
+
+	reject.Resize((numsectors * numsectors + 7) >> 3);
+	memset(reject.Data(), 0, reject.Size());
+	for (int a = 0; a < numsectors; a++)
+	{
+		for (int b = 0; b < numsectors; b++)
+		{
+			if (!(rows[a * rowbytes + (b >> 3)] & (1 << (b & 7))) && !(rows[b * rowbytes + (a >> 3)] & (1 << (a & 7))))
+			{
+				int pnum = a * numsectors + b;
+				reject[pnum >> 3] |= 1 << (pnum & 7);
+			}
+		}
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// Sight checks pass through linked portals and around polyobjects, neither
+// of which the builder knows about. Line portals count even when they are
+// not linked, since scripts can retarget them with Line_SetPortalTarget.
+//
+//==========================================================================
+
+static bool HasPortalsOrPolyobjects(FLevelLocals *Level)
+{
+	if (Level->linePortals.Size() > 0 || Level->Polyobjects.Size() > 0 || Level->Displacements.size > 1)
+	{
+		return true;
+	}
+	for (auto &portal : Level->sectorPortals)
+	{
+		if (portal.mType == PORTS_LINKEDPORTAL)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//==========================================================================
+//
+// MapLoader :: BuildReject
+//
+// Called at the end of loading a map that has no usable REJECT lump, once
+// portals and polyobjects are set up.
+//
+//==========================================================================
+
+void MapLoader::BuildReject(MapData *map)
+{
+	Level->rejectmatrix.Reset();
+	if (!genreject || Level->sectors.Size() == 0)
+	{
+		return;
+	}
+	if (HasPortalsOrPolyobjects(Level))
+	{
+		DPrintf(DMSG_NOTIFY, "Not building a REJECT for a map with portals or polyobjects\n");
+		return;
+	}
+	if (CheckCachedReject(map))
+	{
+		return;
+	}
+
+	uint64_t startTime = I_msTime();
+	FRejectBuilder builder(Level);
+	if (!builder.Build(Level->rejectmatrix))
+	{
+		DPrintf(DMSG_NOTIFY, "Map geometry is not suitable for building a REJECT\n");
+		Level->rejectmatrix.Reset();
+		return;
+	}
+	uint64_t buildTime = I_msTime() - startTime;
+	DPrintf(DMSG_NOTIFY, "REJECT generation took %.3f sec\n", buildTime * 0.001);
+
+	if (gl_cachenodes && buildTime / 1000.f >= gl_cachetime)
+	{
+		CreateCachedReject(map);
+	}
+}
+
+//==========================================================================
+//
+// CCMD rejecttest
+//
+// Builds a REJECT for the current map with a flow that gives up at once,
+// so every sector falls back to the flood fill. The result must reject
+// exactly the sector pairs that are not connected.
+//
+//==========================================================================
+
+CCMD(rejecttest)
+{
+	auto Level = primaryLevel;
+	const int numsectors = Level->sectors.Size();
+	if (numsectors == 0)
+	{
+		Printf("rejecttest: no map loaded\n");
+		return;
+	}
+
+	FRejectBuilder builder(Level, 0);
+	TArray<uint8_t> reject;
+	if (!builder.Build(reject))
+	{
+		Printf("rejecttest: cannot build a reject for this map\n");
+		return;
+	}
+
+	// Sectors are connected if a chain of two-sided lines leads from one to the other.
+	TArray<int> group(numsectors, true);
+	for (int i = 0; i < numsectors; i++) group[i] = i;
+	auto find = [&](int sec)
+	{
+		while (group[sec] != sec) sec = group[sec] = group[group[sec]];
+		return sec;
+	};
+	for (auto &line : Level->lines)
+	{
+		if (line.backsector != nullptr)
+		{
+			group[find(line.frontsector->Index())] = find(line.backsector->Index());
+		}
+	}
+
+	int mismatches = 0;
+	for (int a = 0; a < numsectors; a++)
+	{
+		for (int b = 0; b < numsectors; b++)
+		{
+			int pnum = a * numsectors + b;
+			bool rejected = !!(reject[pnum >> 3] & (1 << (pnum & 7)));
+			if (rejected != (find(a) != find(b)) && mismatches++ < 10)
+			{
+				Printf("rejecttest: MISMATCH, sector %d %s sector %d\n", a, rejected ? "cannot see connected" : "can see unconnected", b);
+			}
+		}
+	}
+	if (mismatches == 0) Printf("rejecttest: all %d sectors match the reference\n", numsectors);
+	else Printf("rejecttest: %d sector pairs differ from the reference\n", mismatches);
+}
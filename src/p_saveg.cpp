@@ -60,8 +60,12 @@
 #include "version.h"
 #include "fragglescript/t_script.h"
 #include "s_music.h"
+#include "c_dispatch.h"
+#include "stats.h"
+#include "g_game.h"
 
 EXTERN_CVAR(Bool, save_formatted)
+EXTERN_CVAR(Bool, save_binary)
 
 //==========================================================================
 //
@@ -1063,10 +1067,11 @@ void FLevelLocals::Serialize(FSerializer &arc, bool hubload)
 //==========================================================================
 //
 // Archives the current level
+// Savegames compress the snapshot later on their worker thread.
 //
 //==========================================================================
 
-void FLevelLocals::SnapshotLevel()
+void FLevelLocals::SnapshotLevel(bool compress)
 {
 	info->Snapshot.Clean();
 
@@ -1074,11 +1079,11 @@ void FLevelLocals::SnapshotLevel()
 	{
 		FSerializer arc(this);
 
-		if (arc.OpenWriter(save_formatted))
+		if (save_binary && !save_formatted ? arc.OpenBinaryWriter() : arc.OpenWriter(save_formatted))
 		{
 			SaveVersion = SAVEVER;
 			Serialize(arc, false);
-			info->Snapshot = arc.GetCompressedOutput();
+			info->Snapshot = compress ? arc.GetCompressedOutput() : arc.GetStoredOutput();
 		}
 	}
 }
@@ -1143,3 +1148,58 @@ void FLevelLocals::UnSnapshotLevel(bool hubLoad)
 	}
 }
 
+//==========================================================================
+//
+// benchsave [count]
+//
+// Snapshots the current level with both savegame formats and reads the
+// result back in. Only the reading of the document is timed because
+// restoring the level from it is the same for both.
+//
+//==========================================================================
+
+CCMD(benchsave)
+{
+	if (gamestate != GS_LEVEL || !primaryLevel->info->isValid())
+	{
+		Printf("benchsave can only be used inside a level\n");
+		return;
+	}
+	int count = argv.argc() > 1 ? clamp(atoi(argv[1]), 1, 1000) : 10;
+
+	for (int binary = 0; binary < 2; binary++)
+	{
+		cycle_t writetime, readtime;
+		writetime.Reset();
+		readtime.Reset();
+		unsigned size = 0, compressedsize = 0;
+
+		for (int i = 0; i < count; i++)
+		{
+			FCompressedBuffer buffer;
+			{
+				FSerializer arc(primaryLevel);
+				writetime.Clock();
+				if (binary) arc.OpenBinaryWriter();
+				else arc.OpenWriter(false);
+				SaveVersion = SAVEVER;
+				primaryLevel->Serialize(arc, false);
+				buffer = arc.GetCompressedOutput();
+				writetime.Unclock();
+			}
+			size = buffer.mSize;
+			compressedsize = buffer.mCompressedSize;
+			{
+				FSerializer arc(primaryLevel);
+				readtime.Clock();
+				arc.OpenReader(&buffer);
+				arc.Close();
+				readtime.Unclock();
+			}
+			buffer.Clean();
+		}
+		Printf("%-6s: write %.2f ms, read %.2f ms, %u bytes (%u compressed)\n", binary ? "binary" : "json",
+			writetime.TimeMS() / count, readtime.TimeMS() / count, size, compressedsize);
+	}
+}
+
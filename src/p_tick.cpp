@@ -81,6 +81,7 @@ void P_Ticker (void)
 	for (auto Level : AllLevels())
 	{
 		Level->interpolator.UpdateInterpolations();
+		Level->blockmap.Compact();
 	}
 	r_NoInterpolate = true;
 
@@ -42,10 +42,15 @@
 #include "v_text.h"
 #include "g_levellocals.h"
 #include "a_dynlight.h"
+#include "g_benchmark.h"
+#include "c_cvars.h"
+#include "jobsystem.h"
 
 
 static int ThinkCount;
-static cycle_t ThinkCycles;
+cycle_t ThinkCycles;
+bool ThinkerStatTiming;
+cycle_t ThinkerStatCycles[MAX_STATNUM + 1];
 extern cycle_t BotSupportCycles;
 extern cycle_t ActionCycles;
 extern int BotWTG;
@@ -67,6 +72,9 @@ static TMap<FName, ProfileInfo> Profiles;
 static unsigned int profilethinkers, profilelimit;
 DThinker *NextToThink;
 
+// Results are identical to the serial path, so this is a local option and not synchronized in netgames.
+CVAR(Bool, cl_parallelthinkers, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
 //==========================================================================
 //
 //
@@ -111,7 +119,10 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 		// Tick every thinker left from last time
 		for (i = STAT_FIRST_THINKING; i <= MAX_STATNUM; ++i)
 		{
-			Thinkers[i].TickThinkers(nullptr);
+			if (ThinkerStatTiming) ThinkerStatCycles[i].Clock();
+			if (cl_parallelthinkers) Thinkers[i].TickThinkersConcurrent();
+			else Thinkers[i].TickThinkers(nullptr);
+			if (ThinkerStatTiming) ThinkerStatCycles[i].Unclock();
 		}
 
 		// Keep ticking the fresh thinkers until there are no new ones.
@@ -120,7 +131,9 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 			count = 0;
 			for (i = STAT_FIRST_THINKING; i <= MAX_STATNUM; ++i)
 			{
+				if (ThinkerStatTiming) ThinkerStatCycles[i].Clock();
 				count += FreshThinkers[i].TickThinkers(&Thinkers[i]);
+				if (ThinkerStatTiming) ThinkerStatCycles[i].Unclock();
 			}
 		} while (count != 0);
 
@@ -585,6 +598,146 @@ int FThinkerList::TickThinkers(FThinkerList *dest)
 	return count;
 }
 
+//==========================================================================
+//
+// Concurrent ticking
+//
+// Consecutive thinkers that report a ConcurrentTickKey are collected into a
+// batch. Within a batch, thinkers sharing a key are ticked on the same thread
+// in list order, and different keys never touch the same data, so the result
+// is identical to ticking the batch serially. Any thinker without a key ends
+// the batch and is ticked on the main thread, just like TickThinkers does,
+// which keeps the ordering relative to everything else unchanged.
+//
+// The vertices of a sector are shared with its neighbours, so moving planes
+// only record which sectors need their vertices marked dirty and the main
+// thread marks them after the batch.
+//
+//==========================================================================
+
+struct FConcurrentTick
+{
+	const void *Key;
+	DThinker *Thinker;
+};
+
+static TArray<FConcurrentTick> ConcurrentBatch;
+
+static bool CanTickConcurrently(DThinker *node)
+{
+	// Script classes may override Tick, so only the native implementation can be trusted.
+	return !(node->ObjectFlags & OF_JustSpawned) && !node->GetClass()->bRuntimeClass && node->ConcurrentTickKey() != nullptr;
+}
+
+static void TickBatchRange(unsigned start, unsigned end, TArray<sector_t *> *dirtysectors)
+{
+	sector_t::DeferredVertexUpdates = dirtysectors;
+	for (unsigned i = start; i < end; i++)
+	{
+		ConcurrentBatch[i].Thinker->Tick();
+	}
+	sector_t::DeferredVertexUpdates = nullptr;
+}
+
+static void TickConcurrentBatch()
+{
+	const unsigned MIN_BATCH = 64;
+	const unsigned count = ConcurrentBatch.Size();
+
+	int numThreads = FJobSystem::NumThreads();
+	if (count < MIN_BATCH || numThreads < 2)
+	{
+		TickBatchRange(0, count, nullptr);
+		return;
+	}
+
+	std::stable_sort(ConcurrentBatch.begin(), ConcurrentBatch.end(), [](const FConcurrentTick &a, const FConcurrentTick &b)
+	{
+		return a.Key < b.Key;
+	});
+
+	// Split into one slice per thread, never separating thinkers that share a key.
+	TArray<unsigned> bounds;
+	bounds.Push(0);
+	for (int t = 1; t < numThreads; t++)
+	{
+		unsigned split = MAX(bounds.Last(), count * t / numThreads);
+		while (split > 0 && split < count && ConcurrentBatch[split].Key == ConcurrentBatch[split - 1].Key) split++;
+		bounds.Push(split);
+	}
+	bounds.Push(count);
+
+	TArray<TArray<sector_t *>> dirtysectors(numThreads, true);
+	FJobGroup jobs;
+	for (int t = 1; t < numThreads; t++)
+	{
+		unsigned start = bounds[t], end = bounds[t + 1];
+		if (start < end)
+		{
+			TArray<sector_t *> *dirty = &dirtysectors[t];
+			jobs.Run([=]() { TickBatchRange(start, end, dirty); });
+		}
+	}
+	TickBatchRange(bounds[0], bounds[1], &dirtysectors[0]);
+	jobs.Wait();
+
+	for (auto &list : dirtysectors)
+	{
+		for (auto sec : list) sec->SetVerticesDirty();
+	}
+}
+
+int FThinkerList::TickThinkersConcurrent()
+{
+	int count = 0;
+	DThinker *node = GetHead();
+
+	if (node == nullptr)
+	{
+		return 0;
+	}
+
+	while (node != Sentinel)
+	{
+		ConcurrentBatch.Clear();
+		while (node != Sentinel && ((node->ObjectFlags & OF_EuthanizeMe) || CanTickConcurrently(node)))
+		{
+			++count;
+			if (!(node->ObjectFlags & OF_EuthanizeMe))
+			{
+				ConcurrentBatch.Push({ node->ConcurrentTickKey(), node });
+			}
+			node = node->NextThinker;
+		}
+		if (ConcurrentBatch.Size() > 0)
+		{
+			ThinkCount += ConcurrentBatch.Size();
+			TickConcurrentBatch();
+			GC::CheckGC();
+		}
+		if (node == Sentinel)
+		{
+			break;
+		}
+
+		++count;
+		NextToThink = node->NextThinker;
+		if (node->ObjectFlags & OF_JustSpawned)
+		{
+			node->CallPostBeginPlay();
+		}
+		if (!(node->ObjectFlags & OF_EuthanizeMe))
+		{
+			ThinkCount++;
+			node->CallTick();
+			node->ObjectFlags &= ~OF_JustSpawned;
+			GC::CheckGC();
+		}
+		node = NextToThink;
+	}
+	return count;
+}
+
 //==========================================================================
 //
 //
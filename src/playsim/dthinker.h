@@ -61,6 +61,7 @@ struct FThinkerList
 	void DestroyThinkers();
 	bool DoDestroyThinkers();
 	int TickThinkers(FThinkerList *dest);	// Returns: # of thinkers ticked
+	int TickThinkersConcurrent();			// Same as TickThinkers(nullptr) but may use worker threads
 	int ProfileThinkers(FThinkerList *dest);
 	void SaveList(FSerializer &arc);
 
@@ -104,6 +105,10 @@ public:
 	virtual void PostBeginPlay ();	// Called just before the first tick
 	virtual void CallPostBeginPlay(); // different in actor.
 	virtual void PostSerialize();
+	// If Tick() writes to nothing but this thinker and the object returned here,
+	// and reads nothing another thinker of the same statnum may write, it can be
+	// ticked concurrently with thinkers that return a different object.
+	virtual const void *ConcurrentTickKey() const { return nullptr; }
 	void Serialize(FSerializer &arc) override;
 	size_t PropagateMark();
 	
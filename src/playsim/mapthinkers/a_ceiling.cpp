@@ -198,6 +198,27 @@ void DCeiling::Tick ()
 	}
 }
 
+//============================================================================
+//
+// DCeiling :: ConcurrentTickKey
+//
+//============================================================================
+
+const void *DCeiling::ConcurrentTickKey() const
+{
+	switch (m_Direction)
+	{
+	case 1:
+		return MoveIsLocal(sector_t::ceiling, m_Speed, m_TopHeight, 1) ? m_Sector : nullptr;
+
+	case -1:
+		return MoveIsLocal(sector_t::ceiling, m_Speed, m_BottomHeight, -1) ? m_Sector : nullptr;
+
+	default:
+		return m_Sector;	// in stasis
+	}
+}
+
 //============================================================================
 //
 // 
@@ -53,6 +53,7 @@ public:
 
 	void Serialize(FSerializer &arc);
 	void Tick ();
+	const void *ConcurrentTickKey() const override;
 
 protected:
 	ECeiling	m_Type;
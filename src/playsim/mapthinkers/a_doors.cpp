@@ -220,6 +220,39 @@ void DDoor::Tick ()
 	}
 }
 
+//============================================================================
+//
+// DDoor :: ConcurrentTickKey
+//
+// Waiting doors only count down until they start a sound. Moving doors
+// must not reach their destination or change the lights of other sectors.
+//
+//============================================================================
+
+const void *DDoor::ConcurrentTickKey() const
+{
+	if (m_Sector->floorplane.fD() != m_OldFloorDist)
+	{
+		return nullptr;	// the bottom gets adjusted first
+	}
+
+	switch (m_Direction)
+	{
+	case 0:
+	case 2:
+		return m_TopCountdown != 1 ? m_Sector : nullptr;
+
+	case -1:
+		return m_LightTag == 0 && MoveIsLocal(sector_t::ceiling, m_Speed, m_BotDist, -1) ? m_Sector : nullptr;
+
+	case 1:
+		return m_LightTag == 0 && MoveIsLocal(sector_t::ceiling, m_Speed, m_TopDist, 1) ? m_Sector : nullptr;
+
+	default:
+		return m_Sector;
+	}
+}
+
 //============================================================================
 //
 // [RH] DoorSound: Plays door sound depending on direction and speed
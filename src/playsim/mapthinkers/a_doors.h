@@ -22,6 +22,7 @@ public:
 
 	void Serialize(FSerializer &arc);
 	void Tick ();
+	const void *ConcurrentTickKey() const override;
 protected:
 	EVlDoor		m_Type;
 	double	 	m_TopDist;
@@ -212,6 +212,28 @@ void DFloor::Tick ()
 	}
 }
 
+//==========================================================================
+//
+// Only moves that stay away from the destination can run concurrently
+//
+//==========================================================================
+
+const void *DFloor::ConcurrentTickKey() const
+{
+	if (m_Type == buildStair || m_Type == waitStair)
+	{
+		if (m_ResetCount == 1)
+		{
+			return nullptr;	// resetting changes the move
+		}
+		if (m_PauseTime || m_Type == waitStair)
+		{
+			return m_Sector;	// only counts down
+		}
+	}
+	return MoveIsLocal(sector_t::floor, m_Speed, m_FloorDestDist, m_Direction) ? m_Sector : nullptr;
+}
+
 //==========================================================================
 //
 //
@@ -65,6 +65,7 @@ public:
 
 	void Serialize(FSerializer &arc);
 	void Tick ();
+	const void *ConcurrentTickKey() const override;
 
 //protected:
 	EFloor	 	m_Type;
@@ -287,6 +287,17 @@ void DStrobe::Tick ()
 	}
 }
 
+//-----------------------------------------------------------------------------
+//
+// Light thinkers without random numbers only touch their own sector
+//
+//-----------------------------------------------------------------------------
+
+const void *DStrobe::ConcurrentTickKey() const
+{
+	return m_Sector;
+}
+
 //-----------------------------------------------------------------------------
 //
 // Hexen-style constructor
@@ -385,6 +396,17 @@ void DGlow::Tick ()
 //
 //-----------------------------------------------------------------------------
 
+const void *DGlow::ConcurrentTickKey() const
+{
+	return m_Sector;
+}
+
+//-----------------------------------------------------------------------------
+//
+//
+//
+//-----------------------------------------------------------------------------
+
 void DGlow::Construct(sector_t *sector)
 {
 	Super::Construct(sector);
@@ -439,6 +461,17 @@ void DGlow2::Tick ()
 	m_Sector->SetLightLevel(((m_End - m_Start) * m_Tics) / m_MaxTics + m_Start);
 }
 
+//-----------------------------------------------------------------------------
+//
+// One shot glows destroy themselves and must run on the main thread
+//
+//-----------------------------------------------------------------------------
+
+const void *DGlow2::ConcurrentTickKey() const
+{
+	return m_OneShot ? nullptr : m_Sector;
+}
+
 //-----------------------------------------------------------------------------
 //
 //
@@ -501,6 +534,17 @@ void DPhased::Tick ()
 //
 //-----------------------------------------------------------------------------
 
+const void *DPhased::ConcurrentTickKey() const
+{
+	return m_Sector;
+}
+
+//-----------------------------------------------------------------------------
+//
+//
+//
+//-----------------------------------------------------------------------------
+
 int DPhased::PhaseHelper (sector_t *sector, int index, int light, sector_t *prev)
 {
 	if (!sector || sector->validcount == validcount)
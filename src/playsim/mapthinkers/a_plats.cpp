@@ -215,6 +215,36 @@ void DPlat::Tick ()
 	}
 }
 
+//-----------------------------------------------------------------------------
+//
+// Plats that wait, or move without reaching their destination, only
+// change their own sector
+//
+//-----------------------------------------------------------------------------
+
+const void *DPlat::ConcurrentTickKey() const
+{
+	switch (m_Status)
+	{
+	case up:
+		return MoveIsLocal(sector_t::floor, m_Speed, m_High, 1) ? m_Sector : nullptr;
+
+	case down:
+		// Pure raise types destroy themselves after any move down.
+		if (m_Type == platUpByValueStay || m_Type == platRaiseAndStay || m_Type == platRaiseAndStayLockout)
+		{
+			return nullptr;
+		}
+		return MoveIsLocal(sector_t::floor, m_Speed, m_Low, -1) ? m_Sector : nullptr;
+
+	case waiting:
+		return m_Count != 1 ? m_Sector : nullptr;
+
+	default:
+		return m_Sector;
+	}
+}
+
 //-----------------------------------------------------------------------------
 //
 //
@@ -34,6 +34,7 @@ public:
 
 	void Serialize(FSerializer &arc);
 	void Tick ();
+	const void *ConcurrentTickKey() const override;
 
 	bool IsLift() const { return m_Type == platDownWaitUpStay || m_Type == platDownWaitUpStayStone; }
 	void Construct(sector_t *sector);
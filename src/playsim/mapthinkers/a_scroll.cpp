@@ -226,6 +226,29 @@ void DScroller::Tick ()
 	}
 }
 
+//-----------------------------------------------------------------------------
+//
+// Texture scrollers only modify the offsets of their side or sector.
+// Carrying scrollers mark actors and must run on the main thread.
+//
+//-----------------------------------------------------------------------------
+
+const void *DScroller::ConcurrentTickKey() const
+{
+	switch (m_Type)
+	{
+	case EScroll::sc_side:
+		return m_Side;
+
+	case EScroll::sc_floor:
+	case EScroll::sc_ceiling:
+		return m_Sector;
+
+	default:
+		return nullptr;
+	}
+}
+
 //-----------------------------------------------------------------------------
 //
 // Add_Scroller()
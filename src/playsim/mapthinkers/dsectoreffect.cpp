@@ -144,6 +144,76 @@ bool sector_t::MoveAttached(int crush, double move, int floorOrCeiling, bool res
 	return true;
 }
 
+//==========================================================================
+//
+// DMover :: MoveIsLocal
+//
+// Checks if a MoveFloor or MoveCeiling call with these parameters only
+// changes the mover's own sector this tic: nothing touches the sector or
+// is attached to it, and the plane stops short of its destination, which
+// is where movers stop sounds, change specials and destroy themselves.
+// Movers use this for their ConcurrentTickKey.
+//
+//==========================================================================
+
+bool DMover::MoveIsLocal(int pos, double speed, double dest, int direction) const
+{
+	sector_t *sec = m_Sector;
+	extsector_t *e = sec->e;
+
+	if (sec->touching_thinglist != nullptr ||
+		sec->PortalIsLinked(sector_t::floor) || sec->PortalIsLinked(sector_t::ceiling) ||
+		e->XFloor.ffloors.Size() > 0 || e->XFloor.attached.Size() > 0 || e->FakeFloor.Sectors.Size() > 0 ||
+		e->Midtex.Floor.AttachedLines.Size() > 0 || e->Midtex.Ceiling.AttachedLines.Size() > 0 ||
+		e->Linked.Floor.Sectors.Size() > 0 || e->Linked.Ceiling.Sectors.Size() > 0)
+	{
+		return false;
+	}
+
+	// A mover of the other plane in the same batch could change the clipping below.
+	if ((pos == sector_t::floor ? sec->ceilingdata : sec->floordata) != nullptr)
+	{
+		return false;
+	}
+
+	// The same tests as in MoveFloor and MoveCeiling.
+	if (pos == sector_t::floor)
+	{
+		switch (direction)
+		{
+		case -1:
+			return sec->floorplane.GetChangedHeight(-speed) < dest;
+
+		case 1:
+			if (!sec->ceilingplane.isSlope() && !sec->floorplane.isSlope() &&
+				!sec->PortalIsLinked(sector_t::ceiling) &&
+				(!(sec->Level->i_compatflags2 & COMPATF2_FLOORMOVE) && -dest > sec->ceilingplane.fD()))
+			{
+				dest = -sec->ceilingplane.fD();
+			}
+			return sec->floorplane.GetChangedHeight(speed) > dest;
+		}
+	}
+	else
+	{
+		switch (direction)
+		{
+		case -1:
+			if (!sec->ceilingplane.isSlope() && !sec->floorplane.isSlope() &&
+				!sec->PortalIsLinked(sector_t::floor) &&
+				(!(sec->Level->i_compatflags2 & COMPATF2_FLOORMOVE) && dest < -sec->floorplane.fD()))
+			{
+				dest = -sec->floorplane.fD();
+			}
+			return sec->ceilingplane.GetChangedHeight(-speed) > dest;
+
+		case 1:
+			return sec->ceilingplane.GetChangedHeight(speed) < dest;
+		}
+	}
+	return true;	// does not move at all
+}
+
 //
 // Move a plane (floor or ceiling) and check for crushing
 // [RH] Crush specifies the actual amount of crushing damage inflictable.
@@ -32,6 +32,7 @@ public:
 	void StopInterpolation(bool force = false);
 
 protected:
+	bool MoveIsLocal(int pos, double speed, double dest, int direction) const;
 
 	void Serialize(FSerializer &arc);
 	void OnDestroy() override;
@@ -1133,14 +1133,13 @@ void P_RandomChaseDir (AActor *actor)
 
 //---------------------------------------------------------------------------
 //
-// P_IsVisible
+// P_IsInViewRange
 //
-// killough 9/9/98: whether a target is visible to a monster
-// Extended to handle all A_LookEx related checking, too.
+// The distance and field of view part of P_IsVisible.
 //
 //---------------------------------------------------------------------------
 
-int P_IsVisible(AActor *lookee, AActor *other, INTBOOL allaround, FLookExParams *params)
+static bool P_IsInViewRange(AActor *lookee, AActor *other, INTBOOL allaround, FLookExParams *params)
 {
 	double maxdist;
 	double mindist;
@@ -1183,11 +1182,74 @@ int P_IsVisible(AActor *lookee, AActor *other, INTBOOL allaround, FLookExParams
 				return false;	// outside of fov
 		}
 	}
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//
+// P_IsVisible
+//
+// killough 9/9/98: whether a target is visible to a monster
+// Extended to handle all A_LookEx related checking, too.
+//
+//---------------------------------------------------------------------------
+
+int P_IsVisible(AActor *lookee, AActor *other, INTBOOL allaround, FLookExParams *params)
+{
+	if (!P_IsInViewRange(lookee, other, allaround, params))
+		return false;
 
 	// P_CheckSight is by far the most expensive operation in here so let's do it last.
 	return P_CheckSight(lookee, other, SF_SEEPASTSHOOTABLELINES);
 }
 
+//---------------------------------------------------------------------------
+//
+// P_PrefetchPlayerSight
+//
+// With several players in the game a monster may have to check all of
+// them before it finds a target. Those checks do not depend on each other,
+// so trace them in one batch up front. Players that would need a random
+// number are left at -1 and get checked normally when they come up.
+//
+// This only helps multiplayer games. With a single player there is nothing
+// to batch within one monster, and batching across monsters is not exact:
+// any actor ticked in between can move, open a door or change lines and
+// sectors from a script, which would change the result of later traces.
+// The sight stat shows how many traces went through the pool.
+//
+//---------------------------------------------------------------------------
+
+EXTERN_CVAR(Bool, cl_parallelsight)
+
+static void P_PrefetchPlayerSight(AActor *actor, INTBOOL allaround, FLookExParams *params, int sight[MAXPLAYERS])
+{
+	FSightQuery queries[MAXPLAYERS];
+	int pnums[MAXPLAYERS];
+	unsigned count = 0;
+
+	for (int i = 0; i < MAXPLAYERS; i++)
+	{
+		sight[i] = -1;
+		if (!cl_parallelsight || !actor->Level->PlayerInGame(i)) continue;
+
+		AActor *mo = actor->Level->Players[i]->mo;
+		if (mo == nullptr || !(mo->flags & MF_SHOOTABLE) || actor->IsFriend(mo)) continue;
+		if (!P_IsInViewRange(actor, mo, allaround, params)) continue;
+
+		queries[count] = { actor, mo, SF_SEEPASTSHOOTABLELINES, -1 };
+		pnums[count++] = i;
+	}
+	if (count > 1)
+	{
+		P_CheckSightBatch(queries, count, true);
+		for (unsigned i = 0; i < count; i++)
+		{
+			sight[pnums[i]] = queries[i].Result;
+		}
+	}
+}
+
 //---------------------------------------------------------------------------
 //
 // FUNC P_LookForMonsters
@@ -1254,13 +1316,15 @@ int P_LookForMonsters (AActor *actor)
 AActor *LookForTIDInBlock (AActor *lookee, int index, void *extparams)
 {
 	FLookExParams *params = (FLookExParams *)extparams;
-	FBlockNode *block;
 	AActor *link;
 	AActor *other;
+	auto &links = lookee->Level->blockmap.blocklinks[index];
 	
-	for (block = lookee->Level->blockmap.blocklinks[index]; block != NULL; block = block->NextActor)
+	for (unsigned i = links.Size(); i-- > 0; )
 	{
-		link = block->Me;
+		link = links[i].Me;
+		if (link == nullptr)
+			continue;			// unlinked
 
         if (!(link->flags & MF_SHOOTABLE))
 			continue;			// not shootable (observer or dead)
@@ -1424,14 +1488,16 @@ int P_LookForTID (AActor *actor, INTBOOL allaround, FLookExParams *params)
 
 AActor *LookForEnemiesInBlock (AActor *lookee, int index, void *extparam)
 {
-	FBlockNode *block;
 	AActor *link;
 	AActor *other;
 	FLookExParams *params = (FLookExParams *)extparam;
+	auto &links = lookee->Level->blockmap.blocklinks[index];
 	
-	for (block = lookee->Level->blockmap.blocklinks[index]; block != NULL; block = block->NextActor)
+	for (unsigned i = links.Size(); i-- > 0; )
 	{
-		link = block->Me;
+		link = links[i].Me;
+		if (link == nullptr)
+			continue;			// unlinked
 
         if (!(link->flags & MF_SHOOTABLE))
 			continue;			// not shootable (observer or dead)
@@ -1644,6 +1710,9 @@ int P_LookForPlayers (AActor *actor, INTBOOL allaround, FLookExParams *params)
 	{
 		pnum = actor->LastLookPlayerNumber;
 	}
+
+	int sight[MAXPLAYERS];
+	P_PrefetchPlayerSight(actor, allaround, params, sight);
 		
 	for (;;)
 	{
@@ -1703,7 +1772,7 @@ int P_LookForPlayers (AActor *actor, INTBOOL allaround, FLookExParams *params)
 		if (player->health <= 0)
 			continue;			// dead
 
-		if (!P_IsVisible (actor, player->mo, allaround, params))
+		if (sight[pnum] >= 0 ? !sight[pnum] : !P_IsVisible (actor, player->mo, allaround, params))
 			continue;			// out of sight
 
 		// [SP] Deathmatch fixes - if we have MF_FRIENDLY we're definitely in deathmatch
@@ -272,6 +272,15 @@ enum ESightFlags
 	SF_IGNOREWATERBOUNDARY=8
 };
 
+struct FSightQuery
+{
+	AActor *Looker;
+	AActor *Target;
+	int Flags;
+	int Result;		// -1 if a speculative check could not be decided
+};
+
+void	P_CheckSightBatch (FSightQuery *queries, unsigned count, bool speculative = false);
 void	P_ResetSightCounters (bool full);
 bool	P_TalkFacing (AActor *player);
 void	P_UseLines (player_t* player);
@@ -335,11 +335,7 @@ void AActor::UnlinkFromWorld (FLinkContext *ctx)
 
 		while (block != NULL)
 		{
-			if (block->NextActor != NULL)
-			{
-				block->NextActor->PrevActor = block->PrevActor;
-			}
-			*(block->PrevActor) = block->NextActor;
+			Level->blockmap.UnlinkActor(block);
 			FBlockNode *next = block->NextBlock;
 			block->Release ();
 			block = next;
@@ -535,26 +531,22 @@ void AActor::LinkToWorld(FLinkContext *ctx, bool spawningmapthing, sector_t *sec
 				{
 					for (int x = x1; x <= x2; ++x)
 					{
-						FBlockNode **link = &Level->blockmap.blocklinks[y*Level->blockmap.bmapwidth + x];
-						FBlockNode *node = FBlockNode::Create(this, x, y, this->Sector->PortalGroup);
+						FBlockNode *node = FBlockNode::Create(this, x, y);
 
 						// Link in to block
-						if ((node->NextActor = *link) != NULL)
-						{
-							(*link)->PrevActor = &node->NextActor;
-						}
-						node->PrevActor = link;
-						*link = node;
+						Level->blockmap.LinkActor(node);
 
 						// Link in to actor
-						node->PrevBlock = alink;
-						node->NextBlock = NULL;
 						(*alink) = node;
 						alink = &node->NextBlock;
 					}
 				}
 			}
 		}
+		if (BlockNode != NULL && BlockNode->NextBlock == NULL)
+		{
+			Level->blockmap.blocklinks[BlockNode->BlockIndex][BlockNode->Position].SingleBlock = true;
+		}
 	}
 	// Portal links cannot be done unless the level is fully initialized.
 	if (!spawningmapthing) UpdateRenderSectorList();
@@ -896,6 +888,7 @@ FBlockThingsIterator::FBlockThingsIterator(FLevelLocals *l)
 	miny = maxy = 0;
 	ClearHash();
 	block = NULL;
+	blockpos = 0;
 }
 
 FBlockThingsIterator::FBlockThingsIterator(FLevelLocals *l, int _minx, int _miny, int _maxx, int _maxy)
@@ -945,12 +938,14 @@ void FBlockThingsIterator::StartBlock(int x, int y)
 	cury = y;
 	if (Level->blockmap.isValidBlock(x, y))
 	{
-		block = Level->blockmap.blocklinks[y*Level->blockmap.bmapwidth + x];
+		block = &Level->blockmap.blocklinks[y*Level->blockmap.bmapwidth + x];
+		blockpos = block->Size();
 	}
 	else
 	{
 		// invalid block
 		block = NULL;
+		blockpos = 0;
 	}
 }
 
@@ -977,16 +972,25 @@ AActor *FBlockThingsIterator::Next(bool centeronly)
 {
 	for (;;)
 	{
-		while (block != NULL)
+		// Blocks only shrink when compacted, which script iterators may outlive.
+		if (block != NULL && blockpos > block->Size())
+		{
+			blockpos = block->Size();
+		}
+		while (blockpos > 0)
 		{
-			AActor *me = block->Me;
-			FBlockNode *mynode = block;
+			const FBlockEntry &mynode = (*block)[--blockpos];
+			AActor *me = mynode.Me;
 			HashEntry *entry;
 			int i;
 
-			block = block->NextActor;
+			if (me == NULL)
+			{ // unlinked since the block was last compacted
+				continue;
+			}
+
 			// Don't recheck things that were already checked
-			if (mynode->NextBlock == NULL && mynode->PrevBlock == &me->BlockNode)
+			if (mynode.SingleBlock)
 			{ // This actor doesn't span blocks, so we know it can only ever be checked once.
 				return me;
 			}
@@ -1796,23 +1800,24 @@ static AActor *RoughBlockCheck (AActor *mo, int index, void *param)
 {
 	BlockCheckInfo *info = (BlockCheckInfo *)param;
 
-	FBlockNode *link;
+	auto &links = mo->Level->blockmap.blocklinks[index];
 
-	for (link = mo->Level->blockmap.blocklinks[index]; link != NULL; link = link->NextActor)
+	for (unsigned i = links.Size(); i-- > 0; )
 	{
-		if (link->Me != mo)
+		AActor *link = links[i].Me;
+		if (link != nullptr && link != mo)
 		{
-			if (info->onlyseekable && !mo->CanSeek(link->Me))
+			if (info->onlyseekable && !mo->CanSeek(link))
 			{
 				continue;
 			}
-			if (info->frontonly && P_PointOnDivlineSide(link->Me->X(), link->Me->Y(), &info->frontline) != 0)
+			if (info->frontonly && P_PointOnDivlineSide(link->X(), link->Y(), &info->frontline) != 0)
 			{
 				continue;
 			}
-			if (mo->IsOkayToAttack (link->Me))
+			if (mo->IsOkayToAttack (link))
 			{
-				return link->Me;
+				return link;
 			}
 		}
 	}
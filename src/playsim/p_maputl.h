@@ -8,7 +8,7 @@
 #include "m_bbox.h"
 
 extern int validcount;
-struct FBlockNode;
+#include "p_blockmap.h"
 
 struct divline_t
 {
@@ -285,7 +285,8 @@ class FBlockThingsIterator
 
 	int curx, cury;
 
-	FBlockNode *block;
+	FBlockLinks *block;
+	unsigned blockpos;
 
 	int Buckets[32];
 
@@ -27,6 +27,7 @@
 #include "g_levellocals.h"
 #include "p_maputl.h"
 #include "actor.h"
+#include <algorithm>
 
 //=============================================================================
 // phares 3/21/98
@@ -453,7 +454,7 @@ void AActor::ClearRenderLineList()
 
 FBlockNode *FBlockNode::FreeBlocks = nullptr;
 
-FBlockNode *FBlockNode::Create(AActor *who, int x, int y, int group)
+FBlockNode *FBlockNode::Create(AActor *who, int x, int y)
 {
 	FBlockNode *block;
 
@@ -468,9 +469,7 @@ FBlockNode *FBlockNode::Create(AActor *who, int x, int y, int group)
 	}
 	block->BlockIndex = x + y * who->Level->blockmap.bmapwidth;
 	block->Me = who;
-	block->NextActor = nullptr;
-	block->PrevActor = nullptr;
-	block->PrevBlock = nullptr;
+	block->Position = 0;
 	block->NextBlock = nullptr;
 	return block;
 }
@@ -480,3 +479,36 @@ void FBlockNode::Release()
 	NextBlock = FreeBlocks;
 	FreeBlocks = this;
 }
+
+//===========================================================================
+//
+// FBlockmap :: Compact
+//
+// Removes the entries of unlinked actors. This must only be called when
+// nothing is iterating over the blockmap and no player is being predicted.
+//
+//===========================================================================
+
+void FBlockmap::Compact()
+{
+	std::sort(unlinkedblocks.begin(), unlinkedblocks.end());
+	int last = -1;
+	for (int index : unlinkedblocks)
+	{
+		if (index == last) continue;
+		last = index;
+
+		auto &links = blocklinks[index];
+		unsigned count = 0;
+		for (unsigned i = 0; i < links.Size(); i++)
+		{
+			if (links[i].Me != nullptr)
+			{
+				links[i].Node->Position = count;
+				links[count++] = links[i];
+			}
+		}
+		links.Resize(count);
+	}
+	unlinkedblocks.Clear();
+}
@@ -83,6 +83,8 @@ CUSTOM_CVAR(Int, r_fakecontrast, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
 	else if (self > 2) self = 2;
 }
 
+thread_local TArray<sector_t *> *sector_t::DeferredVertexUpdates;
+
 // [RH]
 // P_NextSpecialSector()
 //
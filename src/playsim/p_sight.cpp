@@ -36,6 +36,12 @@
 
 #include "g_levellocals.h"
 #include "actorinlines.h"
+#include "c_cvars.h"
+#include "jobsystem.h"
+
+CVAR(Bool, cl_parallelsight, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+static int SerialTraces, ParallelTraces;	// for the sight stat
 
 static FRandom pr_botchecksight ("BotCheckSight");
 static FRandom pr_checksight ("CheckSight");
@@ -51,7 +57,6 @@ This uses specialized forms of the maputils routines for optimized performance
 */
 
 // Performance meters
-static int sightcounts[6];
 static cycle_t SightCycles;
 static cycle_t MaxSightCycles;
 
@@ -87,12 +92,89 @@ struct SightTask
 };
 
 
-static TArray<intercept_t> intercepts (128);
-static TArray<SightTask> portals(32);
+//==========================================================================
+//
+// All scratch state of a sight check. The main thread's context marks
+// lines and polyobjects with validcount, like it always did. Worker
+// threads may not touch the map, so their contexts keep private stamps
+// instead.
+//
+//==========================================================================
+
+struct SightContext
+{
+	TArray<intercept_t> intercepts;
+	TArray<SightTask> portals;
+	int sightcounts[6] = {};
+
+	bool useStamps = false;
+	FLevelLocals *stampLevel = nullptr;
+	TArray<int> lineStamps;
+	TArray<int> polyStamps;
+	int stamp = 0;
+
+	SightContext()
+	{
+		intercepts.Grow(128);
+		portals.Grow(32);
+	}
+
+	void NextStamp(FLevelLocals *Level)
+	{
+		if (!useStamps)
+		{
+			validcount++;
+			return;
+		}
+		if (stampLevel != Level || lineStamps.Size() != Level->lines.Size() || polyStamps.Size() != Level->Polyobjects.Size())
+		{
+			stampLevel = Level;
+			lineStamps.Resize(Level->lines.Size());
+			polyStamps.Resize(Level->Polyobjects.Size());
+			memset(lineStamps.Data(), 0, lineStamps.Size() * sizeof(int));
+			memset(polyStamps.Data(), 0, polyStamps.Size() * sizeof(int));
+			stamp = 0;
+		}
+		stamp++;
+	}
+
+	bool MarkLine(FLevelLocals *Level, line_t *ld)
+	{
+		if (!useStamps)
+		{
+			if (ld->validcount == validcount) return false;
+			ld->validcount = validcount;
+			return true;
+		}
+		int &mark = lineStamps[ld->Index()];
+		if (mark == stamp) return false;
+		mark = stamp;
+		return true;
+	}
+
+	bool MarkPolyobj(FLevelLocals *Level, FPolyObj *po)
+	{
+		if (!useStamps)
+		{
+			if (po->validcount == validcount) return false;
+			po->validcount = validcount;
+			return true;
+		}
+		int &mark = polyStamps[po - &Level->Polyobjects[0]];
+		if (mark == stamp) return false;
+		mark = stamp;
+		return true;
+	}
+};
+
+static SightContext MainSight;
 
 class SightCheck
 {
 	FLevelLocals *Level;
+	SightContext &ctx;
+	TArray<intercept_t> &intercepts;
+	TArray<SightTask> &portals;
 	DVector3 sightstart;
 	DVector2 sightend;
 	double Startfrac;
@@ -117,7 +199,8 @@ class SightCheck
 	bool LineBlocksSight(line_t *ld);
 
 public:
-	SightCheck(FLevelLocals *l)
+	SightCheck(FLevelLocals *l, SightContext &c)
+		: ctx(c), intercepts(c.intercepts), portals(c.portals)
 	{
 		Level = l;
 	}
@@ -434,11 +517,10 @@ bool SightCheck::P_SightCheckLine (line_t *ld)
 {
 	divline_t dl;
 
-	if (ld->validcount == validcount)
+	if (!ctx.MarkLine(Level, ld))
 	{
 		return true;
 	}
-	ld->validcount = validcount;
 	if (P_PointOnDivlineSide (ld->v1->fPos(), &Trace) ==
 		P_PointOnDivlineSide (ld->v2->fPos(), &Trace))
 	{
@@ -456,7 +538,7 @@ bool SightCheck::P_SightCheckLine (line_t *ld)
 		if (LineBlocksSight(ld)) return false;
 	}
 
-	sightcounts[3]++;
+	ctx.sightcounts[3]++;
 	// store the line for later intersection testing
 	intercept_t newintercept;
 	newintercept.isaline = true;
@@ -495,9 +577,8 @@ int SightCheck::P_SightBlockLinesIterator (int x, int y)
 	{
 		if (polyLink->polyobj)
 		{ // only check non-empty links
-			if (polyLink->polyobj->validcount != validcount)
+			if (ctx.MarkPolyobj(Level, polyLink->polyobj))
 			{
-				polyLink->polyobj->validcount = validcount;
 				for (i = 0; i < polyLink->polyobj->Linedefs.Size(); i++)
 				{
 					if (!P_SightCheckLine(polyLink->polyobj->Linedefs[i]))
@@ -627,7 +708,7 @@ bool SightCheck::P_SightPathTraverse ()
 	int mapx, mapy, mapxstep, mapystep;
 	int count;
 
-	validcount++;
+	ctx.NextStamp(Level);
 	intercepts.Clear ();
 	x1 = sightstart.X + Startfrac * Trace.dx;
 	y1 = sightstart.Y + Startfrac * Trace.dy;
@@ -760,7 +841,7 @@ bool SightCheck::P_SightPathTraverse ()
 		itres = P_SightBlockLinesIterator(mapx, mapy);
 		if (itres == 0)
 		{
-			sightcounts[1]++;
+			ctx.sightcounts[1]++;
 			return false;	// early out
 		}
 
@@ -771,7 +852,7 @@ bool SightCheck::P_SightPathTraverse ()
 		switch (((xs_FloorToInt(yintercept) == mapy) << 1) | (xs_FloorToInt(xintercept) == mapx))
 		{
 		case 0:		// neither xintercept nor yintercept match!
-sightcounts[5]++;
+ctx.sightcounts[5]++;
 			// Continuing won't make things any better, so we might as well stop right here
 			return false;
 
@@ -790,7 +871,7 @@ sightcounts[5]++;
 			break;
 
 		case 3:		// xintercept and yintercept both match
-			sightcounts[4]++;
+			ctx.sightcounts[4]++;
 			// The trace is exiting a block through its corner. Not only does the block
 			// being entered need to be checked (which will happen when this loop
 			// continues), but the other two blocks adjacent to the corner also need to
@@ -798,7 +879,7 @@ sightcounts[5]++;
 			if (!P_SightBlockLinesIterator (mapx + mapxstep, mapy) ||
 				!P_SightBlockLinesIterator (mapx, mapy + mapystep))
 			{
-sightcounts[1]++;
+ctx.sightcounts[1]++;
 				return false;
 			}
 			xintercept += xstep;
@@ -817,7 +898,7 @@ sightcounts[1]++;
 //
 // couldn't early out, so go through the sorted list
 //
-sightcounts[2]++;
+ctx.sightcounts[2]++;
 
 	bool traverseres = P_SightTraverseIntercepts ( );
 	if (itres == -1) return false;	// if the iterator had an early out there was no line of sight. The traverser was only called to collect more portals.
@@ -825,30 +906,26 @@ sightcounts[2]++;
 	return traverseres;
 }
 
-/*
-=====================
-=
-= P_CheckSight
-=
-= Returns true if a straight line between t1 and t2 is unobstructed
-= look from eyes of t1 to any part of t2
-=
-= killough 4/20/98: cleaned up, made to use new LOS struct
-=
-=====================
-*/
+//==========================================================================
+//
+// P_SightPrecheck
+//
+// The cheap part of P_CheckSight that can decide the result without
+// tracing. This is also the only part that may consume a random number,
+// so it always runs on the main thread. Returns SIGHT_TRACE if a trace
+// is needed and, for speculative checks, SIGHT_UNKNOWN instead of
+// consuming a random number.
+//
+//==========================================================================
 
-int P_CheckSight (AActor *t1, AActor *t2, int flags)
+enum
 {
-	SightCycles.Clock();
-
-	bool res;
-
-	if (t1 == nullptr || t2 == nullptr)
-	{
-		return false;
-	}
+	SIGHT_TRACE = -1,
+	SIGHT_UNKNOWN = -2,
+};
 
+static int P_SightPrecheck(AActor *t1, AActor *t2, int flags, bool speculative)
+{
 	auto s1 = t1->Sector;
 	auto s2 = t2->Sector;
 	//
@@ -856,9 +933,8 @@ int P_CheckSight (AActor *t1, AActor *t2, int flags)
 	//
 	if (!t1->Level->CheckReject(s1, s2))
 	{
-sightcounts[0]++;
-		res = false;			// can't possibly be connected
-		goto done;
+MainSight.sightcounts[0]++;
+		return false;			// can't possibly be connected
 	}
 
 //
@@ -868,10 +944,13 @@ sightcounts[0]++;
 	// Cannot see an invisible object
 	if ((flags & SF_IGNOREVISIBILITY) == 0 && ((t2->renderflags & RF_INVISIBLE) || !t2->RenderStyle.IsVisible(t2->Alpha)))
 	{ // small chance of an attack being made anyway
+		if (speculative)
+		{
+			return SIGHT_UNKNOWN;
+		}
 		if ((t1->Level->BotInfo.m_Thinking ? pr_botchecksight() : pr_checksight()) > 50)
 		{
-			res = false;
-			goto done;
+			return false;
 		}
 	}
 
@@ -891,56 +970,186 @@ sightcounts[0]++;
 			  (t2->Z() >= s2->heightsec->ceilingplane.ZatPoint(t2) &&
 			   t1->Top() <= s2->heightsec->ceilingplane.ZatPoint(t1)))))
 		{
-			res = false;
-			goto done;
+			return false;
 		}
 	}
+	return SIGHT_TRACE;
+}
 
-	// An unobstructed LOS is possible.
-	// Now look from eyes of t1 to any part of t2.
+//==========================================================================
+//
+// P_SightTrace
+//
+// An unobstructed LOS is possible.
+// Now look from eyes of t1 to any part of t2.
+// Only reads the map, so this is safe to call from a worker thread
+// with its own context.
+//
+//==========================================================================
 
-	validcount++;
-	portals.Clear();
-	{
-		sector_t *sec;
-		double lookheight = t1->Z() + t1->Height*0.75;
-		t1->GetPortalTransition(lookheight, &sec);
+static bool P_SightTrace(SightContext &ctx, AActor *t1, AActor *t2, int flags)
+{
+	bool res;
+
+	ctx.NextStamp(t1->Level);
+	ctx.portals.Clear();
+
+	sector_t *sec;
+	double lookheight = t1->Z() + t1->Height*0.75;
+	t1->GetPortalTransition(lookheight, &sec);
 
-		double bottomslope = t2->Z() - lookheight;
-		double topslope = bottomslope + t2->Height;
-		SightTask task = { 0, topslope, bottomslope, -1, sec->PortalGroup };
+	double bottomslope = t2->Z() - lookheight;
+	double topslope = bottomslope + t2->Height;
+	SightTask task = { 0, topslope, bottomslope, -1, sec->PortalGroup };
 
 
-		SightCheck s(t1->Level);
-		s.init(t1, t2, sec, &task, flags);
-		res = s.P_SightPathTraverse ();
-		if (!res)
+	SightCheck s(t1->Level, ctx);
+	s.init(t1, t2, sec, &task, flags);
+	res = s.P_SightPathTraverse ();
+	if (!res)
+	{
+		auto &portals = ctx.portals;
+		double dist = t1->Distance2D(t2);
+		for (unsigned i = 0; i < portals.Size(); i++)
 		{
-			double dist = t1->Distance2D(t2);
-			for (unsigned i = 0; i < portals.Size(); i++)
+			portals[i].Frac += 1 / dist;
+			s.init(t1, t2, NULL, &portals[i], flags);
+			if (s.P_SightPathTraverse())
 			{
-				portals[i].Frac += 1 / dist;
-				s.init(t1, t2, NULL, &portals[i], flags);
-				if (s.P_SightPathTraverse())
-				{
-					res = true;
-					break;
-				}
+				res = true;
+				break;
 			}
 		}
 	}
+	return res;
+}
+
+/*
+=====================
+=
+= P_CheckSight
+=
+= Returns true if a straight line between t1 and t2 is unobstructed
+= look from eyes of t1 to any part of t2
+=
+= killough 4/20/98: cleaned up, made to use new LOS struct
+=
+=====================
+*/
+
+int P_CheckSight (AActor *t1, AActor *t2, int flags)
+{
+	if (t1 == nullptr || t2 == nullptr)
+	{
+		return false;
+	}
+
+	SightCycles.Clock();
+
+	int res = P_SightPrecheck(t1, t2, flags, false);
+	if (res == SIGHT_TRACE)
+	{
+		res = P_SightTrace(MainSight, t1, t2, flags);
+		SerialTraces++;
+	}
 
-done:
 	SightCycles.Unclock();
 	return res;
 }
 
+//==========================================================================
+//
+// P_CheckSightBatch
+//
+// Checks a list of independent queries at once. The prechecks run in
+// list order on the main thread, so random numbers are consumed exactly
+// as if P_CheckSight had been called for each query in turn. Since no
+// game code runs until all traces are done, the results are identical,
+// no matter how the traces get distributed across threads.
+//
+// With speculative set, queries that would need a random number are
+// left at -1 so that the caller can check them normally if it actually
+// gets to them.
+//
+//==========================================================================
+
+static TArray<unsigned> SightTraces;
+static std::vector<SightContext> WorkerSight;
+
+void P_CheckSightBatch(FSightQuery *queries, unsigned count, bool speculative)
+{
+	const unsigned MIN_TRACES = 2;
+
+	SightCycles.Clock();
+
+	SightTraces.Clear();
+	for (unsigned i = 0; i < count; i++)
+	{
+		auto &q = queries[i];
+		int res = (q.Looker == nullptr || q.Target == nullptr) ? false : P_SightPrecheck(q.Looker, q.Target, q.Flags, speculative);
+		q.Result = res == SIGHT_UNKNOWN ? -1 : res;
+		if (res == SIGHT_TRACE) SightTraces.Push(i);
+	}
+
+	const unsigned traces = SightTraces.Size();
+	int numThreads = MIN<int>(FJobSystem::NumThreads(), traces);
+	if (!cl_parallelsight || traces < MIN_TRACES || numThreads < 2)
+	{
+		for (auto i : SightTraces)
+		{
+			auto &q = queries[i];
+			q.Result = P_SightTrace(MainSight, q.Looker, q.Target, q.Flags);
+		}
+		SerialTraces += traces;
+	}
+	else
+	{
+		if (WorkerSight.empty())
+		{
+			// Slot 0 stands for the main thread, which keeps using MainSight.
+			WorkerSight.resize(FJobSystem::NumThreads());
+			for (auto &ctx : WorkerSight) ctx.useStamps = true;
+		}
+
+		auto traceRange = [=](unsigned start, unsigned end)
+		{
+			int index = FJobSystem::ThreadIndex();
+			SightContext &ctx = index == 0 ? MainSight : WorkerSight[index];
+			for (unsigned t = start; t < end; t++)
+			{
+				auto &q = queries[SightTraces[t]];
+				q.Result = P_SightTrace(ctx, q.Looker, q.Target, q.Flags);
+			}
+		};
+
+		FJobGroup jobs;
+		for (int t = 1; t < numThreads; t++)
+		{
+			unsigned start = traces * t / numThreads, end = traces * (t + 1) / numThreads;
+			jobs.Run([=]() { traceRange(start, end); });
+		}
+		traceRange(0, traces / numThreads);
+		jobs.Wait();
+		ParallelTraces += traces;
+
+		for (auto &ctx : WorkerSight)
+		{
+			for (int i = 0; i < 6; i++) MainSight.sightcounts[i] += ctx.sightcounts[i];
+			memset(ctx.sightcounts, 0, sizeof(ctx.sightcounts));
+		}
+	}
+
+	SightCycles.Unclock();
+}
+
 ADD_STAT (sight)
 {
+	auto &sightcounts = MainSight.sightcounts;
 	FString out;
-	out.Format ("%04.1f ms (%04.1f max), %5d %2d%4d%4d%4d%4d\n",
+	out.Format ("%04.1f ms (%04.1f max), %5d %2d%4d%4d%4d%4d, traces %d serial %d parallel\n",
 		SightCycles.TimeMS(), MaxSightCycles.TimeMS(),
-		sightcounts[3], sightcounts[0], sightcounts[1], sightcounts[2], sightcounts[4], sightcounts[5]);
+		sightcounts[3], sightcounts[0], sightcounts[1], sightcounts[2], sightcounts[4], sightcounts[5],
+		SerialTraces, ParallelTraces);
 	return out;
 }
 
@@ -955,5 +1164,6 @@ void P_ResetSightCounters (bool full)
 		MaxSightCycles = SightCycles;
 	}
 	SightCycles.Reset();
-	memset (sightcounts, 0, sizeof(sightcounts));
+	memset (MainSight.sightcounts, 0, sizeof(MainSight.sightcounts));
+	SerialTraces = ParallelTraces = 0;
 }
@@ -1440,11 +1440,7 @@ void P_PredictPlayer (player_t *player)
 
 	while (block != NULL)
 	{
-		if (block->NextActor != NULL)
-		{
-			block->NextActor->PrevActor = block->PrevActor;
-		}
-		*(block->PrevActor) = block->NextActor;
+		act->Level->blockmap.UnlinkActor(block);
 		block = block->NextBlock;
 	}
 	act->BlockNode = NULL;
@@ -1578,17 +1574,11 @@ void P_UnPredictPlayer ()
 			act->touching_lineportallist = RestoreNodeList(act, lineportal_list, &FLinePortal::lineportal_thinglist, PredictionPortalLines_sprev_Backup, PredictionPortalLinesBackup);
 		}
 
-		// Now fix the pointers in the blocknode chain
-		FBlockNode *block = act->BlockNode;
-
-		while (block != NULL)
+		// Now put the actor back into the entries it left in its blocks.
+		bool singleblock = act->BlockNode != NULL && act->BlockNode->NextBlock == NULL;
+		for (FBlockNode *block = act->BlockNode; block != NULL; block = block->NextBlock)
 		{
-			*(block->PrevActor) = block;
-			if (block->NextActor != NULL)
-			{
-				block->NextActor->PrevActor = &block->NextActor;
-			}
-			block = block->NextBlock;
+			act->Level->blockmap.RestoreActor(block, singleblock);
 		}
 
 		actInvSel = InvSel;
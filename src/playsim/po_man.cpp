@@ -1026,7 +1026,6 @@ void FPolyObj::UnLinkPolyobj ()
 bool FPolyObj::CheckMobjBlocking (side_t *sd)
 {
 	static TArray<AActor *> checker;
-	FBlockNode *block;
 	AActor *mobj;
 	int i, j, k;
 	int left, right, top, bottom;
@@ -1059,9 +1058,12 @@ bool FPolyObj::CheckMobjBlocking (side_t *sd)
 	{
 		for (i = left; i <= right; i++)
 		{
-			for (block = Level->blockmap.blocklinks[j+i]; block != nullptr; block = block->NextActor)
+			auto &links = Level->blockmap.blocklinks[j+i];
+			for (unsigned b = links.Size(); b-- > 0; )
 			{
-				mobj = block->Me;
+				// Actors moved by P_TryMove below get relinked behind the current position.
+				mobj = links[b].Me;
+				if (mobj == nullptr) continue;
 				for (k = (int)checker.Size()-1; k >= 0; --k)
 				{
 					if (checker[k] == mobj)
@@ -41,7 +41,11 @@
 #include "r_data/models/models.h"
 #include "r_data/models/models_ue1.h"
 #include "r_data/models/models_obj.h"
+#include "r_data/models/models_iqm.h"
 #include "i_time.h"
+#include "c_dispatch.h"
+#include "parallel_for.h"
+#include "doomerrors.h"
 
 #ifdef _MSC_VER
 #pragma warning(disable:4244) // warning C4244: conversion from 'double' to 'float', possible loss of data
@@ -454,6 +458,10 @@ static unsigned FindModel(const char * path, const char * modelfile)
 	{
 		model = new FMD3Model;
 	}
+	else if (len >= 16 && !memcmp(buffer, "INTERQUAKEMODEL", 16))
+	{
+		model = new FIQMModel;
+	}
 
 	if (model != nullptr)
 	{
@@ -479,6 +487,7 @@ static unsigned FindModel(const char * path, const char * modelfile)
 	}
 	// The vertex buffer cannot be initialized here because this gets called before OpenGL is initialized
 	model->mFileName = fullname;
+	model->mLumpNum = lump;
 	return Models.Push(model);
 }
 
@@ -500,6 +509,7 @@ void InitModels()
 	for (unsigned i = 0; i < Voxels.Size(); i++)
 	{
 		FVoxelModel *md = new FVoxelModel(Voxels[i], false);
+		md->mLumpNum = Voxels[i]->LumpNum;
 		Voxels[i]->VoxelIndex = Models.Push(md);
 	}
 	// now create GL model frames for the voxeldefs
@@ -541,11 +551,32 @@ void InitModels()
 
 	int Lump;
 	int lastLump = 0;
+	unsigned firstModel = Models.Size();
 	while ((Lump = Wads.FindLump("MODELDEF", &lastLump)) != -1)
 	{
 		ParseModelDefLump(Lump);
 	}
 
+	// Errors cannot be thrown from a job, so they get rethrown from here.
+	unsigned numModels = Models.Size() - firstModel;
+	TArray<FString> errors(numModels, true);
+	parallel_for((int)numModels, [&](int i)
+	{
+		try
+		{
+			Models[firstModel + i]->ParseData();
+		}
+		catch (CRecoverableError &err)
+		{
+			errors[i] = err.GetMessage();
+		}
+	});
+	for (unsigned i = 0; i < numModels; i++)
+	{
+		if (errors[i].IsNotEmpty()) I_Error("%s", errors[i].GetChars());
+		Models[firstModel + i]->FinishLoad();
+	}
+
 	// create a hash table for quick access
 	SpriteModelHash.Resize(SpriteModelFrames.Size ());
 	memset(SpriteModelHash.Data(), 0xff, SpriteModelFrames.Size () * sizeof(int));
@@ -938,3 +969,63 @@ bool IsHUDModelForPlayerAvailable (player_t * player)
 	return ( smf != nullptr );
 }
 
+
+//===========================================================================
+//
+// benchmodels <class> [count]
+//
+// Spawns a grid of actors in front of the player to get a scene that is
+// dominated by model rendering. Use 'bench' to measure it. zdoomtest.pk3,
+// written by tests/maketestwad, has an animated IQM model for this in
+// BenchIQMModel and an empty map for it in zdoomtest.wad's TEST03.
+//
+//===========================================================================
+
+CCMD(benchmodels)
+{
+	if (gamestate != GS_LEVEL || players[consoleplayer].mo == nullptr)
+	{
+		Printf("benchmodels can only be used inside a level\n");
+		return;
+	}
+	if (netgame || demorecording)
+	{
+		Printf("benchmodels cannot be used in net games or while recording a demo\n");
+		return;
+	}
+	if (argv.argc() < 2)
+	{
+		Printf("Usage: benchmodels <actor class> [count]\n");
+		return;
+	}
+
+	PClassActor *cls = PClass::FindActor(argv[1]);
+	if (cls == nullptr)
+	{
+		Printf("Unknown actor class '%s'\n", argv[1]);
+		return;
+	}
+	AActor *defaults = GetDefaultByType(cls);
+	if (FindModelFrame(cls, defaults->sprite, defaults->frame, false) == nullptr)
+	{
+		Printf("Warning: '%s' is not drawn with a model in its spawn frame\n", cls->TypeName.GetChars());
+	}
+
+	int count = argv.argc() > 2 ? clamp(atoi(argv[2]), 1, 10000) : 100;
+	int side = (int)ceil(sqrt((double)count));
+	double spacing = MAX(defaults->radius * 2 + 8, 32.);
+
+	AActor *pmo = players[consoleplayer].mo;
+	DVector2 forward = pmo->Angles.Yaw.ToVector();
+	DVector2 right(forward.Y, -forward.X);
+
+	int spawned = 0;
+	for (int i = 0; i < count; i++)
+	{
+		int row = i / side;
+		int col = i % side;
+		DVector2 pos = pmo->Pos().XY() + forward * (spacing * (row + 2)) + right * (spacing * (col - side / 2));
+		if (Spawn(primaryLevel, cls, DVector3(pos, ONFLOORZ), ALLOW_REPLACE) != nullptr) spawned++;
+	}
+	Printf("Spawned %d actors of class %s\n", spawned, cls->TypeName.GetChars());
+}
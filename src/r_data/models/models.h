@@ -70,7 +70,7 @@ public:
 	virtual void BeginDrawModel(AActor *actor, FSpriteModelFrame *smf, const VSMatrix &objectToWorldMatrix, bool mirrored) = 0;
 	virtual void EndDrawModel(AActor *actor, FSpriteModelFrame *smf) = 0;
 
-	virtual IModelVertexBuffer *CreateVertexBuffer(bool needindex, bool singleframe) = 0;
+	virtual IModelVertexBuffer *CreateVertexBuffer(bool needindex, bool singleframe, bool skinned) = 0;
 
 	virtual VSMatrix GetViewToWorldMatrix() = 0;
 
@@ -78,6 +78,7 @@ public:
 	virtual void EndDrawHUDModel(AActor *actor) = 0;
 
 	virtual void SetInterpolation(double interpolation) = 0;
+	virtual void SetBones(const TArray<VSMatrix> &bones) {}	// renderers without bone support draw the bind pose
 	virtual void SetMaterial(FTexture *skin, bool clampNoFilter, int translation) = 0;
 	virtual void DrawArrays(int start, int count) = 0;
 	virtual void DrawElements(int numIndices, size_t offset) = 0;
@@ -111,6 +112,37 @@ struct FModelVertex
 	}
 };
 
+// Bone palette indices and weights of skeletal models. They are kept in a
+// stream of their own so that the vertices of all other models stay small.
+struct FModelVertexBones
+{
+	uint8_t selector[4];
+	uint8_t weight[4];
+
+	void SetSelector(int b0, int b1, int b2, int b3)
+	{
+		selector[0] = b0;
+		selector[1] = b1;
+		selector[2] = b2;
+		selector[3] = b3;
+	}
+
+	void SetWeight(int w0, int w1, int w2, int w3)
+	{
+		weight[0] = w0;
+		weight[1] = w1;
+		weight[2] = w2;
+		weight[3] = w3;
+	}
+};
+
+// Vertex layout of the hardware buffers of skeletal models.
+struct FSkinnedModelVertex
+{
+	FModelVertex vertex;
+	FModelVertexBones bones;
+};
+
 #define VMO ((FModelVertex*)NULL)
 
 class FModelRenderer;
@@ -127,6 +159,21 @@ public:
 	virtual void UnlockIndexBuffer() = 0;
 
 	virtual void SetupFrame(FModelRenderer *renderer, unsigned int frame1, unsigned int frame2, unsigned int size) = 0;
+
+	// Skinned buffers get their bone stream after the vertices have been
+	// unlocked. Renderers that draw the bind pose can ignore it.
+	virtual void SetVertexBones(const FModelVertexBones *bones, unsigned int size) {}
+};
+
+// The contents of a model's vertex buffer.
+struct FModelMesh
+{
+	TArray<FModelVertex> Vertices;
+	TArray<unsigned int> Indices;	// empty if the model draws without an index buffer
+	TArray<FModelVertexBones> Bones;	// one per vertex for skeletal models, otherwise empty
+	bool SingleFrame = true;
+
+	TArray<TArray<uint8_t>> Lumps;	// the lumps named by GetMeshLumps, in that order
 };
 
 class FModel
@@ -138,21 +185,46 @@ public:
 	virtual bool Load(const char * fn, int lumpnum, const char * buffer, int length) = 0;
 	virtual int FindFrame(const char * name) = 0;
 	virtual void RenderFrame(FModelRenderer *renderer, FTexture * skin, int frame, int frame2, double inter, int translation=0) = 0;
-	virtual void BuildVertexBuffer(FModelRenderer *renderer) = 0;
+	virtual void BuildVertexBuffer(FModelRenderer *renderer);
 	virtual void AddSkins(uint8_t *hitlist) = 0;
 	virtual float getAspectFactor(FLevelLocals *) { return 1.f; }
 
+	// Creating the vertex data is split up so that the precacher can do it for
+	// many models at once. GetMeshLumps runs on the main thread and names the
+	// lumps BuildMesh needs. BuildMesh must not touch anything but the model
+	// and the mesh since it runs on the job system.
+	virtual void GetMeshLumps(TArray<int> &lumps) {}
+	virtual void BuildMesh(FModelMesh &mesh) {}
+
+	// Models that need more than their vertex buffer for rendering must always build their mesh.
+	virtual bool CanCacheMesh() { return mLumpNum >= 0; }
+
+	// Load can leave the parsing that only touches the model to ParseData,
+	// which InitModels runs on the job system for all models in MODELDEF.
+	// FinishLoad then looks up textures and the like on the main thread.
+	virtual void ParseData() {}
+	virtual void FinishLoad() {}
+
 	void SetVertexBuffer(FModelRenderer *renderer, IModelVertexBuffer *buffer) { mVBuf[renderer->GetType()] = buffer; }
 	IModelVertexBuffer *GetVertexBuffer(FModelRenderer *renderer) const { return mVBuf[renderer->GetType()]; }
 	void DestroyVertexBuffer();
+	bool UploadCachedMesh(FModelRenderer *renderer);
+	void UploadMesh(FModelRenderer *renderer, const FModelMesh &mesh);
+	void ReadMeshLumps(FModelMesh &mesh);
 
 	const FSpriteModelFrame *curSpriteMDLFrame;
 	int curMDLIndex;
 	void PushSpriteMDLFrame(const FSpriteModelFrame *smf, int index) { curSpriteMDLFrame = smf; curMDLIndex = index; };
 
 	FString mFileName;
+	int mLumpNum = -1;
+
+protected:
+	unsigned int mNumMeshIndices = 0;
 
 private:
+	void CreateVertexBuffer(FModelRenderer *renderer, const FModelVertex *vertices, const FModelVertexBones *bones, unsigned int numvertices, const unsigned int *indices, unsigned int numindices, bool singleframe);
+
 	IModelVertexBuffer *mVBuf[NumModelRendererTypes];
 };
 
@@ -233,7 +305,6 @@ protected:
 	};
 
 
-	int				mLumpNum;
 	DMDHeader	    header;
 	DMDInfo			info;
 	FTextureID *	skins;
@@ -249,7 +320,6 @@ protected:
 public:
 	FDMDModel() 
 	{ 
-		mLumpNum = -1;
 		frames = NULL;
 		skins = NULL;
 		for (int i = 0; i < MAX_LODS; i++)
@@ -265,11 +335,12 @@ public:
 	virtual bool Load(const char * fn, int lumpnum, const char * buffer, int length);
 	virtual int FindFrame(const char * name);
 	virtual void RenderFrame(FModelRenderer *renderer, FTexture * skin, int frame, int frame2, double inter, int translation=0);
-	virtual void LoadGeometry();
+	virtual void LoadGeometry(const char *buffer);
 	virtual void AddSkins(uint8_t *hitlist);
 
 	void UnloadGeometry();
-	void BuildVertexBuffer(FModelRenderer *renderer);
+	void GetMeshLumps(TArray<int> &lumps) override;
+	void BuildMesh(FModelMesh &mesh) override;
 
 };
 
@@ -281,7 +352,7 @@ public:
 	virtual ~FMD2Model();
 
 	virtual bool Load(const char * fn, int lumpnum, const char * buffer, int length);
-	virtual void LoadGeometry();
+	virtual void LoadGeometry(const char *buffer);
 
 };
 
@@ -340,7 +411,6 @@ class FMD3Model : public FModel
 	};
 
 	int numTags;
-	int mLumpNum;
 
 	TArray<MD3Frame> Frames;
 	TArray<MD3Surface> Surfaces;
@@ -351,8 +421,9 @@ public:
 	virtual bool Load(const char * fn, int lumpnum, const char * buffer, int length);
 	virtual int FindFrame(const char * name);
 	virtual void RenderFrame(FModelRenderer *renderer, FTexture * skin, int frame, int frame2, double inter, int translation=0);
-	void LoadGeometry();
-	void BuildVertexBuffer(FModelRenderer *renderer);
+	void LoadGeometry(const char *buffer);
+	void GetMeshLumps(TArray<int> &lumps) override;
+	void BuildMesh(FModelMesh &mesh) override;
 	virtual void AddSkins(uint8_t *hitlist);
 };
 
@@ -391,24 +462,20 @@ protected:
 	FVoxel *mVoxel;
 	bool mOwningVoxel;	// if created through MODELDEF deleting this object must also delete the voxel object
 	FTextureID mPalette;
-	unsigned int mNumIndices;
-	TArray<FModelVertex> mVertices;
-	TArray<unsigned int> mIndices;
 	
-	void MakeSlabPolys(int x, int y, kvxslab_t *voxptr, FVoxelMap &check);
-	void AddFace(int x1, int y1, int z1, int x2, int y2, int z2, int x3, int y3, int z3, int x4, int y4, int z4, uint8_t color, FVoxelMap &check);
-	unsigned int AddVertex(FModelVertex &vert, FVoxelMap &check);
+	void MakeSlabPolys(int x, int y, kvxslab_t *voxptr, FVoxelMap &check, FModelMesh &mesh);
+	void AddFace(int x1, int y1, int z1, int x2, int y2, int z2, int x3, int y3, int z3, int x4, int y4, int z4, uint8_t color, FVoxelMap &check, FModelMesh &mesh);
+	unsigned int AddVertex(FModelVertex &vert, FVoxelMap &check, FModelMesh &mesh);
 
 public:
 	FVoxelModel(FVoxel *voxel, bool owned);
 	~FVoxelModel();
 	bool Load(const char * fn, int lumpnum, const char * buffer, int length);
-	void Initialize();
 	virtual int FindFrame(const char * name);
 	virtual void RenderFrame(FModelRenderer *renderer, FTexture * skin, int frame, int frame2, double inter, int translation=0);
 	virtual void AddSkins(uint8_t *hitlist);
 	FTextureID GetPaletteTexture() const { return mPalette; }
-	void BuildVertexBuffer(FModelRenderer *renderer);
+	void BuildMesh(FModelMesh &mesh) override;
 	float getAspectFactor(FLevelLocals *) override;
 };
 
@@ -463,6 +530,8 @@ struct FSpriteModelFrame
 FSpriteModelFrame * FindModelFrame(const PClass * ti, int sprite, int frame, bool dropped);
 bool IsHUDModelForPlayerAvailable(player_t * player);
 void FlushModels();
+void PrecacheModels(FModelRenderer *renderer, const TArray<FModel *> &models);
+void FlushModelDiskCache();
 
 
 extern TDeletingArray<FModel*> Models;
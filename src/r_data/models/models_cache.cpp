@@ -0,0 +1,327 @@
+/*
+** models_cache.cpp
+** Vertex buffer creation for models, and a disk cache of the results
+**
+**---------------------------------------------------------------------------
+** Copyright 2019 GZDoom maintainers and contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** Each cache entry is one uncompressed file in <cache path>/models, named
+** after a hash of the model's class and source lumps. The file holds the
+** vertex, bone and index data exactly as the vertex buffer takes it so that
+** it can be mapped and copied straight into the buffer.
+** The entries share the index and size limit handling of the texture cache,
+** see diskcache.h.
+**
+*/
+
+#include <memory>
+#include <typeinfo>
+#include "models.h"
+#include "w_wad.h"
+#include "md5.h"
+#include "files.h"
+#include "diskcache.h"
+#include "m_swap.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "parallel_for.h"
+
+CVAR(Bool, gl_model_diskcache, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+CVAR(Int, gl_model_diskcache_size, 256, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// in MB
+
+static const char CacheMagic[4] = { 'G', 'Z', 'M', 'C' };
+static const uint32_t CacheVersion = 3;
+
+// Meshes of this many models are held in memory at once while precaching.
+static const unsigned PrecacheBatchSize = 64;
+
+static FDiskCacheIndex CacheIndex("models", ".gzmc", gl_model_diskcache_size);
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static bool GetCacheName(FModel *model, FString &name)
+{
+	if (!gl_model_diskcache || !model->CanCacheMesh()) return false;
+
+	// OBJ and voxel models build their mesh from what Load parsed, so they name no lumps.
+	TArray<int> lumps;
+	model->GetMeshLumps(lumps);
+	if (lumps.Size() == 0) lumps.Push(model->mLumpNum);
+
+	MD5Context md5;
+	md5.Update((const uint8_t *)&CacheVersion, sizeof(CacheVersion));
+	const char *modeltype = typeid(*model).name();
+	md5.Update((const uint8_t *)modeltype, (unsigned)strlen(modeltype));
+	for (int lump : lumps)
+	{
+		if (lump < 0) return false;
+		uint8_t digest[16];
+		Wads.GetLumpDigest(lump, digest);
+		md5.Update(digest, 16);
+	}
+	uint8_t digest[16];
+	md5.Final(digest);
+
+	name = "";
+	for (int i = 0; i < 16; i++) name.AppendFormat("%02x", digest[i]);
+	return true;
+}
+
+//==========================================================================
+//
+// FlushModelDiskCache
+//
+// Writes the index. Called after precaching and on shutdown.
+//
+//==========================================================================
+
+void FlushModelDiskCache()
+{
+	CacheIndex.Flush();
+}
+
+//==========================================================================
+//
+// FModel :: CreateVertexBuffer
+//
+//==========================================================================
+
+void FModel::CreateVertexBuffer(FModelRenderer *renderer, const FModelVertex *vertices, const FModelVertexBones *bones, unsigned int numvertices, const unsigned int *indices, unsigned int numindices, bool singleframe)
+{
+	auto vbuf = renderer->CreateVertexBuffer(numindices > 0, singleframe, bones != nullptr);
+	SetVertexBuffer(renderer, vbuf);
+
+	FModelVertex *vertptr = vbuf->LockVertexBuffer(numvertices);
+	memcpy(vertptr, vertices, numvertices * sizeof(FModelVertex));
+	vbuf->UnlockVertexBuffer();
+	if (bones != nullptr) vbuf->SetVertexBones(bones, numvertices);
+
+	if (numindices > 0)
+	{
+		unsigned int *indxptr = vbuf->LockIndexBuffer(numindices);
+		memcpy(indxptr, indices, numindices * sizeof(unsigned int));
+		vbuf->UnlockIndexBuffer();
+	}
+	mNumMeshIndices = numindices;
+}
+
+//==========================================================================
+//
+// FModel :: UploadCachedMesh
+//
+// Creates the vertex buffer from the disk cache if the model is in there.
+// The file gets mapped if possible so that the data is only copied once.
+//
+//==========================================================================
+
+bool FModel::UploadCachedMesh(FModelRenderer *renderer)
+{
+	FString name;
+	if (!GetCacheName(this, name)) return false;
+
+	FString path = CacheIndex.EntryPath(name);
+	FileReader fr;
+	TArray<uint8_t> data;
+	const uint8_t *buffer;
+	size_t length;
+	if (fr.OpenFileMapped(path))
+	{
+		buffer = (const uint8_t *)fr.GetBuffer();
+		length = fr.GetLength();
+	}
+	else if (fr.OpenFile(path))
+	{
+		data = fr.Read();
+		buffer = data.Data();
+		length = data.Size();
+	}
+	else return false;
+
+	const size_t headersize = 4 + 4 * sizeof(uint32_t);
+	if (length < headersize || memcmp(buffer, CacheMagic, 4))
+	{
+		fr.Close();
+		CacheIndex.Remove(name);
+		return false;
+	}
+
+	uint32_t header[4];
+	memcpy(header, buffer + 4, sizeof(header));
+	uint32_t version = LittleLong(header[0]);
+	uint32_t flags = LittleLong(header[1]);
+	uint32_t numvertices = LittleLong(header[2]);
+	uint32_t numindices = LittleLong(header[3]);
+	size_t vertexsize = sizeof(FModelVertex) + ((flags & 2) ? sizeof(FModelVertexBones) : 0);
+	if (version != CacheVersion || numvertices == 0 || numvertices > (length - headersize) / vertexsize ||
+		length != headersize + numvertices * vertexsize + (size_t)numindices * sizeof(unsigned int))
+	{
+		// Damaged or from another version. Delete it so that it gets stored again.
+		fr.Close();
+		CacheIndex.Remove(name);
+		return false;
+	}
+
+	auto vertices = (const FModelVertex *)(buffer + headersize);
+	auto bones = (flags & 2) ? (const FModelVertexBones *)(buffer + headersize + numvertices * sizeof(FModelVertex)) : nullptr;
+	auto indices = (const unsigned int *)(buffer + headersize + numvertices * vertexsize);
+	CreateVertexBuffer(renderer, vertices, bones, numvertices, indices, numindices, !!(flags & 1));
+	CacheIndex.Add(name, length);
+	return true;
+}
+
+//==========================================================================
+//
+// FModel :: UploadMesh
+//
+// Creates the vertex buffer from a freshly built mesh and stores the
+// mesh in the disk cache.
+//
+//==========================================================================
+
+void FModel::UploadMesh(FModelRenderer *renderer, const FModelMesh &mesh)
+{
+	bool hasbones = mesh.Bones.Size() > 0 && mesh.Bones.Size() == mesh.Vertices.Size();
+	CreateVertexBuffer(renderer, mesh.Vertices.Data(), hasbones ? mesh.Bones.Data() : nullptr, mesh.Vertices.Size(), mesh.Indices.Data(), mesh.Indices.Size(), mesh.SingleFrame);
+
+	FString name;
+	if (mesh.Vertices.Size() == 0 || !GetCacheName(this, name)) return;
+
+	CacheIndex.Path(true);
+	FString path = CacheIndex.EntryPath(name);
+	std::unique_ptr<FileWriter> fw(FileWriter::Open(path));
+	if (fw == nullptr) return;
+
+	uint32_t flags = uint32_t(mesh.SingleFrame) | (hasbones ? 2 : 0);
+	uint32_t header[4] = { LittleLong(CacheVersion), LittleLong(flags), LittleLong(mesh.Vertices.Size()), LittleLong(mesh.Indices.Size()) };
+	size_t vsize = mesh.Vertices.Size() * sizeof(FModelVertex);
+	size_t bsize = hasbones ? mesh.Bones.Size() * sizeof(FModelVertexBones) : 0;
+	size_t isize = mesh.Indices.Size() * sizeof(unsigned int);
+	bool ok = fw->Write(CacheMagic, 4) == 4 && fw->Write(header, sizeof(header)) == sizeof(header) &&
+		fw->Write(mesh.Vertices.Data(), vsize) == vsize && (bsize == 0 || fw->Write(mesh.Bones.Data(), bsize) == bsize) &&
+		(isize == 0 || fw->Write(mesh.Indices.Data(), isize) == isize);
+	fw.reset();
+	if (!ok)
+	{
+		remove(path);
+		return;
+	}
+	CacheIndex.Add(name, 4 + sizeof(header) + vsize + bsize + isize);
+	CacheIndex.Evict();
+}
+
+//==========================================================================
+//
+// FModel :: ReadMeshLumps
+//
+//==========================================================================
+
+void FModel::ReadMeshLumps(FModelMesh &mesh)
+{
+	TArray<int> lumps;
+	GetMeshLumps(lumps);
+	for (int lump : lumps)
+	{
+		mesh.Lumps.Push(Wads.ReadLumpIntoArray(lump));
+	}
+}
+
+//==========================================================================
+//
+// FModel :: BuildVertexBuffer
+//
+//==========================================================================
+
+void FModel::BuildVertexBuffer(FModelRenderer *renderer)
+{
+	if (GetVertexBuffer(renderer) || UploadCachedMesh(renderer)) return;
+
+	FModelMesh mesh;
+	ReadMeshLumps(mesh);
+	BuildMesh(mesh);
+	mesh.Lumps.Reset();
+	UploadMesh(renderer, mesh);
+}
+
+//==========================================================================
+//
+// PrecacheModels
+//
+// Creates the vertex buffers of all given models. Meshes that are not in
+// the disk cache get built on the job system, the lump reads and buffer
+// uploads around that stay on the main thread.
+//
+//==========================================================================
+
+void PrecacheModels(FModelRenderer *renderer, const TArray<FModel *> &models)
+{
+	TArray<FModel *> build;
+	for (auto model : models)
+	{
+		if (!model->GetVertexBuffer(renderer) && !model->UploadCachedMesh(renderer))
+		{
+			build.Push(model);
+		}
+	}
+
+	for (unsigned start = 0; start < build.Size(); start += PrecacheBatchSize)
+	{
+		unsigned count = MIN(build.Size() - start, PrecacheBatchSize);
+		TArray<FModelMesh> meshes(count, true);
+		for (unsigned i = 0; i < count; i++)
+		{
+			build[start + i]->ReadMeshLumps(meshes[i]);
+		}
+
+		parallel_for((int)count, [&](int i)
+		{
+			build[start + i]->BuildMesh(meshes[i]);
+			meshes[i].Lumps.Reset();
+		});
+
+		for (unsigned i = 0; i < count; i++)
+		{
+			build[start + i]->UploadMesh(renderer, meshes[i]);
+		}
+	}
+	FlushModelDiskCache();
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+CCMD(clearmodelcache)
+{
+	Printf("%u models removed from the cache\n", CacheIndex.Clear());
+}
@@ -0,0 +1,627 @@
+/*
+** models_iqm.cpp
+** Inter-Quake Model loader with GPU skinning
+**
+**---------------------------------------------------------------------------
+** Copyright 2019 GZDoom maintainers and contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include "w_wad.h"
+#include "cmdlib.h"
+#include "templates.h"
+#include "r_data/models/models_iqm.h"
+
+//===========================================================================
+//
+// IQM file structure
+//
+//===========================================================================
+
+#pragma pack(4)
+struct iqm_header_t
+{
+	char Magic[16];
+	uint32_t Version;
+	uint32_t FileSize;
+	uint32_t Flags;
+	uint32_t Num_Text, Ofs_Text;
+	uint32_t Num_Meshes, Ofs_Meshes;
+	uint32_t Num_VertexArrays, Num_Vertexes, Ofs_VertexArrays;
+	uint32_t Num_Triangles, Ofs_Triangles, Ofs_Adjacency;
+	uint32_t Num_Joints, Ofs_Joints;
+	uint32_t Num_Poses, Ofs_Poses;
+	uint32_t Num_Anims, Ofs_Anims;
+	uint32_t Num_Frames, Num_FrameChannels, Ofs_Frames, Ofs_Bounds;
+	uint32_t Num_Comment, Ofs_Comment;
+	uint32_t Num_Extensions, Ofs_Extensions;
+};
+
+struct iqm_mesh_t
+{
+	uint32_t Name;
+	uint32_t Material;
+	uint32_t First_Vertex, Num_Vertexes;
+	uint32_t First_Triangle, Num_Triangles;
+};
+
+struct iqm_vertexarray_t
+{
+	uint32_t Type;
+	uint32_t Flags;
+	uint32_t Format;
+	uint32_t Size;
+	uint32_t Offset;
+};
+
+struct iqm_joint_t
+{
+	uint32_t Name;
+	int32_t Parent;
+	float Translate[3], Rotate[4], Scale[3];
+};
+
+struct iqm_pose_t
+{
+	int32_t Parent;
+	uint32_t ChannelMask;
+	float ChannelOffset[10];
+	float ChannelScale[10];
+};
+
+struct iqm_anim_t
+{
+	uint32_t Name;
+	uint32_t First_Frame, Num_Frames;
+	float Framerate;
+	uint32_t Flags;
+};
+#pragma pack()
+
+enum
+{
+	IQM_VERSION = 2,
+
+	IQM_POSITION = 0,
+	IQM_TEXCOORD = 1,
+	IQM_NORMAL = 2,
+	IQM_BLENDINDEXES = 4,
+	IQM_BLENDWEIGHTS = 5,
+
+	IQM_UBYTE = 1,
+	IQM_FLOAT = 7,
+
+	IQM_MAX_JOINTS = 256,	// the vertex format stores the bone indices as bytes.
+};
+
+//===========================================================================
+//
+// Converts a joint or pose transform to a matrix
+//
+//===========================================================================
+
+static VSMatrix MakeBoneMatrix(const float *translate, const float *rotate, const float *scale)
+{
+	float x = rotate[0], y = rotate[1], z = rotate[2], w = rotate[3];
+	float len = sqrtf(x * x + y * y + z * z + w * w);
+	if (len > 0)
+	{
+		x /= len; y /= len; z /= len; w /= len;
+	}
+
+	FLOATTYPE rot[16] =
+	{
+		1 - 2 * (y * y + z * z), 2 * (x * y + w * z), 2 * (x * z - w * y), 0,
+		2 * (x * y - w * z), 1 - 2 * (x * x + z * z), 2 * (y * z + w * x), 0,
+		2 * (x * z + w * y), 2 * (y * z - w * x), 1 - 2 * (x * x + y * y), 0,
+		0, 0, 0, 1
+	};
+
+	VSMatrix mat(0);
+	mat.translate(translate[0], translate[1], translate[2]);
+	mat.multMatrix(rot);
+	mat.scale(scale[0], scale[1], scale[2]);
+	return mat;
+}
+
+//===========================================================================
+//
+// The vertices get their y and z swapped like MD3's so the bones have
+// to be converted to that coordinate system as well.
+//
+//===========================================================================
+
+static VSMatrix SwapYZ(const VSMatrix &mat)
+{
+	FLOATTYPE m[16];
+	memcpy(m, mat.get(), sizeof(m));
+	for (int c = 0; c < 4; c++) std::swap(m[c * 4 + 1], m[c * 4 + 2]);
+	for (int r = 0; r < 4; r++) std::swap(m[4 + r], m[8 + r]);
+
+	VSMatrix result;
+	result.loadMatrix(m);
+	return result;
+}
+
+//===========================================================================
+//
+//
+//
+//===========================================================================
+
+bool FIQMModel::CheckLump(unsigned int offset, unsigned int count, unsigned int size, int length)
+{
+	return uint64_t(offset) + uint64_t(count) * size <= (uint64_t)length;
+}
+
+//===========================================================================
+//
+//
+//
+//===========================================================================
+
+bool FIQMModel::Load(const char * path, int lumpnum, const char * buffer, int length)
+{
+	const char *lumpname = Wads.GetLumpFullName(lumpnum);
+	if ((unsigned)length < sizeof(iqm_header_t))
+	{
+		Printf("%s: IQM header is truncated\n", lumpname);
+		return false;
+	}
+
+	auto hdr = (const iqm_header_t *)buffer;
+	if (memcmp(hdr->Magic, "INTERQUAKEMODEL", 16) || LittleLong(hdr->Version) != IQM_VERSION)
+	{
+		Printf("%s: Only IQM version %d is supported\n", lumpname, IQM_VERSION);
+		return false;
+	}
+
+	unsigned numText = LittleLong(hdr->Num_Text);
+	unsigned ofsText = LittleLong(hdr->Ofs_Text);
+	unsigned numMeshes = LittleLong(hdr->Num_Meshes);
+	unsigned ofsMeshes = LittleLong(hdr->Ofs_Meshes);
+	unsigned numVertexArrays = LittleLong(hdr->Num_VertexArrays);
+	unsigned ofsVertexArrays = LittleLong(hdr->Ofs_VertexArrays);
+	unsigned numJoints = LittleLong(hdr->Num_Joints);
+	unsigned ofsJoints = LittleLong(hdr->Ofs_Joints);
+	unsigned numPoses = LittleLong(hdr->Num_Poses);
+	unsigned ofsPoses = LittleLong(hdr->Ofs_Poses);
+	unsigned numAnims = LittleLong(hdr->Num_Anims);
+	unsigned ofsAnims = LittleLong(hdr->Ofs_Anims);
+	unsigned numFrames = LittleLong(hdr->Num_Frames);
+	unsigned numFrameChannels = LittleLong(hdr->Num_FrameChannels);
+	unsigned ofsFrames = LittleLong(hdr->Ofs_Frames);
+
+	NumVertices = LittleLong(hdr->Num_Vertexes);
+	NumTriangles = LittleLong(hdr->Num_Triangles);
+	OfsTriangles = LittleLong(hdr->Ofs_Triangles);
+
+	if (!CheckLump(ofsText, numText, 1, length) || (numText > 0 && buffer[ofsText + numText - 1] != 0) ||
+		!CheckLump(ofsMeshes, numMeshes, sizeof(iqm_mesh_t), length) ||
+		!CheckLump(ofsVertexArrays, numVertexArrays, sizeof(iqm_vertexarray_t), length) ||
+		!CheckLump(OfsTriangles, NumTriangles, 3 * sizeof(uint32_t), length) ||
+		!CheckLump(ofsJoints, numJoints, sizeof(iqm_joint_t), length) ||
+		!CheckLump(ofsPoses, numPoses, sizeof(iqm_pose_t), length) ||
+		!CheckLump(ofsAnims, numAnims, sizeof(iqm_anim_t), length) ||
+		!CheckLump(ofsFrames, numFrames, numFrameChannels * sizeof(uint16_t), length))
+	{
+		Printf("%s: IQM data exceeds the size of the file\n", lumpname);
+		return false;
+	}
+	if (numMeshes > MD3_MAX_SURFACES)
+	{
+		Printf("%s: IQM models may not have more than %d meshes\n", lumpname, MD3_MAX_SURFACES);
+		return false;
+	}
+	if (numJoints > IQM_MAX_JOINTS)
+	{
+		Printf("%s: IQM models may not have more than %d joints\n", lumpname, IQM_MAX_JOINTS);
+		return false;
+	}
+
+	auto text = [&](uint32_t ofs) -> const char *
+	{
+		ofs = LittleLong(ofs);
+		return ofs < numText ? buffer + ofsText + ofs : "";
+	};
+
+	auto meshes = (const iqm_mesh_t *)(buffer + ofsMeshes);
+	Meshes.Resize(numMeshes);
+	for (unsigned i = 0; i < numMeshes; i++)
+	{
+		IQMMesh &m = Meshes[i];
+		m.Name = text(meshes[i].Name);
+		m.Material = text(meshes[i].Material);
+		m.FirstVertex = LittleLong(meshes[i].First_Vertex);
+		m.NumVertices = LittleLong(meshes[i].Num_Vertexes);
+		m.FirstTriangle = LittleLong(meshes[i].First_Triangle);
+		m.NumTriangles = LittleLong(meshes[i].Num_Triangles);
+		if (uint64_t(m.FirstVertex) + m.NumVertices > NumVertices || uint64_t(m.FirstTriangle) + m.NumTriangles > NumTriangles)
+		{
+			Printf("%s: IQM mesh '%s' is out of range\n", lumpname, m.Name.GetChars());
+			return false;
+		}
+
+		m.Skin = FTextureID();
+		if (m.Material.IsNotEmpty())
+		{
+			FixPathSeperator(m.Material);
+			m.Skin = LoadSkin("", m.Material);
+			if (!m.Skin.isValid())
+				m.Skin = LoadSkin(path, m.Material);
+		}
+	}
+
+	// Only keep the vertex arrays the vertex format can hold.
+	auto arrays = (const iqm_vertexarray_t *)(buffer + ofsVertexArrays);
+	bool hasPosition = false;
+	VertexArrays.Clear();
+	for (unsigned i = 0; i < numVertexArrays; i++)
+	{
+		IQMVertexArray va = { LittleLong(arrays[i].Type), LittleLong(arrays[i].Format), LittleLong(arrays[i].Size), LittleLong(arrays[i].Offset) };
+		bool usable;
+		switch (va.Type)
+		{
+		case IQM_POSITION:
+		case IQM_NORMAL:
+			usable = va.Format == IQM_FLOAT && va.Size == 3;
+			break;
+
+		case IQM_TEXCOORD:
+			usable = va.Format == IQM_FLOAT && va.Size == 2;
+			break;
+
+		case IQM_BLENDINDEXES:
+			usable = va.Format == IQM_UBYTE && va.Size == 4;
+			break;
+
+		case IQM_BLENDWEIGHTS:
+			usable = (va.Format == IQM_UBYTE || va.Format == IQM_FLOAT) && va.Size == 4;
+			break;
+
+		default:
+			usable = false;
+			break;
+		}
+		if (!usable) continue;
+
+		unsigned elementsize = va.Size * (va.Format == IQM_FLOAT ? sizeof(float) : 1);
+		if (!CheckLump(va.Offset, NumVertices, elementsize, length))
+		{
+			Printf("%s: IQM vertex array exceeds the size of the file\n", lumpname);
+			return false;
+		}
+		if (va.Type == IQM_POSITION) hasPosition = true;
+		VertexArrays.Push(va);
+	}
+	if (!hasPosition)
+	{
+		Printf("%s: IQM model has no usable vertex positions\n", lumpname);
+		return false;
+	}
+
+	// The bind pose and its inverse in model space.
+	auto joints = (const iqm_joint_t *)(buffer + ofsJoints);
+	TArray<VSMatrix> baseframe(numJoints, true);
+	TArray<VSMatrix> inversebaseframe(numJoints, true);
+	JointParents.Resize(numJoints);
+	for (unsigned i = 0; i < numJoints; i++)
+	{
+		int parent = LittleLong(joints[i].Parent);
+		if (parent >= (int)i)
+		{
+			Printf("%s: IQM joints must come after their parents\n", lumpname);
+			return false;
+		}
+		JointParents[i] = parent < 0 ? -1 : parent;
+
+		baseframe[i] = MakeBoneMatrix(joints[i].Translate, joints[i].Rotate, joints[i].Scale);
+		baseframe[i].inverseMatrix(inversebaseframe[i]);
+		if (parent >= 0)
+		{
+			VSMatrix m = baseframe[parent];
+			m.multMatrix(baseframe[i]);
+			baseframe[i] = m;
+
+			m = inversebaseframe[i];
+			m.multMatrix(inversebaseframe[parent]);
+			inversebaseframe[i] = m;
+		}
+	}
+
+	// Animations. Models without usable poses are still drawn in their bind pose.
+	NumFrames = 0;
+	FrameMatrices.Clear();
+	Anims.Clear();
+	if (numFrames > 0 && numPoses == numJoints)
+	{
+		auto poses = (const iqm_pose_t *)(buffer + ofsPoses);
+		unsigned channels = 0;
+		for (unsigned i = 0; i < numPoses; i++)
+		{
+			uint32_t mask = LittleLong(poses[i].ChannelMask);
+			for (int k = 0; k < 10; k++) if (mask & (1 << k)) channels++;
+		}
+
+		if (channels == numFrameChannels)
+		{
+			NumFrames = numFrames;
+			FrameMatrices.Resize(numFrames * numJoints);
+
+			auto framedata = (const uint16_t *)(buffer + ofsFrames);
+			for (unsigned f = 0; f < numFrames; f++)
+			{
+				for (unsigned i = 0; i < numPoses; i++)
+				{
+					const iqm_pose_t &pose = poses[i];
+					uint32_t mask = LittleLong(pose.ChannelMask);
+					float ch[10];
+					for (int k = 0; k < 10; k++)
+					{
+						ch[k] = pose.ChannelOffset[k];
+						if (mask & (1 << k)) ch[k] += LittleShort(*framedata++) * pose.ChannelScale[k];
+					}
+
+					// Relative to the parent's animated transform so that frames can be interpolated before the joints are concatenated.
+					int parent = JointParents[i];
+					VSMatrix m = parent >= 0 ? baseframe[parent] : VSMatrix(0);
+					m.multMatrix(MakeBoneMatrix(&ch[0], &ch[3], &ch[7]));
+					m.multMatrix(inversebaseframe[i]);
+					FrameMatrices[f * numJoints + i] = SwapYZ(m);
+				}
+			}
+
+			auto anims = (const iqm_anim_t *)(buffer + ofsAnims);
+			for (unsigned i = 0; i < numAnims; i++)
+			{
+				IQMAnim anim = { text(anims[i].Name), LittleLong(anims[i].First_Frame), LittleLong(anims[i].Num_Frames) };
+				if (uint64_t(anim.FirstFrame) + anim.NumFrames <= numFrames) Anims.Push(anim);
+			}
+		}
+		else
+		{
+			Printf("%s: IQM frame channels do not match the poses, animation disabled\n", lumpname);
+		}
+	}
+
+	mLumpNum = lumpnum;
+	return true;
+}
+
+//===========================================================================
+//
+//
+//
+//===========================================================================
+
+void FIQMModel::GetMeshLumps(TArray<int> &lumps)
+{
+	lumps.Push(mLumpNum);
+}
+
+//===========================================================================
+//
+// Runs on a worker thread so it may only touch the lump data handed to it.
+// All offsets were validated by Load.
+//
+//===========================================================================
+
+void FIQMModel::BuildMesh(FModelMesh &mesh)
+{
+	const uint8_t *buffer = mesh.Lumps[0].Data();
+	unsigned numJoints = JointParents.Size();
+
+	mesh.Vertices.Resize(NumVertices);
+	mesh.Bones.Resize(NumVertices);
+	mesh.Indices.Resize(NumTriangles * 3);
+	mesh.SingleFrame = true;
+
+	for (unsigned i = 0; i < NumVertices; i++)
+	{
+		mesh.Vertices[i].Set(0, 0, 0, 0, 0);
+		mesh.Vertices[i].SetNormal(0, 0, 0);
+		mesh.Bones[i].SetSelector(0, 0, 0, 0);
+		mesh.Bones[i].SetWeight(0, 0, 0, 0);
+	}
+
+	for (auto &va : VertexArrays)
+	{
+		const uint8_t *data = buffer + va.Offset;
+		for (unsigned i = 0; i < NumVertices; i++)
+		{
+			FModelVertex &vert = mesh.Vertices[i];
+			FModelVertexBones &bones = mesh.Bones[i];
+			switch (va.Type)
+			{
+			case IQM_POSITION:
+			{
+				auto p = (const float *)data + i * 3;
+				vert.x = p[0];
+				vert.y = p[2];
+				vert.z = p[1];
+				break;
+			}
+
+			case IQM_TEXCOORD:
+			{
+				auto p = (const float *)data + i * 2;
+				vert.u = p[0];
+				vert.v = p[1];
+				break;
+			}
+
+			case IQM_NORMAL:
+			{
+				auto p = (const float *)data + i * 3;
+				vert.SetNormal(p[0], p[2], p[1]);
+				break;
+			}
+
+			case IQM_BLENDINDEXES:
+			{
+				auto p = data + i * 4;
+				int sel[4];
+				for (int k = 0; k < 4; k++) sel[k] = p[k] < numJoints ? p[k] : 0;
+				bones.SetSelector(sel[0], sel[1], sel[2], sel[3]);
+				break;
+			}
+
+			case IQM_BLENDWEIGHTS:
+				if (va.Format == IQM_UBYTE)
+				{
+					auto p = data + i * 4;
+					bones.SetWeight(p[0], p[1], p[2], p[3]);
+				}
+				else
+				{
+					auto p = (const float *)data + i * 4;
+					int w[4];
+					for (int k = 0; k < 4; k++) w[k] = clamp(int(p[k] * 255.f + 0.5f), 0, 255);
+					bones.SetWeight(w[0], w[1], w[2], w[3]);
+				}
+				break;
+			}
+		}
+	}
+
+	auto tris = (const uint32_t *)(buffer + OfsTriangles);
+	for (unsigned i = 0; i < NumTriangles * 3; i++)
+	{
+		unsigned index = LittleLong(tris[i]);
+		mesh.Indices[i] = index < NumVertices ? index : 0;
+	}
+}
+
+//===========================================================================
+//
+// for skin precaching
+//
+//===========================================================================
+
+void FIQMModel::AddSkins(uint8_t *hitlist)
+{
+	for (unsigned i = 0; i < Meshes.Size(); i++)
+	{
+		if (curSpriteMDLFrame->surfaceskinIDs[curMDLIndex][i].isValid())
+		{
+			hitlist[curSpriteMDLFrame->surfaceskinIDs[curMDLIndex][i].GetIndex()] |= FTextureManager::HIT_Flat;
+		}
+
+		if (Meshes[i].Skin.isValid())
+		{
+			hitlist[Meshes[i].Skin.GetIndex()] |= FTextureManager::HIT_Flat;
+		}
+	}
+}
+
+//===========================================================================
+//
+// Frames are addressed by animation name
+//
+//===========================================================================
+
+int FIQMModel::FindFrame(const char * name)
+{
+	for (unsigned i = 0; i < Anims.Size(); i++)
+	{
+		if (!Anims[i].Name.CompareNoCase(name)) return Anims[i].FirstFrame;
+	}
+	return -1;
+}
+
+//===========================================================================
+//
+// Each draw gets its own bone palette so every actor can be in a
+// different frame of the animation.
+//
+//===========================================================================
+
+void FIQMModel::RenderFrame(FModelRenderer *renderer, FTexture * skin, int frameno, int frameno2, double inter, int translation)
+{
+	TArray<VSMatrix> bones;
+
+	if (NumFrames > 0)
+	{
+		if ((unsigned)frameno >= NumFrames || (unsigned)frameno2 >= NumFrames) return;
+
+		unsigned numJoints = JointParents.Size();
+		const VSMatrix *from = &FrameMatrices[frameno * numJoints];
+		const VSMatrix *to = &FrameMatrices[frameno2 * numJoints];
+		FLOATTYPE t = (FLOATTYPE)inter;
+
+		bones.Resize(numJoints);
+		for (unsigned i = 0; i < numJoints; i++)
+		{
+			FLOATTYPE m[16];
+			const FLOATTYPE *a = from[i].get();
+			const FLOATTYPE *b = to[i].get();
+			for (int k = 0; k < 16; k++) m[k] = a[k] + (b[k] - a[k]) * t;
+
+			int parent = JointParents[i];
+			if (parent >= 0)
+			{
+				bones[i] = bones[parent];
+				bones[i].multMatrix(m);
+			}
+			else
+			{
+				bones[i].loadMatrix(m);
+			}
+		}
+	}
+
+	renderer->SetBones(bones);
+	for (unsigned i = 0; i < Meshes.Size(); i++)
+	{
+		IQMMesh &mesh = Meshes[i];
+
+		// Skins work like MD3's: MODELDEF's surface skins take precedence over the material stored in the model.
+		FTexture *surfaceSkin = skin;
+		if (!surfaceSkin)
+		{
+			if (curSpriteMDLFrame->surfaceskinIDs[curMDLIndex][i].isValid())
+			{
+				surfaceSkin = TexMan.GetTexture(curSpriteMDLFrame->surfaceskinIDs[curMDLIndex][i], true);
+			}
+			else if (mesh.Skin.isValid())
+			{
+				surfaceSkin = TexMan.GetTexture(mesh.Skin, true);
+			}
+
+			if (!surfaceSkin)
+			{
+				continue;
+			}
+		}
+
+		renderer->SetMaterial(surfaceSkin, false, translation);
+		GetVertexBuffer(renderer)->SetupFrame(renderer, 0, 0, NumVertices);
+		renderer->DrawElements(mesh.NumTriangles * 3, mesh.FirstTriangle * 3 * sizeof(unsigned int));
+	}
+	renderer->SetBones(TArray<VSMatrix>());
+}
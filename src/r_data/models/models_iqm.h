@@ -0,0 +1,58 @@
+#pragma once
+
+#include "models.h"
+
+// Inter-Quake Model (IQM v2). The vertices are skinned on the GPU: the model
+// computes one bone palette per draw and the vertex shader blends up to four
+// bones per vertex.
+class FIQMModel : public FModel
+{
+	struct IQMMesh
+	{
+		FString Name;
+		FString Material;
+		FTextureID Skin;
+		unsigned int FirstVertex;
+		unsigned int NumVertices;
+		unsigned int FirstTriangle;
+		unsigned int NumTriangles;
+	};
+
+	struct IQMVertexArray
+	{
+		unsigned int Type;
+		unsigned int Format;
+		unsigned int Size;
+		unsigned int Offset;
+	};
+
+	struct IQMAnim
+	{
+		FString Name;
+		unsigned int FirstFrame;
+		unsigned int NumFrames;
+	};
+
+	unsigned int NumVertices = 0;
+	unsigned int NumTriangles = 0;
+	unsigned int OfsTriangles = 0;
+	unsigned int NumFrames = 0;
+
+	TArray<IQMMesh> Meshes;
+	TArray<IQMVertexArray> VertexArrays;
+	TArray<IQMAnim> Anims;
+	TArray<int> JointParents;
+	TArray<VSMatrix> FrameMatrices;	// NumFrames * number of joints, relative to the parent joint
+
+	static bool CheckLump(unsigned int offset, unsigned int count, unsigned int size, int length);
+
+public:
+	FIQMModel() = default;
+
+	bool Load(const char * fn, int lumpnum, const char * buffer, int length) override;
+	int FindFrame(const char * name) override;
+	void RenderFrame(FModelRenderer *renderer, FTexture * skin, int frame, int frame2, double inter, int translation=0) override;
+	void GetMeshLumps(TArray<int> &lumps) override;
+	void BuildMesh(FModelMesh &mesh) override;
+	void AddSkins(uint8_t *hitlist) override;
+};
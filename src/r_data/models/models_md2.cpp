@@ -155,7 +155,19 @@ bool FDMDModel::Load(const char * path, int lumpnum, const char * buffer, int le
 		dmd_packedFrame_t *pfr = (dmd_packedFrame_t *)(temp + info.frameSize * i);
 
 		memcpy(frame->name, pfr->name, sizeof(pfr->name));
-		frame->vindex = UINT_MAX;
+	}
+
+	memcpy(lodInfo, buffer + info.offsetLODs, info.numLODs * sizeof(DMDLoDInfo));
+	for (i = 0; i < info.numLODs; i++)
+	{
+		lodInfo[i].numTriangles = LittleLong(lodInfo[i].numTriangles);
+		lodInfo[i].offsetTriangles = LittleLong(lodInfo[i].offsetTriangles);
+	}
+
+	// The vertex buffer holds every frame's triangles in sequence.
+	for (i = 0; i < info.numFrames; i++)
+	{
+		frames[i].vindex = i * lodInfo[0].numTriangles * 3;
 	}
 	mLumpNum = lumpnum;
 	return true;
@@ -167,11 +179,9 @@ bool FDMDModel::Load(const char * path, int lumpnum, const char * buffer, int le
 //
 //===========================================================================
 
-void FDMDModel::LoadGeometry()
+void FDMDModel::LoadGeometry(const char *buffer)
 {
 	static int axis[3] = { VX, VY, VZ };
-	FMemLump lumpdata = Wads.ReadLump(mLumpNum);
-	const char *buffer = (const char *)lumpdata.GetMem();
 	texCoords = new FTexCoord[info.numTexCoords];
 	memcpy(texCoords, buffer + info.offsetTexCoords, info.numTexCoords * sizeof(FTexCoord));
 
@@ -200,11 +210,8 @@ void FDMDModel::LoadGeometry()
 		}
 	}
 
-	memcpy(lodInfo, buffer+info.offsetLODs, info.numLODs * sizeof(DMDLoDInfo));
 	for(i = 0; i < info.numLODs; i++)
 	{
-		lodInfo[i].numTriangles = LittleLong(lodInfo[i].numTriangles);
-		lodInfo[i].offsetTriangles = LittleLong(lodInfo[i].offsetTriangles);
 		if (lodInfo[i].numTriangles > 0)
 		{
 			lods[i].triangles = new FTriangle[lodInfo[i].numTriangles];
@@ -277,47 +284,49 @@ FDMDModel::~FDMDModel()
 //
 //===========================================================================
 
-void FDMDModel::BuildVertexBuffer(FModelRenderer *renderer)
+void FDMDModel::GetMeshLumps(TArray<int> &lumps)
 {
-	if (!GetVertexBuffer(renderer))
-	{
-		LoadGeometry();
-
-		int VertexBufferSize = info.numFrames * lodInfo[0].numTriangles * 3;
-		unsigned int vindex = 0;
+	lumps.Push(mLumpNum);
+}
 
-		auto vbuf = renderer->CreateVertexBuffer(false, info.numFrames == 1);
-		SetVertexBuffer(renderer, vbuf);
+//===========================================================================
+//
+// Unpacks every frame into the mesh. This runs on a worker thread so it
+// may only touch the lump data handed to it.
+//
+//===========================================================================
 
-		FModelVertex *vertptr = vbuf->LockVertexBuffer(VertexBufferSize);
+void FDMDModel::BuildMesh(FModelMesh &mesh)
+{
+	LoadGeometry((const char *)mesh.Lumps[0].Data());
 
-		for (int i = 0; i < info.numFrames; i++)
-		{
-			DMDModelVertex *vert = framevtx[i].vertices;
-			DMDModelVertex *norm = framevtx[i].normals;
+	unsigned int vindex = 0;
+	mesh.Vertices.Resize(info.numFrames * lodInfo[0].numTriangles * 3);
+	mesh.SingleFrame = info.numFrames == 1;
 
-			frames[i].vindex = vindex;
+	for (int i = 0; i < info.numFrames; i++)
+	{
+		DMDModelVertex *vert = framevtx[i].vertices;
+		DMDModelVertex *norm = framevtx[i].normals;
 
-			FTriangle *tri = lods[0].triangles;
+		FTriangle *tri = lods[0].triangles;
 
-			for (int i = 0; i < lodInfo[0].numTriangles; i++)
+		for (int i = 0; i < lodInfo[0].numTriangles; i++)
+		{
+			for (int j = 0; j < 3; j++)
 			{
-				for (int j = 0; j < 3; j++)
-				{
 
-					int ti = tri->textureIndices[j];
-					int vi = tri->vertexIndices[j];
+				int ti = tri->textureIndices[j];
+				int vi = tri->vertexIndices[j];
 
-					FModelVertex *bvert = &vertptr[vindex++];
-					bvert->Set(vert[vi].xyz[0], vert[vi].xyz[1], vert[vi].xyz[2], (float)texCoords[ti].s / info.skinWidth, (float)texCoords[ti].t / info.skinHeight);
-					bvert->SetNormal(norm[vi].xyz[0], norm[vi].xyz[1], norm[vi].xyz[2]);
-				}
-				tri++;
+				FModelVertex *bvert = &mesh.Vertices[vindex++];
+				bvert->Set(vert[vi].xyz[0], vert[vi].xyz[1], vert[vi].xyz[2], (float)texCoords[ti].s / info.skinWidth, (float)texCoords[ti].t / info.skinHeight);
+				bvert->SetNormal(norm[vi].xyz[0], norm[vi].xyz[1], norm[vi].xyz[2]);
 			}
+			tri++;
 		}
-		vbuf->UnlockVertexBuffer();
-		UnloadGeometry();
 	}
+	UnloadGeometry();
 }
 
 //===========================================================================
@@ -480,7 +489,7 @@ bool FMD2Model::Load(const char * path, int lumpnum, const char * buffer, int le
 		md2_packedFrame_t *pfr = (md2_packedFrame_t *)(md2_frames + info.frameSize * i);
 
 		memcpy(frame->name, pfr->name, sizeof(pfr->name));
-		frame->vindex = UINT_MAX;
+		frame->vindex = i * lodInfo[0].numTriangles * 3;
 	}
 	mLumpNum = lumpnum;
 	return true;
@@ -492,12 +501,10 @@ bool FMD2Model::Load(const char * path, int lumpnum, const char * buffer, int le
 //
 //===========================================================================
 
-void FMD2Model::LoadGeometry()
+void FMD2Model::LoadGeometry(const char *buffer)
 {
 	static int axis[3] = { VX, VY, VZ };
 	uint8_t   *md2_frames;
-	FMemLump lumpdata = Wads.ReadLump(mLumpNum);
-	const char *buffer = (const char *)lumpdata.GetMem();
 
 	texCoords = new FTexCoord[info.numTexCoords];
 	memcpy(texCoords, (uint8_t*)buffer + info.offsetTexCoords, info.numTexCoords * sizeof(FTexCoord));
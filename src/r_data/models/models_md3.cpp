@@ -173,6 +173,16 @@ bool FMD3Model::Load(const char * path, int lumpnum, const char * buffer, int le
 				s->Skins[i] = LoadSkin(path, shader[i].Name);
 		}
 	}
+
+	// The vertex buffer holds all frames of all surfaces in sequence.
+	unsigned int vindex = 0, iindex = 0;
+	for (auto &s : Surfaces)
+	{
+		s.vindex = vindex;
+		s.iindex = iindex;
+		vindex += Frames.Size() * s.numVertices;
+		iindex += 3 * s.numTriangles;
+	}
 	mLumpNum = lumpnum;
 	return true;
 }
@@ -183,10 +193,8 @@ bool FMD3Model::Load(const char * path, int lumpnum, const char * buffer, int le
 //
 //===========================================================================
 
-void FMD3Model::LoadGeometry()
+void FMD3Model::LoadGeometry(const char *buffer)
 {
-	FMemLump lumpdata = Wads.ReadLump(mLumpNum);
-	const char *buffer = (const char *)lumpdata.GetMem();
 	md3_header_t * hdr = (md3_header_t *)buffer;
 	md3_surface_t * surf = (md3_surface_t*)(buffer + LittleLong(hdr->Ofs_Surfaces));
 
@@ -236,60 +244,60 @@ void FMD3Model::LoadGeometry()
 //
 //===========================================================================
 
-void FMD3Model::BuildVertexBuffer(FModelRenderer *renderer)
+void FMD3Model::GetMeshLumps(TArray<int> &lumps)
 {
-	if (!GetVertexBuffer(renderer))
-	{
-		LoadGeometry();
+	lumps.Push(mLumpNum);
+}
 
-		unsigned int vbufsize = 0;
-		unsigned int ibufsize = 0;
+//===========================================================================
+//
+// Runs on a worker thread so it may only touch the lump data handed to it.
+//
+//===========================================================================
 
-		for (unsigned i = 0; i < Surfaces.Size(); i++)
-		{
-			MD3Surface * surf = &Surfaces[i];
-			vbufsize += Frames.Size() * surf->numVertices;
-			ibufsize += 3 * surf->numTriangles;
-		}
+void FMD3Model::BuildMesh(FModelMesh &mesh)
+{
+	LoadGeometry((const char *)mesh.Lumps[0].Data());
 
-		auto vbuf = renderer->CreateVertexBuffer(true, Frames.Size() == 1);
-		SetVertexBuffer(renderer, vbuf);
+	unsigned int vbufsize = 0;
+	unsigned int ibufsize = 0;
 
-		FModelVertex *vertptr = vbuf->LockVertexBuffer(vbufsize);
-		unsigned int *indxptr = vbuf->LockIndexBuffer(ibufsize);
+	for (unsigned i = 0; i < Surfaces.Size(); i++)
+	{
+		MD3Surface * surf = &Surfaces[i];
+		vbufsize += Frames.Size() * surf->numVertices;
+		ibufsize += 3 * surf->numTriangles;
+	}
 
-		assert(vertptr != nullptr && indxptr != nullptr);
+	mesh.Vertices.Resize(vbufsize);
+	mesh.Indices.Resize(ibufsize);
+	mesh.SingleFrame = Frames.Size() == 1;
 
-		unsigned int vindex = 0, iindex = 0;
+	unsigned int vindex = 0, iindex = 0;
 
-		for (unsigned i = 0; i < Surfaces.Size(); i++)
-		{
-			MD3Surface * surf = &Surfaces[i];
+	for (unsigned i = 0; i < Surfaces.Size(); i++)
+	{
+		MD3Surface * surf = &Surfaces[i];
 
-			surf->vindex = vindex;
-			surf->iindex = iindex;
-			for (unsigned j = 0; j < Frames.Size() * surf->numVertices; j++)
-			{
-				MD3Vertex* vert = &surf->Vertices[j];
+		for (unsigned j = 0; j < Frames.Size() * surf->numVertices; j++)
+		{
+			MD3Vertex* vert = &surf->Vertices[j];
 
-				FModelVertex *bvert = &vertptr[vindex++];
+			FModelVertex *bvert = &mesh.Vertices[vindex++];
 
-				int tc = j % surf->numVertices;
-				bvert->Set(vert->x, vert->z, vert->y, surf->Texcoords[tc].s, surf->Texcoords[tc].t);
-				bvert->SetNormal(vert->nx, vert->nz, vert->ny);
-			}
+			int tc = j % surf->numVertices;
+			bvert->Set(vert->x, vert->z, vert->y, surf->Texcoords[tc].s, surf->Texcoords[tc].t);
+			bvert->SetNormal(vert->nx, vert->nz, vert->ny);
+		}
 
-			for (unsigned k = 0; k < surf->numTriangles; k++)
+		for (unsigned k = 0; k < surf->numTriangles; k++)
+		{
+			for (int l = 0; l < 3; l++)
 			{
-				for (int l = 0; l < 3; l++)
-				{
-					indxptr[iindex++] = surf->Tris[k].VertIndex[l];
-				}
+				mesh.Indices[iindex++] = surf->Tris[k].VertIndex[l];
 			}
-			surf->UnloadGeometry();
 		}
-		vbuf->UnlockVertexBuffer();
-		vbuf->UnlockIndexBuffer();
+		surf->UnloadGeometry();
 	}
 }
 
@@ -20,22 +20,32 @@
 //--------------------------------------------------------------------------
 
 #include "w_wad.h"
+#include "v_text.h"
 #include "r_data/models/models_obj.h"
 
 /**
- * Load an OBJ model
+ * Load an OBJ model. The text is only parsed by ParseData.
  *
  * @param fn The path to the model file
  * @param lumpnum The lump index in the wad collection
  * @param buffer The contents of the model file
  * @param length The size of the model file
- * @return Whether or not the model was parsed successfully
+ * @return Whether or not the model was loaded successfully
  */
 bool FOBJModel::Load(const char* fn, int lumpnum, const char* buffer, int length)
 {
-	FString objName = Wads.GetLumpFullPath(lumpnum);
-	FString objBuf(buffer, length);
+	objName = Wads.GetLumpFullPath(lumpnum);
+	objPath = fn;
+	objBuf = FString(buffer, length);
+	return true;
+}
 
+/**
+ * Parse the OBJ text. This runs on a worker thread, so materials are only
+ * looked up by FinishLoad.
+ */
+void FOBJModel::ParseData()
+{
 	// Do some replacements before we parse the OBJ string
 	{
 		// Ensure usemtl statements remain intact
@@ -98,8 +108,8 @@ bool FOBJModel::Load(const char* fn, int lumpnum, const char* buffer, int length
 		objBuf.UnlockBuffer();
 	}
 	sc.OpenString(objName, objBuf);
+	objBuf = "";
 
-	FTextureID curMtl = FNullTextureID();
 	OBJSurface *curSurface = nullptr;
 	unsigned int aggSurfFaceCount = 0;
 	unsigned int curSurfFaceCount = 0;
@@ -121,26 +131,15 @@ bool FOBJModel::Load(const char* fn, int lumpnum, const char* buffer, int length
 		}
 		else if (sc.Compare("usemtl"))
 		{
-			// Get material name and try to load it
+			// Get material name
 			sc.MustGetString();
-
-			curMtl = LoadSkin("", sc.String);
-			if (!curMtl.isValid())
-			{
-				// Relative to model file path?
-				curMtl = LoadSkin(fn, sc.String);
-			}
-
-			if (!curMtl.isValid())
-			{
-				sc.ScriptMessage("Material %s (#%u) not found.", sc.String, surfaces.Size());
-			}
+			FString curMtl = sc.String;
 
 			// Build surface...
 			if (curSurface == nullptr)
 			{
 				// First surface
-				curSurface = new OBJSurface(curMtl);
+				curSurface = new OBJSurface(curMtl, sc.Line);
 			}
 			else
 			{
@@ -152,12 +151,13 @@ bool FOBJModel::Load(const char* fn, int lumpnum, const char* buffer, int length
 					surfaces.Push(*curSurface);
 					delete curSurface;
 					// Go to next surface
-					curSurface = new OBJSurface(curMtl);
+					curSurface = new OBJSurface(curMtl, sc.Line);
 					aggSurfFaceCount += curSurfFaceCount;
 				}
 				else
 				{
-					curSurface->skin = curMtl;
+					curSurface->material = curMtl;
+					curSurface->materialLine = sc.Line;
 				}
 			}
 			curSurfFaceCount = 0;
@@ -171,7 +171,7 @@ bool FOBJModel::Load(const char* fn, int lumpnum, const char* buffer, int length
 				// A face must have at least 3 sides
 				sc.MustGetString();
 				sides[i] = sc.String;
-				if (!ParseFaceSide(sides[i], face, i)) return false;
+				if (!ParseFaceSide(sides[i], face, i)) return;
 			}
 			face.sideCount = 3;
 			if (sc.GetString())
@@ -180,7 +180,7 @@ bool FOBJModel::Load(const char* fn, int lumpnum, const char* buffer, int length
 				{
 					sides[3] = sc.String;
 					face.sideCount += 1;
-					if (!ParseFaceSide(sides[3], face, 3)) return false;
+					if (!ParseFaceSide(sides[3], face, 3)) return;
 				}
 				else
 				{
@@ -211,8 +211,7 @@ bool FOBJModel::Load(const char* fn, int lumpnum, const char* buffer, int length
 
 	if (curSurface == nullptr)
 	{ // No valid materials detected
-		FTextureID dummyMtl = LoadSkin("", "-NOFLAT-"); // Built-in to GZDoom
-		curSurface = new OBJSurface(dummyMtl);
+		curSurface = new OBJSurface("", 0);
 	}
 	curSurface->numFaces = curSurfFaceCount;
 	curSurface->faceStart = aggSurfFaceCount;
@@ -224,7 +223,48 @@ bool FOBJModel::Load(const char* fn, int lumpnum, const char* buffer, int length
 		uvs.Push(FVector2(0.0, 0.0));
 	}
 
-	return true;
+	// Lay out the vertex buffer now so that a cached mesh can be rendered
+	// without building the triangles first
+	unsigned int vbufsize = 0;
+	for (auto &surf : surfaces)
+	{
+		surf.numTris = 0;
+		for (unsigned int i = surf.faceStart; i < surf.faceStart + surf.numFaces; i++)
+		{
+			surf.numTris += faces[i].sideCount - 2;
+		}
+		surf.vbStart = vbufsize;
+		vbufsize += surf.numTris * 3;
+	}
+}
+
+/**
+ * Load the materials of all surfaces
+ */
+void FOBJModel::FinishLoad()
+{
+	for (unsigned int i = 0; i < surfaces.Size(); i++)
+	{
+		OBJSurface &surf = surfaces[i];
+		if (surf.material.IsEmpty())
+		{
+			surf.skin = LoadSkin("", "-NOFLAT-"); // Built-in to GZDoom
+			continue;
+		}
+
+		surf.skin = LoadSkin("", surf.material);
+		if (!surf.skin.isValid())
+		{
+			// Relative to model file path?
+			surf.skin = LoadSkin(objPath, surf.material);
+		}
+
+		if (!surf.skin.isValid())
+		{
+			Printf(TEXTCOLOR_RED "Script error, \"%s\"" TEXTCOLOR_RED " line %d:\n" TEXTCOLOR_RED "Material %s (#%u) not found.\n",
+				objName.GetChars(), surf.materialLine, surf.material.GetChars(), i);
+		}
+	}
 }
 
 /**
@@ -348,23 +388,17 @@ int FOBJModel::ResolveIndex(int origIndex, FaceElement el)
 }
 
 /**
- * Construct the vertex buffer for this model
+ * Construct the vertex data for this model. This runs on a worker thread.
  *
- * @param renderer A pointer to the model renderer. Used to allocate the vertex buffer.
+ * @param[out] mesh The mesh to fill in
  */
-void FOBJModel::BuildVertexBuffer(FModelRenderer *renderer)
+void FOBJModel::BuildMesh(FModelMesh &mesh)
 {
-	if (GetVertexBuffer(renderer))
-	{
-		return;
-	}
-
 	unsigned int vbufsize = 0;
 
 	for (size_t i = 0; i < surfaces.Size(); i++)
 	{
 		ConstructSurfaceTris(surfaces[i]);
-		surfaces[i].vbStart = vbufsize;
 		vbufsize += surfaces[i].numTris * 3;
 	}
 	// Initialize/populate vertFaces
@@ -373,10 +407,8 @@ void FOBJModel::BuildVertexBuffer(FModelRenderer *renderer)
 		AddVertFaces();
 	}
 
-	auto vbuf = renderer->CreateVertexBuffer(false,true);
-	SetVertexBuffer(renderer, vbuf);
-
-	FModelVertex *vertptr = vbuf->LockVertexBuffer(vbufsize);
+	mesh.Vertices.Resize(vbufsize);
+	FModelVertex *vertptr = mesh.Vertices.Data();
 
 	for (unsigned int i = 0; i < surfaces.Size(); i++)
 	{
@@ -429,8 +461,8 @@ void FOBJModel::BuildVertexBuffer(FModelRenderer *renderer)
 			vertFaces[i].Clear();
 		}
 		delete[] vertFaces;
+		vertFaces = nullptr;
 	}
-	vbuf->UnlockVertexBuffer();
 }
 
 /**
@@ -469,7 +501,6 @@ void FOBJModel::ConstructSurfaceTris(OBJSurface &surf)
 			delete[] triangulated;
 			triIdx += 1; // Filling out two faces
 		}
-		DPrintf(DMSG_SPAMMY, "Smooth group: %d\n", surf.tris[triIdx].smoothGroup);
 	}
 }
 
@@ -69,7 +69,9 @@ private:
 		unsigned int faceStart; // Index of first face in faces array
 		OBJFace* tris; // Triangles
 		FTextureID skin;
-		OBJSurface(FTextureID skin): numTris(0), numFaces(0), vbStart(0), faceStart(0), tris(nullptr), skin(skin) {}
+		FString material; // Looked up by FinishLoad, empty for the dummy material
+		int materialLine;
+		OBJSurface(const FString &material, int line): numTris(0), numFaces(0), vbStart(0), faceStart(0), tris(nullptr), material(material), materialLine(line) {}
 	};
 
 	TArray<FVector3> verts;
@@ -79,6 +81,9 @@ private:
 	TArray<OBJSurface> surfaces;
 	FScanner sc;
 	TArray<OBJTriRef>* vertFaces;
+	FString objName;
+	FString objPath;
+	FString objBuf; // The OBJ text until ParseData is done with it
 
 	int ResolveIndex(int origIndex, FaceElement el);
 	template<typename T, size_t L> void ParseVector(TArray<T> &array);
@@ -95,9 +100,11 @@ public:
 	FOBJModel(): hasMissingNormals(false), hasSmoothGroups(false), vertFaces(nullptr) {}
 	~FOBJModel();
 	bool Load(const char* fn, int lumpnum, const char* buffer, int length) override;
+	void ParseData() override;
+	void FinishLoad() override;
 	int FindFrame(const char* name) override;
 	void RenderFrame(FModelRenderer* renderer, FTexture* skin, int frame, int frame2, double inter, int translation=0) override;
-	void BuildVertexBuffer(FModelRenderer* renderer) override;
+	void BuildMesh(FModelMesh& mesh) override;
 	void AddSkins(uint8_t* hitlist) override;
 };
 
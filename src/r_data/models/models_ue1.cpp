@@ -60,14 +60,8 @@ bool FUE1Model::Load( const char *filename, int lumpnum, const char *buffer, int
 	return true;
 }
 
-void FUE1Model::LoadGeometry()
+void FUE1Model::LoadGeometry( const char *buffer, const char *buffer2 )
 {
-	FMemLump lump, lump2;
-	const char *buffer, *buffer2;
-	lump = Wads.ReadLump(mDataLump);
-	buffer = (char*)lump.GetMem();
-	lump2 = Wads.ReadLump(mAnivLump);
-	buffer2 = (char*)lump2.GetMem();
 	// map structures
 	dhead = (d3dhead*)(buffer);
 	dpolys = (d3dpoly*)(buffer+sizeof(d3dhead));
@@ -252,19 +246,23 @@ void FUE1Model::RenderFrame( FModelRenderer *renderer, FTexture *skin, int frame
 	renderer->SetInterpolation(0.f);
 }
 
-void FUE1Model::BuildVertexBuffer( FModelRenderer *renderer )
+void FUE1Model::GetMeshLumps( TArray<int> &lumps )
+{
+	if ( mDataLoaded ) return;
+	lumps.Push(mDataLump);
+	lumps.Push(mAnivLump);
+}
+
+void FUE1Model::BuildMesh( FModelMesh &mesh )
 {
-	if (GetVertexBuffer(renderer))
-		return;
 	if ( !mDataLoaded )
-		LoadGeometry();
+		LoadGeometry((const char*)mesh.Lumps[0].Data(),(const char*)mesh.Lumps[1].Data());
 	int vsize = 0;
 	for ( int i=0; i<numGroups; i++ )
 		vsize += groups[i].numPolys*3;
 	vsize *= numFrames;
-	auto vbuf = renderer->CreateVertexBuffer(false,numFrames==1);
-	SetVertexBuffer(renderer, vbuf);
-	FModelVertex *vptr = vbuf->LockVertexBuffer(vsize);
+	mesh.Vertices.Resize(vsize);
+	mesh.SingleFrame = numFrames==1;
 	int vidx = 0;
 	for ( int i=0; i<numFrames; i++ )
 	{
@@ -276,7 +274,7 @@ void FUE1Model::BuildVertexBuffer( FModelRenderer *renderer )
 				{
 					UE1Vertex V = verts[polys[groups[j].P[k]].V[l]+i*numVerts];
 					FVector2 C = polys[groups[j].P[k]].C[l];
-					FModelVertex *vert = &vptr[vidx++];
+					FModelVertex *vert = &mesh.Vertices[vidx++];
 					vert->Set(V.Pos.X,V.Pos.Y,V.Pos.Z,C.X,C.Y);
 					if ( groups[j].type&PT_Curvy )	// use facet normal
 					{
@@ -289,7 +287,6 @@ void FUE1Model::BuildVertexBuffer( FModelRenderer *renderer )
 			}
 		}
 	}
-	vbuf->UnlockVertexBuffer();
 }
 
 void FUE1Model::AddSkins( uint8_t *hitlist )
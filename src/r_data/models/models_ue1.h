@@ -25,9 +25,12 @@ public:
 	bool Load(const char * fn, int lumpnum, const char * buffer, int length) override;
 	int FindFrame(const char * name) override;
 	void RenderFrame(FModelRenderer *renderer, FTexture * skin, int frame, int frame2, double inter, int translation=0) override;
-	void BuildVertexBuffer(FModelRenderer *renderer) override;
+	void GetMeshLumps(TArray<int> &lumps) override;
+	void BuildMesh(FModelMesh &mesh) override;
+	// The poly groups needed for rendering only exist after loading the geometry.
+	bool CanCacheMesh() override { return false; }
 	void AddSkins(uint8_t *hitlist) override;
-	void LoadGeometry();
+	void LoadGeometry(const char *buffer, const char *buffer2);
 	void UnloadGeometry();
 	FUE1Model()
 	{
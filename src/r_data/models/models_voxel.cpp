@@ -177,12 +177,12 @@ FVoxelModel::~FVoxelModel()
 //
 //===========================================================================
 
-unsigned int FVoxelModel::AddVertex(FModelVertex &vert, FVoxelMap &check)
+unsigned int FVoxelModel::AddVertex(FModelVertex &vert, FVoxelMap &check, FModelMesh &mesh)
 {
 	unsigned int index = check[vert];
 	if (index == 0xffffffff)
 	{
-		index = check[vert] =mVertices.Push(vert);
+		index = check[vert] =mesh.Vertices.Push(vert);
 	}
 	return index;
 }
@@ -193,7 +193,7 @@ unsigned int FVoxelModel::AddVertex(FModelVertex &vert, FVoxelMap &check)
 //
 //===========================================================================
 
-void FVoxelModel::AddFace(int x1, int y1, int z1, int x2, int y2, int z2, int x3, int y3, int z3, int x4, int y4, int z4, uint8_t col, FVoxelMap &check)
+void FVoxelModel::AddFace(int x1, int y1, int z1, int x2, int y2, int z2, int x3, int y3, int z3, int x4, int y4, int z4, uint8_t col, FVoxelMap &check, FModelMesh &mesh)
 {
 	float PivotX = mVoxel->Mips[0].Pivot.X;
 	float PivotY = mVoxel->Mips[0].Pivot.Y;
@@ -209,30 +209,30 @@ void FVoxelModel::AddFace(int x1, int y1, int z1, int x2, int y2, int z2, int x3
 	vert.x =  x1 - PivotX;
 	vert.z = -y1 + PivotY;
 	vert.y = -z1 + PivotZ;
-	indx[0] = AddVertex(vert, check);
+	indx[0] = AddVertex(vert, check, mesh);
 
 	vert.x =  x2 - PivotX;
 	vert.z = -y2 + PivotY;
 	vert.y = -z2 + PivotZ;
-	indx[1] = AddVertex(vert, check);
+	indx[1] = AddVertex(vert, check, mesh);
 
 	vert.x =  x4 - PivotX;
 	vert.z = -y4 + PivotY;
 	vert.y = -z4 + PivotZ;
-	indx[2] = AddVertex(vert, check);
+	indx[2] = AddVertex(vert, check, mesh);
 
 	vert.x =  x3 - PivotX;
 	vert.z = -y3 + PivotY;
 	vert.y = -z3 + PivotZ;
-	indx[3] = AddVertex(vert, check);
+	indx[3] = AddVertex(vert, check, mesh);
 
 
-	mIndices.Push(indx[0]);
-	mIndices.Push(indx[1]);
-	mIndices.Push(indx[3]);
-	mIndices.Push(indx[1]);
-	mIndices.Push(indx[2]);
-	mIndices.Push(indx[3]);
+	mesh.Indices.Push(indx[0]);
+	mesh.Indices.Push(indx[1]);
+	mesh.Indices.Push(indx[3]);
+	mesh.Indices.Push(indx[1]);
+	mesh.Indices.Push(indx[2]);
+	mesh.Indices.Push(indx[3]);
 }
 
 //===========================================================================
@@ -241,7 +241,7 @@ void FVoxelModel::AddFace(int x1, int y1, int z1, int x2, int y2, int z2, int x3
 //
 //===========================================================================
 
-void FVoxelModel::MakeSlabPolys(int x, int y, kvxslab_t *voxptr, FVoxelMap &check)
+void FVoxelModel::MakeSlabPolys(int x, int y, kvxslab_t *voxptr, FVoxelMap &check, FModelMesh &mesh)
 {
 	const uint8_t *col = voxptr->col;
 	int zleng = voxptr->zleng;
@@ -250,7 +250,7 @@ void FVoxelModel::MakeSlabPolys(int x, int y, kvxslab_t *voxptr, FVoxelMap &chec
 
 	if (cull & 16)
 	{
-		AddFace(x, y, ztop, x+1, y, ztop, x, y+1, ztop, x+1, y+1, ztop, *col, check);
+		AddFace(x, y, ztop, x+1, y, ztop, x, y+1, ztop, x+1, y+1, ztop, *col, check, mesh);
 	}
 	int z = ztop;
 	while (z < ztop+zleng)
@@ -260,19 +260,19 @@ void FVoxelModel::MakeSlabPolys(int x, int y, kvxslab_t *voxptr, FVoxelMap &chec
 
 		if (cull & 1)
 		{
-			AddFace(x, y, z, x, y+1, z, x, y, z+c, x, y+1, z+c, *col, check);
+			AddFace(x, y, z, x, y+1, z, x, y, z+c, x, y+1, z+c, *col, check, mesh);
 		}
 		if (cull & 2)
 		{
-			AddFace(x+1, y+1, z, x+1, y, z, x+1, y+1, z+c, x+1, y, z+c, *col, check);
+			AddFace(x+1, y+1, z, x+1, y, z, x+1, y+1, z+c, x+1, y, z+c, *col, check, mesh);
 		}
 		if (cull & 4)
 		{
-			AddFace(x+1, y, z, x, y, z, x+1, y, z+c, x, y, z+c, *col, check);
+			AddFace(x+1, y, z, x, y, z, x+1, y, z+c, x, y, z+c, *col, check, mesh);
 		}
 		if (cull & 8)
 		{
-			AddFace(x, y+1, z, x+1, y+1, z, x, y+1, z+c, x+1, y+1, z+c, *col, check);
+			AddFace(x, y+1, z, x+1, y+1, z, x, y+1, z+c, x+1, y+1, z+c, *col, check, mesh);
 		}	
 		z+=c;
 		col+=c;
@@ -280,7 +280,7 @@ void FVoxelModel::MakeSlabPolys(int x, int y, kvxslab_t *voxptr, FVoxelMap &chec
 	if (cull & 32)
 	{
 		int z = ztop+zleng-1;
-		AddFace(x+1, y, z+1, x, y, z+1, x+1, y+1, z+1, x, y+1, z+1, voxptr->col[zleng-1], check);
+		AddFace(x+1, y, z+1, x, y, z+1, x+1, y+1, z+1, x, y+1, z+1, voxptr->col[zleng-1], check, mesh);
 	}
 }
 
@@ -290,7 +290,7 @@ void FVoxelModel::MakeSlabPolys(int x, int y, kvxslab_t *voxptr, FVoxelMap &chec
 //
 //===========================================================================
 
-void FVoxelModel::Initialize()
+void FVoxelModel::BuildMesh(FModelMesh &mesh)
 {
 	FVoxelMap check;
 	FVoxelMipLevel *mip = &mVoxel->Mips[0];
@@ -304,46 +304,12 @@ void FVoxelModel::Initialize()
 			kvxslab_t *voxend = (kvxslab_t *)(slabxoffs + xyoffs[y+1]);
 			for (; voxptr < voxend; voxptr = (kvxslab_t *)((uint8_t *)voxptr + voxptr->zleng + 3))
 			{
-				MakeSlabPolys(x, y, voxptr, check);
+				MakeSlabPolys(x, y, voxptr, check, mesh);
 			}
 		}
 	}
 }
 
-//===========================================================================
-//
-// 
-//
-//===========================================================================
-
-void FVoxelModel::BuildVertexBuffer(FModelRenderer *renderer)
-{
-	if (!GetVertexBuffer(renderer))
-	{
-		Initialize();
-
-		auto vbuf = renderer->CreateVertexBuffer(true, true);
-		SetVertexBuffer(renderer, vbuf);
-
-		FModelVertex *vertptr = vbuf->LockVertexBuffer(mVertices.Size());
-		unsigned int *indxptr = vbuf->LockIndexBuffer(mIndices.Size());
-
-		memcpy(vertptr, &mVertices[0], sizeof(FModelVertex)* mVertices.Size());
-		memcpy(indxptr, &mIndices[0], sizeof(unsigned int)* mIndices.Size());
-
-		vbuf->UnlockVertexBuffer();
-		vbuf->UnlockIndexBuffer();
-		mNumIndices = mIndices.Size();
-
-		// delete our temporary buffers
-		mVertices.Clear();
-		mIndices.Clear();
-		mVertices.ShrinkToFit();
-		mIndices.ShrinkToFit();
-	}
-}
-
-
 //===========================================================================
 //
 // for skin precaching
@@ -398,6 +364,6 @@ void FVoxelModel::RenderFrame(FModelRenderer *renderer, FTexture * skin, int fra
 {
 	renderer->SetMaterial(skin, true, translation);
 	GetVertexBuffer(renderer)->SetupFrame(renderer, 0, 0, 0);
-	renderer->DrawElements(mNumIndices, 0);
+	renderer->DrawElements(mNumMeshIndices, 0);
 }
 
@@ -64,6 +64,7 @@ FGLRenderBuffers::~FGLRenderBuffers()
 
 void FGLRenderBuffers::ClearScene()
 {
+	ClearStereoScene();
 	DeleteFrameBuffer(mSceneFB);
 	DeleteFrameBuffer(mSceneDataFB);
 	if (mSceneUsesTextures)
@@ -82,6 +83,15 @@ void FGLRenderBuffers::ClearScene()
 	}
 }
 
+void FGLRenderBuffers::ClearStereoScene()
+{
+	DeleteFrameBuffer(mStereoSceneFB);
+	DeleteFrameBuffer(mStereoLayerFB[0]);
+	DeleteFrameBuffer(mStereoLayerFB[1]);
+	DeleteTexture(mStereoSceneTex);
+	DeleteTexture(mStereoDepthStencilTex);
+}
+
 void FGLRenderBuffers::ClearPipeline()
 {
 	for (int i = 0; i < NumPipelineTextures; i++)
@@ -327,6 +337,45 @@ PPGLTexture FGLRenderBuffers::Create2DMultisampleTexture(const char *name, GLuin
 	return tex;
 }
 
+//==========================================================================
+//
+// Creates a 2D array texture, multisampled if samples > 1
+//
+//==========================================================================
+
+PPGLTexture FGLRenderBuffers::Create2DArrayTexture(const char *name, GLuint format, int width, int height, int layers, int samples)
+{
+	PPGLTexture tex;
+	tex.Width = width;
+	tex.Height = height;
+	glGenTextures(1, &tex.handle);
+	if (samples > 1)
+	{
+		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE_ARRAY, tex.handle);
+		FGLDebug::LabelObject(GL_TEXTURE, tex.handle, name);
+		glTexImage3DMultisample(GL_TEXTURE_2D_MULTISAMPLE_ARRAY, samples, format, width, height, layers, false);
+		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE_ARRAY, 0);
+	}
+	else
+	{
+		GLenum dataformat = 0, datatype = 0;
+		switch (format)
+		{
+		case GL_RGBA16F:			dataformat = GL_RGBA; datatype = GL_FLOAT; break;
+		case GL_DEPTH24_STENCIL8:	dataformat = GL_DEPTH_STENCIL; datatype = GL_UNSIGNED_INT_24_8; break;
+		default: I_FatalError("Unknown format passed to FGLRenderBuffers.Create2DArrayTexture");
+		}
+
+		glBindTexture(GL_TEXTURE_2D_ARRAY, tex.handle);
+		FGLDebug::LabelObject(GL_TEXTURE, tex.handle, name);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, format, width, height, layers, 0, dataformat, datatype, nullptr);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+	return tex;
+}
+
 //==========================================================================
 //
 // Creates a render buffer
@@ -521,6 +570,70 @@ void FGLRenderBuffers::BlitSceneToTexture()
 	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 }
 
+//==========================================================================
+//
+// Layered scene frame buffer. Layer n receives eye n when the scene is
+// drawn with stereo instancing. Created on first use and thrown away
+// together with the regular scene buffers.
+//
+//==========================================================================
+
+void FGLRenderBuffers::CreateStereoScene()
+{
+	if (mStereoSceneFB)
+		return;
+
+	GLint frameBufferBinding;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &frameBufferBinding);
+
+	mStereoSceneTex = Create2DArrayTexture("StereoScene", GL_RGBA16F, mWidth, mHeight, 2, mSamples);
+	mStereoDepthStencilTex = Create2DArrayTexture("StereoSceneDepthStencil", GL_DEPTH24_STENCIL8, mWidth, mHeight, 2, mSamples);
+
+	glGenFramebuffers(1, &mStereoSceneFB.handle);
+	glBindFramebuffer(GL_FRAMEBUFFER, mStereoSceneFB.handle);
+	FGLDebug::LabelObject(GL_FRAMEBUFFER, mStereoSceneFB.handle, "StereoSceneFB");
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, mStereoSceneTex.handle, 0);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, mStereoDepthStencilTex.handle, 0);
+	if (CheckFrameBufferCompleteness())
+		ClearFrameBuffer(true, true);
+
+	for (int i = 0; i < 2; i++)
+	{
+		glGenFramebuffers(1, &mStereoLayerFB[i].handle);
+		glBindFramebuffer(GL_FRAMEBUFFER, mStereoLayerFB[i].handle);
+		FGLDebug::LabelObject(GL_FRAMEBUFFER, mStereoLayerFB[i].handle, "StereoLayerFB");
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, mStereoSceneTex.handle, 0, i);
+		CheckFrameBufferCompleteness();
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBufferBinding);
+}
+
+void FGLRenderBuffers::BindStereoSceneFB()
+{
+	CreateStereoScene();
+	glBindFramebuffer(GL_FRAMEBUFFER, mStereoSceneFB.handle);
+}
+
+//==========================================================================
+//
+// Copies one eye out of the layered scene buffer into the first pipeline
+// texture so that post processing can work on it like on a normal scene.
+//
+//==========================================================================
+
+void FGLRenderBuffers::BlitStereoLayerToTexture(int layer)
+{
+	mCurrentPipelineTexture = 0;
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, mStereoLayerFB[layer].handle);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mPipelineFB[mCurrentPipelineTexture].handle);
+	glBlitFramebuffer(0, 0, mWidth, mHeight, 0, 0, mWidth, mHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+}
+
 //==========================================================================
 //
 // Eye textures and their frame buffers
@@ -570,6 +683,21 @@ void FGLRenderBuffers::BindEyeTexture(int eye, int texunit)
 	glBindTexture(GL_TEXTURE_2D, mEyeTextures[eye].handle);
 }
 
+void FGLRenderBuffers::ReadEyeTexture(int eye, TArray<float> &pixels)
+{
+	CreateEyeBuffers(eye);
+	pixels.Resize(mWidth * mHeight * 4);
+
+	GLint activeTex, textureBinding;
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTex);
+	glActiveTexture(GL_TEXTURE0);
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &textureBinding);
+	glBindTexture(GL_TEXTURE_2D, mEyeTextures[eye].handle);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, pixels.Data());
+	glBindTexture(GL_TEXTURE_2D, textureBinding);
+	glActiveTexture(activeTex);
+}
+
 void FGLRenderBuffers::BindDitherTexture(int texunit)
 {
 	if (!mDitherTexture)
@@ -115,6 +115,9 @@ public:
 	void BindSceneDepthTexture(int index);
 	void BlitSceneToTexture();
 
+	void BindStereoSceneFB();
+	void BlitStereoLayerToTexture(int layer);
+
 	void BindCurrentTexture(int index, int filter = GL_NEAREST, int wrap = GL_CLAMP_TO_EDGE);
 	void BindCurrentFB();
 	void BindNextFB();
@@ -127,6 +130,7 @@ public:
 	void BlitToEyeTexture(int eye, bool allowInvalidate=true);
 	void BlitFromEyeTexture(int eye);
 	void BindEyeTexture(int eye, int texunit);
+	void ReadEyeTexture(int eye, TArray<float> &pixels);
 	int NextEye(int eyeCount);
 	int & CurrentEye() { return mCurrentEye; }
 
@@ -146,13 +150,16 @@ private:
 	void ClearPipeline();
 	void ClearEyeBuffers();
 	void ClearShadowMap();
+	void ClearStereoScene();
 	void CreateScene(int width, int height, int samples, bool needsSceneTextures);
+	void CreateStereoScene();
 	void CreatePipeline(int width, int height);
 	void CreateEyeBuffers(int eye);
 	void CreateShadowMap();
 
 	PPGLTexture Create2DTexture(const char *name, GLuint format, int width, int height, const void *data = nullptr);
 	PPGLTexture Create2DMultisampleTexture(const char *name, GLuint format, int width, int height, int samples, bool fixedSampleLocations);
+	PPGLTexture Create2DArrayTexture(const char *name, GLuint format, int width, int height, int layers, int samples);
 	PPGLRenderBuffer CreateRenderBuffer(const char *name, GLuint format, int width, int height);
 	PPGLRenderBuffer CreateRenderBuffer(const char *name, GLuint format, int width, int height, int samples);
 	PPGLFrameBuffer CreateFrameBuffer(const char *name, PPGLTexture colorbuffer);
@@ -188,6 +195,12 @@ private:
 	PPGLFrameBuffer mSceneDataFB;
 	bool mSceneUsesTextures = false;
 
+	// Layered scene buffers for drawing both eyes in one pass
+	PPGLTexture mStereoSceneTex;
+	PPGLTexture mStereoDepthStencilTex;
+	PPGLFrameBuffer mStereoSceneFB;
+	PPGLFrameBuffer mStereoLayerFB[2];
+
 	// Effect/HUD buffers
 	PPGLTexture mPipelineTexture[NumPipelineTextures];
 	PPGLFrameBuffer mPipelineFB[NumPipelineTextures];
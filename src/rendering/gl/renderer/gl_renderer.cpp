@@ -54,6 +54,7 @@
 #include "hwrenderer/scene/hw_fakeflat.h"
 #include "gl/textures/gl_samplers.h"
 #include "hwrenderer/dynlights/hw_lightbuffer.h"
+#include "hwrenderer/models/hw_bonebuffer.h"
 #include "hwrenderer/data/hw_viewpointbuffer.h"
 #include "r_videoscale.h"
 #include <hwrenderer\utility\hw_vrmodes.h>
@@ -248,6 +249,7 @@ sector_t *FGLRenderer::RenderView(player_t *player)
 			r_viewpoint.TicFrac = I_GetTimeFrac();
 
 		screen->mLights->Clear();
+		screen->mBones->Clear();
 		screen->mViewpoints->Clear();
 
 		// NoInterpolateView should have no bearing on camera textures, but needs to be preserved for the main view below.
@@ -360,6 +362,7 @@ void FGLRenderer::WriteSavePic(player_t *player, FileWriter *file, int width, in
 	gl_RenderState.SetVertexBuffer(screen->mVertexData);
 	screen->mVertexData->Reset();
 	screen->mLights->Clear();
+	screen->mBones->Clear();
 	screen->mViewpoints->Clear();
 
     // This shouldn't overwrite the global viewpoint even for a short time.
@@ -29,6 +29,8 @@ class FHardwareTexture;
 class SWSceneDrawer;
 class HWViewpointBuffer;
 struct FRenderViewpoint;
+struct VRMode;
+struct VREyeInfo;
 
 namespace OpenGLRenderer
 {
@@ -106,6 +108,12 @@ public:
 private:
 	void gl_FillScreen();
 	void DrawScene(HWDrawInfo *di, int drawmode);
+	void CreateScene(HWDrawInfo *di, int drawmode);
+	void DrawSceneLists(HWDrawInfo *di, int drawmode);
+	void StartEye(IntRect *bounds, bool mainview);
+	void FinishEye(HWDrawInfo *di, const VREyeInfo *eye, sector_t *viewsector, int cm, bool toscreen, int stereolayer = -1);
+	void RenderSharedEyes(FRenderViewpoint &mainvp, const VRMode *vrmode, IntRect *bounds, float fov, float ratio, float fovratio, bool instanced);
+	void CheckStereoParity(FRenderViewpoint &mainvp, const VRMode *vrmode, IntRect *bounds, float fov, float ratio, float fovratio);
 	bool QuadStereoCheckInitialRenderContextState();
 	void PresentAnaglyph(bool r, bool g, bool b);
 	void PresentSideBySide();
@@ -36,6 +36,7 @@
 #include "gl/shaders/gl_shader.h"
 #include "gl/renderer/gl_renderer.h"
 #include "hwrenderer/dynlights/hw_lightbuffer.h"
+#include "hwrenderer/models/hw_bonebuffer.h"
 #include "gl/renderer/gl_renderbuffers.h"
 #include "gl/textures/gl_hwtexture.h"
 #include "gl/system/gl_buffers.h"
@@ -207,6 +208,21 @@ bool FGLRenderState::ApplyShader()
 	}
 
 	activeShader->muLightIndex.Set(index);
+
+	index = mBoneIndexBase;
+	if (!screen->mBones->GetBufferType() && index >= 0)
+	{
+		size_t start, size;
+		index = screen->mBones->GetBinding(index, &start, &size);
+
+		if (start != mLastMappedBoneIndex)
+		{
+			mLastMappedBoneIndex = start;
+			static_cast<GLDataBuffer*>(screen->mBones->GetBuffer())->BindRange(nullptr, start, size);
+		}
+	}
+
+	activeShader->muBoneIndexBase.Set(index);
 	return true;
 }
 
@@ -395,7 +411,8 @@ void FGLRenderState::Draw(int dt, int index, int count, bool apply)
 		Apply();
 	}
 	drawcalls.Clock();
-	glDrawArrays(dt2gl[dt], index, count);
+	if (mInstances > 1) glDrawArraysInstanced(dt2gl[dt], index, count, mInstances);
+	else glDrawArrays(dt2gl[dt], index, count);
 	drawcalls.Unclock();
 }
 
@@ -406,7 +423,8 @@ void FGLRenderState::DrawIndexed(int dt, int index, int count, bool apply)
 		Apply();
 	}
 	drawcalls.Clock();
-	glDrawElements(dt2gl[dt], count, GL_UNSIGNED_INT, (void*)(intptr_t)(index * sizeof(uint32_t)));
+	if (mInstances > 1) glDrawElementsInstanced(dt2gl[dt], count, GL_UNSIGNED_INT, (void*)(intptr_t)(index * sizeof(uint32_t)), mInstances);
+	else glDrawElements(dt2gl[dt], count, GL_UNSIGNED_INT, (void*)(intptr_t)(index * sizeof(uint32_t)));
 	drawcalls.Unclock();
 }
 
@@ -556,7 +574,8 @@ void FGLRenderState::ClearScreen()
 	glDisable(GL_MULTISAMPLE);
 	glDisable(GL_DEPTH_TEST);
 
-	glDrawArrays(GL_TRIANGLE_STRIP, FFlatVertexBuffer::FULLSCREEN_INDEX, 4);
+	if (mInstances > 1) glDrawArraysInstanced(GL_TRIANGLE_STRIP, FFlatVertexBuffer::FULLSCREEN_INDEX, 4, mInstances);
+	else glDrawArrays(GL_TRIANGLE_STRIP, FFlatVertexBuffer::FULLSCREEN_INDEX, 4);
 
 	glEnable(GL_DEPTH_TEST);
 	if (multi) glEnable(GL_MULTISAMPLE);
@@ -60,6 +60,7 @@ class FGLRenderState : public FRenderState
 	FShader *activeShader;
 
 	int mNumDrawBuffers = 1;
+	int mInstances = 1;	// 2 while both eyes of a stereo view are drawn in one pass
 
 	bool ApplyShader();
 	void ApplyState();
@@ -70,6 +71,7 @@ class FGLRenderState : public FRenderState
 	int lastTranslation = 0;
 	int maxBoundMaterial = -1;
 	size_t mLastMappedLightIndex = SIZE_MAX;
+	size_t mLastMappedBoneIndex = SIZE_MAX;
 
 	IVertexBuffer *mCurrentVertexBuffer;
 	int mCurrentVertexOffsets[2];	// one per binding point
@@ -120,6 +122,13 @@ public:
 		}
 	}
 
+	// Every draw call gets issued once per eye; the vertex shader routes the
+	// second instance to layer 1. Requires RFL_SHADER_LAYER.
+	void EnableStereoInstancing(bool on)
+	{
+		mInstances = on ? 2 : 1;
+	}
+
 	void ToggleState(int state, bool on);
 
 	void ClearScreen() override;
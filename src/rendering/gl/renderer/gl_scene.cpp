@@ -38,6 +38,7 @@
 #include "po_man.h"
 #include "p_local.h"
 #include "serializer.h"
+#include "c_dispatch.h"
 #include "g_levellocals.h"
 #include "actorinlines.h"
 #include "r_data/models/models.h"
@@ -68,6 +69,9 @@ CVAR(Bool, gl_texture, true, 0)
 CVAR(Bool, gl_no_skyclear, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 CVAR(Float, gl_mask_threshold, 0.5f,CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 CVAR(Float, gl_mask_sprite_threshold, 0.5f,CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+CVAR(Bool, vr_sharedscene, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)	// stereo modes walk the BSP once for both eyes
+CVAR(Float, vr_sharedscene_fovmargin, 10.f, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)	// degrees added to the culling FOV for that
+CVAR(Bool, vr_instancedstereo, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)	// with vr_sharedscene, draw both eyes in one pass where supported
 
 EXTERN_CVAR (Bool, cl_capfps)
 EXTERN_CVAR (Bool, r_deathcamera)
@@ -75,6 +79,27 @@ EXTERN_CVAR (Float, r_visibility)
 EXTERN_CVAR (Bool, r_drawvoxels)
 
 
+//-----------------------------------------------------------------------------
+//
+// gl_stereoparity renders the next frame with both stereo paths and
+// compares the eye textures. Meant for checking the instanced path
+// against the reference on a software GL implementation like llvmpipe,
+// where the results are deterministic.
+//
+//-----------------------------------------------------------------------------
+
+static bool StereoParityPending;
+
+CCMD(gl_stereoparity)
+{
+	if (VRMode::GetVRMode(true)->mEyeCount != 2)
+	{
+		Printf("gl_stereoparity needs a stereo vr_mode\n");
+		return;
+	}
+	StereoParityPending = true;
+}
+
 namespace OpenGLRenderer
 {
 
@@ -88,10 +113,43 @@ namespace OpenGLRenderer
 //-----------------------------------------------------------------------------
 
 void FGLRenderer::DrawScene(HWDrawInfo *di, int drawmode)
+{
+	CreateScene(di, drawmode);
+	DrawSceneLists(di, drawmode);
+}
+
+//-----------------------------------------------------------------------------
+//
+// Walks the BSP and fills the draw lists
+//
+//-----------------------------------------------------------------------------
+
+void FGLRenderer::CreateScene(HWDrawInfo *di, int drawmode)
+{
+	const auto &vp = di->Viewpoint;
+
+	if (vp.camera != nullptr)
+	{
+		ActorRenderFlags savedflags = vp.camera->renderflags;
+		di->CreateScene(drawmode == DM_MAINVIEW);
+		vp.camera->renderflags = savedflags;
+	}
+	else
+	{
+		di->CreateScene(false);
+	}
+}
+
+//-----------------------------------------------------------------------------
+//
+// Draws what CreateScene collected, portals included
+//
+//-----------------------------------------------------------------------------
+
+void FGLRenderer::DrawSceneLists(HWDrawInfo *di, int drawmode)
 {
 	static int recursion=0;
 	static int ssao_portals_available = 0;
-	const auto &vp = di->Viewpoint;
 
 	bool applySSAO = false;
 	if (drawmode == DM_MAINVIEW)
@@ -109,17 +167,6 @@ void FGLRenderer::DrawScene(HWDrawInfo *di, int drawmode)
 		ssao_portals_available--;
 	}
 
-	if (vp.camera != nullptr)
-	{
-		ActorRenderFlags savedflags = vp.camera->renderflags;
-		di->CreateScene(drawmode == DM_MAINVIEW);
-		vp.camera->renderflags = savedflags;
-	}
-	else
-	{
-		di->CreateScene(false);
-	}
-
 	glDepthMask(true);
 	if (!gl_no_skyclear) screen->mPortalState->RenderFirstSkyPortal(recursion, di, gl_RenderState);
 
@@ -153,6 +200,56 @@ void FGLRenderer::DrawScene(HWDrawInfo *di, int drawmode)
 	di->RenderTranslucent(gl_RenderState);
 }
 
+//-----------------------------------------------------------------------------
+//
+// Per eye setup and post processing
+//
+//-----------------------------------------------------------------------------
+
+void FGLRenderer::StartEye(IntRect *bounds, bool mainview)
+{
+	screen->SetViewportRects(bounds);
+
+	if (mainview) // Bind the scene frame buffer and turn on draw buffers used by ssao
+	{
+		bool useSSAO = (gl_ssao != 0);
+		mBuffers->BindSceneFB(useSSAO);
+		gl_RenderState.SetPassType(useSSAO ? GBUFFER_PASS : NORMAL_PASS);
+		gl_RenderState.EnableDrawBuffers(gl_RenderState.GetPassDrawBufferCount());
+		gl_RenderState.Apply();
+	}
+}
+
+void FGLRenderer::FinishEye(HWDrawInfo *di, const VREyeInfo *eye, sector_t *viewsector, int cm, bool toscreen, int stereolayer)
+{
+	PostProcess.Clock();
+	if (stereolayer >= 0)
+	{
+		// EndDrawScene already ran for all layers together.
+		mBuffers->BlitStereoLayerToTexture(stereolayer);
+	}
+	else
+	{
+		if (toscreen) di->EndDrawScene(viewsector, gl_RenderState); // do not call this for camera textures.
+
+		if (gl_RenderState.GetPassType() == GBUFFER_PASS) // Turn off ssao draw buffers
+		{
+			gl_RenderState.SetPassType(NORMAL_PASS);
+			gl_RenderState.EnableDrawBuffers(1);
+		}
+
+		mBuffers->BlitSceneToTexture(); // Copy the resulting scene to the current post process texture
+	}
+
+	PostProcessScene(cm, [&]() { di->DrawEndScene2D(viewsector, gl_RenderState); });
+
+	eye->AdjustBlend(di);
+	PalEntry modulateColor;
+	auto blend = screen->CalcBlend(viewsector, &modulateColor);
+	GLRenderer->DrawBlend(&blend, &modulateColor);
+	PostProcess.Unclock();
+}
+
 //-----------------------------------------------------------------------------
 //
 // Renders one viewpoint in a scene
@@ -176,22 +273,29 @@ sector_t * FGLRenderer::RenderViewpoint (FRenderViewpoint &mainvp, AActor * came
 	vrmode->SetUp();
 	const int eyeCount = vrmode->mEyeCount;
 	mBuffers->CurrentEye() = 0;  // always begin at zero, in case eye count changed
+	if (eyeCount > 1 && vr_sharedscene)
+	{
+		bool instanced = vr_instancedstereo && eyeCount == 2 && gl_ssao == 0 && (gl.flags & RFL_SHADER_LAYER);
+		if (StereoParityPending)
+		{
+			StereoParityPending = false;
+			if (instanced) CheckStereoParity(mainvp, vrmode, bounds, fov, ratio, fovratio);
+			else Printf("Instanced stereo is not active. It needs vr_instancedstereo, gl_ssao 0 and vertex shader layer output.\n");
+		}
+		else
+		{
+			RenderSharedEyes(mainvp, vrmode, bounds, fov, ratio, fovratio, instanced);
+		}
+		vrmode->TearDown();
+		return mainvp.sector;
+	}
+
 	DVector3 centerPos;
 	for (int eye_ix = 0; eye_ix < eyeCount; ++eye_ix)
 	{
 		const auto &eye = vrmode->mEyes[mBuffers->CurrentEye()];
 		eye->SetUp();
-		screen->SetViewportRects(bounds);
-
-		if (mainview) // Bind the scene frame buffer and turn on draw buffers used by ssao
-		{
-			bool useSSAO = (gl_ssao != 0);
-			mBuffers->BindSceneFB(useSSAO);
-			gl_RenderState.SetPassType(useSSAO ? GBUFFER_PASS : NORMAL_PASS);
-			gl_RenderState.EnableDrawBuffers(gl_RenderState.GetPassDrawBufferCount());
-			gl_RenderState.Apply();
-		}
-
+		StartEye(bounds, mainview);
 
 		auto di = HWDrawInfo::StartDrawInfo(mainvp.ViewLevel, nullptr, mainvp, nullptr);
 		auto &vp = di->Viewpoint;
@@ -218,32 +322,161 @@ sector_t * FGLRenderer::RenderViewpoint (FRenderViewpoint &mainvp, AActor * came
 
 		if (mainview)
 		{
-			PostProcess.Clock();
-			if (toscreen) di->EndDrawScene(mainvp.sector, gl_RenderState); // do not call this for camera textures.
+			FinishEye(di, eye, mainvp.sector, cm, toscreen);
+		}
+		di->EndDrawInfo();
+		eye->TearDown();
+		mBuffers->NextEye(eyeCount);
+	}
+	vrmode->TearDown();
+	
+	return mainvp.sector;
+}
 
-			if (gl_RenderState.GetPassType() == GBUFFER_PASS) // Turn off ssao draw buffers
+//-----------------------------------------------------------------------------
+//
+// Stereo rendering with one BSP traversal for all eyes
+//
+// The scene is created once from the midpoint between the eyes with a
+// frustum that is wide enough to cover all of them. Afterwards the draw
+// lists are submitted once per eye, each time with a new entry in the
+// viewpoint buffer for that eye's position and projection.
+//
+// Portals are kept alive until the last eye is done. Their contents still
+// get created once per eye because what is visible through a portal depends
+// far more on the exact view position than the main scene does.
+//
+// With 'instanced' both eyes are drawn in a single pass into the layers of
+// a layered scene buffer. Every draw call is issued with two instances and
+// the vertex shader uses StereoProjectionMatrix for the second one. Post
+// processing still runs per eye on a copy of the respective layer.
+//
+//-----------------------------------------------------------------------------
+
+void FGLRenderer::RenderSharedEyes(FRenderViewpoint &mainvp, const VRMode *vrmode, IntRect *bounds, float fov, float ratio, float fovratio, bool instanced)
+{
+	const int eyeCount = vrmode->mEyeCount;
+
+	auto di = HWDrawInfo::StartDrawInfo(mainvp.ViewLevel, nullptr, mainvp, nullptr);
+	auto &vp = di->Viewpoint;
+	const float yaw = vp.HWAngles.Yaw.Degrees;
+
+	DVector3 centerPos = vp.Pos;
+	DVector3 shift = { 0, 0, 0 };
+	for (int eye_ix = 0; eye_ix < eyeCount; ++eye_ix)
+	{
+		shift += vrmode->mEyes[eye_ix]->GetViewShift(yaw);
+	}
+	centerPos += shift / eyeCount;
+
+	int cm = CM_DEFAULT;
+	TArray<HWPortal *> portals;
+	for (int eye_ix = 0; eye_ix < eyeCount; ++eye_ix)
+	{
+		const auto &eye = vrmode->mEyes[mBuffers->CurrentEye()];
+		eye->SetUp();
+
+		if (eye_ix == 0 || !instanced)
+		{
+			if (instanced)
 			{
+				screen->SetViewportRects(bounds);
+				mBuffers->BindStereoSceneFB();
 				gl_RenderState.SetPassType(NORMAL_PASS);
 				gl_RenderState.EnableDrawBuffers(1);
+				gl_RenderState.Apply();
 			}
+			else
+			{
+				StartEye(bounds, true);
+			}
+			di->Set3DViewport(gl_RenderState);
 
-			mBuffers->BlitSceneToTexture(); // Copy the resulting scene to the current post process texture
+			if (eye_ix == 0)
+			{
+				di->KeepPortals = true;
+				di->SetViewArea();
+				cm = di->SetFullbrightFlags(vp.camera->player);
+
+				vp.Pos = vp.CenterPos = centerPos;
+				vp.FieldOfView = fov + vr_sharedscene_fovmargin;
+				di->VPUniforms.mProjectionMatrix = eye->GetProjection(fov, ratio, fovratio);
+				di->SetupView(gl_RenderState, vp.Pos.X, vp.Pos.Y, vp.Pos.Z, false, false);
+
+				// Only the main scene is created here, portals still need the full path.
+				di->ProcessScene(true, [&](HWDrawInfo *di, int mode) {
+					if (mode == DM_MAINVIEW) CreateScene(di, mode);
+					else DrawScene(di, mode);
+				});
+				portals = di->Portals;
+			}
+			else
+			{
+				screen->mPortalState->StartFrame();
+				di->Portals = portals;
+			}
 
-			PostProcessScene(cm, [&]() { di->DrawEndScene2D(mainvp.sector, gl_RenderState); });
+			vp.Pos = centerPos + eye->GetViewShift(yaw);
+			vp.FieldOfView = fov;
+			di->VPUniforms.mProjectionMatrix = eye->GetProjection(fov, ratio, fovratio);
+			if (instanced)
+			{
+				const auto &other = vrmode->mEyes[1 - mBuffers->CurrentEye()];
+				di->SetStereoProjection(other->GetProjection(fov, ratio, fovratio), centerPos + other->GetViewShift(yaw));
+				gl_RenderState.EnableStereoInstancing(true);
+			}
+			di->SetupView(gl_RenderState, vp.Pos.X, vp.Pos.Y, vp.Pos.Z, false, false);
+			DrawSceneLists(di, DM_MAINVIEW);
 
-			eye->AdjustBlend(di);
-			PalEntry modulateColor;
-			auto blend = screen->CalcBlend(mainvp.sector, &modulateColor);
-			GLRenderer->DrawBlend(&blend, &modulateColor);
-			PostProcess.Unclock();
+			if (instanced)
+			{
+				di->EndDrawScene(mainvp.sector, gl_RenderState);
+				gl_RenderState.EnableStereoInstancing(false);
+			}
 		}
-		di->EndDrawInfo();
+
+		FinishEye(di, eye, mainvp.sector, cm, true, instanced ? eye_ix : -1);
 		eye->TearDown();
 		mBuffers->NextEye(eyeCount);
 	}
-	vrmode->TearDown();
-	
-	return mainvp.sector;
+
+	for (auto p : portals) delete p;
+	di->EndDrawInfo();
+}
+
+void FGLRenderer::CheckStereoParity(FRenderViewpoint &mainvp, const VRMode *vrmode, IntRect *bounds, float fov, float ratio, float fovratio)
+{
+	TArray<float> reference[2], pixels;
+
+	RenderSharedEyes(mainvp, vrmode, bounds, fov, ratio, fovratio, false);
+	for (int eye = 0; eye < 2; eye++)
+	{
+		mBuffers->ReadEyeTexture(eye, reference[eye]);
+	}
+
+	mBuffers->CurrentEye() = 0;
+	RenderSharedEyes(mainvp, vrmode, bounds, fov, ratio, fovratio, true);
+	bool match = true;
+	for (int eye = 0; eye < 2; eye++)
+	{
+		mBuffers->ReadEyeTexture(eye, pixels);
+
+		float maxdiff = 0;
+		unsigned differing = 0;
+		for (unsigned i = 0; i < pixels.Size(); i += 4)
+		{
+			float diff = 0;
+			for (unsigned c = 0; c < 3; c++)
+			{
+				diff = MAX(diff, fabsf(pixels[i + c] - reference[eye][i + c]));
+			}
+			if (diff > 1.f / 255.f) differing++;
+			maxdiff = MAX(maxdiff, diff);
+		}
+		Printf("Eye %d: %u of %u pixels differ, largest difference %.4f\n", eye, differing, pixels.Size() / 4, maxdiff);
+		if (differing > 0 || pixels.Size() != reference[eye].Size()) match = false;
+	}
+	Printf("gl_stereoparity: %s\n", match ? "both eyes match" : "eyes differ");
 }
 
 }
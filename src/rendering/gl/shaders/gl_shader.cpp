@@ -38,6 +38,7 @@
 #include "hwrenderer/data/shaderuniforms.h"
 #include "hwrenderer/scene/hw_viewpointuniforms.h"
 #include "hwrenderer/dynlights/hw_lightbuffer.h"
+#include "hwrenderer/models/hw_bonebuffer.h"
 
 #include "gl_load/gl_interface.h"
 #include "gl/system/gl_debug.h"
@@ -220,6 +221,7 @@ bool FShader::Load(const char * name, const char * vert_prog_lump, const char *
 			mat4 ProjectionMatrix;
 			mat4 ViewMatrix;
 			mat4 NormalViewMatrix;
+			mat4 StereoProjectionMatrix;
 
 			vec4 uCameraPos;
 			vec4 uClipLine;
@@ -273,6 +275,9 @@ bool FShader::Load(const char * name, const char * vert_prog_lump, const char *
 	// dynamic lights
 	i_data += "uniform int uLightIndex;\n";
 
+	// skeletal model bones
+	i_data += "uniform int uBoneIndexBase;\n";
+
 	// Blinn glossiness and specular level
 	i_data += "uniform vec2 uSpecularMaterial;\n";
 
@@ -294,6 +299,19 @@ bool FShader::Load(const char * name, const char * vert_prog_lump, const char *
 	i_data += "};\n";
 	i_data += "#endif\n";
 
+	// bone buffer, uses the same buffer type as the lights
+	i_data += "#ifdef SHADER_STORAGE_LIGHTS\n";
+	i_data += "layout(std430, binding = 7) readonly buffer BoneBufferSSO\n";
+	i_data += "{\n";
+	i_data += "    mat4 bones[];\n";
+	i_data += "};\n";
+	i_data += "#elif defined NUM_UBO_BONES\n";
+	i_data += "uniform BoneBufferUBO\n";
+	i_data += "{\n";
+	i_data += "    mat4 bones[NUM_UBO_BONES];\n";
+	i_data += "};\n";
+	i_data += "#endif\n";
+
 	// textures
 	i_data += "uniform sampler2D tex;\n";
 	i_data += "uniform sampler2D ShadowMap;\n";
@@ -352,7 +370,7 @@ bool FShader::Load(const char * name, const char * vert_prog_lump, const char *
 	unsigned int lightbuffersize = screen->mLights->GetBlockSize();
 	if (!lightbuffertype)
 	{
-		vp_comb.Format("#version 330 core\n#define NUM_UBO_LIGHTS %d\n", lightbuffersize);
+		vp_comb.Format("#version 330 core\n#define NUM_UBO_LIGHTS %d\n#define NUM_UBO_BONES %d\n", lightbuffersize, screen->mBones->GetBlockSize());
 	}
 	else
 	{
@@ -368,9 +386,18 @@ bool FShader::Load(const char * name, const char * vert_prog_lump, const char *
 		vp_comb << "#define SUPPORTS_SHADOWMAPS\n";
 	}
 
-	vp_comb << defines << i_data.GetChars();
 	FString fp_comb = vp_comb;
 
+	if (gl.flags & RFL_SHADER_LAYER)
+	{
+		// Only needed by the vertex shader, where it allows drawing both eyes of a stereo view in one pass.
+		vp_comb << "#ifdef GL_ARB_shader_viewport_layer_array\n#extension GL_ARB_shader_viewport_layer_array : enable\n#else\n#extension GL_AMD_vertex_shader_layer : enable\n#endif\n";
+		vp_comb << "#define STEREO_LAYERS\n";
+	}
+
+	vp_comb << defines << i_data.GetChars();
+	fp_comb << defines << i_data.GetChars();
+
 	vp_comb << "#line 1\n";
 	fp_comb << "#line 1\n";
 
@@ -534,6 +561,7 @@ bool FShader::Load(const char * name, const char * vert_prog_lump, const char *
 	muLightParms.Init(hShader, "uLightAttr");
 	muClipSplit.Init(hShader, "uClipSplit");
 	muLightIndex.Init(hShader, "uLightIndex");
+	muBoneIndexBase.Init(hShader, "uBoneIndexBase");
 	muFogColor.Init(hShader, "uFogColor");
 	muDynLightColor.Init(hShader, "uDynLightColor");
 	muObjectColor.Init(hShader, "uObjectColor");
@@ -564,6 +592,8 @@ bool FShader::Load(const char * name, const char * vert_prog_lump, const char *
 	{
 		int tempindex = glGetUniformBlockIndex(hShader, "LightBufferUBO");
 		if (tempindex != -1) glUniformBlockBinding(hShader, tempindex, LIGHTBUF_BINDINGPOINT);
+		tempindex = glGetUniformBlockIndex(hShader, "BoneBufferUBO");
+		if (tempindex != -1) glUniformBlockBinding(hShader, tempindex, BONEBUF_BINDINGPOINT);
 	}
 	int tempindex = glGetUniformBlockIndex(hShader, "ViewpointUBO");
 	if (tempindex != -1) glUniformBlockBinding(hShader, tempindex, VIEWPOINT_BINDINGPOINT);
@@ -288,11 +288,12 @@ namespace s3d
 			for (int v = 0; v < pModel->unVertexCount; ++v)
 			{
 				const RenderModel_Vertex_t& vd = pModel->rVertexData[v];
-				vertptr[v].x = vd.vPosition.v[0];
-				vertptr[v].y = vd.vPosition.v[1];
-				vertptr[v].z = vd.vPosition.v[2];
-				vertptr[v].u = vd.rfTextureCoord[0];
-				vertptr[v].v = vd.rfTextureCoord[1];
+				vertptr[v].Set(
+					vd.vPosition.v[0],
+					vd.vPosition.v[1],
+					vd.vPosition.v[2],
+					vd.rfTextureCoord[0],
+					vd.rfTextureCoord[1]);
 				vertptr[v].SetNormal(
 					vd.vNormal.v[0],
 					vd.vNormal.v[1],
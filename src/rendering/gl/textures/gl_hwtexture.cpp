@@ -181,6 +181,42 @@ unsigned int FHardwareTexture::CreateTexture(unsigned char * buffer, int w, int
 }
 
 
+//===========================================================================
+// 
+//	Uploads a block compressed buffer with the mip levels it contains.
+//	The GPU cannot generate mipmaps for these, so any missing levels
+//	are cut off instead.
+//
+//===========================================================================
+
+unsigned int FHardwareTexture::CreateCompressedTexture(const FTextureBuffer &texbuffer, int texunit, const char *name)
+{
+	static const int Formats[] = { 0, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT };
+
+	if (glTexID == 0) glGenTextures(1, &glTexID);
+	if (texunit > 0) glActiveTexture(GL_TEXTURE0 + texunit);
+	if (texunit >= 0) lastbound[texunit] = glTexID;
+	glBindTexture(GL_TEXTURE_2D, glTexID);
+
+	FGLDebug::LabelObject(GL_TEXTURE, glTexID, name);
+
+	const uint8_t *data = texbuffer.mBuffer;
+	int w = texbuffer.mWidth, h = texbuffer.mHeight;
+	for (int level = 0; level < texbuffer.mLevels; level++)
+	{
+		int size = GetCompressedLevelSize(texbuffer.mFormat, w, h);
+		glCompressedTexImage2D(GL_TEXTURE_2D, level, Formats[texbuffer.mFormat], w, h, 0, size, data);
+		data += size;
+		w = MAX(w >> 1, 1);
+		h = MAX(h >> 1, 1);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texbuffer.mLevels - 1);
+	mipmapped = true;
+
+	if (texunit > 0) glActiveTexture(GL_TEXTURE0);
+	return glTexID;
+}
+
 //===========================================================================
 // 
 //
@@ -341,7 +377,19 @@ bool FHardwareTexture::BindOrCreate(FTexture *tex, int texunit, int clampmode, i
 
 		if (!tex->isHardwareCanvas())
 		{
-			texbuffer = tex->CreateTexBuffer(translation, flags | CTF_ProcessData);
+			if (gl.flags & RFL_TEXTURE_COMPRESSION_S3TC)
+			{
+				texbuffer = tex->CreateTexBuffer(translation, flags | CTF_ProcessData | CTF_AllowCompressed);
+				// Compressed data cannot be scaled down to fit.
+				if (texbuffer.mFormat != TBF_BGRA8 && (texbuffer.mWidth > gl.max_texturesize || texbuffer.mHeight > gl.max_texturesize))
+				{
+					texbuffer = tex->CreateTexBuffer(translation, flags | CTF_ProcessData);
+				}
+			}
+			else
+			{
+				texbuffer = tex->CreateTexBuffer(translation, flags | CTF_ProcessData);
+			}
 			w = texbuffer.mWidth;
 			h = texbuffer.mHeight;
 		}
@@ -350,7 +398,11 @@ bool FHardwareTexture::BindOrCreate(FTexture *tex, int texunit, int clampmode, i
 			w = tex->GetWidth();
 			h = tex->GetHeight();
 		}
-		if (!CreateTexture(texbuffer.mBuffer, w, h, texunit, needmipmap, translation, "FHardwareTexture.BindOrCreate"))
+		if (texbuffer.mFormat != TBF_BGRA8)
+		{
+			CreateCompressedTexture(texbuffer, texunit, "FHardwareTexture.BindOrCreate");
+		}
+		else if (!CreateTexture(texbuffer.mBuffer, w, h, texunit, needmipmap, translation, "FHardwareTexture.BindOrCreate"))
 		{
 			// could not create texture
 			return false;
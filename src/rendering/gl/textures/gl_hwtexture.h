@@ -15,6 +15,7 @@
 
 class FCanvasTexture;
 class AActor;
+struct FTextureBuffer;
 
 namespace OpenGLRenderer
 {
@@ -65,6 +66,7 @@ public:
 	uint8_t *MapBuffer();
 
 	unsigned int CreateTexture(unsigned char * buffer, int w, int h, int texunit, bool mipmap, int translation, const char *name);
+	unsigned int CreateCompressedTexture(const FTextureBuffer &texbuffer, int texunit, const char *name);
 	unsigned int GetTextureHandle(int translation);
 };
 
@@ -185,6 +185,7 @@ void gl_LoadExtensions()
 
 	if (gl_version >= 4.3f || CheckExtension("GL_ARB_invalidate_subdata")) gl.flags |= RFL_INVALIDATE_BUFFER;
 	if (gl_version >= 4.3f || CheckExtension("GL_KHR_debug")) gl.flags |= RFL_DEBUG;
+	if (CheckExtension("GL_ARB_shader_viewport_layer_array") || CheckExtension("GL_AMD_vertex_shader_layer")) gl.flags |= RFL_SHADER_LAYER;
 
 	glGetIntegerv(GL_MAX_FRAGMENT_UNIFORM_COMPONENTS, &v);
 	gl.maxuniforms = v;
@@ -16,6 +16,8 @@ enum
 	VATTR_VERTEX2,
 	VATTR_NORMAL,
 	VATTR_NORMAL2,
+	VATTR_BONESELECTOR,
+	VATTR_BONEWEIGHT,
 	
 	VATTR_MAX
 };
@@ -80,6 +80,7 @@ void HWViewpointBuffer::Set2D(FRenderState &di, int width, int height)
 		HWViewpointUniforms matrices;
 		matrices.SetDefaults(nullptr);
 		matrices.mProjectionMatrix.ortho(0, (float)width, (float)height, 0, -1.0f, 1.0f);
+		matrices.mStereoProjectionMatrix = matrices.mProjectionMatrix;
 		matrices.CalcDependencies();
 		mBuffer->Map();
 		memcpy(mBuffer->Memory(), &matrices, sizeof(matrices));
@@ -11,7 +11,8 @@ enum
 	VIEWPOINT_BINDINGPOINT = 3,
 	LIGHTNODES_BINDINGPOINT = 4,
 	LIGHTLINES_BINDINGPOINT = 5,
-	LIGHTLIST_BINDINGPOINT = 6
+	LIGHTLIST_BINDINGPOINT = 6,
+	BONEBUF_BINDINGPOINT = 7
 };
 
 enum class UniformType
@@ -0,0 +1,122 @@
+/*
+** hw_bonebuffer.cpp
+** Buffer data maintenance for skeletal model bones
+**
+**---------------------------------------------------------------------------
+** Copyright 2019 GZDoom maintainers and contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include "templates.h"
+#include "v_video.h"
+#include "hw_bonebuffer.h"
+#include "hwrenderer/data/shaderuniforms.h"
+
+static const int ELEMENT_SIZE = 16 * sizeof(float);	// one mat4 per bone
+
+FBoneBuffer::FBoneBuffer()
+{
+	int maxNumberOfBones = 80000;
+
+	mBufferSize = maxNumberOfBones;
+	mByteSize = mBufferSize * ELEMENT_SIZE;
+
+	// This must use the same kind of buffer as the lights because both share the shader preamble
+	// which has to decide between the storage buffer and the uniform buffer variant.
+	if (screen->IsVulkan() || screen->IsPoly() || ((screen->hwcaps & RFL_SHADER_STORAGE_BUFFER) && !strstr(screen->vendorstring, "Intel")))
+	{
+		mBufferType = true;
+		mBlockAlign = 0;
+		mBlockSize = mBufferSize;
+		mMaxUploadSize = mBlockSize;
+	}
+	else
+	{
+		mBufferType = false;
+		mBlockSize = screen->maxuniformblock / ELEMENT_SIZE;
+		mBlockAlign = MAX(1u, screen->uniformblockalignment / ELEMENT_SIZE);
+		mMaxUploadSize = (mBlockSize - mBlockAlign);
+		mByteSize += screen->maxuniformblock;	// to avoid binding beyond the end of the buffer.
+	}
+
+	mBuffer = screen->CreateDataBuffer(BONEBUF_BINDINGPOINT, mBufferType, false);
+	mBuffer->SetData(mByteSize, nullptr, false);
+
+	Clear();
+}
+
+FBoneBuffer::~FBoneBuffer()
+{
+	delete mBuffer;
+}
+
+void FBoneBuffer::Clear()
+{
+	mIndex = 0;
+}
+
+//==========================================================================
+//
+// Returns the index of the first bone, or -1 if the palette doesn't fit.
+// Unlike the light buffer this gets filled while drawing, so it cannot
+// rely on the buffer being mapped unless the mapping is persistent.
+//
+//==========================================================================
+
+int FBoneBuffer::UploadBones(const TArray<VSMatrix> &bones)
+{
+	unsigned int totalsize = bones.Size();
+	if (totalsize == 0 || totalsize > mMaxUploadSize) return -1;
+
+	unsigned thisindex = mIndex.fetch_add(totalsize);
+	if (thisindex + totalsize > mBufferSize)
+	{
+		return -1;	// Buffer is full. The model will be drawn in its bind pose.
+	}
+
+	static_assert(sizeof(VSMatrix) == ELEMENT_SIZE, "VSMatrix must be a plain float mat4");
+	if (screen->BuffersArePersistent())
+	{
+		memcpy((uint8_t*)mBuffer->Memory() + thisindex * ELEMENT_SIZE, bones.Data(), totalsize * ELEMENT_SIZE);
+	}
+	else
+	{
+		mBuffer->SetSubData(thisindex * ELEMENT_SIZE, totalsize * ELEMENT_SIZE, bones.Data());
+	}
+	return thisindex;
+}
+
+int FBoneBuffer::GetBinding(unsigned int index, size_t* pOffset, size_t* pSize)
+{
+	// this function will only get called if a uniform buffer is used. For a shader storage buffer we only need to bind the buffer once at the start.
+	unsigned int offset = (index / mBlockAlign) * mBlockAlign;
+
+	*pOffset = offset * ELEMENT_SIZE;
+	*pSize = mBlockSize * ELEMENT_SIZE;
+	return (index - offset);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+#include "tarray.h"
+#include "matrix.h"
+#include "hwrenderer/data/buffers.h"
+
+// Holds the bone matrices of all skeletal models drawn in the current frame.
+// Each model instance uploads its palette once per draw and the vertex shader
+// picks its matrices out of here by index.
+class FBoneBuffer
+{
+	IDataBuffer *mBuffer;
+
+	bool mBufferType;
+	std::atomic<unsigned int> mIndex;
+	unsigned int mBlockAlign;
+	unsigned int mBlockSize;
+	unsigned int mBufferSize;
+	unsigned int mByteSize;
+	unsigned int mMaxUploadSize;
+
+public:
+
+	FBoneBuffer();
+	~FBoneBuffer();
+	void Clear();
+	int UploadBones(const TArray<VSMatrix> &bones);
+	unsigned int GetBlockSize() const { return mBlockSize; }
+	bool GetBufferType() const { return mBufferType; }
+	int GetBinding(unsigned int index, size_t* pOffset, size_t* pSize);
+
+	// OpenGL needs the buffer to mess around with the binding.
+	IDataBuffer* GetBuffer() const
+	{
+		return mBuffer;
+	}
+};
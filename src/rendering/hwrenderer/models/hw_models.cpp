@@ -41,6 +41,7 @@
 #include "hwrenderer/scene/hw_drawinfo.h"
 #include "hwrenderer/scene/hw_renderstate.h"
 #include "hwrenderer/scene/hw_portal.h"
+#include "hwrenderer/models/hw_bonebuffer.h"
 #include "hw_models.h"
 
 #include "hwrenderer/utility/hw_cvars.h"
@@ -163,9 +164,9 @@ void FHWModelRenderer::EndDrawHUDModel(AActor *actor)
 		state.SetCulling(Cull_None);
 }
 
-IModelVertexBuffer *FHWModelRenderer::CreateVertexBuffer(bool needindex, bool singleframe)
+IModelVertexBuffer *FHWModelRenderer::CreateVertexBuffer(bool needindex, bool singleframe, bool skinned)
 {
-	return new FModelVertexBuffer(needindex, singleframe);
+	return new FModelVertexBuffer(needindex, singleframe, skinned);
 }
 
 void FHWModelRenderer::SetInterpolation(double inter)
@@ -173,6 +174,11 @@ void FHWModelRenderer::SetInterpolation(double inter)
 	state.SetInterpolationFactor((float)inter);
 }
 
+void FHWModelRenderer::SetBones(const TArray<VSMatrix> &bones)
+{
+	state.SetBoneIndexBase(bones.Size() > 0 ? screen->mBones->UploadBones(bones) : -1);
+}
+
 void FHWModelRenderer::SetMaterial(FTexture *skin, bool clampNoFilter, int translation)
 {
 	FMaterial * tex = FMaterial::ValidateTexture(skin, false);
@@ -196,10 +202,11 @@ void FHWModelRenderer::DrawElements(int numIndices, size_t offset)
 //
 //===========================================================================
 
-FModelVertexBuffer::FModelVertexBuffer(bool needindex, bool singleframe)
+FModelVertexBuffer::FModelVertexBuffer(bool needindex, bool singleframe, bool skinned)
 {
 	mVertexBuffer = screen->CreateVertexBuffer();
 	mIndexBuffer = needindex ? screen->CreateIndexBuffer() : nullptr;
+	mSkinned = skinned;
 
 	static const FVertexBufferAttribute format[] = {
 		{ 0, VATTR_VERTEX, VFmt_Float3, (int)myoffsetof(FModelVertex, x) },
@@ -208,7 +215,20 @@ FModelVertexBuffer::FModelVertexBuffer(bool needindex, bool singleframe)
 		{ 1, VATTR_VERTEX2, VFmt_Float3, (int)myoffsetof(FModelVertex, x) },
 		{ 1, VATTR_NORMAL2, VFmt_Packed_A2R10G10B10, (int)myoffsetof(FModelVertex, packedNormal) }
 	};
-	mVertexBuffer->SetFormat(2, 5, sizeof(FModelVertex), format);
+
+	// Skeletal models are single frame, so they have no second binding point.
+	static const FVertexBufferAttribute skinnedformat[] = {
+		{ 0, VATTR_VERTEX, VFmt_Float3, (int)myoffsetof(FSkinnedModelVertex, vertex.x) },
+		{ 0, VATTR_TEXCOORD, VFmt_Float2, (int)myoffsetof(FSkinnedModelVertex, vertex.u) },
+		{ 0, VATTR_NORMAL, VFmt_Packed_A2R10G10B10, (int)myoffsetof(FSkinnedModelVertex, vertex.packedNormal) },
+		{ 1, VATTR_VERTEX2, VFmt_Float3, (int)myoffsetof(FSkinnedModelVertex, vertex.x) },
+		{ 1, VATTR_NORMAL2, VFmt_Packed_A2R10G10B10, (int)myoffsetof(FSkinnedModelVertex, vertex.packedNormal) },
+		{ 0, VATTR_BONESELECTOR, VFmt_Byte4, (int)myoffsetof(FSkinnedModelVertex, bones.selector) },
+		{ 0, VATTR_BONEWEIGHT, VFmt_Byte4, (int)myoffsetof(FSkinnedModelVertex, bones.weight) }
+	};
+
+	if (!skinned) mVertexBuffer->SetFormat(2, 5, sizeof(FModelVertex), format);
+	else mVertexBuffer->SetFormat(2, 7, sizeof(FSkinnedModelVertex), skinnedformat);
 }
 
 //===========================================================================
@@ -231,6 +251,11 @@ FModelVertexBuffer::~FModelVertexBuffer()
 
 FModelVertex *FModelVertexBuffer::LockVertexBuffer(unsigned int size)
 {
+	if (mSkinned)
+	{
+		mSkinnedVertices.Resize(size);
+		return mSkinnedVertices.Data();
+	}
 	return static_cast<FModelVertex*>(mVertexBuffer->Lock(size * sizeof(FModelVertex)));
 }
 
@@ -242,7 +267,28 @@ FModelVertex *FModelVertexBuffer::LockVertexBuffer(unsigned int size)
 
 void FModelVertexBuffer::UnlockVertexBuffer()
 {
+	if (!mSkinned) mVertexBuffer->Unlock();
+}
+
+//===========================================================================
+//
+// Skinned buffers are only uploaded here, with the bones next to the
+// vertices they belong to.
+//
+//===========================================================================
+
+void FModelVertexBuffer::SetVertexBones(const FModelVertexBones *bones, unsigned int size)
+{
+	if (!mSkinned || size != mSkinnedVertices.Size()) return;
+
+	auto vertptr = static_cast<FSkinnedModelVertex*>(mVertexBuffer->Lock(size * sizeof(FSkinnedModelVertex)));
+	for (unsigned int i = 0; i < size; i++)
+	{
+		vertptr[i].vertex = mSkinnedVertices[i];
+		vertptr[i].bones = bones[i];
+	}
 	mVertexBuffer->Unlock();
+	mSkinnedVertices.Reset();
 }
 
 //===========================================================================
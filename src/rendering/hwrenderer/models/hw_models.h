@@ -36,10 +36,12 @@ class FModelVertexBuffer : public IModelVertexBuffer
 {
 	IVertexBuffer *mVertexBuffer;
 	IIndexBuffer *mIndexBuffer;
+	TArray<FModelVertex> mSkinnedVertices;	// held until SetVertexBones interleaves them with the bones
+	bool mSkinned;
 
 public:
 
-	FModelVertexBuffer(bool needindex, bool singleframe);
+	FModelVertexBuffer(bool needindex, bool singleframe, bool skinned = false);
 	~FModelVertexBuffer();
 
 	FModelVertex *LockVertexBuffer(unsigned int size) override;
@@ -49,6 +51,7 @@ public:
 	void UnlockIndexBuffer() override;
 
 	void SetupFrame(FModelRenderer *renderer, unsigned int frame1, unsigned int frame2, unsigned int size) override;
+	void SetVertexBones(const FModelVertexBones *bones, unsigned int size) override;
 };
 
 class FHWModelRenderer : public FModelRenderer
@@ -64,11 +67,12 @@ public:
 	ModelRendererType GetType() const override { return GLModelRendererType; }
 	void BeginDrawModel(AActor *actor, FSpriteModelFrame *smf, const VSMatrix &objectToWorldMatrix, bool mirrored) override;
 	void EndDrawModel(AActor *actor, FSpriteModelFrame *smf) override;
-	IModelVertexBuffer *CreateVertexBuffer(bool needindex, bool singleframe) override;
+	IModelVertexBuffer *CreateVertexBuffer(bool needindex, bool singleframe, bool skinned) override;
 	VSMatrix GetViewToWorldMatrix() override;
 	void BeginDrawHUDModel(AActor* actor, const VSMatrix& objectToWorldMatrix, bool mirrored) override;
 	void EndDrawHUDModel(AActor* actor) override;
 	void SetInterpolation(double interpolation) override;
+	void SetBones(const TArray<VSMatrix> &bones) override;
 	void SetMaterial(FTexture* skin, bool clampNoFilter, int translation) override;
 	void DrawArrays(int start, int count) override;
 	void DrawElements(int numIndices, size_t offset) override;
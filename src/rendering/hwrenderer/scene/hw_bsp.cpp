@@ -32,7 +32,7 @@
 #include "p_effect.h"
 #include "po_man.h"
 #include "m_fixed.h"
-#include "ctpl.h"
+#include "jobsystem.h"
 #include "hwrenderer/scene/hw_fakeflat.h"
 #include "hwrenderer/scene/hw_clipper.h"
 #include "hwrenderer/scene/hw_drawstructs.h"
@@ -41,14 +41,14 @@
 #include "hwrenderer/utility/hw_clock.h"
 #include "hwrenderer/data/flatvertices.h"
 
-#ifdef ARCH_IA32
-#include <immintrin.h>
-#endif // ARCH_IA32
+#include <condition_variable>
+#include <memory>
 
 CVAR(Bool, gl_multithread, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+CVAR(Int, gl_bspthreads, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// 0 = one per job system worker
 
 thread_local bool isWorkerThread;
-ctpl::thread_pool renderPool(1);
+thread_local HWBspLane *bspLane;
 bool inited = false;
 
 struct RenderJob
@@ -60,82 +60,191 @@ struct RenderJob
 		SpriteJob,
 		ParticleJob,
 		PortalJob,
-		TerminateJob	// inserted when all work is done so that the worker can return.
+		TerminateJob	// inserted when all work is done so that the workers can return.
 	};
 	
 	int type;
+	int lane;	// -1 for all of them
 	subsector_t *sub;
 	seg_t *seg;
 };
 
+struct RenderLane
+{
+	HWBspLane Output;
+	std::atomic<int> Queued{};		// jobs added for this lane
+	std::atomic<bool> Waiting{};
+	int Taken = 0;					// only used by the worker
+	int Notified = 0;				// only used by the main thread
+	int RenderedLines = 0;
+	std::mutex Mutex;
+	std::condition_variable Wakeup;
+};
+
+//==========================================================================
+//
+// All jobs go into one array in the order the BSP walk produces them, each
+// one tagged with the lane that is supposed to process it. Every worker
+// skips the jobs of the other lanes, so the array index of a job doubles
+// as the key the results get put back in order with.
+//
+// Walls and flats are dealt out round robin. Everything that touches
+// sprites goes to lane 0, since thing processing relies on validcount and
+// is not safe to run on more than one thread.
+//
+// A worker that runs out of jobs sleeps until a batch of new ones has been
+// queued for it, so the main thread does not need to wake it for each job.
+//
+//==========================================================================
 
 class RenderJobQueue
 {
 	RenderJob pool[300000];	// Way more than ever needed. The largest ever seen on a single viewpoint is around 40000.
-	std::atomic<int> readindex{};
 	std::atomic<int> writeindex{};
+	std::vector<std::unique_ptr<RenderLane>> lanes;
+	int numLanes = 0;
+	int nextLane = 0;
+
+	enum { WakeBatch = 32 };
+
+	void Queue(RenderLane &lane, bool force)
+	{
+		int queued = ++lane.Queued;
+		if (lane.Waiting && (force || queued - lane.Notified >= WakeBatch))
+		{
+			lane.Notified = queued;
+			{
+				std::unique_lock<std::mutex> lock(lane.Mutex);
+			}
+			lane.Wakeup.notify_one();
+		}
+	}
+
 public:
+	void Start(int count)
+	{
+		while ((int)lanes.size() < count)
+		{
+			lanes.push_back(std::make_unique<RenderLane>());
+		}
+		for (int i = 0; i < count; i++)
+		{
+			auto &lane = *lanes[i];
+			lane.Output.Events.Clear();
+			lane.Queued = 0;
+			lane.Taken = 0;
+			lane.Notified = 0;
+			lane.RenderedLines = 0;
+		}
+		numLanes = count;
+		nextLane = 0;
+		writeindex = 0;
+	}
+
+	RenderLane &Lane(int index)
+	{
+		return *lanes[index];
+	}
+
 	void AddJob(int type, subsector_t *sub, seg_t *seg = nullptr)
 	{
 		// This does not check for array overflows. The pool should be large enough that it never hits the limit.
+		int lane = 0;
+		if (type == RenderJob::WallJob || type == RenderJob::FlatJob)
+		{
+			lane = nextLane;
+			if (++nextLane == numLanes) nextLane = 0;
+		}
+		int index = writeindex;
+		pool[index] = { type, lane, sub, seg };
+		writeindex = index + 1;	// update index only after the value has been written.
+		Queue(*lanes[lane], false);
+	}
 
-		pool[writeindex] = { type, sub, seg };
-		writeindex++;	// update index only after the value has been written.
+	void Terminate()
+	{
+		int index = writeindex;
+		pool[index] = { RenderJob::TerminateJob, -1, nullptr, nullptr };
+		writeindex = index + 1;
+		for (int i = 0; i < numLanes; i++)
+		{
+			Queue(*lanes[i], true);
+		}
 	}
 
-	RenderJob *GetJob()
+	// Returns the next job for the given lane and its index.
+	RenderJob *GetJob(int lane, int &readindex)
 	{
-		if (readindex < writeindex) return &pool[readindex++];
-		return nullptr;
+		auto &self = *lanes[lane];
+		while (true)
+		{
+			while (readindex < writeindex)
+			{
+				RenderJob *job = &pool[readindex++];
+				if (job->lane == lane || job->lane < 0)
+				{
+					self.Taken++;
+					return job;
+				}
+			}
+
+			std::unique_lock<std::mutex> lock(self.Mutex);
+			self.Waiting = true;
+			self.Wakeup.wait(lock, [&]() { return self.Queued > self.Taken; });
+			self.Waiting = false;
+		}
 	}
-	
-	void ReleaseAll()
+
+	void ResetAllocators()
 	{
-		readindex = 0;
-		writeindex = 0;
+		for (auto &lane : lanes)
+		{
+			lane->Output.Allocator.FreeAll();
+		}
 	}
 };
 
 static RenderJobQueue jobQueue;	// One static queue is sufficient here. This code will never be called recursively.
 
-void HWDrawInfo::WorkerThread()
+void ResetBspLaneAllocators()
+{
+	jobQueue.ResetAllocators();
+}
+
+void HWDrawInfo::WorkerThread(int lane)
 {
 	sector_t *front, *back;
+	auto &self = jobQueue.Lane(lane);
+	int readindex = 0;
+
+	// The setup timers cannot be shared between threads, so only the
+	// first lane feeds them. It gets all the sprites.
+	bool timed = lane == 0;
 
-	WTTotal.Clock();
+	if (timed) WTTotal.Clock();
 	isWorkerThread = true;	// for adding asserts in GL API code. The worker thread may never call any GL API.
+	bspLane = &self.Output;
 	while (true)
 	{
-		auto job = jobQueue.GetJob();
-		if (job == nullptr)
-		{
-#ifdef ARCH_IA32
-			// The queue is empty. But yielding would be too costly here and possibly cause further delays down the line if the thread is halted.
-			// So instead add a few pause instructions and retry immediately.
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-#endif // ARCH_IA32
-		}
+		auto job = jobQueue.GetJob(lane, readindex);
+		bspLane->CurrentJob = readindex - 1;
+
 		// Note that the main thread MUST have prepared the fake sectors that get used below!
 		// This worker thread cannot prepare them itself without costly synchronization.
-		else switch (job->type)
+		switch (job->type)
 		{
 		case RenderJob::TerminateJob:
-			WTTotal.Unclock();
+			// This runs as a job on the shared workers, so the thread may be
+			// reused for other work, including by the main thread itself.
+			isWorkerThread = false;
+			bspLane = nullptr;
+			if (timed) WTTotal.Unclock();
 			return;
 
 		case RenderJob::WallJob:
 		{
 			HWWall wall;
-			SetupWall.Clock();
+			if (timed) SetupWall.Clock();
 			wall.sub = job->sub;
 
 			front = hw_FakeFlat(job->sub->sector, in_area, false);
@@ -154,19 +263,19 @@ void HWDrawInfo::WorkerThread()
 			else back = nullptr;
 
 			wall.Process(this, job->seg, front, back);
-			rendered_lines++;
-			SetupWall.Unclock();
+			self.RenderedLines++;
+			if (timed) SetupWall.Unclock();
 			break;
 		}
 
 		case RenderJob::FlatJob:
 		{
 			HWFlat flat;
-			SetupFlat.Clock();
+			if (timed) SetupFlat.Clock();
 			flat.section = job->sub->section;
 			front = hw_FakeFlat(job->sub->render_sector, in_area, false);
 			flat.ProcessSector(this, front);
-			SetupFlat.Unclock();
+			if (timed) SetupFlat.Unclock();
 			break;
 		}
 
@@ -188,13 +297,81 @@ void HWDrawInfo::WorkerThread()
 			AddSubsectorToPortal((FSectorPortalGroup *)job->seg, job->sub);
 			break;
 		}
-
 	}
 }
 
+//==========================================================================
+//
+// Feeds everything the workers recorded into the draw info, ordered by
+// the job it came from. All output of one job is in the same lane.
+//
+//==========================================================================
 
+void HWDrawInfo::ReplayLanes(int numLanes)
+{
+	std::vector<unsigned> pos(numLanes);
 
+	for (int i = 0; i < numLanes; i++)
+	{
+		rendered_lines += jobQueue.Lane(i).RenderedLines;
+	}
 
+	while (true)
+	{
+		int lane = -1;
+		int job = INT_MAX;
+		for (int i = 0; i < numLanes; i++)
+		{
+			auto &events = jobQueue.Lane(i).Output.Events;
+			if (pos[i] < events.Size() && events[pos[i]].job < job)
+			{
+				job = events[pos[i]].job;
+				lane = i;
+			}
+		}
+		if (lane < 0) break;
+
+		auto &events = jobQueue.Lane(lane).Output.Events;
+		for (; pos[lane] < events.Size() && events[pos[lane]].job == job; pos[lane]++)
+		{
+			auto &ev = events[pos[lane]];
+			switch (ev.type)
+			{
+			case HWLaneEvent::Wall:
+				drawlists[ev.arg[0]].LinkWall((HWWall *)ev.ptr[0]);
+				break;
+
+			case HWLaneEvent::Flat:
+				drawlists[ev.arg[0]].LinkFlat((HWFlat *)ev.ptr[0]);
+				break;
+
+			case HWLaneEvent::Sprite:
+				drawlists[ev.arg[0]].LinkSprite((HWSprite *)ev.ptr[0]);
+				break;
+
+			case HWLaneEvent::Decal:
+				Decals[ev.arg[0]].Push((HWDecal *)ev.ptr[0]);
+				break;
+
+			case HWLaneEvent::Portal:
+				((HWWall *)ev.ptr[0])->PutPortal(this, ev.arg[0], ev.arg[1]);
+				break;
+
+			case HWLaneEvent::SubsectorPortal:
+				AddSubsectorToPortal((FSectorPortalGroup *)ev.ptr[0], (subsector_t *)ev.ptr[1]);
+				break;
+
+			case HWLaneEvent::UpperMissingTexture:
+				AddUpperMissingTexture((side_t *)ev.ptr[0], (subsector_t *)ev.ptr[1], ev.value);
+				break;
+
+			case HWLaneEvent::LowerMissingTexture:
+				AddLowerMissingTexture((side_t *)ev.ptr[0], (subsector_t *)ev.ptr[1], ev.value);
+				break;
+			}
+		}
+	}
+}
 
 EXTERN_CVAR(Bool, gl_render_segs)
 
@@ -809,16 +986,21 @@ void HWDrawInfo::RenderBSP(void *node, bool drawpsprites)
 	multithread = gl_multithread;
 	if (multithread)
 	{
-		jobQueue.ReleaseAll();
-		auto future = renderPool.push([&](int id) {
-			WorkerThread();
-		});
+		int maxLanes = FJobSystem::NumThreads() - 1;
+		int numLanes = clamp<int>(gl_bspthreads > 0 ? *gl_bspthreads : maxLanes, 1, maxLanes);
+		FJobGroup workers;
+		jobQueue.Start(numLanes);
+		for (int i = 0; i < numLanes; i++)
+		{
+			workers.Run([=]() { WorkerThread(i); });
+		}
 		RenderBSPNode(node);
 
-		jobQueue.AddJob(RenderJob::TerminateJob, nullptr, nullptr);
+		jobQueue.Terminate();
 		Bsp.Unclock();
 		MTWait.Clock();
-		future.wait();
+		workers.Wait();
+		ReplayLanes(numLanes);
 		MTWait.Unclock();
 	}
 	else
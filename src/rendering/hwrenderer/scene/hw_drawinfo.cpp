@@ -138,6 +138,7 @@ void HWDrawInfo::StartScene(FRenderViewpoint &parentvp, HWViewpointUniforms *uni
 	}
 	else VPUniforms.SetDefaults(this);
 	mClipper->SetViewpoint(Viewpoint);
+	KeepPortals = false;
 
 	ClearBuffers();
 
@@ -368,6 +369,36 @@ void HWDrawInfo::SetupView(FRenderState &state, float vx, float vy, float vz, bo
 	vpIndex = screen->mViewpoints->SetViewpoint(state, &VPUniforms);
 }
 
+//-----------------------------------------------------------------------------
+//
+// SetStereoProjection
+// Projection of a second eye at eyepos for instanced stereo. It gets
+// applied to view space coordinates of the current viewpoint, so it only
+// needs to add the eye offset rotated into view space. Portals inherit it
+// unchanged since the eyes keep their relative position in view space.
+// Must be called before SetupView.
+//
+//-----------------------------------------------------------------------------
+
+void HWDrawInfo::SetStereoProjection(const VSMatrix &projection, const DVector3 &eyepos)
+{
+	auto &vp = Viewpoint;
+	DVector3 delta = eyepos - vp.Pos;
+
+	VSMatrix rotation;
+	rotation.loadIdentity();
+	rotation.rotate(vp.HWAngles.Roll.Degrees, 0.0f, 0.0f, 1.0f);
+	rotation.rotate(vp.HWAngles.Pitch.Degrees, 1.0f, 0.0f, 0.0f);
+	rotation.rotate(vp.HWAngles.Yaw.Degrees, 0.0f, 1.0f, 0.0f);
+
+	FLOATTYPE offset[4] = { (FLOATTYPE)delta.X, (FLOATTYPE)(-delta.Z * Level->info->pixelstretch), (FLOATTYPE)-delta.Y, 0 };
+	FLOATTYPE shift[4];
+	rotation.multMatrixPoint(offset, shift);
+
+	VPUniforms.mStereoProjectionMatrix = projection;
+	VPUniforms.mStereoProjectionMatrix.translate(shift[0], shift[1], shift[2]);
+}
+
 //-----------------------------------------------------------------------------
 //
 //
@@ -393,6 +424,7 @@ void HWViewpointUniforms::SetDefaults(HWDrawInfo *drawInfo)
 	mProjectionMatrix.loadIdentity();
 	mViewMatrix.loadIdentity();
 	mNormalViewMatrix.loadIdentity();
+	mStereoProjectionMatrix.loadIdentity();
 	mViewHeight = viewheight;
 	mGlobVis = (float)R_GetGlobVis(r_viewwindow, r_visibility) / 32.f;
 	const int lightMode = drawInfo == nullptr ? static_cast<int>(*gl_lightmode) : static_cast<int>(drawInfo->lightmode);
@@ -410,6 +442,12 @@ void HWViewpointUniforms::SetDefaults(HWDrawInfo *drawInfo)
 
 HWDecal *HWDrawInfo::AddDecal(bool onmirror)
 {
+	if (bspLane != nullptr)
+	{
+		auto decal = bspLane->Alloc<HWDecal>();
+		bspLane->Add(HWLaneEvent::Decal, decal, nullptr, onmirror);
+		return decal;
+	}
 	auto decal = (HWDecal*)RenderDataAllocator.Alloc(sizeof(HWDecal));
 	Decals[onmirror ? 1 : 0].Push(decal);
 	return decal;
@@ -675,6 +713,11 @@ void HWDrawInfo::ProcessScene(bool toscreen, const std::function<void(HWDrawInfo
 
 void HWDrawInfo::AddSubsectorToPortal(FSectorPortalGroup *ptg, subsector_t *sub)
 {
+	if (bspLane != nullptr)
+	{
+		bspLane->Add(HWLaneEvent::SubsectorPortal, ptg, sub);
+		return;
+	}
 	auto portal = FindPortal(ptg);
 	if (!portal)
 	{
@@ -95,6 +95,57 @@ enum DrawListType
 };
 
 
+//==========================================================================
+//
+// With more than one BSP worker nothing a worker produces may go into the
+// draw info directly. Each worker records it here instead, tagged with
+// the number of the job that produced it, and RenderBSP replays all of it
+// in job order once the workers are done. That way the draw lists come
+// out the same no matter which worker processed which job.
+//
+//==========================================================================
+
+struct HWLaneEvent
+{
+	enum
+	{
+		Wall,
+		Flat,
+		Sprite,
+		Decal,
+		Portal,
+		SubsectorPortal,
+		UpperMissingTexture,
+		LowerMissingTexture,
+	};
+
+	int job;
+	int type;
+	int arg[2];
+	float value;
+	void *ptr[2];
+};
+
+struct HWBspLane
+{
+	FMemArena Allocator { 256 * 1024 };	// freed together with RenderDataAllocator
+	TArray<HWLaneEvent> Events;
+	int CurrentJob;
+
+	template<class T> T *Alloc()
+	{
+		return (T*)Allocator.Alloc(sizeof(T));
+	}
+
+	void Add(int type, void *ptr0, void *ptr1 = nullptr, int arg0 = 0, int arg1 = 0, float value = 0)
+	{
+		Events.Push({ CurrentJob, type, { arg0, arg1 }, value, { ptr0, ptr1 } });
+	}
+};
+
+// Set while a BSP worker is processing a job.
+extern thread_local HWBspLane *bspLane;
+
 struct HWDrawInfo
 {
 	struct wallseg
@@ -148,6 +199,7 @@ struct HWDrawInfo
 	FRenderViewpoint Viewpoint;
 	HWViewpointUniforms VPUniforms;	// per-viewpoint uniform state
 	TArray<HWPortal *> Portals;
+	bool KeepPortals;	// set when the same lists get drawn for several eyes. The owner deletes the portals then.
 	TArray<HWDecal *> Decals[2];	// the second slot is for mirrors which get rendered in a separate pass.
 	TArray<HUDSprite> hudsprites;	// These may just be stored by value.
 
@@ -190,7 +242,12 @@ private:
 	subsector_t *currentsubsector;	// used by the line processing code.
 	sector_t *currentsector;
 
-	void WorkerThread();
+	void WorkerThread(int lane);
+	void ReplayLanes(int numLanes);
+
+	HWWall *NewWall(int list);
+	HWFlat *NewFlat(int list);
+	HWSprite *NewSprite(int list);
 
 	void UnclipSubsector(subsector_t *sub);
 	
@@ -297,6 +354,7 @@ public:
 	void UpdateCurrentMapSection();
 	void SetViewMatrix(const FRotator &angles, float vx, float vy, float vz, bool mirror, bool planemirror);
 	void SetupView(FRenderState &state, float vx, float vy, float vz, bool mirror, bool planemirror);
+	void SetStereoProjection(const VSMatrix &projection, const DVector3 &eyepos);
 	angle_t FrustumAngle();
 
 	void DrawDecals(FRenderState &state, TArray<HWDecal *> &decals);
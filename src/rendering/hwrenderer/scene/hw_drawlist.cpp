@@ -43,6 +43,7 @@ FMemArena RenderDataAllocator(1024*1024);	// Use large blocks to reduce allocati
 void ResetRenderDataAllocator()
 {
 	RenderDataAllocator.FreeAll();
+	ResetBspLaneAllocators();
 }
 
 //==========================================================================
@@ -753,10 +754,15 @@ void HWDrawList::SortFlats()
 HWWall *HWDrawList::NewWall()
 {
 	auto wall = (HWWall*)RenderDataAllocator.Alloc(sizeof(HWWall));
-	drawitems.Push(HWDrawItem(DrawType_WALL, walls.Push(wall)));
+	LinkWall(wall);
 	return wall;
 }
 
+void HWDrawList::LinkWall(HWWall *wall)
+{
+	drawitems.Push(HWDrawItem(DrawType_WALL, walls.Push(wall)));
+}
+
 //==========================================================================
 //
 //
@@ -765,10 +771,15 @@ HWWall *HWDrawList::NewWall()
 HWFlat *HWDrawList::NewFlat()
 {
 	auto flat = (HWFlat*)RenderDataAllocator.Alloc(sizeof(HWFlat));
-	drawitems.Push(HWDrawItem(DrawType_FLAT,flats.Push(flat)));
+	LinkFlat(flat);
 	return flat;
 }
 
+void HWDrawList::LinkFlat(HWFlat *flat)
+{
+	drawitems.Push(HWDrawItem(DrawType_FLAT,flats.Push(flat)));
+}
+
 //==========================================================================
 //
 //
@@ -777,10 +788,15 @@ HWFlat *HWDrawList::NewFlat()
 HWSprite *HWDrawList::NewSprite()
 {	
 	auto sprite = (HWSprite*)RenderDataAllocator.Alloc(sizeof(HWSprite));
-	drawitems.Push(HWDrawItem(DrawType_SPRITE, sprites.Push(sprite)));
+	LinkSprite(sprite);
 	return sprite;
 }
 
+void HWDrawList::LinkSprite(HWSprite *sprite)
+{
+	drawitems.Push(HWDrawItem(DrawType_SPRITE, sprites.Push(sprite)));
+}
+
 //==========================================================================
 //
 //
@@ -4,6 +4,7 @@
 
 extern FMemArena RenderDataAllocator;
 void ResetRenderDataAllocator();
+void ResetBspLaneAllocators();
 struct HWDrawInfo;
 class HWWall;
 class HWFlat;
@@ -90,6 +91,9 @@ public:
 	HWWall *NewWall();
 	HWFlat *NewFlat();
 	HWSprite *NewSprite();
+	void LinkWall(HWWall *wall);
+	void LinkFlat(HWFlat *flat);
+	void LinkSprite(HWSprite *sprite);
 	void Reset();
 	void SortWalls();
 	void SortFlats();
@@ -29,6 +29,37 @@
 
 EXTERN_CVAR(Bool, gl_seamless)
 
+//==========================================================================
+//
+// Allocates a draw item in the given list, or in the current BSP
+// worker's output if called from one.
+//
+//==========================================================================
+
+HWWall *HWDrawInfo::NewWall(int list)
+{
+	if (bspLane == nullptr) return drawlists[list].NewWall();
+	auto wall = bspLane->Alloc<HWWall>();
+	bspLane->Add(HWLaneEvent::Wall, wall, nullptr, list);
+	return wall;
+}
+
+HWFlat *HWDrawInfo::NewFlat(int list)
+{
+	if (bspLane == nullptr) return drawlists[list].NewFlat();
+	auto flat = bspLane->Alloc<HWFlat>();
+	bspLane->Add(HWLaneEvent::Flat, flat, nullptr, list);
+	return flat;
+}
+
+HWSprite *HWDrawInfo::NewSprite(int list)
+{
+	if (bspLane == nullptr) return drawlists[list].NewSprite();
+	auto sprite = bspLane->Alloc<HWSprite>();
+	bspLane->Add(HWLaneEvent::Sprite, sprite, nullptr, list);
+	return sprite;
+}
+
 //==========================================================================
 //
 // 
@@ -39,7 +70,7 @@ void HWDrawInfo::AddWall(HWWall *wall)
 {
 	if (wall->flags & HWWall::HWF_TRANSLUCENT)
 	{
-		auto newwall = drawlists[GLDL_TRANSLUCENT].NewWall();
+		auto newwall = NewWall(GLDL_TRANSLUCENT);
 		*newwall = *wall;
 	}
 	else
@@ -55,7 +86,7 @@ void HWDrawInfo::AddWall(HWWall *wall)
 		{
 			list = masked ? GLDL_MASKEDWALLS : GLDL_PLAINWALLS;
 		}
-		auto newwall = drawlists[list].NewWall();
+		auto newwall = NewWall(list);
 		*newwall = *wall;
 	}
 }
@@ -69,7 +100,7 @@ void HWDrawInfo::AddWall(HWWall *wall)
 void HWDrawInfo::AddMirrorSurface(HWWall *w)
 {
 	w->type = RENDERWALL_MIRRORSURFACE;
-	auto newwall = drawlists[GLDL_TRANSLUCENTBORDER].NewWall();
+	auto newwall = NewWall(GLDL_TRANSLUCENTBORDER);
 	*newwall = *w;
 
 	// Invalidate vertices to allow setting of texture coordinates
@@ -121,7 +152,7 @@ void HWDrawInfo::AddFlat(HWFlat *flat, bool fog)
 		bool masked = flat->gltexture->isMasked() && ((flat->renderflags&SSRF_RENDER3DPLANES) || flat->stack);
 		list = masked ? GLDL_MASKEDFLATS : GLDL_PLAINFLATS;
 	}
-	auto newflat = drawlists[list].NewFlat();
+	auto newflat = NewFlat(list);
 	*newflat = *flat;
 }
 
@@ -144,7 +175,7 @@ void HWDrawInfo::AddSprite(HWSprite *sprite, bool translucent)
 		list = GLDL_MODELS;
 	}
 
-	auto newsprt = drawlists[list].NewSprite();
+	auto newsprt = NewSprite(list);
 	*newsprt = *sprite;
 }
 
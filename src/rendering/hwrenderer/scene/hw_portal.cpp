@@ -97,7 +97,7 @@ void FPortalSceneState::EndFrame(HWDrawInfo *di, FRenderState &state)
 		{
 			RenderPortal(p, state, true, di);
 		}
-		delete p;
+		if (!di->KeepPortals) delete p;
 	}
 	renderdepth--;
 
@@ -155,7 +155,7 @@ bool FPortalSceneState::RenderFirstSkyPortal(int recursion, HWDrawInfo *outer_di
 	{
 		portals.Delete(bestindex);
 		RenderPortal(best, state, false, outer_di);
-		delete best;
+		if (!outer_di->KeepPortals) delete best;
 		return true;
 	}
 	return false;
@@ -192,6 +192,11 @@ void HWDrawInfo::AddOtherCeilingPlane(int sector, gl_subsectorrendernode * node)
 //==========================================================================
 void HWDrawInfo::AddUpperMissingTexture(side_t * side, subsector_t *sub, float Backheight)
 {
+	if (bspLane != nullptr)
+	{
+		bspLane->Add(HWLaneEvent::UpperMissingTexture, side, sub, 0, 0, Backheight);
+		return;
+	}
 	if (!side->segs[0]->backsector) return;
 
 	for (int i = 0; i < side->numsegs; i++)
@@ -244,6 +249,11 @@ void HWDrawInfo::AddUpperMissingTexture(side_t * side, subsector_t *sub, float B
 //==========================================================================
 void HWDrawInfo::AddLowerMissingTexture(side_t * side, subsector_t *sub, float Backheight)
 {
+	if (bspLane != nullptr)
+	{
+		bspLane->Add(HWLaneEvent::LowerMissingTexture, side, sub, 0, 0, Backheight);
+		return;
+	}
 	sector_t *backsec = side->segs[0]->backsector;
 	if (!backsec) return;
 	if (backsec->transdoor)
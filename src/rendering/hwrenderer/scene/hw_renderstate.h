@@ -214,6 +214,7 @@ protected:
 	uint8_t mSplitEnabled : 1;
 
 	int mLightIndex;
+	int mBoneIndexBase;
 	int mSpecialEffect;
 	int mTextureMode;
 	int mSoftLight;
@@ -267,6 +268,7 @@ public:
 		mLightParms[3] = -1.f;
 		mSpecialEffect = EFF_NONE;
 		mLightIndex = -1;
+		mBoneIndexBase = -1;
 		mStreamData.uInterpolationFactor = 0;
 		mRenderStyle = DefaultRenderStyle();
 		mMaterial.Reset();
@@ -525,6 +527,11 @@ public:
 		mLightIndex = index;
 	}
 
+	void SetBoneIndexBase(int index)
+	{
+		mBoneIndexBase = index;
+	}
+
 	void SetRenderStyle(FRenderStyle rs)
 	{
 		mRenderStyle = rs;
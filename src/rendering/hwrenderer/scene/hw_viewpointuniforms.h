@@ -10,6 +10,7 @@ struct HWViewpointUniforms
 	VSMatrix mProjectionMatrix;
 	VSMatrix mViewMatrix;
 	VSMatrix mNormalViewMatrix;
+	VSMatrix mStereoProjectionMatrix;	// second eye for instanced stereo, takes the first eye's view coordinates
 	FVector4 mCameraPos;
 	FVector4 mClipLine;
 
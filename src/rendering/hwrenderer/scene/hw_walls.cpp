@@ -497,6 +497,29 @@ void HWWall::PutPortal(HWDrawInfo *di, int ptype, int plane)
 	auto pstate = screen->mPortalState;
 	HWPortal * portal = nullptr;
 
+	if (bspLane != nullptr)
+	{
+		// The portal list is shared by all BSP workers so this has to wait
+		// until RenderBSP replays it. Sky and horizon info live on the
+		// caller's stack and must be copied along, padding included, since
+		// the unique lists compare them with memcmp.
+		auto wall = bspLane->Alloc<HWWall>();
+		*wall = *this;
+		if (ptype == PORTALTYPE_HORIZON)
+		{
+			wall->horizon = bspLane->Alloc<HWHorizonInfo>();
+			memcpy(wall->horizon, horizon, sizeof(HWHorizonInfo));
+		}
+		else if (ptype == PORTALTYPE_SKY)
+		{
+			wall->sky = bspLane->Alloc<HWSkyInfo>();
+			memcpy(wall->sky, sky, sizeof(HWSkyInfo));
+		}
+		bspLane->Add(HWLaneEvent::Portal, wall, nullptr, ptype, plane);
+		vertcount = 0;
+		return;
+	}
+
 	MakeVertices(di, false);
 	switch (ptype)
 	{
@@ -20,6 +20,7 @@
 //--------------------------------------------------------------------------
 //
 
+#include <mutex>
 #include "w_wad.h"
 #include "m_png.h"
 #include "sbar.h"
@@ -466,6 +467,14 @@ again:
 		FMaterial *hwtex = tex->Material[expand];
 		if (hwtex == NULL && create)
 		{
+			// The hardware renderer's BSP workers may get here at the same time.
+			static std::mutex mutex;
+			std::lock_guard<std::mutex> lock(mutex);
+			hwtex = tex->Material[expand];
+			if (hwtex != NULL)
+			{
+				return hwtex;
+			}
 			if (expand)
 			{
 				if (tex->isWarped() || tex->isHardwareCanvas() || tex->shaderindex >= FIRST_USER_SHADER || (tex->shaderindex >= SHADER_Specular && tex->shaderindex <= SHADER_PBRBrightmap))
@@ -34,6 +34,7 @@
 #include "textures/skyboxtexture.h"
 #include "hwrenderer/textures/hw_material.h"
 #include "image.h"
+#include "texturecache.h"
 #include "v_video.h"
 #include "v_font.h"
 
@@ -238,7 +239,7 @@ void hw_PrecacheTexture(uint8_t *texhitlist, TMap<PClassActor*, bool> &actorhitl
 				{
 					if (tex->GetImage() && tex->SystemTextures.GetHardwareTexture(0, false) == nullptr)
 					{
-						FImageSource::RegisterForPrecache(tex->GetImage());
+						FImageSource::RegisterForPrecache(tex->GetImage(), tex);
 					}
 				}
 
@@ -250,6 +251,9 @@ void hw_PrecacheTexture(uint8_t *texhitlist, TMap<PClassActor*, bool> &actorhitl
 			}
 		}
 
+		// start decoding what can be done on the job system while the main thread uploads.
+		FImageSource::StartPrefetch();
+
 		// cache all used textures
 		for (int i = cnt - 1; i >= 0; i--)
 		{
@@ -266,14 +270,17 @@ void hw_PrecacheTexture(uint8_t *texhitlist, TMap<PClassActor*, bool> &actorhitl
 
 
 		FImageSource::EndPrecaching();
+		FTextureDiskCache::Flush();
 
 		// cache all used models
 		FModelRenderer *renderer = screen->CreateModelRenderer(-1);
+		TArray<FModel *> usedmodels;
 		for (unsigned i = 0; i < Models.Size(); i++)
 		{
 			if (modellist[i]) 
-				Models[i]->BuildVertexBuffer(renderer);
+				usedmodels.Push(Models[i]);
 		}
+		PrecacheModels(renderer, usedmodels);
 		delete renderer;
 
 		precache.Unclock();
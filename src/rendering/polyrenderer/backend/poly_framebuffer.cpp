@@ -43,6 +43,7 @@
 #include "hwrenderer/data/flatvertices.h"
 #include "hwrenderer/data/shaderuniforms.h"
 #include "hwrenderer/dynlights/hw_lightbuffer.h"
+#include "hwrenderer/models/hw_bonebuffer.h"
 #include "hwrenderer/postprocessing/hw_postprocess.h"
 
 #include "swrenderer/r_swscene.h"
@@ -92,6 +93,7 @@ PolyFrameBuffer::~PolyFrameBuffer()
 	delete mSkyData;
 	delete mViewpoints;
 	delete mLights;
+	delete mBones;
 	mShadowMap.Reset();
 
 	screen = tmp;
@@ -113,6 +115,7 @@ void PolyFrameBuffer::InitializeState()
 	mSkyData = new FSkyVertexBuffer;
 	mViewpoints = new HWViewpointBuffer;
 	mLights = new FLightBuffer();
+	mBones = new FBoneBuffer();
 
 	static const FVertexBufferAttribute format[] =
 	{
@@ -193,6 +196,8 @@ void PolyFrameBuffer::Update()
 		if (dst)
 		{
 #if 1
+			// The drawers own screen tiles while the copy is split by rows. All of them must be done first.
+			DrawerThreads::WaitForWorkers();
 			auto copyqueue = std::make_shared<DrawerCommandQueue>(&mFrameMemory);
 			copyqueue->Push<MemcpyCommand>(dst, pitch / pixelsize, src, w, h, w, pixelsize);
 			DrawerThreads::Execute(copyqueue);
@@ -260,6 +265,7 @@ sector_t *PolyFrameBuffer::RenderView(player_t *player)
 		else r_viewpoint.TicFrac = I_GetTimeFrac();
 
 		mLights->Clear();
+		mBones->Clear();
 		mViewpoints->Clear();
 
 		// NoInterpolateView should have no bearing on camera textures, but needs to be preserved for the main view below.
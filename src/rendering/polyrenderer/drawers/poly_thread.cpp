@@ -38,6 +38,7 @@
 #include "swrenderer/drawers/r_draw_rgba.h"
 #include "screen_triangle.h"
 #include "x86.h"
+#include <thread>
 
 PolyTriangleThreadData::PolyTriangleThreadData(int32_t core, int32_t num_cores, int32_t numa_node, int32_t num_numa_nodes, int numa_start_y, int numa_end_y)
 	: core(core), num_cores(num_cores), numa_node(numa_node), num_numa_nodes(num_numa_nodes), numa_start_y(numa_start_y), numa_end_y(numa_end_y)
@@ -50,15 +51,14 @@ void PolyTriangleThreadData::ClearDepth(float value)
 	int height = depthstencil->Height();
 	float *data = depthstencil->DepthValues();
 
-	int skip = skipped_by_thread(0);
-	int count = count_for_thread(0, height);
-
-	data += skip * width;
-	for (int i = 0; i < count; i++)
+	for (int y = 0; y < height; y++)
 	{
-		for (int x = 0; x < width; x++)
-			data[x] = value;
-		data += num_cores * width;
+		float *line = data + y * width;
+		for_each_owned_span(y, 0, width, [=](int x0, int x1)
+		{
+			for (int x = x0; x < x1; x++)
+				line[x] = value;
+		});
 	}
 }
 
@@ -68,19 +68,21 @@ void PolyTriangleThreadData::ClearStencil(uint8_t value)
 	int height = depthstencil->Height();
 	uint8_t *data = depthstencil->StencilValues();
 
-	int skip = skipped_by_thread(0);
-	int count = count_for_thread(0, height);
-
-	data += skip * width;
-	for (int i = 0; i < count; i++)
+	for (int y = 0; y < height; y++)
 	{
-		memset(data, value, width);
-		data += num_cores * width;
+		uint8_t *line = data + y * width;
+		for_each_owned_span(y, 0, width, [=](int x0, int x1)
+		{
+			memset(line + x0, value, x1 - x0);
+		});
 	}
 }
 
-void PolyTriangleThreadData::SetViewport(int x, int y, int width, int height, uint8_t *new_dest, int new_dest_width, int new_dest_height, int new_dest_pitch, bool new_dest_bgra, PolyDepthStencil *new_depthstencil, bool new_topdown)
+void PolyTriangleThreadData::SetViewport(int x, int y, int width, int height, uint8_t *new_dest, int new_dest_width, int new_dest_height, int new_dest_pitch, bool new_dest_bgra, PolyDepthStencil *new_depthstencil, bool new_topdown, bool tiled)
 {
+	tile_width = tiled ? (int)TileSize : MAXWIDTH;
+	tile_height = tiled ? (int)TileSize : 1;
+
 	viewport_x = x;
 	viewport_y = y;
 	viewport_width = width;
@@ -264,57 +266,53 @@ void PolyTriangleThreadData::SetTexture(int unit, const void *pixels, int width,
 	textures[unit].bgra = bgra;
 }
 
-void PolyTriangleThreadData::DrawIndexed(int index, int vcount, PolyDrawMode drawmode)
+void PolyTriangleThreadData::DrawIndexed(int index, int vcount, PolyDrawMode drawmode, PolyDrawSetup *setup)
 {
 	if (vcount < 3)
 		return;
 
-	elements += index;
+	const unsigned int *indices = elements + index;
 
-	ShadedTriVertex vertbuffer[3];
-	ShadedTriVertex *vert[3] = { &vertbuffer[0], &vertbuffer[1], &vertbuffer[2] };
-	if (drawmode == PolyDrawMode::Triangles)
+	ShadedTriVertex vertbuffer[2];
+	ShadedTriVertex *vert[2] = { &vertbuffer[0], &vertbuffer[1] };
+	if (drawmode == PolyDrawMode::Lines)
 	{
-		for (int i = 0; i < vcount / 3; i++)
+		for (int i = 0; i < vcount / 2; i++)
 		{
-			for (int j = 0; j < 3; j++)
-				*vert[j] = ShadeVertex(*(elements++));
-			DrawShadedTriangle(vert, ccw);
+			*vert[0] = ShadeVertex(*(indices++));
+			*vert[1] = ShadeVertex(*(indices++));
+			DrawShadedLine(vert);
 		}
 	}
-	else if (drawmode == PolyDrawMode::TriangleFan)
+	else if (drawmode == PolyDrawMode::Points)
 	{
-		*vert[0] = ShadeVertex(*(elements++));
-		*vert[1] = ShadeVertex(*(elements++));
-		for (int i = 2; i < vcount; i++)
+		for (int i = 0; i < vcount; i++)
 		{
-			*vert[2] = ShadeVertex(*(elements++));
-			DrawShadedTriangle(vert, ccw);
-			std::swap(vert[1], vert[2]);
+			*vert[0] = ShadeVertex(*(indices++));
+			DrawShadedPoint(vert);
 		}
 	}
-	else if (drawmode == PolyDrawMode::TriangleStrip)
+	else
 	{
-		bool toggleccw = ccw;
-		*vert[0] = ShadeVertex(*(elements++));
-		*vert[1] = ShadeVertex(*(elements++));
-		for (int i = 2; i < vcount; i++)
-		{
-			*vert[2] = ShadeVertex(*(elements++));
-			DrawShadedTriangle(vert, toggleccw);
-			ShadedTriVertex *vtmp = vert[0];
-			vert[0] = vert[1];
-			vert[1] = vert[2];
-			vert[2] = vtmp;
-			toggleccw = !toggleccw;
-		}
+		DrawTriangles(setup, drawmode, indices, 0);
 	}
-	else if (drawmode == PolyDrawMode::Lines)
+}
+
+void PolyTriangleThreadData::Draw(int index, int vcount, PolyDrawMode drawmode, PolyDrawSetup *setup)
+{
+	if (vcount < 3)
+		return;
+
+	int vinput = index;
+
+	ShadedTriVertex vertbuffer[2];
+	ShadedTriVertex *vert[2] = { &vertbuffer[0], &vertbuffer[1] };
+	if (drawmode == PolyDrawMode::Lines)
 	{
 		for (int i = 0; i < vcount / 2; i++)
 		{
-			*vert[0] = ShadeVertex(*(elements++));
-			*vert[1] = ShadeVertex(*(elements++));
+			*vert[0] = ShadeVertex(vinput++);
+			*vert[1] = ShadeVertex(vinput++);
 			DrawShadedLine(vert);
 		}
 	}
@@ -322,50 +320,137 @@ void PolyTriangleThreadData::DrawIndexed(int index, int vcount, PolyDrawMode dra
 	{
 		for (int i = 0; i < vcount; i++)
 		{
-			*vert[0] = ShadeVertex(*(elements++));
+			*vert[0] = ShadeVertex(vinput++);
 			DrawShadedPoint(vert);
 		}
 	}
+	else
+	{
+		DrawTriangles(setup, drawmode, nullptr, index);
+	}
 }
 
-void PolyTriangleThreadData::Draw(int index, int vcount, PolyDrawMode drawmode)
+void PolyTriangleThreadData::DrawTriangles(PolyDrawSetup *setup, PolyDrawMode drawmode, const unsigned int *indices, int first)
 {
-	if (vcount < 3)
+	int numTriangles = setup->NumTriangles;
+
+	if (num_cores == 1)
+	{
+		// Nothing to share with other threads
+		for (int start = 0; start < numTriangles; start += PolyDrawSetup::BatchSize)
+		{
+			localTriangles.clear();
+			SetupTriangles(drawmode, indices, first, start, MIN(start + (int)PolyDrawSetup::BatchSize, numTriangles), localTriangles);
+			RasterTriangles(localTriangles);
+		}
 		return;
+	}
 
-	int vinput = index;
+	std::call_once(setup->Allocated, [=]() { setup->Batches.reset(new PolyDrawSetup::Batch[setup->NumBatches]); });
+
+	// The batches are claimed in order. While a batch is still being set up by another
+	// thread, this thread helps out with the ones following it instead of waiting.
+	for (int i = 0; i < setup->NumBatches; i++)
+	{
+		PolyDrawSetup::Batch &batch = setup->Batches[i];
+		while (!batch.Ready.load(std::memory_order_acquire))
+		{
+			int next = setup->NextBatch.fetch_add(1);
+			if (next < setup->NumBatches)
+			{
+				PolyDrawSetup::Batch &nextbatch = setup->Batches[next];
+				int start = next * PolyDrawSetup::BatchSize;
+				AllocTriangles(nextbatch.Triangles);
+				SetupTriangles(drawmode, indices, first, start, MIN(start + (int)PolyDrawSetup::BatchSize, numTriangles), nextbatch.Triangles);
+				nextbatch.Ready.store(true, std::memory_order_release);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+		RasterTriangles(batch.Triangles);
+
+		if (batch.Rasterized.fetch_add(1, std::memory_order_acq_rel) + 1 == num_cores)
+			FreeTriangles(batch.Triangles);
+	}
+
+	// No other thread touches the batches once all of them are done with the command
+	if (setup->Finished.fetch_add(1, std::memory_order_acq_rel) + 1 == num_cores)
+		setup->Batches.reset();
+}
+
+// Triangle lists of released batches. They are shared by all threads because the
+// thread that releases a batch usually is not the one setting up the next ones.
+static std::mutex SpareTriangleListsMutex;
+static std::vector<std::vector<PolySetupTriangle>> SpareTriangleLists;
+enum { MaxSpareTriangleLists = 64 };
+
+void PolyTriangleThreadData::AllocTriangles(std::vector<PolySetupTriangle> &triangles)
+{
+	std::unique_lock<std::mutex> lock(SpareTriangleListsMutex);
+	if (!SpareTriangleLists.empty())
+	{
+		triangles.swap(SpareTriangleLists.back());
+		SpareTriangleLists.pop_back();
+	}
+	else
+	{
+		lock.unlock();
+		triangles.reserve(PolyDrawSetup::BatchSize);
+	}
+}
+
+void PolyTriangleThreadData::FreeTriangles(std::vector<PolySetupTriangle> &triangles)
+{
+	triangles.clear();
+	std::unique_lock<std::mutex> lock(SpareTriangleListsMutex);
+	if (SpareTriangleLists.size() < MaxSpareTriangleLists)
+	{
+		SpareTriangleLists.push_back(std::move(triangles));
+	}
+	else
+	{
+		lock.unlock();
+		std::vector<PolySetupTriangle>().swap(triangles);
+	}
+}
+
+void PolyTriangleThreadData::SetupTriangles(PolyDrawMode drawmode, const unsigned int *indices, int first, int start, int end, std::vector<PolySetupTriangle> &output)
+{
+	auto vertexIndex = [=](int i) { return indices ? (int)indices[i] : first + i; };
 
 	ShadedTriVertex vertbuffer[3];
 	ShadedTriVertex *vert[3] = { &vertbuffer[0], &vertbuffer[1], &vertbuffer[2] };
 	if (drawmode == PolyDrawMode::Triangles)
 	{
-		for (int i = 0; i < vcount / 3; i++)
+		for (int i = start; i < end; i++)
 		{
 			for (int j = 0; j < 3; j++)
-				*vert[j] = ShadeVertex(vinput++);
-			DrawShadedTriangle(vert, ccw);
+				*vert[j] = ShadeVertex(vertexIndex(i * 3 + j));
+			SetupShadedTriangle(vert, ccw, output);
 		}
 	}
 	else if (drawmode == PolyDrawMode::TriangleFan)
 	{
-		*vert[0] = ShadeVertex(vinput++);
-		*vert[1] = ShadeVertex(vinput++);
-		for (int i = 2; i < vcount; i++)
+		*vert[0] = ShadeVertex(vertexIndex(0));
+		*vert[1] = ShadeVertex(vertexIndex(start + 1));
+		for (int i = start; i < end; i++)
 		{
-			*vert[2] = ShadeVertex(vinput++);
-			DrawShadedTriangle(vert, ccw);
+			*vert[2] = ShadeVertex(vertexIndex(i + 2));
+			SetupShadedTriangle(vert, ccw, output);
 			std::swap(vert[1], vert[2]);
 		}
 	}
 	else if (drawmode == PolyDrawMode::TriangleStrip)
 	{
-		bool toggleccw = ccw;
-		*vert[0] = ShadeVertex(vinput++);
-		*vert[1] = ShadeVertex(vinput++);
-		for (int i = 2; i < vcount; i++)
+		bool toggleccw = (start & 1) ? !ccw : ccw;
+		*vert[0] = ShadeVertex(vertexIndex(start));
+		*vert[1] = ShadeVertex(vertexIndex(start + 1));
+		for (int i = start; i < end; i++)
 		{
-			*vert[2] = ShadeVertex(vinput++);
-			DrawShadedTriangle(vert, toggleccw);
+			*vert[2] = ShadeVertex(vertexIndex(i + 2));
+			SetupShadedTriangle(vert, toggleccw, output);
 			ShadedTriVertex *vtmp = vert[0];
 			vert[0] = vert[1];
 			vert[1] = vert[2];
@@ -373,22 +458,22 @@ void PolyTriangleThreadData::Draw(int index, int vcount, PolyDrawMode drawmode)
 			toggleccw = !toggleccw;
 		}
 	}
-	else if (drawmode == PolyDrawMode::Lines)
-	{
-		for (int i = 0; i < vcount / 2; i++)
-		{
-			*vert[0] = ShadeVertex(vinput++);
-			*vert[1] = ShadeVertex(vinput++);
-			DrawShadedLine(vert);
-		}
-	}
-	else if (drawmode == PolyDrawMode::Points)
+}
+
+void PolyTriangleThreadData::RasterTriangles(std::vector<PolySetupTriangle> &triangles)
+{
+	TriDrawTriangleArgs args;
+	for (PolySetupTriangle &tri : triangles)
 	{
-		for (int i = 0; i < vcount; i++)
-		{
-			*vert[0] = ShadeVertex(vinput++);
-			DrawShadedPoint(vert);
-		}
+		if (!rect_owned_by_thread(tri.left, tri.top, tri.right, tri.bottom))
+			continue;
+
+		args.v1 = &tri.v[0];
+		args.v2 = &tri.v[1];
+		args.v3 = &tri.v[2];
+		args.gradientX = tri.gradientX;
+		args.gradientY = tri.gradientY;
+		ScreenTriangle::Draw(&args, this);
 	}
 }
 
@@ -517,7 +602,7 @@ void PolyTriangleThreadData::DrawShadedLine(const ShadedTriVertex *const* vert)
 	{
 		int scrx = (int)x;
 		int scry = (int)y;
-		if (scrx >= clip.left && scrx < clip.right && scry >= clip.top && scry < clip.bottom && !line_skipped_by_thread(scry))
+		if (scrx >= clip.left && scrx < clip.right && scry >= clip.top && scry < clip.bottom && pixel_owned_by_thread(scrx, scry))
 		{
 			uint8_t *destpixel = dest + (scrx + scry * dest_width) * pixelsize;
 			if (pixelsize == 4)
@@ -534,7 +619,7 @@ void PolyTriangleThreadData::DrawShadedLine(const ShadedTriVertex *const* vert)
 	}
 }
 
-void PolyTriangleThreadData::DrawShadedTriangle(const ShadedTriVertex *const* vert, bool ccw)
+void PolyTriangleThreadData::SetupShadedTriangle(const ShadedTriVertex *const* vert, bool ccw, std::vector<PolySetupTriangle> &output)
 {
 	// Reject triangle if degenerate
 	if (IsDegenerate(vert))
@@ -637,7 +722,7 @@ void PolyTriangleThreadData::DrawShadedTriangle(const ShadedTriVertex *const* ve
 		ccw = !IsFrontfacing(&args);
 	}
 
-	// Draw screen triangles
+	// Output screen triangles
 	if (ccw)
 	{
 		for (int i = numclipvert - 1; i > 1; i--)
@@ -647,7 +732,7 @@ void PolyTriangleThreadData::DrawShadedTriangle(const ShadedTriVertex *const* ve
 			args.v3 = &clippedvert[i - 2];
 			if (IsFrontfacing(&args) == ccw && args.CalculateGradients())
 			{
-				ScreenTriangle::Draw(&args, this);
+				AddSetupTriangle(&args, output);
 			}
 		}
 	}
@@ -660,12 +745,40 @@ void PolyTriangleThreadData::DrawShadedTriangle(const ShadedTriVertex *const* ve
 			args.v3 = &clippedvert[i];
 			if (IsFrontfacing(&args) != ccw && args.CalculateGradients())
 			{
-				ScreenTriangle::Draw(&args, this);
+				AddSetupTriangle(&args, output);
 			}
 		}
 	}
 }
 
+void PolyTriangleThreadData::AddSetupTriangle(const TriDrawTriangleArgs *args, std::vector<PolySetupTriangle> &output)
+{
+	float minX = MIN(MIN(args->v1->x, args->v2->x), args->v3->x);
+	float maxX = MAX(MAX(args->v1->x, args->v2->x), args->v3->x);
+	float minY = MIN(MIN(args->v1->y, args->v2->y), args->v3->y);
+	float maxY = MAX(MAX(args->v1->y, args->v2->y), args->v3->y);
+
+	// The rasterizer rounds to the nearest pixel centers, so this is slightly conservative.
+	int left = MAX((int)minX, clip.left);
+	int right = MIN((int)maxX + 2, clip.right);
+	int top = MAX((int)minY, clip.top);
+	int bottom = MIN((int)maxY + 2, clip.bottom);
+	if (left >= right || top >= bottom)
+		return;
+
+	output.emplace_back();
+	PolySetupTriangle &tri = output.back();
+	tri.v[0] = *args->v1;
+	tri.v[1] = *args->v2;
+	tri.v[2] = *args->v3;
+	tri.gradientX = args->gradientX;
+	tri.gradientY = args->gradientY;
+	tri.left = left;
+	tri.top = top;
+	tri.right = right;
+	tri.bottom = bottom;
+}
+
 int PolyTriangleThreadData::ClipEdge(const ShadedTriVertex *const* verts)
 {
 	// use barycentric weights for clipped vertices
@@ -814,6 +927,15 @@ int PolyTriangleThreadData::ClipEdge(const ShadedTriVertex *const* verts)
 	return inputverts;
 }
 
+PolyDrawSetup::PolyDrawSetup(int vcount, PolyDrawMode mode)
+{
+	if (mode == PolyDrawMode::Triangles)
+		NumTriangles = vcount / 3;
+	else if (mode == PolyDrawMode::TriangleFan || mode == PolyDrawMode::TriangleStrip)
+		NumTriangles = MAX(vcount - 2, 0);
+	NumBatches = (NumTriangles + BatchSize - 1) / BatchSize;
+}
+
 PolyTriangleThreadData *PolyTriangleThreadData::Get(DrawerThread *thread)
 {
 	if (!thread->poly)
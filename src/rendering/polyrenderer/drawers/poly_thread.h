@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>
 #include "poly_triangle.h"
 
 struct PolyLight
@@ -31,6 +33,44 @@ struct PolyLight
 	float radius;
 };
 
+// A triangle after clipping, culling and gradient setup, ready to be rasterized
+struct PolySetupTriangle
+{
+	ScreenTriVertex v[3];
+	ScreenTriangleStepVariables gradientX;
+	ScreenTriangleStepVariables gradientY;
+	int left, top, right, bottom;	// conservative bounding box in pixels
+};
+
+// Triangle setup results of a draw command, shared by all threads executing it.
+// The threads claim batches of triangles in order and set them up, then every
+// thread rasterizes all batches but only draws into the tiles it owns. That way
+// each triangle is set up once no matter how many threads there are.
+// The last thread to rasterize a batch gives its triangles back, and the last
+// thread to finish the command frees the batches, so only the batches still in
+// flight hold any memory.
+class PolyDrawSetup
+{
+public:
+	PolyDrawSetup(int vcount, PolyDrawMode mode);
+
+	enum { BatchSize = 64 };
+
+	struct Batch
+	{
+		std::atomic<bool> Ready { false };
+		std::atomic<int> Rasterized { 0 };
+		std::vector<PolySetupTriangle> Triangles;
+	};
+
+	int NumTriangles = 0;
+	int NumBatches = 0;
+	std::atomic<int> NextBatch { 0 };
+	std::atomic<int> Finished { 0 };
+	std::once_flag Allocated;
+	std::unique_ptr<Batch[]> Batches;
+};
+
 class PolyTriangleThreadData
 {
 public:
@@ -38,7 +78,7 @@ public:
 
 	void ClearDepth(float value);
 	void ClearStencil(uint8_t value);
-	void SetViewport(int x, int y, int width, int height, uint8_t *dest, int dest_width, int dest_height, int dest_pitch, bool dest_bgra, PolyDepthStencil *depthstencil, bool topdown);
+	void SetViewport(int x, int y, int width, int height, uint8_t *dest, int dest_width, int dest_height, int dest_pitch, bool dest_bgra, PolyDepthStencil *depthstencil, bool topdown, bool tiled);
 
 	void SetCullCCW(bool value) { ccw = value; }
 	void SetTwoSided(bool value) { twosided = value; }
@@ -67,8 +107,8 @@ public:
 	void PushStreamData(const StreamData &data, const PolyPushConstants &constants);
 	void PushMatrices(const VSMatrix &modelMatrix, const VSMatrix &normalModelMatrix, const VSMatrix &textureMatrix);
 
-	void DrawIndexed(int index, int count, PolyDrawMode mode);
-	void Draw(int index, int vcount, PolyDrawMode mode);
+	void DrawIndexed(int index, int count, PolyDrawMode mode, PolyDrawSetup *setup);
+	void Draw(int index, int vcount, PolyDrawMode mode, PolyDrawSetup *setup);
 
 	int32_t core;
 	int32_t num_cores;
@@ -78,23 +118,55 @@ public:
 	int numa_start_y;
 	int numa_end_y;
 
-	bool line_skipped_by_thread(int line)
+	// The screen is split into tiles that are handed out diagonally to the threads.
+	// The poly backend uses square tiles. Everywhere else a tile is a full line,
+	// so that the threads own the same pixels as the software renderer's drawers
+	// they share their command queues with (see DrawerThread).
+	enum { TileSize = 64 };
+	int tile_width = MAXWIDTH;
+	int tile_height = 1;
+
+	bool pixel_owned_by_thread(int x, int y) const
 	{
-		return line < numa_start_y || line >= numa_end_y || line % num_cores != core;
+		return y >= numa_start_y && y < numa_end_y && (x / tile_width + y / tile_height) % num_cores == core;
 	}
 
-	int skipped_by_thread(int first_line)
+	// Checks if any tile in the (exclusive) pixel rectangle belongs to this thread
+	bool rect_owned_by_thread(int x0, int y0, int x1, int y1) const
 	{
-		int clip_first_line = MAX(first_line, numa_start_y);
-		int core_skip = (num_cores - (clip_first_line - core) % num_cores) % num_cores;
-		return clip_first_line + core_skip - first_line;
+		y0 = MAX(y0, numa_start_y);
+		y1 = MIN(y1, numa_end_y);
+		if (x0 >= x1 || y0 >= y1)
+			return false;
+
+		// The tiles of a rectangle cover a continuous range of diagonals
+		int first = x0 / tile_width + y0 / tile_height;
+		int last = (x1 - 1) / tile_width + (y1 - 1) / tile_height;
+		if (last - first + 1 >= num_cores)
+			return true;
+		return first + (core - first % num_cores + num_cores) % num_cores <= last;
 	}
 
-	int count_for_thread(int first_line, int count)
+	// Calls callback(x0, x1) for each part of the span that is in a tile owned by this thread
+	template<typename Callback>
+	void for_each_owned_span(int y, int x0, int x1, Callback &&callback) const
 	{
-		count = MIN(count, numa_end_y - first_line);
-		int c = (count - skipped_by_thread(first_line) + num_cores - 1) / num_cores;
-		return MAX(c, 0);
+		if (x0 >= x1 || y < numa_start_y || y >= numa_end_y)
+			return;
+
+		if (num_cores == 1)
+		{
+			callback(x0, x1);
+			return;
+		}
+
+		int ty = y / tile_height;
+		int tx = x0 / tile_width;
+		tx += (core - (tx + ty) % num_cores + num_cores) % num_cores;
+		for (int x = tx * tile_width; x < x1; x += num_cores * tile_width)
+		{
+			callback(MAX(x, x0), MIN(x + tile_width, x1));
+		}
 	}
 
 	struct Scanline
@@ -178,7 +250,13 @@ private:
 	ShadedTriVertex ShadeVertex(int index);
 	void DrawShadedPoint(const ShadedTriVertex *const* vertex);
 	void DrawShadedLine(const ShadedTriVertex *const* vertices);
-	void DrawShadedTriangle(const ShadedTriVertex *const* vertices, bool ccw);
+	void DrawTriangles(PolyDrawSetup *setup, PolyDrawMode drawmode, const unsigned int *indices, int first);
+	void SetupTriangles(PolyDrawMode drawmode, const unsigned int *indices, int first, int start, int end, std::vector<PolySetupTriangle> &output);
+	void SetupShadedTriangle(const ShadedTriVertex *const* vertices, bool ccw, std::vector<PolySetupTriangle> &output);
+	void AddSetupTriangle(const TriDrawTriangleArgs *args, std::vector<PolySetupTriangle> &output);
+	void RasterTriangles(std::vector<PolySetupTriangle> &triangles);
+	static void AllocTriangles(std::vector<PolySetupTriangle> &triangles);
+	static void FreeTriangles(std::vector<PolySetupTriangle> &triangles);
 	static bool IsDegenerate(const ShadedTriVertex *const* vertices);
 	static bool IsFrontfacing(TriDrawTriangleArgs *args);
 
@@ -194,4 +272,6 @@ private:
 	enum { max_additional_vertices = 16 };
 	float weightsbuffer[max_additional_vertices * 3 * 2];
 	float *weights = nullptr;
+
+	std::vector<PolySetupTriangle> localTriangles;
 };
@@ -256,9 +256,9 @@ private:
 class PolySetViewportCommand : public PolyDrawerCommand
 {
 public:
-	PolySetViewportCommand(int x, int y, int width, int height, uint8_t* dest, int dest_width, int dest_height, int dest_pitch, bool dest_bgra, PolyDepthStencil* depthstencil, bool topdown)
-		: x(x), y(y), width(width), height(height), dest(dest), dest_width(dest_width), dest_height(dest_height), dest_pitch(dest_pitch), dest_bgra(dest_bgra), depthstencil(depthstencil), topdown(topdown) { }
-	void Execute(DrawerThread* thread) override { PolyTriangleThreadData::Get(thread)->SetViewport(x, y, width, height, dest, dest_width, dest_height, dest_pitch, dest_bgra, depthstencil, topdown); }
+	PolySetViewportCommand(int x, int y, int width, int height, uint8_t* dest, int dest_width, int dest_height, int dest_pitch, bool dest_bgra, PolyDepthStencil* depthstencil, bool topdown, bool tiled)
+		: x(x), y(y), width(width), height(height), dest(dest), dest_width(dest_width), dest_height(dest_height), dest_pitch(dest_pitch), dest_bgra(dest_bgra), depthstencil(depthstencil), topdown(topdown), tiled(tiled) { }
+	void Execute(DrawerThread* thread) override { PolyTriangleThreadData::Get(thread)->SetViewport(x, y, width, height, dest, dest_width, dest_height, dest_pitch, dest_bgra, depthstencil, topdown, tiled); }
 
 private:
 	int x;
@@ -272,6 +272,7 @@ private:
 	bool dest_bgra;
 	PolyDepthStencil* depthstencil;
 	bool topdown;
+	bool tiled;
 };
 
 class PolySetViewpointUniformsCommand : public PolyDrawerCommand
@@ -311,25 +312,27 @@ private:
 class PolyDrawCommand : public PolyDrawerCommand
 {
 public:
-	PolyDrawCommand(int index, int count, PolyDrawMode mode) : index(index), count(count), mode(mode) { }
-	void Execute(DrawerThread* thread) override { PolyTriangleThreadData::Get(thread)->Draw(index, count, mode); }
+	PolyDrawCommand(int index, int count, PolyDrawMode mode) : index(index), count(count), mode(mode), setup(count, mode) { }
+	void Execute(DrawerThread* thread) override { PolyTriangleThreadData::Get(thread)->Draw(index, count, mode, &setup); }
 
 private:
 	int index;
 	int count;
 	PolyDrawMode mode;
+	PolyDrawSetup setup;
 };
 
 class PolyDrawIndexedCommand : public PolyDrawerCommand
 {
 public:
-	PolyDrawIndexedCommand(int index, int count, PolyDrawMode mode) : index(index), count(count), mode(mode) { }
-	void Execute(DrawerThread* thread) override { PolyTriangleThreadData::Get(thread)->DrawIndexed(index, count, mode); }
+	PolyDrawIndexedCommand(int index, int count, PolyDrawMode mode) : index(index), count(count), mode(mode), setup(count, mode) { }
+	void Execute(DrawerThread* thread) override { PolyTriangleThreadData::Get(thread)->DrawIndexed(index, count, mode, &setup); }
 
 private:
 	int index;
 	int count;
 	PolyDrawMode mode;
+	PolyDrawSetup setup;
 };
 
 /////////////////////////////////////////////////////////////////////////////
@@ -347,7 +350,8 @@ void PolyCommandBuffer::SetViewport(int x, int y, int width, int height, DCanvas
 	int dest_pitch = canvas->GetPitch();
 	bool dest_bgra = canvas->IsBgra();
 
-	mQueue->Push<PolySetViewportCommand>(x, y, width, height, dest, dest_width, dest_height, dest_pitch, dest_bgra, depthstencil, topdown);
+	// Only the poly backend's own commands go into this queue, so it can use tiles
+	mQueue->Push<PolySetViewportCommand>(x, y, width, height, dest, dest_width, dest_height, dest_pitch, dest_bgra, depthstencil, topdown, true);
 }
 
 void PolyCommandBuffer::SetInputAssembly(PolyInputAssembly *input)
@@ -233,8 +233,13 @@ void ScreenTriangle::Draw(const TriDrawTriangleArgs* args, PolyTriangleThreadDat
 	if (thread->StencilTest) opt |= SWTRI_StencilTest;
 	testfunc = ScreenTriangle::TestSpanOpts[opt];
 
-	topY += thread->skipped_by_thread(topY);
-	int num_cores = thread->num_cores;
+	// Only the rows in the thread's part of the screen. The tiles are filtered per span.
+	topY = MAX(topY, thread->numa_start_y);
+	midY = MIN(midY, thread->numa_end_y);
+	bottomY = MIN(bottomY, thread->numa_end_y);
+
+	if (topY >= bottomY)
+		return;
 
 	// Find start/end X positions for each line covered by the triangle:
 
@@ -244,7 +249,6 @@ void ScreenTriangle::Draw(const TriDrawTriangleArgs* args, PolyTriangleThreadDat
 	float longDY = sortedVertices[2]->y - sortedVertices[0]->y;
 	float longStep = longDX / longDY;
 	float longPos = sortedVertices[0]->x + longStep * (y + 0.5f - sortedVertices[0]->y) + 0.5f;
-	longStep *= num_cores;
 
 	if (y < midY)
 	{
@@ -252,7 +256,6 @@ void ScreenTriangle::Draw(const TriDrawTriangleArgs* args, PolyTriangleThreadDat
 		float shortDY = sortedVertices[1]->y - sortedVertices[0]->y;
 		float shortStep = shortDX / shortDY;
 		float shortPos = sortedVertices[0]->x + shortStep * (y + 0.5f - sortedVertices[0]->y) + 0.5f;
-		shortStep *= num_cores;
 
 		while (y < midY)
 		{
@@ -262,11 +265,11 @@ void ScreenTriangle::Draw(const TriDrawTriangleArgs* args, PolyTriangleThreadDat
 			x0 = clamp(x0, clipleft, clipright);
 			x1 = clamp(x1, clipleft, clipright);
 
-			testfunc(y, x0, x1, args, thread);
+			thread->for_each_owned_span(y, x0, x1, [=](int sx0, int sx1) { testfunc(y, sx0, sx1, args, thread); });
 
 			shortPos += shortStep;
 			longPos += longStep;
-			y += num_cores;
+			y++;
 		}
 	}
 
@@ -276,7 +279,6 @@ void ScreenTriangle::Draw(const TriDrawTriangleArgs* args, PolyTriangleThreadDat
 		float shortDY = sortedVertices[2]->y - sortedVertices[1]->y;
 		float shortStep = shortDX / shortDY;
 		float shortPos = sortedVertices[1]->x + shortStep * (y + 0.5f - sortedVertices[1]->y) + 0.5f;
-		shortStep *= num_cores;
 
 		while (y < bottomY)
 		{
@@ -286,11 +288,11 @@ void ScreenTriangle::Draw(const TriDrawTriangleArgs* args, PolyTriangleThreadDat
 			x0 = clamp(x0, clipleft, clipright);
 			x1 = clamp(x1, clipleft, clipright);
 
-			testfunc(y, x0, x1, args, thread);
+			thread->for_each_owned_span(y, x0, x1, [=](int sx0, int sx1) { testfunc(y, sx0, sx1, args, thread); });
 
 			shortPos += shortStep;
 			longPos += longStep;
-			y += num_cores;
+			y++;
 		}
 	}
 }
@@ -34,20 +34,24 @@
 */
 
 #ifndef NO_SSE
-#include <xmmintrin.h>
+#include <emmintrin.h>
 #endif
+#include <random>
 #include "templates.h"
 #include "doomtype.h"
 #include "doomdef.h"
 #include "r_defs.h"
 #include "r_draw.h"
 #include "v_video.h"
+#include "c_dispatch.h"
 #include "r_draw_pal.h"
 #include "swrenderer/viewport/r_viewport.h"
 #include "swrenderer/scene/r_light.h"
 
 // [SP] r_blendmethod - false = rgb555 matching (ZDoom classic), true = rgb666 (refactored)
 CVAR(Bool, r_blendmethod, false, CVAR_GLOBALCONFIG | CVAR_ARCHIVE)
+// Switches the 64x64 span drawers between the SSE2 and the scalar loops, for comparing them
+CVAR(Bool, r_spansse, true, 0)
 EXTERN_CVAR(Int, gl_particles_style)
 
 /*
@@ -93,6 +97,38 @@ EXTERN_CVAR(Int, gl_particles_style)
 
 namespace swrenderer
 {
+#ifndef NO_SSE
+	// SSE2 has no gather, so the vectorized drawers below still fetch texels
+	// and table entries one by one. What runs four pixels at a time is the
+	// address math and the blending of the Col2RGB8 values described above.
+
+	// Texture offsets of four consecutive pixels of a 64x64 span
+	static inline void SpanSpots64x4(__m128i xfrac, __m128i yfrac, uint32_t *spots)
+	{
+		__m128i x = _mm_and_si128(_mm_srli_epi32(xfrac, 32 - 6 - 6), _mm_set1_epi32(63 * 64));
+		__m128i y = _mm_srli_epi32(yfrac, 32 - 6);
+		_mm_store_si128((__m128i*)spots, _mm_add_epi32(x, y));
+	}
+
+	// RGB32k indices for four additive blends
+	static inline void BlendAdd4(__m128i fg, __m128i bg, uint32_t *index)
+	{
+		__m128i a = _mm_or_si128(_mm_add_epi32(fg, bg), _mm_set1_epi32(0x1f07c1f));
+		_mm_store_si128((__m128i*)index, _mm_and_si128(a, _mm_srli_epi32(a, 15)));
+	}
+
+	// RGB32k indices for four additive blends that saturate instead of wrapping
+	static inline void BlendAddClamp4(__m128i fg, __m128i bg, uint32_t *index)
+	{
+		__m128i a = _mm_add_epi32(fg, bg);
+		__m128i b = _mm_and_si128(a, _mm_set1_epi32(0x40100400));
+		a = _mm_and_si128(_mm_or_si128(a, _mm_set1_epi32(0x01f07c1f)), _mm_set1_epi32(0x3fffffff));
+		b = _mm_sub_epi32(b, _mm_srli_epi32(b, 5));
+		a = _mm_or_si128(a, b);
+		_mm_store_si128((__m128i*)index, _mm_and_si128(a, _mm_srli_epi32(a, 15)));
+	}
+#endif
+
 	uint8_t PalWall1Command::AddLights(const DrawerLight *lights, int num_lights, float viewpos_z, uint8_t fg, uint8_t material)
 	{
 		uint32_t lit_r = 0;
@@ -2121,6 +2157,30 @@ namespace swrenderer
 		if (_srcwidth == 64 && _srcheight == 64 && num_dynlights == 0)
 		{
 			// 64x64 is the most common case by far, so special case it.
+#ifndef NO_SSE
+			if (r_spansse)
+			{
+				__m128i mxfrac = _mm_setr_epi32(xfrac, xfrac + xstep, xfrac + xstep * 2, xfrac + xstep * 3);
+				__m128i myfrac = _mm_setr_epi32(yfrac, yfrac + ystep, yfrac + ystep * 2, yfrac + ystep * 3);
+				__m128i mxstep = _mm_set1_epi32(xstep * 4);
+				__m128i mystep = _mm_set1_epi32(ystep * 4);
+				while (count >= 4)
+				{
+					alignas(16) uint32_t spots[4];
+					SpanSpots64x4(mxfrac, myfrac, spots);
+					for (int i = 0; i < 4; i++)
+						dest[i] = colormap[source[spots[i]]];
+					mxfrac = _mm_add_epi32(mxfrac, mxstep);
+					myfrac = _mm_add_epi32(myfrac, mystep);
+					dest += 4;
+					count -= 4;
+				}
+				if (count == 0)
+					return;
+				xfrac = _mm_cvtsi128_si32(mxfrac);
+				yfrac = _mm_cvtsi128_si32(myfrac);
+			}
+#endif
 			do
 			{
 				// Current texture index in u,v.
@@ -2286,6 +2346,34 @@ namespace swrenderer
 			if (_srcwidth == 64 && _srcheight == 64)
 			{
 				// 64x64 is the most common case by far, so special case it.
+#ifndef NO_SSE
+				if (num_dynlights == 0 && r_spansse)
+				{
+					__m128i mxfrac = _mm_setr_epi32(xfrac, xfrac + xstep, xfrac + xstep * 2, xfrac + xstep * 3);
+					__m128i myfrac = _mm_setr_epi32(yfrac, yfrac + ystep, yfrac + ystep * 2, yfrac + ystep * 3);
+					__m128i mxstep = _mm_set1_epi32(xstep * 4);
+					__m128i mystep = _mm_set1_epi32(ystep * 4);
+					while (count >= 4)
+					{
+						alignas(16) uint32_t spots[4];
+						SpanSpots64x4(mxfrac, myfrac, spots);
+						__m128i fg = _mm_setr_epi32(fg2rgb[colormap[source[spots[0]]]], fg2rgb[colormap[source[spots[1]]]], fg2rgb[colormap[source[spots[2]]]], fg2rgb[colormap[source[spots[3]]]]);
+						__m128i bg = _mm_setr_epi32(bg2rgb[dest[0]], bg2rgb[dest[1]], bg2rgb[dest[2]], bg2rgb[dest[3]]);
+						alignas(16) uint32_t index[4];
+						BlendAdd4(fg, bg, index);
+						for (int i = 0; i < 4; i++)
+							dest[i] = RGB32k.All[index[i]];
+						mxfrac = _mm_add_epi32(mxfrac, mxstep);
+						myfrac = _mm_add_epi32(myfrac, mystep);
+						dest += 4;
+						count -= 4;
+					}
+					if (count == 0)
+						return;
+					xfrac = _mm_cvtsi128_si32(mxfrac);
+					yfrac = _mm_cvtsi128_si32(myfrac);
+				}
+#endif
 				do
 				{
 					spot = ((xfrac >> (32 - 6 - 6))&(63 * 64)) + (yfrac >> (32 - 6));
@@ -2543,6 +2631,34 @@ namespace swrenderer
 			if (_srcwidth == 64 && _srcheight == 64)
 			{
 				// 64x64 is the most common case by far, so special case it.
+#ifndef NO_SSE
+				if (num_dynlights == 0 && r_spansse)
+				{
+					__m128i mxfrac = _mm_setr_epi32(xfrac, xfrac + xstep, xfrac + xstep * 2, xfrac + xstep * 3);
+					__m128i myfrac = _mm_setr_epi32(yfrac, yfrac + ystep, yfrac + ystep * 2, yfrac + ystep * 3);
+					__m128i mxstep = _mm_set1_epi32(xstep * 4);
+					__m128i mystep = _mm_set1_epi32(ystep * 4);
+					while (count >= 4)
+					{
+						alignas(16) uint32_t spots[4];
+						SpanSpots64x4(mxfrac, myfrac, spots);
+						__m128i fg = _mm_setr_epi32(fg2rgb[colormap[source[spots[0]]]], fg2rgb[colormap[source[spots[1]]]], fg2rgb[colormap[source[spots[2]]]], fg2rgb[colormap[source[spots[3]]]]);
+						__m128i bg = _mm_setr_epi32(bg2rgb[dest[0]], bg2rgb[dest[1]], bg2rgb[dest[2]], bg2rgb[dest[3]]);
+						alignas(16) uint32_t index[4];
+						BlendAddClamp4(fg, bg, index);
+						for (int i = 0; i < 4; i++)
+							dest[i] = RGB32k.All[index[i]];
+						mxfrac = _mm_add_epi32(mxfrac, mxstep);
+						myfrac = _mm_add_epi32(myfrac, mystep);
+						dest += 4;
+						count -= 4;
+					}
+					if (count == 0)
+						return;
+					xfrac = _mm_cvtsi128_si32(mxfrac);
+					yfrac = _mm_cvtsi128_si32(myfrac);
+				}
+#endif
 				do
 				{
 					spot = ((xfrac >> (32 - 6 - 6))&(63 * 64)) + (yfrac >> (32 - 6));
@@ -3162,3 +3278,96 @@ namespace swrenderer
 		}
 	}
 }
+
+//==========================================================================
+//
+// CCMD drawertest
+//
+// Runs the 64x64 span drawers on random input with r_spansse off and on
+// and reports any pixel that differs between the two.
+//
+//==========================================================================
+
+namespace
+{
+	template<class T>
+	class SpanTestCommand : public T
+	{
+	public:
+		SpanTestCommand(uint8_t *dest, int count, const uint8_t *source, const uint8_t *colormap, uint32_t *fg2rgb, uint32_t *bg2rgb, std::mt19937 &rng)
+		{
+			this->_source = source;
+			this->_colormap = colormap;
+			this->_xfrac = rng();
+			this->_yfrac = rng();
+			this->_xstep = rng() & 0x3ffffff;
+			this->_ystep = rng() & 0x3ffffff;
+			this->_y = 0;
+			this->_x1 = 0;
+			this->_x2 = count - 1;
+			this->_dest = dest;
+			this->_srcwidth = 64;
+			this->_srcheight = 64;
+			this->_srcblend = fg2rgb;
+			this->_destblend = bg2rgb;
+			this->_color = 0;
+			this->_srcalpha = 0;
+			this->_destalpha = 0;
+			this->_dynlights = nullptr;
+			this->_num_dynlights = 0;
+			this->_viewpos_x = 0.0f;
+			this->_step_viewpos_x = 0.0f;
+		}
+	};
+
+	template<class T>
+	int TestSpanDrawer(const char *name, DrawerThread *thread)
+	{
+		std::mt19937 rng(1234);
+		TArray<uint8_t> source(64 * 64, true), colormap(256, true), scalar(MAXWIDTH, true), sse(MAXWIDTH, true);
+		for (auto &c : source) c = (uint8_t)rng();
+		for (auto &c : colormap) c = (uint8_t)rng();
+
+		int mismatches = 0;
+		bool oldsse = r_spansse;
+		for (int run = 0; run < 1000; run++)
+		{
+			int count = 1 + rng() % 1024;
+			int alpha = rng() % 65;
+			for (int i = 0; i < count; i++) scalar[i] = sse[i] = (uint8_t)rng();
+
+			std::mt19937 a = rng, b = rng;
+			r_spansse = false;
+			SpanTestCommand<T>(&scalar[0], count, &source[0], &colormap[0], Col2RGB8[alpha], Col2RGB8[64 - alpha], a).Execute(thread);
+			r_spansse = true;
+			SpanTestCommand<T>(&sse[0], count, &source[0], &colormap[0], Col2RGB8[alpha], Col2RGB8[64 - alpha], b).Execute(thread);
+			rng.discard(4);
+
+			if (memcmp(&scalar[0], &sse[0], count) != 0)
+			{
+				mismatches++;
+			}
+		}
+		r_spansse = oldsse;
+
+		Printf("%s: %s\n", name, mismatches == 0 ? "match" : "MISMATCH");
+		return mismatches;
+	}
+}
+
+CCMD(drawertest)
+{
+#ifdef NO_SSE
+	Printf("drawertest: built without SSE, nothing to compare\n");
+#else
+	auto thread = std::make_unique<DrawerThread>();
+	bool oldblend = r_blendmethod;
+	r_blendmethod = false;
+	int mismatches = 0;
+	mismatches += TestSpanDrawer<swrenderer::DrawSpanPalCommand>("span", thread.get());
+	mismatches += TestSpanDrawer<swrenderer::DrawSpanTranslucentPalCommand>("span translucent", thread.get());
+	mismatches += TestSpanDrawer<swrenderer::DrawSpanAddClampPalCommand>("span addclamp", thread.get());
+	r_blendmethod = oldblend;
+	Printf("drawertest: %s\n", mismatches == 0 ? "all drawers match" : "drawers differ");
+#endif
+}
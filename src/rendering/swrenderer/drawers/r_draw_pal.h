@@ -220,6 +220,8 @@ namespace swrenderer
 		PalSpanCommand(const SpanDrawerArgs &args);
 
 	protected:
+		PalSpanCommand() = default;	// for drawertest, which fills in the fields itself
+
 		inline static uint8_t AddLights(const DrawerLight *lights, int num_lights, float viewpos_x, uint8_t fg, uint8_t material);
 
 		const uint8_t *_source;
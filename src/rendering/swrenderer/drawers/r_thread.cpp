@@ -34,11 +34,6 @@
 #include "swrenderer/r_memory.h"
 #include "swrenderer/r_renderthread.h"
 #include "polyrenderer/drawers/poly_triangle.h"
-#include <chrono>
-
-#ifdef WIN32
-void PeekThreadedErrorPane();
-#endif
 
 CVAR(Int, r_multithreaded, 1, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 CVAR(Int, r_debug_draw, 0, 0);
@@ -57,7 +52,7 @@ DrawerThreads::DrawerThreads()
 
 DrawerThreads::~DrawerThreads()
 {
-	StopThreads();
+	lanes.Wait();
 }
 
 void DrawerThreads::Execute(DrawerCommandQueuePtr commands)
@@ -67,22 +62,26 @@ void DrawerThreads::Execute(DrawerCommandQueuePtr commands)
 	
 	auto queue = Instance();
 
-	queue->StartThreads();
-
-	// Add to queue and awaken worker threads
-	std::unique_lock<std::mutex> start_lock(queue->start_mutex);
-	std::unique_lock<std::mutex> end_lock(queue->end_mutex);
+	// Add to queue and start a job for every lane that is not already draining it
+	std::unique_lock<std::mutex> lock(queue->mutex);
+	if (queue->active_commands.empty())
+		queue->UpdateLanes();
 	queue->active_commands.push_back(commands);
-	queue->tasks_left += queue->threads.size();
-	end_lock.unlock();
-	start_lock.unlock();
-	queue->start_condition.notify_all();
+	for (auto &thread : queue->threads)
+	{
+		if (!thread.running)
+		{
+			DrawerThread *lane = &thread;
+			lane->running = true;
+			queue->lanes.Run([=]() { queue->RunLane(lane); });
+		}
+	}
 }
 
 void DrawerThreads::ResetDebugDrawPos()
 {
 	auto queue = Instance();
-	std::unique_lock<std::mutex> start_lock(queue->start_mutex);
+	std::unique_lock<std::mutex> lock(queue->mutex);
 	bool reached_end = false;
 	for (auto &thread : queue->threads)
 	{
@@ -98,24 +97,12 @@ void DrawerThreads::ResetDebugDrawPos()
 
 void DrawerThreads::WaitForWorkers()
 {
-	using namespace std::chrono_literals;
-
-	// Wait for workers to finish
+	// Wait for all lanes to finish
 	auto queue = Instance();
-	std::unique_lock<std::mutex> end_lock(queue->end_mutex);
-	if (!queue->end_condition.wait_for(end_lock, 5s, [&]() { return queue->tasks_left == 0; }))
-	{
-#ifdef WIN32
-		PeekThreadedErrorPane();
-#endif
-		// Invoke the crash reporter so that we can capture the call stack of whatever the hung worker thread is doing
-		int *threadCrashed = nullptr;
-		*threadCrashed = 0xdeadbeef;
-	}
-	end_lock.unlock();
+	queue->lanes.Wait();
 
 	// Clean up
-	std::unique_lock<std::mutex> start_lock(queue->start_mutex);
+	std::unique_lock<std::mutex> lock(queue->mutex);
 	for (auto &thread : queue->threads)
 		thread.current_queue = 0;
 
@@ -128,15 +115,18 @@ void DrawerThreads::WaitForWorkers()
 	queue->active_commands.clear();
 }
 
-void DrawerThreads::WorkerMain(DrawerThread *thread)
+void DrawerThreads::RunLane(DrawerThread *thread)
 {
+	// Each lane must see the command lists in submission order, so a lane
+	// keeps draining them here instead of getting one job per list.
 	while (true)
 	{
-		// Wait until we are signalled to run:
-		std::unique_lock<std::mutex> start_lock(start_mutex);
-		start_condition.wait(start_lock, [&]() { return thread->current_queue < active_commands.size() || shutdown_flag; });
-		if (shutdown_flag)
+		std::unique_lock<std::mutex> lock(mutex);
+		if (thread->current_queue == active_commands.size())
+		{
+			thread->running = false;
 			break;
+		}
 
 		// Grab the commands
 		DrawerCommandQueuePtr list = active_commands[thread->current_queue];
@@ -148,7 +138,7 @@ void DrawerThreads::WorkerMain(DrawerThread *thread)
 			thread->poly->numa_start_y = thread->numa_start_y;
 			thread->poly->numa_end_y = thread->numa_end_y;
 		}
-		start_lock.unlock();
+		lock.unlock();
 
 		// Do the work:
 		if (r_debug_draw)
@@ -167,98 +157,33 @@ void DrawerThreads::WorkerMain(DrawerThread *thread)
 				command->Execute(thread);
 			}
 		}
-
-		// Notify main thread that we finished:
-		std::unique_lock<std::mutex> end_lock(end_mutex);
-		tasks_left--;
-		bool finishedTasks = tasks_left == 0;
-		end_lock.unlock();
-		if (finishedTasks)
-			end_condition.notify_all();
 	}
 }
 
-void DrawerThreads::StartThreads()
+void DrawerThreads::UpdateLanes()
 {
-	std::unique_lock<std::mutex> lock(threads_mutex);
-
-	int num_numathreads = 0;
-	for (int i = 0; i < I_GetNumaNodeCount(); i++)
-		num_numathreads += I_GetNumaNodeThreadCount(i);
-
-	int num_threads = num_numathreads;
-	if (num_threads == 0)
-	{
-		static bool firstCall = true;
-		if (firstCall)
-		{
-			firstCall = false;
-			if (r_multithreaded == 1)
-				Printf("Warning: Unable to determine number of CPU cores/threads for this computer. To improve performance, please type 'r_multithreaded x' in the console, where x is the number of threads to use.\n");
-		}
-
-		num_threads = 1;
-	}
-
+	// Only called while no lane has any work, as the lanes point into the array.
+	int num_lanes = FJobSystem::NumThreads();
 	if (r_multithreaded == 0)
-		num_threads = 1;
+		num_lanes = 1;
 	else if (r_multithreaded != 1)
-		num_threads = r_multithreaded;
+		num_lanes = r_multithreaded;
 
-	if (num_threads != (int)threads.size())
+	if (num_lanes != (int)threads.size())
 	{
-		StopThreads();
-
-		threads.resize(num_threads);
-
-		if (num_threads == num_numathreads)
+		threads.resize(num_lanes);
+		for (int i = 0; i < num_lanes; i++)
 		{
-			int curThread = 0;
-			for (int numaNode = 0; numaNode < I_GetNumaNodeCount(); numaNode++)
-			{
-				for (int i = 0; i < I_GetNumaNodeThreadCount(numaNode); i++)
-				{
-					DrawerThreads *queue = this;
-					DrawerThread *thread = &threads[curThread++];
-					thread->core = i;
-					thread->num_cores = I_GetNumaNodeThreadCount(numaNode);
-					thread->numa_node = numaNode;
-					thread->num_numa_nodes = I_GetNumaNodeCount();
-					thread->thread = std::thread([=]() { queue->WorkerMain(thread); });
-					I_SetThreadNumaNode(thread->thread, numaNode);
-				}
-			}
-		}
-		else
-		{
-			for (int i = 0; i < num_threads; i++)
-			{
-				DrawerThreads *queue = this;
-				DrawerThread *thread = &threads[i];
-				thread->core = i;
-				thread->num_cores = num_threads;
-				thread->numa_node = 0;
-				thread->num_numa_nodes = 1;
-				thread->thread = std::thread([=]() { queue->WorkerMain(thread); });
-				I_SetThreadNumaNode(thread->thread, 0);
-			}
+			DrawerThread *thread = &threads[i];
+			thread->core = i;
+			thread->num_cores = num_lanes;
+			thread->numa_node = 0;
+			thread->num_numa_nodes = 1;
+			thread->poly.reset();
 		}
 	}
 }
 
-void DrawerThreads::StopThreads()
-{
-	std::unique_lock<std::mutex> lock(start_mutex);
-	shutdown_flag = true;
-	lock.unlock();
-	start_condition.notify_all();
-	for (auto &thread : threads)
-		thread.thread.join();
-	threads.clear();
-	lock.lock();
-	shutdown_flag = false;
-}
-
 /////////////////////////////////////////////////////////////////////////////
 
 DrawerCommandQueue::DrawerCommandQueue(RenderMemory *frameMemory) : FrameMemory(frameMemory)
@@ -272,16 +197,6 @@ void *DrawerCommandQueue::AllocMemory(size_t size)
 
 /////////////////////////////////////////////////////////////////////////////
 
-void GroupMemoryBarrierCommand::Execute(DrawerThread *thread)
-{
-	std::unique_lock<std::mutex> lock(mutex);
-	count++;
-	condition.notify_all();
-	condition.wait(lock, [&]() { return count >= (size_t)thread->num_cores; });
-}
-
-/////////////////////////////////////////////////////////////////////////////
-
 MemcpyCommand::MemcpyCommand(void *dest, int destpitch, const void *src, int width, int height, int srcpitch, int pixelsize)
 	: dest(dest), src(src), destpitch(destpitch), width(width), height(height), srcpitch(srcpitch), pixelsize(pixelsize)
 {
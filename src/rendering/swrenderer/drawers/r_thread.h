@@ -25,9 +25,8 @@
 #include "r_draw.h"
 #include <vector>
 #include <memory>
-#include <thread>
 #include <mutex>
-#include <condition_variable>
+#include "jobsystem.h"
 
 // Use multiple threads when drawing
 EXTERN_CVAR(Int, r_multithreaded)
@@ -36,11 +35,12 @@ class PolyTriangleThreadData;
 
 namespace swrenderer { class WallColumnDrawerArgs; }
 
-// Worker data for each thread executing drawer commands
+// Worker data for each lane executing drawer commands. A lane runs as a
+// job on the shared workers and owns every num_cores'th line of the screen.
 class DrawerThread
 {
 public:
-	std::thread thread;
+	bool running = false;
 	size_t current_queue = 0;
 
 	// Thread line index of this thread
@@ -112,18 +112,6 @@ public:
 	virtual void Execute(DrawerThread *thread) = 0;
 };
 
-// Wait for all worker threads before executing next command
-class GroupMemoryBarrierCommand : public DrawerCommand
-{
-public:
-	void Execute(DrawerThread *thread);
-
-private:
-	std::mutex mutex;
-	std::condition_variable condition;
-	size_t count = 0;
-};
-
 // Copy finished rows to video memory
 class MemcpyCommand : public DrawerCommand
 {
@@ -147,7 +135,7 @@ typedef std::shared_ptr<DrawerCommandQueue> DrawerCommandQueuePtr;
 class DrawerThreads
 {
 public:
-	// Runs the collected commands on worker threads
+	// Runs the collected commands on all lanes
 	static void Execute(DrawerCommandQueuePtr queue);
 
 	// Waits for all commands to finish executing
@@ -159,23 +147,15 @@ private:
 	DrawerThreads();
 	~DrawerThreads();
 	
-	void StartThreads();
-	void StopThreads();
-	void WorkerMain(DrawerThread *thread);
+	void UpdateLanes();
+	void RunLane(DrawerThread *thread);
 
 	static DrawerThreads *Instance();
 	
-	std::mutex threads_mutex;
+	std::mutex mutex;
 	std::vector<DrawerThread> threads;
-
-	std::mutex start_mutex;
-	std::condition_variable start_condition;
 	std::vector<DrawerCommandQueuePtr> active_commands;
-	bool shutdown_flag = false;
-
-	std::mutex end_mutex;
-	std::condition_variable end_condition;
-	size_t tasks_left = 0;
+	FJobGroup lanes;
 
 	size_t debug_draw_end = 0;
 
@@ -193,7 +173,7 @@ public:
 	
 	void Clear() { commands.clear(); }
 	
-	// Queue command to be executed by drawer worker threads
+	// Queue command to be executed by the drawer lanes
 	template<typename T, typename... Types>
 	void Push(Types &&... args)
 	{
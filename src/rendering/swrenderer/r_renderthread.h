@@ -23,7 +23,6 @@
 #pragma once
 
 #include <memory>
-#include <thread>
 
 class DrawerCommandQueue;
 typedef std::shared_ptr<DrawerCommandQueue> DrawerCommandQueuePtr;
@@ -79,8 +78,6 @@ namespace swrenderer
 
 		TArray<FDynamicLight*> AddedLightsArray;
 
-		std::thread thread;
-
 		// VisibleSprite working buffers
 		short clipbot[MAXWIDTH];
 		short cliptop[MAXWIDTH];
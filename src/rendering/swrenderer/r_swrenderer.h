@@ -17,6 +17,9 @@ struct FSoftwareRenderer : public FRenderer
 	// renders view to a savegame picture
 	void WriteSavePic (player_t *player, FileWriter *file, int width, int height) override;
 
+	// renders view to a canvas that never gets presented (for benchmarking)
+	void RenderOffscreen(player_t *player, DCanvas *canvas) override;
+
 	// draws player sprites with hardware acceleration (only useful for software rendering)
 	void DrawRemainingPlayerSprites() override;
 
@@ -57,16 +57,13 @@
 #include "swrenderer/r_memory.h"
 #include "swrenderer/r_renderthread.h"
 #include "swrenderer/things/r_playersprite.h"
-#include <chrono>
-
-#ifdef WIN32
-void PeekThreadedErrorPane();
-#endif
+#include "jobsystem.h"
 
 EXTERN_CVAR(Int, r_clearbuffer)
 EXTERN_CVAR(Int, r_debug_draw)
 
 CVAR(Int, r_scene_multithreaded, 0, 0);
+CVAR(Bool, r_scene_balance, true, 0);
 CVAR(Bool, r_models, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 
 bool r_modelscene = false;
@@ -74,6 +71,10 @@ bool r_modelscene = false;
 namespace swrenderer
 {
 	cycle_t WallCycles, PlaneCycles, MaskedCycles, DrawerWaitCycles;
+
+	// Slice widths and timings of the last main view, for the slices stat
+	static std::vector<int> StatSliceWidth;
+	static std::vector<double> StatSliceMS;
 	
 	RenderScene::RenderScene()
 	{
@@ -82,7 +83,6 @@ namespace swrenderer
 
 	RenderScene::~RenderScene()
 	{
-		StopThreads();
 	}
 
 	void RenderScene::SetClearColor(int color)
@@ -206,58 +206,56 @@ namespace swrenderer
 
 	void RenderScene::RenderThreadSlices()
 	{
-		int numThreads = std::thread::hardware_concurrency();
-		if (numThreads == 0)
-			numThreads = 1;
+		int numThreads = FJobSystem::NumThreads();
 
 		if (r_scene_multithreaded == 0 || r_multithreaded == 0)
 			numThreads = 1;
 		else if (r_scene_multithreaded != 1)
 			numThreads = r_scene_multithreaded;
 
-		if (numThreads != (int)Threads.size())
-		{
-			StopThreads();
-			StartThreads(numThreads);
-		}
+		while (Threads.size() < (size_t)numThreads)
+			Threads.push_back(std::unique_ptr<RenderThread>(new RenderThread(this, false)));
+		while (Threads.size() > (size_t)numThreads)
+			Threads.pop_back();
+
+		// Camera textures get rendered in between, so only the main view is balanced
+		bool mainview = !MainThread()->Viewport->RenderingToCanvas;
+		bool balance = mainview && r_scene_balance && numThreads > 1;
+		if (balance)
+			BalanceSlices(numThreads);
+		else if (mainview)
+			SliceBounds.clear();
 
 		// Setup threads:
-		std::unique_lock<std::mutex> start_lock(start_mutex);
 		for (int i = 0; i < numThreads; i++)
 		{
 			*Threads[i]->Viewport = *MainThread()->Viewport;
 			*Threads[i]->Light = *MainThread()->Light;
-			Threads[i]->X1 = viewwidth * i / numThreads;
-			Threads[i]->X2 = viewwidth * (i + 1) / numThreads;
+			Threads[i]->X1 = balance ? SliceBounds[i] : viewwidth * i / numThreads;
+			Threads[i]->X2 = balance ? SliceBounds[i + 1] : viewwidth * (i + 1) / numThreads;
 		}
-		run_id++;
-		start_lock.unlock();
 
-		// Notify threads to run
-		if (Threads.size() > 1)
+		// The other slices become jobs, the main thread does the first one itself:
+		SliceCycles.resize(numThreads);
+		FJobGroup slices;
+		for (int i = 1; i < numThreads; i++)
 		{
-			start_condition.notify_all();
+			RenderThread *thread = Threads[i].get();
+			slices.Run([=]() { RenderTimedSlice(thread, SliceCycles[i]); });
 		}
+		RenderTimedSlice(MainThread(), SliceCycles[0]);
+		slices.Wait();
 
-		// Do the main thread ourselves:
-		RenderThreadSlice(MainThread());
-
-		// Wait for everyone to finish:
-		if (Threads.size() > 1)
+		if (mainview)
 		{
-			using namespace std::chrono_literals;
-			std::unique_lock<std::mutex> end_lock(end_mutex);
-			finished_threads++;
-			if (!end_condition.wait_for(end_lock, 5s, [&]() { return finished_threads == Threads.size(); }))
+			SliceTimes.resize(numThreads);
+			StatSliceWidth.resize(numThreads);
+			for (int i = 0; i < numThreads; i++)
 			{
-#ifdef WIN32
-				PeekThreadedErrorPane();
-#endif
-				// Invoke the crash reporter so that we can capture the call stack of whatever the hung worker thread is doing
-				int *threadCrashed = nullptr;
-				*threadCrashed = 0xdeadbeef;
+				SliceTimes[i] = SliceCycles[i].TimeMS();
+				StatSliceWidth[i] = Threads[i]->X2 - Threads[i]->X1;
 			}
-			finished_threads = 0;
+			StatSliceMS = SliceTimes;
 		}
 
 		// Change main thread back to covering the whole screen for player sprites
@@ -265,6 +263,55 @@ namespace swrenderer
 		MainThread()->X2 = viewwidth;
 	}
 
+	// Moves the slice boundaries so that every slice would have taken the
+	// same time in the previous frame, assuming the cost is spread evenly
+	// within each slice. Only goes half the way each frame so that a single
+	// expensive frame does not make the split oscillate.
+	void RenderScene::BalanceSlices(int numThreads)
+	{
+		int minWidth = MAX(viewwidth / (numThreads * 8), 1);
+		if (SliceBounds.size() != (size_t)numThreads + 1 || SliceBounds.back() != viewwidth || SliceTimes.size() != (size_t)numThreads || viewwidth < numThreads * minWidth)
+		{
+			SliceBounds.resize(numThreads + 1);
+			for (int i = 0; i <= numThreads; i++)
+				SliceBounds[i] = viewwidth * i / numThreads;
+			return;
+		}
+
+		double total = 0;
+		for (double time : SliceTimes)
+			total += time;
+		if (total <= 0)
+			return;
+
+		std::vector<int> bounds = SliceBounds;
+		double target = total / numThreads;
+		double accum = 0;
+		int slice = 0;
+		for (int i = 1; i < numThreads; i++)
+		{
+			double wanted = target * i;
+			while (slice < numThreads - 1 && accum + SliceTimes[slice] < wanted)
+				accum += SliceTimes[slice++];
+
+			double time = SliceTimes[slice];
+			double frac = time > 0 ? (wanted - accum) / time : 0.5;
+			double pos = SliceBounds[slice] + clamp(frac, 0.0, 1.0) * (SliceBounds[slice + 1] - SliceBounds[slice]);
+			bounds[i] = xs_RoundToInt((SliceBounds[i] + pos) * 0.5);
+		}
+
+		for (int i = 1; i < numThreads; i++)
+			SliceBounds[i] = clamp(bounds[i], SliceBounds[i - 1] + minWidth, viewwidth - (numThreads - i) * minWidth);
+	}
+
+	void RenderScene::RenderTimedSlice(RenderThread *thread, cycle_t &cycles)
+	{
+		cycles.Reset();
+		cycles.Clock();
+		RenderThreadSlice(thread);
+		cycles.Unclock();
+	}
+
 	void RenderScene::RenderThreadSlice(RenderThread *thread)
 	{
 		thread->DrawQueue->Clear();
@@ -309,54 +356,6 @@ namespace swrenderer
 		DrawerThreads::Execute(thread->DrawQueue);
 	}
 
-	void RenderScene::StartThreads(size_t numThreads)
-	{
-		while (Threads.size() < (size_t)numThreads)
-		{
-			std::unique_ptr<RenderThread> thread(new RenderThread(this, false));
-			auto renderthread = thread.get();
-			int start_run_id = run_id;
-			thread->thread = std::thread([=]()
-			{
-				int last_run_id = start_run_id;
-				while (true)
-				{
-					// Wait until we are signalled to run:
-					std::unique_lock<std::mutex> start_lock(start_mutex);
-					start_condition.wait(start_lock, [&]() { return run_id != last_run_id || shutdown_flag; });
-					if (shutdown_flag)
-						break;
-					last_run_id = run_id;
-					start_lock.unlock();
-
-					RenderThreadSlice(renderthread);
-
-					// Notify main thread that we finished:
-					std::unique_lock<std::mutex> end_lock(end_mutex);
-					finished_threads++;
-					end_lock.unlock();
-					end_condition.notify_all();
-				}
-			});
-			Threads.push_back(std::move(thread));
-		}
-	}
-
-	void RenderScene::StopThreads()
-	{
-		std::unique_lock<std::mutex> lock(start_mutex);
-		shutdown_flag = true;
-		lock.unlock();
-		start_condition.notify_all();
-		while (Threads.size() > 1)
-		{
-			Threads.back()->thread.join();
-			Threads.pop_back();
-		}
-		lock.lock();
-		shutdown_flag = false;
-	}
-
 	void RenderScene::RenderViewToCanvas(AActor *actor, DCanvas *canvas, int x, int y, int width, int height, bool dontmaplines)
 	{
 		auto viewport = MainThread()->Viewport.get();
@@ -423,6 +422,27 @@ namespace swrenderer
 		return out;
 	}
 
+	// Shows how long each slice took. Idle is the share of the threads' time
+	// spent waiting for the slowest slice.
+	ADD_STAT(slices)
+	{
+		FString out;
+		double total = 0, slowest = 0;
+		for (double ms : StatSliceMS)
+		{
+			total += ms;
+			slowest = MAX(slowest, ms);
+		}
+		if (slowest <= 0)
+			return "no slices";
+
+		double mean = total / StatSliceMS.size();
+		out.Format("imbalance=%.2f idle=%d%%", slowest / mean, int(100 * (1 - mean / slowest)));
+		for (size_t i = 0; i < StatSliceMS.size(); i++)
+			out.AppendFormat("  %dpx=%04.1f ms", StatSliceWidth[i], StatSliceMS[i]);
+		return out;
+	}
+
 	static double f_acc, w_acc, p_acc, m_acc, drawer_acc;
 	static int acc_c;
 
@@ -24,9 +24,6 @@
 #include <stddef.h>
 #include <vector>
 #include <memory>
-#include <thread>
-#include <mutex>
-#include <condition_variable>
 #include "r_defs.h"
 #include "d_player.h"
 
@@ -60,23 +57,18 @@ namespace swrenderer
 	private:
 		void RenderActorView(AActor *actor,bool renderplayersprite, bool dontmaplines);
 		void RenderThreadSlices();
+		void BalanceSlices(int numThreads);
+		void RenderTimedSlice(RenderThread *thread, cycle_t &cycles);
 		void RenderThreadSlice(RenderThread *thread);
 		void RenderPSprites();
 
-		void StartThreads(size_t numThreads);
-		void StopThreads();
-		
 		bool dontmaplines = false;
 		int clearcolor = 0;
 
 		std::unique_ptr<PolyDepthStencil> DepthStencil;
 		std::vector<std::unique_ptr<RenderThread>> Threads;
-		std::mutex start_mutex;
-		std::condition_variable start_condition;
-		bool shutdown_flag = false;
-		int run_id = 0;
-		std::mutex end_mutex;
-		std::condition_variable end_condition;
-		size_t finished_threads = 0;
+		std::vector<int> SliceBounds;
+		std::vector<cycle_t> SliceCycles;
+		std::vector<double> SliceTimes;
 	};
 }
@@ -272,7 +272,7 @@ namespace swrenderer
 		PolyTriangleDrawer::SetCullCCW(Thread->DrawQueue, true);
 	}
 
-	IModelVertexBuffer *SWModelRenderer::CreateVertexBuffer(bool needindex, bool singleframe)
+	IModelVertexBuffer *SWModelRenderer::CreateVertexBuffer(bool needindex, bool singleframe, bool skinned)
 	{
 		return new SWModelVertexBuffer(needindex, singleframe);
 	}
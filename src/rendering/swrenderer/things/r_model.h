@@ -65,7 +65,7 @@ namespace swrenderer
 
 		void BeginDrawModel(AActor *actor, FSpriteModelFrame *smf, const VSMatrix &objectToWorldMatrix, bool mirrored) override;
 		void EndDrawModel(AActor *actor, FSpriteModelFrame *smf) override;
-		IModelVertexBuffer *CreateVertexBuffer(bool needindex, bool singleframe) override;
+		IModelVertexBuffer *CreateVertexBuffer(bool needindex, bool singleframe, bool skinned) override;
 		VSMatrix GetViewToWorldMatrix() override;
 		void BeginDrawHUDModel(AActor *actor, const VSMatrix &objectToWorldMatrix, bool mirrored) override;
 		void EndDrawHUDModel(AActor *actor) override;
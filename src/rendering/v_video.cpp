@@ -189,6 +189,40 @@ CUSTOM_CVAR (Bool, vid_vsync, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 // [RH] Set true when vid_setmode command has been executed
 bool	setmodeneeded = false;
 
+//==========================================================================
+//
+// Null video backend
+//
+// Selected by -nodraw and -benchsw, which never present anything. Nothing
+// gets created, so these modes also run on machines without a display or
+// a usable GPU.
+//
+//==========================================================================
+
+class NullFrameBuffer : public DFrameBuffer
+{
+	typedef DFrameBuffer Super;
+public:
+	NullFrameBuffer(int width, int height)
+		: DFrameBuffer(width, height)
+	{
+	}
+	void InitializeState() override {}
+	void Update() override {}
+	bool IsFullscreen() override { return false; }
+	int GetClientWidth() override { return GetWidth(); }
+	int GetClientHeight() override { return GetHeight(); }
+};
+
+class NullVideo : public IVideo
+{
+public:
+	DFrameBuffer *CreateFrameBuffer() override
+	{
+		return new NullFrameBuffer(vid_defwidth, vid_defheight);
+	}
+};
+
 //==========================================================================
 //
 // DCanvas Constructor
@@ -630,7 +664,15 @@ void V_Init2()
 	ticker.SetGenericRepDefault(val, CVAR_Bool);
 
 
-	I_InitGraphics();
+	if (Args->CheckParm("-nodraw") || Args->CheckParm("-benchsw"))
+	{
+		Video = new NullVideo;
+		nodrawers = true;
+	}
+	else
+	{
+		I_InitGraphics();
+	}
 
 	Video->SetResolution();	// this only fails via exceptions.
 	Printf ("Resolution: %d x %d\n", SCREENWIDTH, SCREENHEIGHT);
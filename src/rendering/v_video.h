@@ -62,6 +62,7 @@ class IDataBuffer;
 class FFlatVertexBuffer;
 class HWViewpointBuffer;
 class FLightBuffer;
+class FBoneBuffer;
 struct HWDrawInfo;
 
 enum EHWCaps
@@ -77,6 +78,8 @@ enum EHWCaps
 
 	RFL_INVALIDATE_BUFFER = 64,
 	RFL_DEBUG = 128,
+
+	RFL_SHADER_LAYER = 256,	// vertex shaders can select the layer of a layered frame buffer
 };
 
 
@@ -385,6 +388,7 @@ public:
 	FFlatVertexBuffer *mVertexData = nullptr;	// Global vertex data
 	HWViewpointBuffer *mViewpoints = nullptr;	// Viewpoint render data.
 	FLightBuffer *mLights = nullptr;			// Dynamic lights
+	FBoneBuffer *mBones = nullptr;				// Skeletal model bones
 	IShadowMap mShadowMap;
 
 	IntRect mScreenViewport;
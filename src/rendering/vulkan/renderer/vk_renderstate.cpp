@@ -384,6 +384,7 @@ void VkRenderState::ApplyPushConstants()
 		mPushConstants.uSpecularMaterial = { mMaterial.mMaterial->tex->Glossiness, mMaterial.mMaterial->tex->SpecularLevel };
 
 	mPushConstants.uLightIndex = mLightIndex;
+	mPushConstants.uBoneIndexBase = mBoneIndexBase;
 	mPushConstants.uDataIndex = mStreamBufferWriter.DataIndex();
 
 	auto fb = GetVulkanFrameBuffer();
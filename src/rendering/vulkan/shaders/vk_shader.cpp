@@ -72,6 +72,8 @@ VkShaderManager::VkShaderManager(VulkanDevice *device) : device(device)
 			mEffectShaders[j].push_back(std::move(prog));
 		}
 	}
+
+	ShaderBuilder::saveCache();
 }
 
 VkShaderManager::~VkShaderManager()
@@ -109,6 +111,7 @@ static const char *shaderBindings = R"(
 		mat4 ProjectionMatrix;
 		mat4 ViewMatrix;
 		mat4 NormalViewMatrix;
+		mat4 StereoProjectionMatrix;
 
 		vec4 uCameraPos;
 		vec4 uClipLine;
@@ -168,6 +171,12 @@ static const char *shaderBindings = R"(
 
 	layout(set = 0, binding = 4) uniform sampler2D ShadowMap;
 
+	// bone matrices for skeletal models
+	layout(set = 0, binding = 5, std430) readonly buffer BoneBufferSSO
+	{
+	    mat4 bones[];
+	};
+
 	// textures
 	layout(set = 1, binding = 0) uniform sampler2D tex;
 	layout(set = 1, binding = 1) uniform sampler2D texture2;
@@ -197,7 +206,10 @@ static const char *shaderBindings = R"(
 		vec2 uSpecularMaterial;
 
 		int uDataIndex;
-		int padding1, padding2, padding3;
+
+		// skeletal model bones
+		int uBoneIndexBase;
+		int padding2, padding3;
 	};
 
 	// material types
@@ -45,7 +45,10 @@ struct PushConstants
 	FVector2 uSpecularMaterial;
 
 	int uDataIndex;
-	int padding1, padding2, padding3;
+
+	// skeletal model bones
+	int uBoneIndexBase;
+	int padding2, padding3;
 };
 
 class VkShaderProgram
@@ -22,9 +22,14 @@
 
 #include "vk_builders.h"
 #include "doomerrors.h"
+#include "cmdlib.h"
+#include "md5.h"
+#include "m_misc.h"
+#include "files.h"
 #include "r_data/renderstyle.h"
 #include <ShaderLang.h>
 #include <GlslangToSpv.h>
+#include <map>
 
 static const TBuiltInResource DefaultTBuiltInResource = {
 	/* .MaxLights = */ 32,
@@ -149,9 +154,116 @@ void ShaderBuilder::setFragmentShader(const FString &c)
 	stage = EShLanguage::EShLangFragment;
 }
 
-std::unique_ptr<VulkanShader> ShaderBuilder::create(const char *shadername, VulkanDevice *device)
+static const char *SpirvCacheMagic = "ZDSV";
+
+// Must be changed whenever the glslang settings in CompileSpirv change
+static const uint32_t SpirvCacheVersion = 1;
+
+static std::map<FString, std::vector<unsigned int>> SpirvCache;
+static bool SpirvCacheChanged;
+
+static FString CalcSpirvChecksum(int stage, const FString &code)
+{
+	uint32_t header[2] = { SpirvCacheVersion, (uint32_t)stage };
+
+	uint8_t digest[16];
+	MD5Context md5;
+	md5.Update((const uint8_t *)header, sizeof(header));
+	md5.Update((const uint8_t *)code.GetChars(), (unsigned int)code.Len());
+	md5.Final(digest);
+
+	char hexdigest[33];
+	for (int i = 0; i < 16; i++)
+	{
+		int v = digest[i] >> 4;
+		hexdigest[i * 2] = v < 10 ? ('0' + v) : ('a' + v - 10);
+		v = digest[i] & 15;
+		hexdigest[i * 2 + 1] = v < 10 ? ('0' + v) : ('a' + v - 10);
+	}
+	hexdigest[32] = 0;
+	return hexdigest;
+}
+
+static FString CreateSpirvCacheName(bool create)
+{
+	FString path = M_GetCachePath(create);
+	if (create) CreatePath(path);
+	path << "/spirvcache.zdsv";
+	return path;
+}
+
+static void LoadSpirvCache()
+{
+	static bool loaded = false;
+	if (loaded)
+		return;
+	loaded = true;
+
+	try
+	{
+		FString path = CreateSpirvCacheName(false);
+		FileReader fr;
+		if (!fr.OpenFile(path))
+			I_Error("Could not open SPIR-V cache file");
+
+		char magic[4];
+		fr.Read(magic, 4);
+		if (memcmp(magic, SpirvCacheMagic, 4) != 0)
+			I_Error("Not a SPIR-V cache file");
+
+		uint32_t count = fr.ReadUInt32();
+		if (count > 4096)
+			I_Error("Too many shaders cached");
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			char hexdigest[33];
+			if (fr.Read(hexdigest, 32) != 32)
+				I_Error("Read error");
+			hexdigest[32] = 0;
+
+			uint32_t size = fr.ReadUInt32();
+			if (size == 0 || size > 1024 * 1024)
+				I_Error("Bad shader size, probably file corruption");
+
+			std::vector<unsigned int> spirv(size);
+			if (fr.Read(spirv.data(), size * sizeof(unsigned int)) != size * sizeof(unsigned int))
+				I_Error("Read error");
+
+			SpirvCache[hexdigest] = std::move(spirv);
+		}
+	}
+	catch (...)
+	{
+		SpirvCache.clear();
+	}
+}
+
+void ShaderBuilder::saveCache()
+{
+	if (!SpirvCacheChanged)
+		return;
+	SpirvCacheChanged = false;
+
+	FString path = CreateSpirvCacheName(true);
+	std::unique_ptr<FileWriter> fw(FileWriter::Open(path));
+	if (fw)
+	{
+		uint32_t count = (uint32_t)SpirvCache.size();
+		fw->Write(SpirvCacheMagic, 4);
+		fw->Write(&count, sizeof(uint32_t));
+		for (const auto &it : SpirvCache)
+		{
+			uint32_t size = (uint32_t)it.second.size();
+			fw->Write(it.first.GetChars(), 32);
+			fw->Write(&size, sizeof(uint32_t));
+			fw->Write(it.second.data(), size * sizeof(unsigned int));
+		}
+	}
+}
+
+static std::vector<unsigned int> CompileSpirv(EShLanguage stage, const FString &code, const char *shadername)
 {
-	EShLanguage stage = (EShLanguage)this->stage;
 	const char *sources[] = { code.GetChars() };
 
 	TBuiltInResource resources = DefaultTBuiltInResource;
@@ -189,6 +301,21 @@ std::unique_ptr<VulkanShader> ShaderBuilder::create(const char *shadername, Vulk
 	std::vector<unsigned int> spirv;
 	spv::SpvBuildLogger logger;
 	glslang::GlslangToSpv(*intermediate, spirv, &logger, &spvOptions);
+	return spirv;
+}
+
+std::unique_ptr<VulkanShader> ShaderBuilder::create(const char *shadername, VulkanDevice *device)
+{
+	LoadSpirvCache();
+
+	FString checksum = CalcSpirvChecksum(stage, code);
+	auto it = SpirvCache.find(checksum);
+	if (it == SpirvCache.end())
+	{
+		it = SpirvCache.emplace(checksum, CompileSpirv((EShLanguage)stage, code, shadername)).first;
+		SpirvCacheChanged = true;
+	}
+	const std::vector<unsigned int> &spirv = it->second;
 
 	VkShaderModuleCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
@@ -113,6 +113,9 @@ public:
 
 	std::unique_ptr<VulkanShader> create(const char *shadername, VulkanDevice *device);
 
+	// Writes the SPIR-V of all shaders compiled so far to the cache directory
+	static void saveCache();
+
 private:
 	FString code;
 	int stage;
@@ -618,7 +621,7 @@ inline void ComputePipelineBuilder::setComputeShader(VulkanShader *shader)
 inline std::unique_ptr<VulkanPipeline> ComputePipelineBuilder::create(VulkanDevice *device)
 {
 	VkPipeline pipeline;
-	vkCreateComputePipelines(device->device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+	vkCreateComputePipelines(device->device, device->pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
 	return std::make_unique<VulkanPipeline>(device, pipeline);
 }
 
@@ -1034,7 +1037,7 @@ inline void GraphicsPipelineBuilder::addDynamicState(VkDynamicState state)
 inline std::unique_ptr<VulkanPipeline> GraphicsPipelineBuilder::create(VulkanDevice *device)
 {
 	VkPipeline pipeline = 0;
-	VkResult result = vkCreateGraphicsPipelines(device->device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+	VkResult result = vkCreateGraphicsPipelines(device->device, device->pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
 	CheckVulkanError(result, "Could not create graphics pipeline");
 	return std::make_unique<VulkanPipeline>(device, pipeline);
 }
@@ -41,6 +41,9 @@
 #include "i_system.h"
 #include "version.h"
 #include "doomerrors.h"
+#include "cmdlib.h"
+#include "m_misc.h"
+#include "files.h"
 #include "gamedata/fonts/v_text.h"
 
 bool I_GetVulkanPlatformExtensions(unsigned int *count, const char **names);
@@ -83,6 +86,7 @@ VulkanDevice::VulkanDevice()
 		SelectFeatures();
 		CreateDevice();
 		CreateAllocator();
+		CreatePipelineCache();
 	}
 	catch (...)
 	{
@@ -102,6 +106,7 @@ void VulkanDevice::SelectFeatures()
 	UsedDeviceFeatures.fragmentStoresAndAtomics = PhysicalDevice.Features.fragmentStoresAndAtomics;
 	UsedDeviceFeatures.depthClamp = PhysicalDevice.Features.depthClamp;
 	UsedDeviceFeatures.shaderClipDistance = PhysicalDevice.Features.shaderClipDistance;
+	UsedDeviceFeatures.textureCompressionBC = PhysicalDevice.Features.textureCompressionBC;
 }
 
 bool VulkanDevice::CheckRequiredFeatures(const VkPhysicalDeviceFeatures &f)
@@ -500,6 +505,13 @@ void VulkanDevice::ReleaseResources()
 	if (device)
 		vkDeviceWaitIdle(device);
 
+	if (pipelineCache)
+	{
+		SavePipelineCache();
+		vkDestroyPipelineCache(device, pipelineCache, nullptr);
+	}
+	pipelineCache = VK_NULL_HANDLE;
+
 	if (allocator)
 		vmaDestroyAllocator(allocator);
 
@@ -519,6 +531,78 @@ void VulkanDevice::ReleaseResources()
 	instance = nullptr;
 }
 
+static FString CreatePipelineCacheName(bool create)
+{
+	FString path = M_GetCachePath(create);
+	if (create) CreatePath(path);
+	path << "/pipelinecache.zdpc";
+	return path;
+}
+
+static uint32_t ReadCacheHeaderField(const uint8_t *data)
+{
+	// The pipeline cache header is always stored least significant byte first
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+void VulkanDevice::CreatePipelineCache()
+{
+	// Only hand the driver data it wrote itself. Drivers are supposed to check this too, but not all of them do it reliably.
+	TArray<uint8_t> data;
+	FileReader fr;
+	if (fr.OpenFile(CreatePipelineCacheName(false)))
+	{
+		data = fr.Read();
+
+		const auto &props = PhysicalDevice.Properties;
+		const size_t headerSize = 16 + VK_UUID_SIZE;
+		if (data.Size() < headerSize ||
+			ReadCacheHeaderField(&data[0]) < headerSize ||
+			ReadCacheHeaderField(&data[4]) != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+			ReadCacheHeaderField(&data[8]) != props.vendorID ||
+			ReadCacheHeaderField(&data[12]) != props.deviceID ||
+			memcmp(&data[16], props.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		{
+			data.Clear();
+		}
+	}
+
+	VkPipelineCacheCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	createInfo.initialDataSize = data.Size();
+	createInfo.pInitialData = data.Size() > 0 ? data.Data() : nullptr;
+
+	VkResult result = vkCreatePipelineCache(device, &createInfo, nullptr, &pipelineCache);
+	if (result != VK_SUCCESS && data.Size() > 0)
+	{
+		createInfo.initialDataSize = 0;
+		createInfo.pInitialData = nullptr;
+		result = vkCreatePipelineCache(device, &createInfo, nullptr, &pipelineCache);
+	}
+	if (result != VK_SUCCESS)
+	{
+		// Pipelines can be created without a cache, so this is not fatal
+		pipelineCache = VK_NULL_HANDLE;
+	}
+}
+
+void VulkanDevice::SavePipelineCache()
+{
+	size_t size = 0;
+	if (vkGetPipelineCacheData(device, pipelineCache, &size, nullptr) != VK_SUCCESS || size == 0)
+		return;
+
+	TArray<uint8_t> data(size, true);
+	if (vkGetPipelineCacheData(device, pipelineCache, &size, data.Data()) != VK_SUCCESS)
+		return;
+
+	std::unique_ptr<FileWriter> fw(FileWriter::Open(CreatePipelineCacheName(true)));
+	if (fw)
+	{
+		fw->Write(data.Data(), size);
+	}
+}
+
 uint32_t VulkanDevice::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
 {
 	for (uint32_t i = 0; i < PhysicalDevice.MemoryProperties.memoryTypeCount; i++)
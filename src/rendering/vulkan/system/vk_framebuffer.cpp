@@ -43,6 +43,7 @@
 #include "hwrenderer/data/flatvertices.h"
 #include "hwrenderer/data/shaderuniforms.h"
 #include "hwrenderer/dynlights/hw_lightbuffer.h"
+#include "hwrenderer/models/hw_bonebuffer.h"
 
 #include "swrenderer/r_swscene.h"
 
@@ -115,11 +116,15 @@ VulkanFrameBuffer::~VulkanFrameBuffer()
 	delete mSkyData;
 	delete mViewpoints;
 	delete mLights;
+	delete mBones;
 	mShadowMap.Reset();
 
 	screen = tmp;
 
 	DeleteFrameObjects();
+
+	// Postprocess shaders are compiled on first use
+	ShaderBuilder::saveCache();
 }
 
 void VulkanFrameBuffer::InitializeState()
@@ -158,6 +163,7 @@ void VulkanFrameBuffer::InitializeState()
 	mSkyData = new FSkyVertexBuffer;
 	mViewpoints = new HWViewpointBuffer;
 	mLights = new FLightBuffer();
+	mBones = new FBoneBuffer();
 
 	CreateFanToTrisIndexBuffer();
 
@@ -345,6 +351,7 @@ void VulkanFrameBuffer::WriteSavePic(player_t *player, FileWriter *file, int wid
 		GetRenderState()->SetVertexBuffer(screen->mVertexData);
 		screen->mVertexData->Reset();
 		screen->mLights->Clear();
+		screen->mBones->Clear();
 		screen->mViewpoints->Clear();
 
 		// This shouldn't overwrite the global viewpoint even for a short time.
@@ -397,6 +404,7 @@ sector_t *VulkanFrameBuffer::RenderView(player_t *player)
 		else r_viewpoint.TicFrac = I_GetTimeFrac();
 
 		screen->mLights->Clear();
+		screen->mBones->Clear();
 		screen->mViewpoints->Clear();
 
 		// NoInterpolateView should have no bearing on camera textures, but needs to be preserved for the main view below.
@@ -685,6 +693,7 @@ IDataBuffer *VulkanFrameBuffer::CreateDataBuffer(int bindingpoint, bool ssbo, bo
 	switch (bindingpoint)
 	{
 	case LIGHTBUF_BINDINGPOINT: LightBufferSSO = buffer; break;
+	case BONEBUF_BINDINGPOINT: BoneBufferSSO = buffer; break;
 	case VIEWPOINT_BINDINGPOINT: ViewpointUBO = buffer; break;
 	case LIGHTNODES_BINDINGPOINT: LightNodes = buffer; break;
 	case LIGHTLINES_BINDINGPOINT: LightLines = buffer; break;
@@ -42,6 +42,7 @@ public:
 
 	VKDataBuffer *ViewpointUBO = nullptr;
 	VKDataBuffer *LightBufferSSO = nullptr;
+	VKDataBuffer *BoneBufferSSO = nullptr;
 	VkStreamBuffer *MatrixBuffer = nullptr;
 	VkStreamBuffer *StreamBuffer = nullptr;
 
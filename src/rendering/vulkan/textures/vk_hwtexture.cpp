@@ -217,8 +217,20 @@ void VkHardwareTexture::CreateImage(FTexture *tex, int translation, int flags)
 			translation = remap == nullptr ? 0 : remap->GetUniqueIndex();
 		}
 
+		if (GetVulkanFrameBuffer()->device->UsedDeviceFeatures.textureCompressionBC)
+		{
+			flags |= CTF_AllowCompressed;
+		}
+
 		FTextureBuffer texbuffer = tex->CreateTexBuffer(translation, flags | CTF_ProcessData);
-		CreateTexture(texbuffer.mWidth, texbuffer.mHeight, 4, VK_FORMAT_B8G8R8A8_UNORM, texbuffer.mBuffer);
+		if (texbuffer.mFormat != TBF_BGRA8)
+		{
+			CreateCompressedTexture(texbuffer);
+		}
+		else
+		{
+			CreateTexture(texbuffer.mWidth, texbuffer.mHeight, 4, VK_FORMAT_B8G8R8A8_UNORM, texbuffer.mBuffer);
+		}
 	}
 	else
 	{
@@ -295,6 +307,68 @@ void VkHardwareTexture::CreateTexture(int w, int h, int pixelsize, VkFormat form
 	mImage.GenerateMipmaps(cmdbuffer);
 }
 
+// Block compressed buffers bring their own mip levels as the GPU cannot blit into these formats.
+void VkHardwareTexture::CreateCompressedTexture(const FTextureBuffer &texbuffer)
+{
+	static const VkFormat Formats[] = { VK_FORMAT_UNDEFINED, VK_FORMAT_BC1_RGBA_UNORM_BLOCK, VK_FORMAT_BC2_UNORM_BLOCK, VK_FORMAT_BC3_UNORM_BLOCK };
+
+	auto fb = GetVulkanFrameBuffer();
+	VkFormat format = Formats[texbuffer.mFormat];
+
+	std::vector<VkBufferImageCopy> regions;
+	int totalSize = 0;
+	for (int level = 0, w = texbuffer.mWidth, h = texbuffer.mHeight; level < texbuffer.mLevels; level++, w = std::max(w >> 1, 1), h = std::max(h >> 1, 1))
+	{
+		VkBufferImageCopy region = {};
+		region.bufferOffset = totalSize;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = level;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent.depth = 1;
+		region.imageExtent.width = w;
+		region.imageExtent.height = h;
+		regions.push_back(region);
+		totalSize += GetCompressedLevelSize(texbuffer.mFormat, w, h);
+	}
+
+	BufferBuilder bufbuilder;
+	bufbuilder.setSize(totalSize);
+	bufbuilder.setUsage(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+	std::unique_ptr<VulkanBuffer> stagingBuffer = bufbuilder.create(fb->device);
+	stagingBuffer->SetDebugName("VkHardwareTexture.mStagingBuffer");
+
+	uint8_t *data = (uint8_t*)stagingBuffer->Map(0, totalSize);
+	memcpy(data, texbuffer.mBuffer, totalSize);
+	stagingBuffer->Unmap();
+
+	ImageBuilder imgbuilder;
+	imgbuilder.setFormat(format);
+	imgbuilder.setSize(texbuffer.mWidth, texbuffer.mHeight, texbuffer.mLevels);
+	imgbuilder.setUsage(VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+	mImage.Image = imgbuilder.create(fb->device);
+	mImage.Image->SetDebugName("VkHardwareTexture.mImage");
+
+	ImageViewBuilder viewbuilder;
+	viewbuilder.setImage(mImage.Image.get(), format);
+	mImage.View = viewbuilder.create(fb->device);
+	mImage.View->SetDebugName("VkHardwareTexture.mImageView");
+
+	auto cmdbuffer = fb->GetTransferCommands();
+
+	PipelineBarrier barrier0;
+	barrier0.addImage(mImage.Image.get(), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_ASPECT_COLOR_BIT, 0, texbuffer.mLevels);
+	barrier0.execute(cmdbuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+	cmdbuffer->copyBufferToImage(stagingBuffer->buffer, mImage.Image->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)regions.size(), regions.data());
+
+	PipelineBarrier barrier1;
+	barrier1.addImage(mImage.Image.get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_ASPECT_COLOR_BIT, 0, texbuffer.mLevels);
+	barrier1.execute(cmdbuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+	mImage.Layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	fb->FrameDeleteList.Buffers.push_back(std::move(stagingBuffer));
+}
+
 int VkHardwareTexture::GetMipLevels(int w, int h)
 {
 	int levels = 1;
@@ -13,6 +13,7 @@
 #include "vk_imagetransition.h"
 
 struct FMaterialState;
+struct FTextureBuffer;
 class VulkanDescriptorSet;
 class VulkanImage;
 class VulkanImageView;
@@ -50,6 +51,7 @@ private:
 	void CreateImage(FTexture *tex, int translation, int flags);
 
 	void CreateTexture(int w, int h, int pixelsize, VkFormat format, const void *pixels);
+	void CreateCompressedTexture(const FTextureBuffer &texbuffer);
 	static int GetMipLevels(int w, int h);
 
 	void ResetDescriptors();
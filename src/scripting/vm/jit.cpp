@@ -6,9 +6,9 @@ extern PString *TypeString;
 extern PStruct *TypeVector2;
 extern PStruct *TypeVector3;
 
-static void OutputJitLog(const asmjit::StringLogger &logger);
+static void OutputJitLog(const asmjit::StringLogger &logger, FString *errors);
 
-JitFuncPtr JitCompile(VMScriptFunction *sfunc)
+JitFuncPtr JitCompile(VMScriptFunction *sfunc, FString *errors)
 {
 #if 0
 	if (strcmp(sfunc->PrintableName.GetChars(), "StatusScreen.drawNum") != 0)
@@ -30,8 +30,11 @@ JitFuncPtr JitCompile(VMScriptFunction *sfunc)
 	}
 	catch (const CRecoverableError &e)
 	{
-		OutputJitLog(logger);
-		Printf("%s: Unexpected JIT error: %s\n",sfunc->PrintableName.GetChars(), e.what());
+		OutputJitLog(logger, errors);
+		if (errors != nullptr)
+			errors->AppendFormat("%s: Unexpected JIT error: %s\n", sfunc->PrintableName.GetChars(), e.what());
+		else
+			Printf("%s: Unexpected JIT error: %s\n",sfunc->PrintableName.GetChars(), e.what());
 		return nullptr;
 	}
 }
@@ -66,8 +69,14 @@ void JitDumpLog(FILE *file, VMScriptFunction *sfunc)
 	}
 }
 
-static void OutputJitLog(const asmjit::StringLogger &logger)
+static void OutputJitLog(const asmjit::StringLogger &logger, FString *errors)
 {
+	if (errors != nullptr)
+	{
+		*errors << logger.getString() << "\n";
+		return;
+	}
+
 	// Write line by line since I_FatalError seems to cut off long strings
 	const char *pos = logger.getString();
 	const char *end = pos;
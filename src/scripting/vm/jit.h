@@ -3,6 +3,8 @@
 
 #include "vmintern.h"
 
-JitFuncPtr JitCompile(VMScriptFunction *func);
+// Safe to call from any thread as long as the function is not deleted meanwhile.
+// If errors is set, failures are written there instead of to the console.
+JitFuncPtr JitCompile(VMScriptFunction *func, FString *errors = nullptr);
 void JitDumpLog(FILE *file, VMScriptFunction *func);
 FString JitCaptureStackTrace(int framesToSkip, bool includeNativeFrames);
@@ -2,6 +2,7 @@
 #include "jitintern.h"
 #include <map>
 #include <memory>
+#include <mutex>
 
 void JitCompiler::EmitPARAM()
 {
@@ -58,6 +59,10 @@ void JitCompiler::EmitCALL_K()
 	{
 		EmitNativeCall(ntarget);
 	}
+	else if (target && !ntarget && CanInlineGetter(static_cast<VMScriptFunction *>(target)))
+	{
+		EmitInlineGetter(static_cast<VMScriptFunction *>(target));
+	}
 	else
 	{
 		auto ptr = newTempIntPtr();
@@ -68,6 +73,84 @@ void JitCompiler::EmitCALL_K()
 	pc += C; // Skip RESULTs
 }
 
+//===========================================================================
+//
+// Script functions that do nothing but return a field of 'self' or an
+// integer constant, like 'int GetHealth() { return health; }', are cheap
+// enough to copy into the caller. A VM call for them costs many times more
+// than the load itself.
+//
+//===========================================================================
+
+static int GetInlineLoadType(int op)
+{
+	switch (op)
+	{
+	case OP_LB: case OP_LBU: case OP_LH: case OP_LHU: case OP_LW: return REGT_INT;
+	case OP_LSP: case OP_LDP: return REGT_FLOAT;
+	default: return REGT_NIL;
+	}
+}
+
+bool JitCompiler::CanInlineGetter(VMScriptFunction *target)
+{
+	if (target->Code == nullptr || target->CodeSize < 1 || target->NumArgs != 1 || B != 1 || C != 1)
+		return false;
+	if (ParamOpcodes.Size() != 1 || ParamOpcodes[0]->op != OP_PARAM || ParamOpcodes[0]->a != REGT_POINTER)
+		return false;
+	if (pc > sfunc->Code && (pc - 1)->op == OP_VTBL)
+		return false;
+
+	const VMOP *result = pc + 1;
+	if (result->op != OP_RESULT)
+		return false;
+
+	const VMOP *code = target->Code;
+	if (code[0].op == OP_RETI)
+	{
+		return code[0].a == RET_FINAL && result->b == REGT_INT;
+	}
+
+	int type = GetInlineLoadType(code[0].op);
+	return type != REGT_NIL && target->CodeSize >= 2 && code[0].b == 0 &&
+		code[1].op == OP_RET && code[1].a == RET_FINAL && code[1].b == type && code[1].c == code[0].a &&
+		result->b == type;
+}
+
+void JitCompiler::EmitInlineGetter(VMScriptFunction *target)
+{
+	using namespace asmjit;
+
+	const VMOP *code = target->Code;
+	int self = ParamOpcodes[0]->i16u;
+	int dest = (pc + 1)->c;
+
+	if (code[0].op == OP_RETI)
+	{
+		cc.mov(regD[dest], (int)code[0].i16);
+	}
+	else
+	{
+		EmitNullPointerThrow(self, X_READ_NIL);
+		int offset = target->KonstD[code[0].c];
+		switch (code[0].op)
+		{
+		case OP_LB: cc.movsx(regD[dest], x86::byte_ptr(regA[self], offset)); break;
+		case OP_LBU: cc.movzx(regD[dest], x86::byte_ptr(regA[self], offset)); break;
+		case OP_LH: cc.movsx(regD[dest], x86::word_ptr(regA[self], offset)); break;
+		case OP_LHU: cc.movzx(regD[dest], x86::word_ptr(regA[self], offset)); break;
+		case OP_LW: cc.mov(regD[dest], x86::dword_ptr(regA[self], offset)); break;
+		case OP_LSP:
+			cc.xorpd(regF[dest], regF[dest]);
+			cc.cvtss2sd(regF[dest], x86::dword_ptr(regA[self], offset));
+			break;
+		case OP_LDP: cc.movsd(regF[dest], x86::qword_ptr(regA[self], offset)); break;
+		}
+	}
+
+	ParamOpcodes.Clear();
+}
+
 void JitCompiler::EmitVMCall(asmjit::X86Gp vmfunc, VMFunction *target)
 {
 	using namespace asmjit;
@@ -566,6 +649,7 @@ void JitCompiler::EmitNativeCall(VMNativeFunction *target)
 }
 
 static std::map<FString, std::unique_ptr<TArray<uint8_t>>> argsCache;
+static std::mutex argsCacheMutex;
 
 asmjit::FuncSignature JitCompiler::CreateFuncSignature()
 {
@@ -681,8 +765,13 @@ asmjit::FuncSignature JitCompiler::CreateFuncSignature()
 	}
 
 	// FuncSignature only keeps a pointer to its args array. Store a copy of each args array variant.
-	std::unique_ptr<TArray<uint8_t>> &cachedArgs = argsCache[key];
-	if (!cachedArgs) cachedArgs.reset(new TArray<uint8_t>(args));
+	TArray<uint8_t> *cachedArgs;
+	{
+		std::unique_lock<std::mutex> lock(argsCacheMutex);
+		std::unique_ptr<TArray<uint8_t>> &entry = argsCache[key];
+		if (!entry) entry.reset(new TArray<uint8_t>(args));
+		cachedArgs = entry.get();
+	}
 
 	FuncSignature signature;
 	signature.init(CallConv::kIdHost, rettype, cachedArgs->Data(), cachedArgs->Size());
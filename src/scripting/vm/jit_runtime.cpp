@@ -1,5 +1,6 @@
 
 #include <memory>
+#include <mutex>
 #include "jit.h"
 #include "jitintern.h"
 
@@ -22,6 +23,9 @@ struct JitFuncInfo
 	void *end;
 };
 
+// Functions may get compiled on worker threads. Code generation only touches
+// the compiler's own state, everything below is guarded by JitMutex.
+static std::mutex JitMutex;
 static TArray<JitFuncInfo> JitDebugInfo;
 static TArray<uint8_t*> JitBlocks;
 static TArray<uint8_t*> JitFrames;
@@ -30,15 +34,11 @@ static size_t JitBlockSize = 0;
 
 asmjit::CodeInfo GetHostCodeInfo()
 {
-	static bool firstCall = true;
-	static asmjit::CodeInfo codeInfo;
-
-	if (firstCall)
+	static const asmjit::CodeInfo codeInfo = []()
 	{
 		asmjit::JitRuntime rt;
-		codeInfo = rt.getCodeInfo();
-		firstCall = false;
-	}
+		return rt.getCodeInfo();
+	}();
 
 	return codeInfo;
 }
@@ -273,6 +273,7 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 
 	codeSize = (codeSize + 15) / 16 * 16;
 
+	std::unique_lock<std::mutex> lock(JitMutex);
 	uint8_t *p = (uint8_t *)AllocJitMemory(codeSize + unwindInfoSize + functionTableSize);
 	if (!p)
 		return nullptr;
@@ -305,7 +306,7 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 	if (result == 0)
 		I_Error("RtlAddFunctionTable failed");
 
-	JitDebugInfo.Push({ compiler->GetScriptFunction()->PrintableName, compiler->GetScriptFunction()->SourceFileName, compiler->LineInfo, startaddr, endaddr });
+	JitDebugInfo.Push({ compiler->GetScriptFunction()->PrintableName.GetChars(), compiler->GetScriptFunction()->SourceFileName.GetChars(), compiler->LineInfo, startaddr, endaddr });
 #endif
 
 	return p;
@@ -664,6 +665,7 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 
 	codeSize = (codeSize + 15) / 16 * 16;
 
+	std::unique_lock<std::mutex> lock(JitMutex);
 	uint8_t *p = (uint8_t *)AllocJitMemory(codeSize + unwindInfoSize);
 	if (!p)
 		return nullptr;
@@ -729,7 +731,7 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 #endif
 	}
 
-	JitDebugInfo.Push({ compiler->GetScriptFunction()->PrintableName, compiler->GetScriptFunction()->SourceFileName, compiler->LineInfo, startaddr, endaddr });
+	JitDebugInfo.Push({ compiler->GetScriptFunction()->PrintableName.GetChars(), compiler->GetScriptFunction()->SourceFileName.GetChars(), compiler->LineInfo, startaddr, endaddr });
 
 	return p;
 }
@@ -737,6 +739,7 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 
 void JitRelease()
 {
+	std::unique_lock<std::mutex> lock(JitMutex);
 #ifdef _WIN64
 	for (auto p : JitFrames)
 	{
@@ -931,6 +934,7 @@ int JITPCToLine(uint8_t *pc, const JitFuncInfo *info)
 
 FString JitGetStackFrameName(NativeSymbolResolver *nativeSymbols, void *pc)
 {
+	std::unique_lock<std::mutex> lock(JitMutex);
 	for (unsigned int i = 0; i < JitDebugInfo.Size(); i++)
 	{
 		const auto &info = JitDebugInfo[i];
@@ -61,6 +61,8 @@ private:
 	void EmitPopFrame();
 
 	void EmitNativeCall(VMNativeFunction *target);
+	bool CanInlineGetter(VMScriptFunction *target);
+	void EmitInlineGetter(VMScriptFunction *target);
 	void EmitVMCall(asmjit::X86Gp ptr, VMFunction *target);
 	void EmitVtbl(const VMOP *op);
 
@@ -54,6 +54,7 @@ extern FMemArena ClassDataAllocator;
 #define MAX_TRY_DEPTH	8	// Maximum number of nested TRYs in a single function
 
 void JitRelease();
+void JitWaitForBackground();
 
 
 typedef unsigned char		VM_UBYTE;
@@ -427,6 +428,8 @@ public:
 	void operator delete[](void *block) {}
 	static void DeleteAll()
 	{
+		// background compiles may still be reading the functions
+		JitWaitForBackground();
 		for (auto f : AllFunctions)
 		{
 			f->~VMFunction();
@@ -1999,6 +1999,8 @@ static void SetReturn(const VMRegisters &reg, VMFrame *frame, VMReturn *ret, VM_
 static int Exec(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret)
 {
 	VMCalls[0]++;
+	static_cast<VMScriptFunction*>(func)->CallCount++;
+	VMProfileScope profile(static_cast<VMScriptFunction*>(func));
 	VMFrameStack *stack = &GlobalVMStack;
 	VMFrame *newf = stack->AllocFrame(static_cast<VMScriptFunction*>(func));
 	VMFillParams(params, newf, numparams);
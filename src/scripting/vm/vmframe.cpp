@@ -33,6 +33,7 @@
 */
 
 #include <new>
+#include <algorithm>
 #include "dobject.h"
 #include "v_text.h"
 #include "stats.h"
@@ -43,6 +44,7 @@
 #include "jit.h"
 #include "c_cvars.h"
 #include "version.h"
+#include "jobsystem.h"
 
 #ifdef HAVE_VM_JIT
 CUSTOM_CVAR(Bool, vm_jit, true, CVAR_NOINITCALL)
@@ -50,6 +52,19 @@ CUSTOM_CVAR(Bool, vm_jit, true, CVAR_NOINITCALL)
 	Printf("You must restart " GAMENAME " for this change to take effect.\n");
 	Printf("This cvar is currently not saved. You must specify it on the command line.");
 }
+// Number of interpreted calls after which a function gets compiled. Most functions
+// only ever run a few times during startup and are not worth the compile time.
+CVAR(Int, vm_jit_threshold, 10, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+// Compile on the worker threads. The function keeps being interpreted until its code is ready.
+CVAR(Bool, vm_jit_background, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+// JitWaitForBackground drains this before the functions are deleted at
+// shutdown, so nothing is pending anymore when static objects get destroyed.
+static FJobGroup &JitJobs()
+{
+	static FJobGroup jobs;
+	return jobs;
+}
 #else
 CVAR(Bool, vm_jit, false, CVAR_NOINITCALL|CVAR_NOSET)
 FString JitCaptureStackTrace(int framesToSkip, bool includeNativeFrames) { return FString(); }
@@ -59,6 +74,11 @@ void JitRelease() {}
 cycle_t VMCycles[10];
 int VMCalls[10];
 
+bool VMProfiling;
+static double JitTimeMS;
+static int JitCount;
+static int JitPending;
+
 #if 0
 IMPLEMENT_CLASS(VMException, false, false)
 #endif
@@ -130,6 +150,7 @@ VMScriptFunction::VMScriptFunction(FName name)
 	NumKonstA = 0;
 	MaxParam = 0;
 	NumArgs = 0;
+	ProfileCycles.Reset();
 	ScriptCall = &VMScriptFunction::FirstScriptCall;
 }
 
@@ -278,14 +299,115 @@ static bool CanJit(VMScriptFunction *func)
 	return false;
 }
 
+//==========================================================================
+//
+// Compiled functions run through this instead of their code while
+// vmprofile is running. The interpreter times itself.
+//
+//==========================================================================
+
+static int ProfiledJitCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret)
+{
+	auto sfunc = static_cast<VMScriptFunction*>(func);
+	VMProfileScope profile(sfunc);
+	return sfunc->JitCall(func, params, numparams, ret, numret);
+}
+
+#ifdef HAVE_VM_JIT
+//==========================================================================
+//
+// Functions that can be compiled start out in the interpreter, which
+// counts their calls. Once they exceeded vm_jit_threshold they get compiled
+// and callers pick up the new entry point with their next call.
+//
+// Compiling happens on the worker threads. Only the main thread ever
+// changes ScriptCall, once it sees the finished code here.
+//
+//==========================================================================
+
+static void InstallJitCode(VMScriptFunction *sfunc)
+{
+	if (sfunc->JitErrors.IsNotEmpty())
+	{
+		Printf("%s", sfunc->JitErrors.GetChars());
+		sfunc->JitErrors = "";
+	}
+	JitTimeMS += sfunc->JitTimeMS;
+
+	if (sfunc->JitCall != nullptr)
+	{
+		JitCount++;
+		sfunc->ScriptCall = VMProfiling ? ProfiledJitCall : sfunc->JitCall;
+	}
+	else
+	{
+		sfunc->ScriptCall = VMExec;
+	}
+}
+
+static void CompileScriptFunction(VMScriptFunction *sfunc)
+{
+	cycle_t time;
+	time.Reset();
+	time.Clock();
+	sfunc->JitCall = JitCompile(sfunc, &sfunc->JitErrors);
+	time.Unclock();
+	sfunc->JitTimeMS = time.TimeMS();
+}
+
+static int TieredScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret)
+{
+	auto sfunc = static_cast<VMScriptFunction*>(func);
+	if (sfunc->JitQueued)
+	{
+		if (sfunc->JitDone.load(std::memory_order_acquire))
+		{
+			JitPending--;
+			InstallJitCode(sfunc);
+			return func->ScriptCall(func, params, numparams, ret, numret);
+		}
+	}
+	else if (sfunc->CallCount >= (unsigned)MAX(0, *vm_jit_threshold))
+	{
+		if (!vm_jit_background)
+		{
+			CompileScriptFunction(sfunc);
+			InstallJitCode(sfunc);
+			return func->ScriptCall(func, params, numparams, ret, numret);
+		}
+
+		sfunc->JitQueued = true;
+		JitPending++;
+		JitJobs().Run([=]()
+		{
+			CompileScriptFunction(sfunc);
+			sfunc->JitDone.store(true, std::memory_order_release);
+		});
+	}
+	return VMExec(func, params, numparams, ret, numret);
+}
+#endif // HAVE_VM_JIT
+
+//==========================================================================
+//
+// Functions must not be deleted while a worker is still compiling them.
+//
+//==========================================================================
+
+void JitWaitForBackground()
+{
+#ifdef HAVE_VM_JIT
+	JitJobs().Wait();
+	JitPending = 0;
+#endif
+}
+
 int VMScriptFunction::FirstScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret)
 {
 #ifdef HAVE_VM_JIT
 	if (vm_jit && CanJit(static_cast<VMScriptFunction*>(func)))
 	{
-		func->ScriptCall = JitCompile(static_cast<VMScriptFunction*>(func));
-		if (!func->ScriptCall)
-			func->ScriptCall = VMExec;
+		func->ScriptCall = TieredScriptCall;
 	}
 	else
 #endif // HAVE_VM_JIT
@@ -769,3 +891,100 @@ CCMD(vmengine)
 	Printf("Usage: vmengine <default|checked|unchecked>\n");
 }
 
+//-----------------------------------------------------------------------------
+//
+// vmprofile start|stop|clear|[count]
+//
+// Call counts and inclusive time per script function. Small getters the
+// JIT copied into their callers do not show up.
+//
+//-----------------------------------------------------------------------------
+
+// Until a background compile was picked up by the main thread JitCall may
+// still be written by the worker.
+static bool IsJitInstalled(VMScriptFunction *sfunc)
+{
+#ifdef HAVE_VM_JIT
+	if (sfunc->ScriptCall == TieredScriptCall) return false;
+#endif
+	return sfunc->JitCall != nullptr;
+}
+
+static void SetProfiling(bool on)
+{
+	VMProfiling = on;
+	for (auto func : VMFunction::AllFunctions)
+	{
+		if (func->VarFlags & VARF_Native) continue;
+		auto sfunc = static_cast<VMScriptFunction*>(func);
+		if (IsJitInstalled(sfunc))
+		{
+			sfunc->ScriptCall = on ? ProfiledJitCall : sfunc->JitCall;
+		}
+	}
+}
+
+CCMD(vmprofile)
+{
+	if (argv.argc() >= 2 && !stricmp(argv[1], "start"))
+	{
+		for (auto func : VMFunction::AllFunctions)
+		{
+			if (func->VarFlags & VARF_Native) continue;
+			auto sfunc = static_cast<VMScriptFunction*>(func);
+			if (sfunc->ProfileDepth == 0)
+			{
+				sfunc->ProfileCalls = 0;
+				sfunc->ProfileCycles.Reset();
+			}
+		}
+		SetProfiling(true);
+		return;
+	}
+	if (argv.argc() >= 2 && !stricmp(argv[1], "stop"))
+	{
+		SetProfiling(false);
+		return;
+	}
+	if (argv.argc() >= 2 && !stricmp(argv[1], "clear"))
+	{
+		SetProfiling(false);
+		for (auto func : VMFunction::AllFunctions)
+		{
+			if (func->VarFlags & VARF_Native) continue;
+			auto sfunc = static_cast<VMScriptFunction*>(func);
+			sfunc->ProfileCalls = 0;
+			sfunc->ProfileCycles.Reset();
+		}
+		return;
+	}
+
+	int count = argv.argc() >= 2 ? atoi(argv[1]) : 30;
+	if (count <= 0)
+	{
+		Printf("Usage: vmprofile <start|stop|clear|count>\n");
+		return;
+	}
+
+	TArray<VMScriptFunction *> funcs;
+	for (auto func : VMFunction::AllFunctions)
+	{
+		if (func->VarFlags & VARF_Native) continue;
+		auto sfunc = static_cast<VMScriptFunction*>(func);
+		if (sfunc->ProfileCalls > 0) funcs.Push(sfunc);
+	}
+	std::sort(funcs.begin(), funcs.end(), [](VMScriptFunction *a, VMScriptFunction *b)
+	{
+		return a->ProfileCycles.TimeMS() > b->ProfileCycles.TimeMS();
+	});
+
+	Printf("%-10s %10s %10s  %s\n", "calls", "ms", "us/call", "function");
+	for (unsigned i = 0; i < funcs.Size() && i < (unsigned)count; i++)
+	{
+		auto sfunc = funcs[i];
+		double ms = sfunc->ProfileCycles.TimeMS();
+		Printf("%-10llu %10.3f %10.3f  %s%s\n", (unsigned long long)sfunc->ProfileCalls, ms, ms * 1000. / sfunc->ProfileCalls,
+			sfunc->PrintableName.GetChars(), IsJitInstalled(sfunc) ? "" : TEXTCOLOR_GRAY " (interpreted)");
+	}
+	Printf("%d functions compiled in %.3f ms, %d pending%s\n", JitCount, JitTimeMS, JitPending, VMProfiling ? ", profiling" : "");
+}
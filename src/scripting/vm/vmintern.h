@@ -1,6 +1,8 @@
 #pragma once
 
 #include "vm.h"
+#include "stats.h"
+#include <atomic>
 #include <csetjmp>
 
 class VMScriptFunction;
@@ -473,6 +475,22 @@ public:
 	VM_UBYTE NumArgs;		// Number of arguments this function takes
 	TArray<FTypeAndOffset> SpecialInits;	// list of all contents on the extra stack which require construction and destruction
 
+	JitFuncPtr JitCall = nullptr;	// compiled code, once the function got hot enough
+	unsigned CallCount = 0;			// calls through the interpreter
+
+	// Set when the function was handed to a background compile. The worker
+	// sets JitDone after it wrote JitCall and JitErrors, only the main thread
+	// then installs the result.
+	bool JitQueued = false;
+	std::atomic<bool> JitDone = { false };
+	FString JitErrors;
+	double JitTimeMS = 0;
+
+	// Collected while vmprofile is running.
+	uint64_t ProfileCalls = 0;
+	int ProfileDepth = 0;
+	cycle_t ProfileCycles;
+
 	void InitExtra(void *addr);
 	void DestroyExtra(void *addr);
 	int AllocExtraStack(PType *type);
@@ -481,3 +499,26 @@ public:
 private:
 	static int FirstScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret);
 };
+
+extern bool VMProfiling;
+
+// Times a script function call while vmprofile is running. Only the
+// outermost call of a recursion is clocked so that time is not counted twice.
+struct VMProfileScope
+{
+	VMScriptFunction *Func;
+
+	VMProfileScope(VMScriptFunction *func) : Func(VMProfiling ? func : nullptr)
+	{
+		if (Func != nullptr)
+		{
+			Func->ProfileCalls++;
+			if (Func->ProfileDepth++ == 0) Func->ProfileCycles.Clock();
+		}
+	}
+
+	~VMProfileScope()
+	{
+		if (Func != nullptr && --Func->ProfileDepth == 0) Func->ProfileCycles.Unclock();
+	}
+};
@@ -38,6 +38,8 @@
 #define RAPIDJSON_PARSE_DEFAULT_FLAGS kParseFullPrecisionFlag
 
 #include <zlib.h>
+#include <string>
+#include <unordered_map>
 #include "rapidjson/rapidjson.h"
 #include "rapidjson/writer.h"
 #include "rapidjson/prettywriter.h"
@@ -139,6 +141,299 @@ struct FJSONObject
 	}
 };
 
+//==========================================================================
+//
+// Binary format
+//
+// A compact encoding of the same event stream the JSON writer gets, so
+// that the reader can build the exact same document from it without
+// having to format and parse any text. Integers are stored as varints,
+// doubles verbatim and each distinct key only once; later occurrences
+// refer to it by index.
+//
+//==========================================================================
+
+static const char BinaryMagic[] = { 'G', 'Z', 'B', 'S', 1 };
+
+enum EBinaryTag : uint8_t
+{
+	BIN_NULL,
+	BIN_FALSE,
+	BIN_TRUE,
+	BIN_INT,		// zigzag varint
+	BIN_UINT,		// varint
+	BIN_DOUBLE,		// 8 bytes, little endian
+	BIN_STRING,		// varint length + data
+	BIN_KEY,		// varint length + data, gets added to the key table
+	BIN_KEYREF,		// varint index into the key table
+	BIN_STARTOBJECT,
+	BIN_ENDOBJECT,
+	BIN_STARTARRAY,
+	BIN_ENDARRAY,
+};
+
+struct FBinaryWriter
+{
+	rapidjson::StringBuffer &mOut;
+	std::unordered_map<std::string, unsigned> mKeys;
+	std::string mKeyBuffer;
+
+	FBinaryWriter(rapidjson::StringBuffer &out) : mOut(out)
+	{
+		for (auto c : BinaryMagic) mOut.Put(c);
+	}
+
+	void Tag(EBinaryTag tag)
+	{
+		mOut.Put((char)tag);
+	}
+
+	void Varint(uint64_t v)
+	{
+		while (v >= 0x80)
+		{
+			mOut.Put((char)(v | 0x80));
+			v >>= 7;
+		}
+		mOut.Put((char)v);
+	}
+
+	void Data(const char *k, size_t len)
+	{
+		Varint(len);
+		memcpy(mOut.Push(len), k, len);
+	}
+
+	void StartObject() { Tag(BIN_STARTOBJECT); }
+	void EndObject() { Tag(BIN_ENDOBJECT); }
+	void StartArray() { Tag(BIN_STARTARRAY); }
+	void EndArray() { Tag(BIN_ENDARRAY); }
+	void Null() { Tag(BIN_NULL); }
+	void Bool(bool k) { Tag(k ? BIN_TRUE : BIN_FALSE); }
+	void Int(int32_t k) { Int64(k); }
+	void Uint(uint32_t k) { Uint64(k); }
+
+	void Int64(int64_t k)
+	{
+		Tag(BIN_INT);
+		Varint(((uint64_t)k << 1) ^ (uint64_t)(k >> 63));
+	}
+
+	void Uint64(uint64_t k)
+	{
+		Tag(BIN_UINT);
+		Varint(k);
+	}
+
+	void Double(double k)
+	{
+		uint64_t bits;
+		memcpy(&bits, &k, 8);
+		Tag(BIN_DOUBLE);
+		for (int i = 0; i < 8; i++, bits >>= 8) mOut.Put((char)bits);
+	}
+
+	void String(const char *k)
+	{
+		Tag(BIN_STRING);
+		Data(k, strlen(k));
+	}
+
+	void Key(const char *k)
+	{
+		mKeyBuffer = k;
+		auto it = mKeys.find(mKeyBuffer);
+		if (it != mKeys.end())
+		{
+			Tag(BIN_KEYREF);
+			Varint(it->second);
+		}
+		else
+		{
+			unsigned index = (unsigned)mKeys.size();
+			mKeys.emplace(mKeyBuffer, index);
+			Tag(BIN_KEY);
+			Data(k, mKeyBuffer.length());
+		}
+	}
+};
+
+//==========================================================================
+//
+// Generator for rapidjson::Document::Populate. Since the document gets
+// built by the same handler calls the JSON parser makes, the result is
+// indistinguishable from reading the JSON version of the same data.
+// Any inconsistency in the stream makes the whole read fail, just like
+// a JSON syntax error would.
+//
+//==========================================================================
+
+struct FBinaryReader
+{
+	struct Container
+	{
+		bool isObject;
+		bool haveKey;
+		unsigned count;
+	};
+
+	const uint8_t *mPos, *mEnd;
+	TArray<std::pair<const char *, unsigned>> mKeys;
+	TArray<Container> mStack;
+
+	static bool IsBinary(const char *buffer, size_t length)
+	{
+		return length >= sizeof(BinaryMagic) && !memcmp(buffer, BinaryMagic, sizeof(BinaryMagic));
+	}
+
+	FBinaryReader(const char *buffer, size_t length)
+	{
+		mPos = (const uint8_t *)buffer + sizeof(BinaryMagic);
+		mEnd = (const uint8_t *)buffer + length;
+	}
+
+	bool Varint(uint64_t &v)
+	{
+		v = 0;
+		for (int shift = 0; shift < 64 && mPos < mEnd; shift += 7)
+		{
+			uint8_t b = *mPos++;
+			v |= uint64_t(b & 0x7f) << shift;
+			if (!(b & 0x80)) return true;
+		}
+		return false;
+	}
+
+	bool Data(const char *&data, unsigned &len)
+	{
+		uint64_t l;
+		if (!Varint(l) || l > uint64_t(mEnd - mPos)) return false;
+		data = (const char *)mPos;
+		len = (unsigned)l;
+		mPos += l;
+		return true;
+	}
+
+	// Checks that a value is allowed at this point and counts it.
+	bool Value()
+	{
+		if (mStack.Size() == 0) return false;
+		auto &top = mStack.Last();
+		if (top.isObject)
+		{
+			if (!top.haveKey) return false;
+			top.haveKey = false;
+		}
+		top.count++;
+		return true;
+	}
+
+	template<class Handler>
+	bool operator()(Handler &h)
+	{
+		bool root = true;
+		while (mPos < mEnd)
+		{
+			uint8_t tag = *mPos++;
+			bool ok;
+			const char *data;
+			unsigned len;
+			uint64_t v;
+
+			if (tag == BIN_ENDOBJECT || tag == BIN_ENDARRAY)
+			{
+				if (mStack.Size() == 0 || mStack.Last().isObject != (tag == BIN_ENDOBJECT) || mStack.Last().haveKey) return false;
+				unsigned count = mStack.Last().count;
+				mStack.Pop();
+				if (!(tag == BIN_ENDOBJECT ? h.EndObject(count) : h.EndArray(count))) return false;
+				if (mStack.Size() == 0) return mPos == mEnd;
+				continue;
+			}
+			if (tag == BIN_KEY || tag == BIN_KEYREF)
+			{
+				if (mStack.Size() == 0 || !mStack.Last().isObject || mStack.Last().haveKey) return false;
+				if (tag == BIN_KEY)
+				{
+					if (!Data(data, len)) return false;
+					mKeys.Push(std::make_pair(data, len));
+				}
+				else
+				{
+					if (!Varint(v) || v >= mKeys.Size()) return false;
+					data = mKeys[(unsigned)v].first;
+					len = mKeys[(unsigned)v].second;
+				}
+				mStack.Last().haveKey = true;
+				if (!h.Key(data, len, true)) return false;
+				continue;
+			}
+
+			// everything else is a value.
+			if (root)
+			{
+				if (tag != BIN_STARTOBJECT && tag != BIN_STARTARRAY) return false;
+				root = false;
+			}
+			else if (!Value()) return false;
+
+			switch (tag)
+			{
+			case BIN_NULL:
+				ok = h.Null();
+				break;
+
+			case BIN_FALSE:
+			case BIN_TRUE:
+				ok = h.Bool(tag == BIN_TRUE);
+				break;
+
+			case BIN_INT:
+			{
+				if (!Varint(v)) return false;
+				int64_t i = int64_t(v >> 1) ^ -int64_t(v & 1);
+				// Use the same handler calls as the JSON parser so that the values get the same type flags.
+				if (i >= 0) ok = i <= UINT_MAX ? h.Uint((unsigned)i) : h.Uint64(i);
+				else ok = i >= INT_MIN ? h.Int((int)i) : h.Int64(i);
+				break;
+			}
+
+			case BIN_UINT:
+				if (!Varint(v)) return false;
+				ok = v <= UINT_MAX ? h.Uint((unsigned)v) : h.Uint64(v);
+				break;
+
+			case BIN_DOUBLE:
+			{
+				if (mEnd - mPos < 8) return false;
+				uint64_t bits = 0;
+				for (int i = 7; i >= 0; i--) bits = (bits << 8) | mPos[i];
+				mPos += 8;
+				double d;
+				memcpy(&d, &bits, 8);
+				ok = h.Double(d);
+				break;
+			}
+
+			case BIN_STRING:
+				if (!Data(data, len)) return false;
+				ok = h.String(data, len, true);
+				break;
+
+			case BIN_STARTOBJECT:
+			case BIN_STARTARRAY:
+				mStack.Push({ tag == BIN_STARTOBJECT, false, 0 });
+				ok = tag == BIN_STARTOBJECT ? h.StartObject() : h.StartArray();
+				break;
+
+			default:
+				return false;
+			}
+			if (!ok) return false;
+		}
+		return false;	// ran out of data before the root was closed.
+	}
+};
+
 //==========================================================================
 //
 // some wrapper stuff to keep the RapidJSON dependencies out of the global headers.
@@ -151,23 +446,26 @@ struct FWriter
 	typedef rapidjson::Writer<rapidjson::StringBuffer, rapidjson::UTF8<> > Writer;
 	typedef rapidjson::PrettyWriter<rapidjson::StringBuffer, rapidjson::UTF8<> > PrettyWriter;
 
-	Writer *mWriter1;
-	PrettyWriter *mWriter2;
+	Writer *mWriter1 = nullptr;
+	PrettyWriter *mWriter2 = nullptr;
+	FBinaryWriter *mWriter3 = nullptr;
 	TArray<bool> mInObject;
 	rapidjson::StringBuffer mOutString;
 	TArray<DObject *> mDObjects;
 	TMap<DObject *, int> mObjectMap;
 	
-	FWriter(bool pretty)
+	FWriter(bool pretty, bool binary = false)
 	{
-		if (!pretty)
+		if (binary)
+		{
+			mWriter3 = new FBinaryWriter(mOutString);
+		}
+		else if (!pretty)
 		{
 			mWriter1 = new Writer(mOutString);
-			mWriter2 = nullptr;
 		}
 		else
 		{
-			mWriter1 = nullptr;
 			mWriter2 = new PrettyWriter(mOutString);
 		}
 	}
@@ -176,6 +474,7 @@ struct FWriter
 	{
 		if (mWriter1) delete mWriter1;
 		if (mWriter2) delete mWriter2;
+		if (mWriter3) delete mWriter3;
 	}
 
 
@@ -188,36 +487,42 @@ struct FWriter
 	{
 		if (mWriter1) mWriter1->StartObject();
 		else if (mWriter2) mWriter2->StartObject();
+		else if (mWriter3) mWriter3->StartObject();
 	}
 
 	void EndObject()
 	{
 		if (mWriter1) mWriter1->EndObject();
 		else if (mWriter2) mWriter2->EndObject();
+		else if (mWriter3) mWriter3->EndObject();
 	}
 
 	void StartArray()
 	{
 		if (mWriter1) mWriter1->StartArray();
 		else if (mWriter2) mWriter2->StartArray();
+		else if (mWriter3) mWriter3->StartArray();
 	}
 
 	void EndArray()
 	{
 		if (mWriter1) mWriter1->EndArray();
 		else if (mWriter2) mWriter2->EndArray();
+		else if (mWriter3) mWriter3->EndArray();
 	}
 
 	void Key(const char *k)
 	{
 		if (mWriter1) mWriter1->Key(k);
 		else if (mWriter2) mWriter2->Key(k);
+		else if (mWriter3) mWriter3->Key(k);
 	}
 
 	void Null()
 	{
 		if (mWriter1) mWriter1->Null();
 		else if (mWriter2) mWriter2->Null();
+		else if (mWriter3) mWriter3->Null();
 	}
 
 	void StringU(const char *k, bool encode)
@@ -225,6 +530,7 @@ struct FWriter
 		if (encode) k = StringToUnicode(k);
 		if (mWriter1) mWriter1->String(k);
 		else if (mWriter2) mWriter2->String(k);
+		else if (mWriter3) mWriter3->String(k);
 	}
 
 	void String(const char *k)
@@ -232,6 +538,7 @@ struct FWriter
 		k = StringToUnicode(k);
 		if (mWriter1) mWriter1->String(k);
 		else if (mWriter2) mWriter2->String(k);
+		else if (mWriter3) mWriter3->String(k);
 	}
 
 	void String(const char *k, int size)
@@ -239,36 +546,42 @@ struct FWriter
 		k = StringToUnicode(k, size);
 		if (mWriter1) mWriter1->String(k);
 		else if (mWriter2) mWriter2->String(k);
+		else if (mWriter3) mWriter3->String(k);
 	}
 
 	void Bool(bool k)
 	{
 		if (mWriter1) mWriter1->Bool(k);
 		else if (mWriter2) mWriter2->Bool(k);
+		else if (mWriter3) mWriter3->Bool(k);
 	}
 
 	void Int(int32_t k)
 	{
 		if (mWriter1) mWriter1->Int(k);
 		else if (mWriter2) mWriter2->Int(k);
+		else if (mWriter3) mWriter3->Int(k);
 	}
 
 	void Int64(int64_t k)
 	{
 		if (mWriter1) mWriter1->Int64(k);
 		else if (mWriter2) mWriter2->Int64(k);
+		else if (mWriter3) mWriter3->Int64(k);
 	}
 
 	void Uint(uint32_t k)
 	{
 		if (mWriter1) mWriter1->Uint(k);
 		else if (mWriter2) mWriter2->Uint(k);
+		else if (mWriter3) mWriter3->Uint(k);
 	}
 
 	void Uint64(int64_t k)
 	{
 		if (mWriter1) mWriter1->Uint64(k);
 		else if (mWriter2) mWriter2->Uint64(k);
+		else if (mWriter3) mWriter3->Uint64(k);
 	}
 
 	void Double(double k)
@@ -281,6 +594,10 @@ struct FWriter
 		{
 			mWriter2->Double(k);
 		}
+		else if (mWriter3)
+		{
+			mWriter3->Double(k);
+		}
 	}
 
 };
@@ -301,7 +618,15 @@ struct FReader
 
 	FReader(const char *buffer, size_t length)
 	{
-		mDoc.Parse(buffer, length);
+		if (FBinaryReader::IsBinary(buffer, length))
+		{
+			FBinaryReader reader(buffer, length);
+			mDoc.Populate(reader);
+		}
+		else
+		{
+			mDoc.Parse(buffer, length);
+		}
 		mObjects.Push(FJSONObject(&mDoc));
 	}
 
@@ -351,6 +676,23 @@ bool FSerializer::OpenWriter(bool pretty)
 	return true;
 }
 
+//==========================================================================
+//
+// Writes the compact binary format instead of JSON. The readers detect
+// it on their own, so nothing else needs to know which one was used.
+//
+//==========================================================================
+
+bool FSerializer::OpenBinaryWriter()
+{
+	if (w != nullptr || r != nullptr) return false;
+
+	mErrors = 0;
+	w = new FWriter(false, true);
+	BeginObject(nullptr);
+	return true;
+}
+
 //==========================================================================
 //
 //
@@ -1040,57 +1382,31 @@ const char *FSerializer::GetOutput(unsigned *len)
 //==========================================================================
 
 FCompressedBuffer FSerializer::GetCompressedOutput()
+{
+	FCompressedBuffer buff = GetStoredOutput();
+	buff.Compress();
+	return buff;
+}
+
+//==========================================================================
+//
+// Returns the output uncompressed so that the compression can be done
+// later, e.g. on another thread. The CRC gets calculated by Compress.
+//
+//==========================================================================
+
+FCompressedBuffer FSerializer::GetStoredOutput()
 {
 	if (isReading()) return{ 0,0,0,0,0,nullptr };
 	FCompressedBuffer buff;
 	WriteObjects();
 	EndObject();
-	buff.mSize = (unsigned)w->mOutString.GetSize();
+	buff.mSize = buff.mCompressedSize = (unsigned)w->mOutString.GetSize();
 	buff.mZipFlags = 0;
-	buff.mCRC32 = crc32(0, (const Bytef*)w->mOutString.GetString(), buff.mSize);
-
-	uint8_t *compressbuf = new uint8_t[buff.mSize+1];
-
-	z_stream stream;
-	int err;
-
-	stream.next_in = (Bytef *)w->mOutString.GetString();
-	stream.avail_in = buff.mSize;
-	stream.next_out = (Bytef*)compressbuf;
-	stream.avail_out = buff.mSize;
-	stream.zalloc = (alloc_func)0;
-	stream.zfree = (free_func)0;
-	stream.opaque = (voidpf)0;
-
-	// create output in zip-compatible form as required by FCompressedBuffer
-	err = deflateInit2(&stream, 8, Z_DEFLATED, -15, 9, Z_DEFAULT_STRATEGY);
-	if (err != Z_OK)
-	{
-		goto error;
-	}
-
-	err = deflate(&stream, Z_FINISH);
-	if (err != Z_STREAM_END) 
-	{
-		deflateEnd(&stream);
-		goto error;
-	}
-	buff.mCompressedSize = stream.total_out;
-
-	err = deflateEnd(&stream);
-	if (err == Z_OK)
-	{
-		buff.mBuffer = new char[buff.mCompressedSize];
-		buff.mMethod = METHOD_DEFLATE;
-		memcpy(buff.mBuffer, compressbuf, buff.mCompressedSize);
-		delete[] compressbuf;
-		return buff;
-	}
-
-error:
-	memcpy(compressbuf, w->mOutString.GetString(), buff.mSize + 1);
-	buff.mCompressedSize = buff.mSize;
+	buff.mCRC32 = 0;
 	buff.mMethod = METHOD_STORED;
+	buff.mBuffer = new char[buff.mSize + 1];
+	memcpy(buff.mBuffer, w->mOutString.GetString(), buff.mSize + 1);
 	return buff;
 }
 
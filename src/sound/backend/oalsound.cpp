@@ -32,6 +32,7 @@
 **
 */
 
+#include <algorithm>
 #include <functional>
 #include <chrono>
 
@@ -924,14 +925,14 @@ void OpenALSoundRenderer::SetSfxVolume(float volume)
 			ALuint source = GET_PTRID(schan->SysChannel);
 			volume = SfxVolume;
 
-			alDeferUpdatesSOFT();
+			DeferUpdates();
 			alSourcef(source, AL_MAX_GAIN, volume);
 			alSourcef(source, AL_GAIN, volume * schan->Volume);
 		}
 		schan = schan->NextChan;
 	}
 
-	alProcessUpdatesSOFT();
+	ProcessUpdates();
 
 	getALError();
 }
@@ -1438,6 +1439,7 @@ FISoundChannel *OpenALSoundRenderer::StartSound(SoundHandle sfx, float vol, int
 	FISoundChannel *chan = reuse_chan;
 	if(!chan) chan = soundEngine->GetChannel(MAKE_PTRID(source));
 	else chan->SysChannel = MAKE_PTRID(source);
+	NewVoices.Push(chan);
 
 	chan->Rolloff.RolloffType = ROLLOFF_Log;
 	chan->Rolloff.RolloffFactor = 0.f;
@@ -1649,6 +1651,7 @@ FISoundChannel *OpenALSoundRenderer::StartSound3D(SoundHandle sfx, SoundListener
 	FISoundChannel *chan = reuse_chan;
 	if(!chan) chan = soundEngine->GetChannel(MAKE_PTRID(source));
 	else chan->SysChannel = MAKE_PTRID(source);
+	NewVoices.Push(chan);
 
 	chan->Rolloff = *rolloff;
 	chan->DistanceSqr = dist_sqr;
@@ -1662,7 +1665,7 @@ void OpenALSoundRenderer::ChannelVolume(FISoundChannel *chan, float volume)
 	if(chan == NULL || chan->SysChannel == NULL)
 		return;
 
-	alDeferUpdatesSOFT();
+	DeferUpdates();
 
 	ALuint source = GET_PTRID(chan->SysChannel);
 	alSourcef(source, AL_GAIN, SfxVolume * volume);
@@ -1673,7 +1676,7 @@ void OpenALSoundRenderer::ChannelPitch(FISoundChannel *chan, float pitch)
 	if (chan == NULL || chan->SysChannel == NULL)
 		return;
 
-	alDeferUpdatesSOFT();
+	DeferUpdates();
 
 	ALuint source = GET_PTRID(chan->SysChannel);
 	if (WasInWater && !(chan->ChanFlags & CHANF_UI))
@@ -1869,7 +1872,7 @@ void OpenALSoundRenderer::UpdateSoundParams3D(SoundListener *listener, FISoundCh
 	}
 	dir += listener->position;
 
-	alDeferUpdatesSOFT();
+	DeferUpdates();
 	ALuint source = GET_PTRID(chan->SysChannel);
 
 	if(chan->DistanceSqr < (0.0004f*0.0004f))
@@ -1891,7 +1894,7 @@ void OpenALSoundRenderer::UpdateListener(SoundListener *listener)
 	if(!listener->valid)
 		return;
 
-	alDeferUpdatesSOFT();
+	DeferUpdates();
 
 	float angle = listener->angle;
 	ALfloat orient[6];
@@ -2015,7 +2018,12 @@ void OpenALSoundRenderer::UpdateListener(SoundListener *listener)
 
 void OpenALSoundRenderer::UpdateSounds()
 {
-	alProcessUpdatesSOFT();
+	ProcessUpdates();
+
+	// Priorities and distances were updated, so the next channel that needs
+	// a source rebuilds the heap. Frames without one don't pay for it.
+	VoicesStale = true;
+	NewVoices.Clear();
 
 	if(!FadingSources.empty())
 	{
@@ -2297,22 +2305,52 @@ void OpenALSoundRenderer::LoadReverb(const ReverbContainer *env)
 	getALError();
 }
 
-FSoundChan *OpenALSoundRenderer::FindLowestChannel()
+void OpenALSoundRenderer::AddVoice(FSoundChan *chan)
 {
-	FSoundChan *schan = soundEngine->GetChannels();
-	FSoundChan *lowest = NULL;
-	while(schan)
+	if(chan->SysChannel != NULL)
+	{
+		Voices.Push({ chan, chan->SysChannel, chan->Priority, chan->DistanceSqr });
+		std::push_heap(Voices.begin(), Voices.end());
+	}
+}
+
+void OpenALSoundRenderer::RebuildVoices()
+{
+	Voices.Clear();
+	NewVoices.Clear();
+	VoicesStale = false;
+	for(FSoundChan *schan = soundEngine->GetChannels();schan;schan = schan->NextChan)
 	{
 		if(schan->SysChannel != NULL)
-		{
-			if(!lowest || schan->Priority < lowest->Priority ||
-			   (schan->Priority == lowest->Priority &&
-				schan->DistanceSqr > lowest->DistanceSqr))
-				lowest = schan;
-		}
-		schan = schan->NextChan;
+			Voices.Push({ schan, schan->SysChannel, schan->Priority, schan->DistanceSqr });
+	}
+	std::make_heap(Voices.begin(), Voices.end());
+}
+
+FSoundChan *OpenALSoundRenderer::FindLowestChannel()
+{
+	if(VoicesStale)
+		RebuildVoices();
+
+	// The sound engine fills in the priority after the channel got started.
+	for(FISoundChannel *chan : NewVoices)
+		AddVoice(static_cast<FSoundChan*>(chan));
+	NewVoices.Clear();
+
+	while(Voices.Size() > 0)
+	{
+		FVoice top = Voices[0];
+		FSoundChan *schan = top.Chan;
+		if(schan->SysChannel == top.SysChannel && schan->Priority == top.Priority &&
+		   schan->DistanceSqr == top.DistanceSqr)
+			return schan;
+
+		std::pop_heap(Voices.begin(), Voices.end());
+		Voices.Pop();
+		if(schan->SysChannel == top.SysChannel)
+			AddVoice(schan);
 	}
-	return lowest;
+	return NULL;
 }
 
 
@@ -247,9 +247,46 @@ private:
 	void LoadReverb(const ReverbContainer *env);
 	void FreeSource(ALuint source);
 	void PurgeStoppedSources();
-	static FSoundChan *FindLowestChannel();
+	FSoundChan *FindLowestChannel();
 	void ForceStopChannel(FISoundChannel *chan);
 
+	// Source changes are collected until the next UpdateSounds.
+	void DeferUpdates()
+	{
+		if (!UpdatesDeferred)
+		{
+			alDeferUpdatesSOFT();
+			UpdatesDeferred = true;
+		}
+	}
+	void ProcessUpdates()
+	{
+		alProcessUpdatesSOFT();
+		UpdatesDeferred = false;
+	}
+
+	// Playing channels ordered by how little they would be missed, so the
+	// one that has to give up its source is found without walking every
+	// channel. The heap is only rebuilt when a source is needed and none is
+	// free, and then at most once per frame; channels started in between are
+	// added the next time it is used. Entries of channels that stopped or
+	// changed since are skipped.
+	struct FVoice
+	{
+		FSoundChan *Chan;
+		void *SysChannel;
+		int Priority;
+		float DistanceSqr;
+
+		// The most expendable voice ends up at the top.
+		bool operator<(const FVoice &other) const
+		{
+			return other.Priority < Priority || (other.Priority == Priority && other.DistanceSqr > DistanceSqr);
+		}
+	};
+	void AddVoice(FSoundChan *chan);
+	void RebuildVoices();
+
     std::thread StreamThread;
     std::mutex StreamLock;
     std::condition_variable StreamWake;
@@ -264,10 +301,14 @@ private:
 	ALfloat MusicVolume;
 
 	int SFXPaused;
+	bool UpdatesDeferred = false;
 	TArray<ALuint> FreeSfx;
 	TArray<ALuint> PausableSfx;
 	TArray<ALuint> ReverbSfx;
 	TArray<ALuint> SfxGroup;
+	TArray<FVoice> Voices;
+	TArray<FISoundChannel *> NewVoices;
+	bool VoicesStale = true;
 
 	int UpdateTimeMS;
 	using SourceTimeMap = std::unordered_map<ALuint,int64_t>;
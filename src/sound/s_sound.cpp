@@ -233,6 +233,7 @@ FSoundChan *SoundEngine::GetChannel(void *syschan)
 
 void SoundEngine::ReturnChannel(FSoundChan *chan)
 {
+	UnindexChannel(chan);
 	UnlinkChannel(chan);
 	memset(chan, 0, sizeof(*chan));
 	LinkChannel(chan, &FreeChannels);
@@ -270,6 +271,65 @@ void SoundEngine::LinkChannel(FSoundChan *chan, FSoundChan **head)
 	chan->PrevChan = head;
 }
 
+//==========================================================================
+//
+// SoundEngine::IndexChannel
+//
+// Lists the channel under its sound ID so that the channels playing a
+// specific sound can be found without going through all of them.
+//
+//==========================================================================
+
+void SoundEngine::IndexChannel(FSoundChan *chan)
+{
+	int id = chan->SoundID;
+	if (chan->IndexedID == id)
+	{
+		return;
+	}
+	UnindexChannel(chan);
+	if (id <= 0)
+	{
+		return;
+	}
+	if ((unsigned)id >= SoundChannels.Size())
+	{
+		unsigned oldsize = SoundChannels.Size();
+		SoundChannels.Resize(id + 1);
+		for (unsigned i = oldsize; i < SoundChannels.Size(); i++) SoundChannels[i] = nullptr;
+	}
+	chan->IndexedID = id;
+	chan->PrevSound = nullptr;
+	chan->NextSound = SoundChannels[id];
+	if (chan->NextSound != nullptr)
+	{
+		chan->NextSound->PrevSound = chan;
+	}
+	SoundChannels[id] = chan;
+}
+
+void SoundEngine::UnindexChannel(FSoundChan *chan)
+{
+	if (chan->IndexedID == 0)
+	{
+		return;
+	}
+	if (chan->PrevSound != nullptr)
+	{
+		chan->PrevSound->NextSound = chan->NextSound;
+	}
+	else
+	{
+		SoundChannels[chan->IndexedID] = chan->NextSound;
+	}
+	if (chan->NextSound != nullptr)
+	{
+		chan->NextSound->PrevSound = chan->PrevSound;
+	}
+	chan->NextSound = chan->PrevSound = nullptr;
+	chan->IndexedID = 0;
+}
+
 //==========================================================================
 //
 //
@@ -621,6 +681,7 @@ FSoundChan *SoundEngine::StartSound(int type, const void *source,
 		{
 			chan->Source = source;
 		}
+		IndexChannel(chan);
 
 		if (spitch > 0.0)
 			SetPitch(chan, spitch);
@@ -645,6 +706,9 @@ void SoundEngine::RestartChannel(FSoundChan *chan)
 	sfxinfo_t *sfx = &S_sfx[chan->SoundID];
 	FSoundLoadBuffer SoundBuffer;
 
+	// Channels restored from a savegame are not indexed yet.
+	IndexChannel(chan);
+
 	// If this is a singular sound, don't play it if it's already playing.
 	if (sfx->bSingular && CheckSingular(chan->SoundID))
 		return;
@@ -879,10 +943,15 @@ bool SoundEngine::CheckSoundLimit(sfxinfo_t *sfx, const FVector3 &pos, int near_
 {
 	FSoundChan *chan;
 	int count;
-	
-	for (chan = Channels, count = 0; chan != NULL && count < near_limit; chan = chan->NextChan)
+	unsigned id = unsigned(sfx - &S_sfx[0]);
+
+	if (id >= SoundChannels.Size())
+	{
+		return false;
+	}
+	for (chan = SoundChannels[id], count = 0; chan != NULL && count < near_limit; chan = chan->NextSound)
 	{
-		if (!(chan->ChanFlags & CHANF_EVICTED) && &S_sfx[chan->SoundID] == sfx)
+		if (!(chan->ChanFlags & CHANF_EVICTED))
 		{
 			FVector3 chanorigin;
 
@@ -166,6 +166,9 @@ struct FSoundChan : public FISoundChannel
 {
 	FSoundChan	*NextChan;	// Next channel in this list.
 	FSoundChan **PrevChan;	// Previous channel in this list.
+	FSoundChan	*NextSound;	// Next channel in the list of its sound ID.
+	FSoundChan	*PrevSound;	// Previous channel in the list of its sound ID.
+	int			IndexedID;	// Sound ID the channel is listed under, 0 if none.
 	FSoundID	SoundID;	// Sound ID of playing sound.
 	FSoundID	OrgID;		// Sound ID of sound used to start this channel.
 	float		Volume;
@@ -243,6 +246,7 @@ protected:
 
 	FSoundChan* Channels = nullptr;
 	FSoundChan* FreeChannels = nullptr;
+	TArray<FSoundChan*> SoundChannels;	// active channels by sound ID, newest first
 
 	// the complete set of sound effects
 	TArray<sfxinfo_t> S_sfx;
@@ -255,6 +259,8 @@ private:
 	void LoadSound3D(sfxinfo_t* sfx, FSoundLoadBuffer* pBuffer);
 	void LinkChannel(FSoundChan* chan, FSoundChan** head);
 	void UnlinkChannel(FSoundChan* chan);
+	void IndexChannel(FSoundChan* chan);
+	void UnindexChannel(FSoundChan* chan);
 	void ReturnChannel(FSoundChan* chan);
 	void RestartChannel(FSoundChan* chan);
 	void RestoreEvictedChannel(FSoundChan* chan);
@@ -25,8 +25,11 @@
 #ifdef _WIN32
 #include <direct.h>
 #include <io.h>
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
 #else
 #include <dirent.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <pwd.h>
@@ -228,6 +231,38 @@ bool GetFileInfo(const char* pathname, size_t *size, time_t *time)
 	return res;
 }
 
+//==========================================================================
+//
+// RenameFile
+//
+// Renames a file, replacing the destination if it exists. The destination
+// always refers to either the old or the new file, never to nothing, and
+// the rename is on the disk when this returns.
+//
+//==========================================================================
+
+bool RenameFile(const char *from, const char *to)
+{
+#ifndef _WIN32
+	if (rename(from, to) != 0)
+	{
+		return false;
+	}
+	// The rename is only durable once the directory has been synced. Not all
+	// file systems support this, so a failure here is not an error.
+	FString dir = ExtractFilePath(to);
+	int fd = open(dir.IsEmpty() ? "." : dir.GetChars(), O_RDONLY);
+	if (fd >= 0)
+	{
+		fsync(fd);
+		close(fd);
+	}
+	return true;
+#else
+	return MoveFileExW(WideString(from).c_str(), WideString(to).c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#endif
+}
+
 //==========================================================================
 //
 // DefaultExtension		-- FString version
@@ -31,6 +31,7 @@ bool FileExists (const char *filename);
 bool DirExists(const char *filename);
 bool DirEntryExists (const char *pathname, bool *isdir = nullptr);
 bool GetFileInfo(const char* pathname, size_t* size, time_t* time);
+bool RenameFile(const char *from, const char *to);
 
 extern	FString progdir;
 
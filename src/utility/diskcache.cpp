@@ -0,0 +1,255 @@
+/*
+** diskcache.cpp
+** Index and size limit of the on-disk caches
+**
+**---------------------------------------------------------------------------
+** Copyright 2019 GZDoom maintainers and contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** The index is a text file with one 'name size lastuse [tag]' line per
+** entry. It gets read on first use and written by Flush.
+**
+*/
+
+#include <time.h>
+#include <algorithm>
+#include <memory>
+#include "diskcache.h"
+#include "doomtype.h"
+#include "m_misc.h"
+#include "cmdlib.h"
+#include "files.h"
+#include "c_cvars.h"
+#include "templates.h"
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+FDiskCacheIndex::FDiskCacheIndex(const char *directory, const char *extension, FIntCVar &sizelimit)
+	: Directory(directory), Extension(extension), SizeLimit(sizelimit)
+{
+}
+
+FString FDiskCacheIndex::Path(bool create) const
+{
+	FString path = M_GetCachePath(create);
+	path << "/" << Directory;
+	if (create) CreatePath(path);
+	return path;
+}
+
+FString FDiskCacheIndex::EntryPath(const FString &name) const
+{
+	return Path(false) + "/" + name + Extension;
+}
+
+//==========================================================================
+//
+// FDiskCacheIndex :: Load
+//
+//==========================================================================
+
+void FDiskCacheIndex::Load()
+{
+	if (Loaded) return;
+	Loaded = true;
+
+	FileReader fr;
+	if (!fr.OpenFile(Path(false) + "/index.txt")) return;
+
+	char line[256];
+	while (fr.Gets(line, sizeof(line)))
+	{
+		char name[33], tag[33] = "";
+		unsigned size, lastuse;
+		if (sscanf(line, "%32s %u %u %32s", name, &size, &lastuse, tag) < 3) continue;
+
+		FEntry *entry = Entries.CheckKey(name);
+		if (entry != nullptr)
+		{
+			TotalSize -= entry->Size;
+			EntryRemoved(*entry);
+		}
+		FEntry &newentry = Entries[name];
+		newentry = { size, lastuse, tag };
+		TotalSize += size;
+		EntryAdded(newentry);
+	}
+}
+
+//==========================================================================
+//
+// FDiskCacheIndex :: Find
+//
+//==========================================================================
+
+FDiskCacheIndex::FEntry *FDiskCacheIndex::Find(const FString &name)
+{
+	Load();
+	return Entries.CheckKey(name);
+}
+
+void FDiskCacheIndex::Use(FEntry *entry)
+{
+	entry->LastUse = (uint32_t)time(nullptr);
+	Dirty = true;
+}
+
+//==========================================================================
+//
+// FDiskCacheIndex :: Add
+//
+// Also updates entries that are already known, so that files which were
+// missing from the index get added when they are used.
+//
+//==========================================================================
+
+void FDiskCacheIndex::Add(const FString &name, size_t size, const FString &tag)
+{
+	Load();
+	FEntry *entry = Entries.CheckKey(name);
+	if (entry != nullptr)
+	{
+		TotalSize -= entry->Size;
+		EntryRemoved(*entry);
+	}
+	FEntry &newentry = Entries[name];
+	newentry = { uint32_t(size), (uint32_t)time(nullptr), tag };
+	TotalSize += size;
+	EntryAdded(newentry);
+	Dirty = true;
+}
+
+//==========================================================================
+//
+// FDiskCacheIndex :: Remove
+//
+// Deletes the entry's file, even if the index does not know about it.
+//
+//==========================================================================
+
+void FDiskCacheIndex::Remove(const FString &name)
+{
+	Load();
+	remove(EntryPath(name));
+	FEntry *entry = Entries.CheckKey(name);
+	if (entry == nullptr) return;
+
+	TotalSize -= entry->Size;
+	EntryRemoved(*entry);
+	Entries.Remove(name);
+	Dirty = true;
+}
+
+//==========================================================================
+//
+// FDiskCacheIndex :: Evict
+//
+// Deletes the least recently used entries until the cache is below 90%
+// of its limit, so that this does not have to run for every new entry.
+//
+//==========================================================================
+
+void FDiskCacheIndex::Evict()
+{
+	size_t limit = (size_t)MAX<int>(SizeLimit, 0) << 20;
+	if (TotalSize <= limit) return;
+
+	TArray<std::pair<uint32_t, FString>> order;
+	TMap<FString, FEntry>::Iterator it(Entries);
+	TMap<FString, FEntry>::Pair *pair;
+	while (it.NextPair(pair))
+	{
+		order.Push(std::make_pair(pair->Value.LastUse, pair->Key));
+	}
+	std::sort(order.begin(), order.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+
+	for (auto &item : order)
+	{
+		if (TotalSize <= limit / 10 * 9) break;
+		Remove(item.second);
+	}
+}
+
+//==========================================================================
+//
+// FDiskCacheIndex :: Clear
+//
+// Deletes every entry and returns how many there were.
+//
+//==========================================================================
+
+unsigned FDiskCacheIndex::Clear()
+{
+	Load();
+	unsigned count = Entries.CountUsed();
+	TMap<FString, FEntry>::Iterator it(Entries);
+	TMap<FString, FEntry>::Pair *pair;
+	while (it.NextPair(pair))
+	{
+		remove(EntryPath(pair->Key));
+		EntryRemoved(pair->Value);
+	}
+	Entries.Clear();
+	TotalSize = 0;
+	Dirty = true;
+	Flush();
+	return count;
+}
+
+//==========================================================================
+//
+// FDiskCacheIndex :: Flush
+//
+// Writes the index if anything changed.
+//
+//==========================================================================
+
+void FDiskCacheIndex::Flush()
+{
+	if (!Dirty) return;
+	Dirty = false;
+
+	FString text;
+	TMap<FString, FEntry>::Iterator it(Entries);
+	TMap<FString, FEntry>::Pair *pair;
+	while (it.NextPair(pair))
+	{
+		text.AppendFormat("%s %u %u", pair->Key.GetChars(), pair->Value.Size, pair->Value.LastUse);
+		if (pair->Value.Tag.IsNotEmpty()) text << " " << pair->Value.Tag;
+		text << "\n";
+	}
+
+	std::unique_ptr<FileWriter> fw(FileWriter::Open(Path(true) + "/index.txt"));
+	if (fw == nullptr || fw->Write(text.GetChars(), text.Len()) != text.Len())
+	{
+		Printf("Could not write the %s cache index\n", Directory);
+	}
+}
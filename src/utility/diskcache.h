@@ -0,0 +1,54 @@
+#ifndef __DISKCACHE_H
+#define __DISKCACHE_H
+
+#include <stdint.h>
+#include "tarray.h"
+#include "zstring.h"
+
+class FIntCVar;
+
+// Bookkeeping for a directory of cache files below the cache path. An index
+// file keeps the size and time of last use of every entry, so that the least
+// recently used ones can be deleted once the size limit (in MB) is hit.
+// The index is only an aid: entries missing from it are never evicted, and
+// stale lines are harmless. Each entry can carry a short tag for the owner.
+class FDiskCacheIndex
+{
+public:
+	struct FEntry
+	{
+		uint32_t Size = 0;
+		uint32_t LastUse = 0;
+		FString Tag;
+	};
+
+	FDiskCacheIndex(const char *directory, const char *extension, FIntCVar &sizelimit);
+	virtual ~FDiskCacheIndex() = default;
+
+	FString Path(bool create) const;
+	FString EntryPath(const FString &name) const;
+
+	void Load();
+	FEntry *Find(const FString &name);
+	void Use(FEntry *entry);
+	void Add(const FString &name, size_t size, const FString &tag = "");
+	void Remove(const FString &name);
+	void Evict();
+	unsigned Clear();
+	void Flush();
+
+protected:
+	virtual void EntryAdded(const FEntry &entry) {}
+	virtual void EntryRemoved(const FEntry &entry) {}
+
+private:
+	const char *Directory;
+	const char *Extension;
+	FIntCVar &SizeLimit;
+	TMap<FString, FEntry> Entries;
+	size_t TotalSize = 0;
+	bool Loaded = false;
+	bool Dirty = false;
+};
+
+#endif
@@ -33,6 +33,17 @@
 **
 */
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #include "files.h"
 #include "templates.h"
 
@@ -347,6 +358,97 @@ public:
 };
 
 
+//==========================================================================
+//
+// MappedFileReader
+//
+// reads data from a file that has been mapped into the address space.
+// The mapping is copy-on-write because lump caches point straight into
+// the reader's buffer and a few loaders modify their lump in place (e.g.
+// Blood's encrypted RFF entries). Such writes only ever touch a private
+// copy of the affected pages, never the file.
+//
+//==========================================================================
+
+class MappedFileReader : public MemoryReader
+{
+#ifdef _WIN32
+	HANDLE Mapping = nullptr;
+#endif
+
+public:
+	MappedFileReader()
+	{}
+
+	~MappedFileReader()
+	{
+		if (bufptr != nullptr)
+		{
+#ifdef _WIN32
+			UnmapViewOfFile(bufptr);
+			CloseHandle(Mapping);
+#else
+			munmap(const_cast<char *>(bufptr), Length);
+#endif
+		}
+		bufptr = nullptr;
+	}
+
+	bool Open(const char *filename)
+	{
+#ifdef _WIN32
+		HANDLE file = CreateFileW(WideString(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || !CheckSize(size.QuadPart))
+		{
+			CloseHandle(file);
+			return false;
+		}
+		Mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+		CloseHandle(file);	// the mapping keeps its own reference to the file.
+		if (Mapping == nullptr) return false;
+
+		void *view = MapViewOfFile(Mapping, FILE_MAP_COPY, 0, 0, 0);
+		if (view == nullptr)
+		{
+			CloseHandle(Mapping);
+			Mapping = nullptr;
+			return false;
+		}
+		bufptr = (const char *)view;
+		Length = (long)size.QuadPart;
+#else
+		int fd = open(filename, O_RDONLY);
+		if (fd < 0) return false;
+
+		struct stat info;
+		if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || !CheckSize(info.st_size))
+		{
+			close(fd);
+			return false;
+		}
+		void *view = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		close(fd);	// same here, the mapping stays valid.
+		if (view == MAP_FAILED) return false;
+
+		bufptr = (const char *)view;
+		Length = (long)info.st_size;
+#endif
+		FilePos = 0;
+		return true;
+	}
+
+private:
+	static bool CheckSize(int64_t size)
+	{
+		// Empty files cannot be mapped, and on 32 bit targets large archives
+		// would eat up the address space the rest of the engine needs.
+		const int64_t maxsize = sizeof(void *) >= 8 ? 0x7fffffff : 0x10000000;
+		return size > 0 && size <= maxsize;
+	}
+};
 
 //==========================================================================
 //
@@ -369,6 +471,19 @@ bool FileReader::OpenFile(const char *filename, FileReader::Size start, FileRead
 	return true;
 }
 
+bool FileReader::OpenFileMapped(const char *filename)
+{
+	auto reader = new MappedFileReader;
+	if (!reader->Open(filename))
+	{
+		delete reader;
+		return false;
+	}
+	Close();
+	mReader = reader;
+	return true;
+}
+
 bool FileReader::OpenFilePart(FileReader &parent, FileReader::Size start, FileReader::Size length)
 {
 	auto reader = new FileReaderRedirect(parent, (long)start, (long)length);
@@ -469,6 +584,19 @@ long FileWriter::Seek(long offset, int mode)
 	}
 }
 
+bool FileWriter::Sync()
+{
+	if (File == NULL || fflush(File) != 0)
+	{
+		return false;
+	}
+#ifdef _WIN32
+	return FlushFileBuffers((HANDLE)_get_osfhandle(_fileno(File))) != 0;
+#else
+	return fsync(fileno(File)) == 0;
+#endif
+}
+
 size_t FileWriter::Printf(const char *fmt, ...)
 {
 	va_list ap;
@@ -180,6 +180,7 @@ public:
 	}
 
 	bool OpenFile(const char *filename, Size start = 0, Size length = -1);
+	bool OpenFileMapped(const char *filename);	// maps the entire file into memory. Fails if the platform cannot do that.
 	bool OpenFilePart(FileReader &parent, Size start, Size length);
 	bool OpenMemory(const void *mem, Size length);	// read directly from the buffer
 	bool OpenMemoryArray(const void *mem, Size length);	// read from a copy of the buffer.
@@ -317,6 +318,9 @@ public:
 	virtual long Seek(long offset, int mode);
 	size_t Printf(const char *fmt, ...) GCCPRINTF(2,3);
 
+	// Makes sure everything written so far is on the disk, not just in the OS's cache.
+	bool Sync();
+
 protected:
 
 	FILE *File;
@@ -0,0 +1,388 @@
+/*
+** jobsystem.cpp
+** Shared worker threads with work stealing
+**
+**---------------------------------------------------------------------------
+** Copyright 2019 GZDoom maintainers and contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** Before this every subsystem that went parallel brought its own threads,
+** so a frame could easily have three times as many runnable threads as
+** there are cores. Everything now submits to the same workers instead.
+**
+** Jobs are expected to be coarse (a screen slice, a range of thinkers) so
+** the queues are plain mutex protected deques. A thread waiting for a group
+** only picks up jobs of that group: helping with unrelated work could make
+** it run a job that itself waits for something the waiting thread has not
+** produced yet.
+**
+*/
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
+#include "jobsystem.h"
+#include "memarena.h"
+#include "c_cvars.h"
+#include "templates.h"
+
+CVAR(Int, sys_workerthreads, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// 0 = one less than the number of cores, takes effect on restart
+
+struct FJob
+{
+	std::function<void()> Func;
+	FJobGroup *Group;
+};
+
+// 0 for every thread that is not a worker.
+static thread_local int WorkerIndex;
+
+// Index 0 is the thread's own scratch arena, index n the one of the job
+// running at nesting depth n. A waiting thread may run jobs of the group it
+// waits for, so each nesting level needs its own arena.
+static thread_local int JobDepth;
+static thread_local std::vector<std::unique_ptr<FMemArena>> ScratchArenas;
+
+class FJobScheduler
+{
+public:
+	static FJobScheduler &Get()
+	{
+		static FJobScheduler scheduler;
+		return scheduler;
+	}
+
+	int NumThreads() const { return (int)Workers.size() + 1; }
+
+	void Push(FJob *job);
+	void WaitFor(FJobGroup *group);
+
+private:
+	struct Queue
+	{
+		std::mutex Mutex;
+		std::deque<FJob *> Jobs;
+	};
+
+	FJobScheduler();
+	~FJobScheduler();
+
+	FJob *TakeFrom(Queue &queue, bool newest, FJobGroup *only);
+	FJob *Take(FJobGroup *only);
+	void Execute(FJob *job);
+	void WorkerMain(int index);
+	void Notify();
+
+	// [0] receives jobs from non-worker threads, [n] is owned by worker n.
+	std::vector<std::unique_ptr<Queue>> Queues;
+	std::vector<std::thread> Workers;
+
+	std::mutex WakeMutex;
+	std::condition_variable WakeCondition;
+	std::atomic<int> Queued = { 0 };
+	std::atomic<unsigned> Generation = { 0 };
+	bool Shutdown = false;
+
+	friend class FJobGroup;
+};
+
+//==========================================================================
+//
+// FJobScheduler :: FJobScheduler
+//
+//==========================================================================
+
+FJobScheduler::FJobScheduler()
+{
+	int count = sys_workerthreads;
+	if (count <= 0)
+	{
+		count = (int)std::thread::hardware_concurrency() - 1;
+	}
+	// Always start at least one worker. A waiting thread only helps with its
+	// own group, so jobs that depend on another group need someone else.
+	count = clamp(count, 1, 63);
+
+	for (int i = 0; i <= count; i++)
+	{
+		Queues.push_back(std::make_unique<Queue>());
+	}
+	for (int i = 1; i <= count; i++)
+	{
+		Workers.push_back(std::thread([=]() { WorkerMain(i); }));
+	}
+}
+
+//==========================================================================
+//
+// FJobScheduler :: ~FJobScheduler
+//
+// Lets the workers drain what is still queued before they exit.
+//
+//==========================================================================
+
+FJobScheduler::~FJobScheduler()
+{
+	{
+		std::unique_lock<std::mutex> lock(WakeMutex);
+		Shutdown = true;
+	}
+	WakeCondition.notify_all();
+	for (auto &worker : Workers)
+	{
+		worker.join();
+	}
+	for (auto &queue : Queues)
+	{
+		for (FJob *job : queue->Jobs) delete job;
+	}
+}
+
+//==========================================================================
+//
+// FJobScheduler :: Push
+//
+// Workers push to the back of their own deque so that a job's children
+// stay on the thread whose caches already hold their data.
+//
+//==========================================================================
+
+void FJobScheduler::Push(FJob *job)
+{
+	Queue &queue = *Queues[WorkerIndex];
+	Queued++;
+	{
+		std::unique_lock<std::mutex> lock(queue.Mutex);
+		queue.Jobs.push_back(job);
+	}
+	Generation++;
+	Notify();
+}
+
+void FJobScheduler::Notify()
+{
+	{
+		std::unique_lock<std::mutex> lock(WakeMutex);
+	}
+	WakeCondition.notify_all();
+}
+
+//==========================================================================
+//
+// FJobScheduler :: Take
+//
+// Own deque newest first, then the injection queue and the other workers'
+// deques oldest first.
+//
+//==========================================================================
+
+FJob *FJobScheduler::TakeFrom(Queue &queue, bool newest, FJobGroup *only)
+{
+	std::unique_lock<std::mutex> lock(queue.Mutex);
+	auto &jobs = queue.Jobs;
+	for (size_t i = 0; i < jobs.size(); i++)
+	{
+		size_t index = newest ? jobs.size() - 1 - i : i;
+		FJob *job = jobs[index];
+		if (only == nullptr || job->Group == only)
+		{
+			jobs.erase(jobs.begin() + index);
+			Queued--;
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+FJob *FJobScheduler::Take(FJobGroup *only)
+{
+	int self = WorkerIndex;
+	FJob *job = nullptr;
+	if (self != 0)
+	{
+		job = TakeFrom(*Queues[self], true, only);
+	}
+	for (size_t i = 0; job == nullptr && i < Queues.size(); i++)
+	{
+		if ((int)i != self) job = TakeFrom(*Queues[i], false, only);
+	}
+	return job;
+}
+
+//==========================================================================
+//
+// FJobScheduler :: Execute
+//
+//==========================================================================
+
+void FJobScheduler::Execute(FJob *job)
+{
+	JobDepth++;
+	job->Func();
+	if ((int)ScratchArenas.size() > JobDepth)
+	{
+		ScratchArenas[JobDepth]->FreeAll();
+	}
+	JobDepth--;
+
+	FJobGroup *group = job->Group;
+	delete job;
+	group->Finish();
+}
+
+//==========================================================================
+//
+// FJobScheduler :: WorkerMain
+//
+//==========================================================================
+
+void FJobScheduler::WorkerMain(int index)
+{
+	WorkerIndex = index;
+	while (true)
+	{
+		FJob *job = Take(nullptr);
+		if (job != nullptr)
+		{
+			Execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(WakeMutex);
+		WakeCondition.wait(lock, [=]() { return Shutdown || Queued > 0; });
+		if (Shutdown && Queued <= 0)
+		{
+			break;
+		}
+	}
+}
+
+//==========================================================================
+//
+// FJobScheduler :: WaitFor
+//
+//==========================================================================
+
+void FJobScheduler::WaitFor(FJobGroup *group)
+{
+	while (!group->IsDone())
+	{
+		unsigned generation = Generation;
+		FJob *job = Take(group);
+		if (job != nullptr)
+		{
+			Execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(WakeMutex);
+		WakeCondition.wait(lock, [=]() { return group->IsDone() || Generation != generation; });
+	}
+}
+
+//==========================================================================
+//
+// FJobSystem
+//
+//==========================================================================
+
+int FJobSystem::NumThreads()
+{
+	return FJobScheduler::Get().NumThreads();
+}
+
+int FJobSystem::ThreadIndex()
+{
+	return WorkerIndex;
+}
+
+FMemArena &FJobSystem::Scratch()
+{
+	while ((int)ScratchArenas.size() <= JobDepth)
+	{
+		ScratchArenas.push_back(std::make_unique<FMemArena>(64 * 1024));
+	}
+	return *ScratchArenas[JobDepth];
+}
+
+//==========================================================================
+//
+// FJobGroup
+//
+//==========================================================================
+
+FJobGroup::~FJobGroup()
+{
+	Wait();
+}
+
+void FJobGroup::Run(std::function<void()> func, FJobGroup *after)
+{
+	FJob *job = new FJob{ std::move(func), this };
+	Pending++;
+	if (after != nullptr)
+	{
+		std::unique_lock<std::mutex> lock(after->ContinuationMutex);
+		if (after->Pending > 0)
+		{
+			after->Continuations.push_back(job);
+			return;
+		}
+	}
+	FJobScheduler::Get().Push(job);
+}
+
+void FJobGroup::Wait()
+{
+	if (!IsDone())
+	{
+		FJobScheduler::Get().WaitFor(this);
+	}
+	// Finish() may still hold the lock right after the counter dropped to
+	// zero. Once it is released nothing touches this group anymore.
+	std::unique_lock<std::mutex> lock(ContinuationMutex);
+}
+
+void FJobGroup::Finish()
+{
+	std::vector<FJob *> continuations;
+	{
+		std::unique_lock<std::mutex> lock(ContinuationMutex);
+		if (--Pending == 0)
+		{
+			continuations.swap(Continuations);
+		}
+	}
+
+	auto &scheduler = FJobScheduler::Get();
+	for (FJob *job : continuations)
+	{
+		scheduler.Push(job);
+	}
+	scheduler.Notify();
+}
@@ -0,0 +1,64 @@
+#ifndef __JOBSYSTEM_H
+#define __JOBSYSTEM_H
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+class FMemArena;
+struct FJob;
+
+// One persistent set of worker threads shared by everything in the engine
+// that wants to run work in parallel. Each worker owns a deque it pushes
+// to and pops from at the back; idle workers steal from the front of the
+// other deques. Work submitted from threads that are not workers goes to
+// a shared injection queue.
+class FJobSystem
+{
+public:
+	// Number of threads that can execute jobs at the same time, i.e. the
+	// workers plus the thread waiting for them.
+	static int NumThreads();
+
+	// 1..NumThreads()-1 on a worker, 0 on any other thread. Meant for
+	// indexing per-thread state of jobs submitted from the main thread.
+	static int ThreadIndex();
+
+	// Scratch memory for temporaries of the running job. Everything
+	// allocated from it is freed as soon as that job returns. Outside of
+	// a job it is never reset, so only jobs should use it.
+	static FMemArena &Scratch();
+};
+
+// A set of jobs that can be waited for as a whole. Groups are not copyable
+// and must outlive the jobs that were added to them; the destructor waits.
+class FJobGroup
+{
+public:
+	FJobGroup() = default;
+	FJobGroup(const FJobGroup &) = delete;
+	FJobGroup &operator=(const FJobGroup &) = delete;
+	~FJobGroup();
+
+	// Queues a job. If 'after' is given the job will not be started before
+	// every job in that group has finished.
+	void Run(std::function<void()> func, FJobGroup *after = nullptr);
+
+	// Blocks until all jobs of this group have finished. While waiting the
+	// calling thread executes queued jobs of this group itself.
+	void Wait();
+
+	bool IsDone() const { return Pending.load() == 0; }
+
+private:
+	void Finish();
+
+	std::atomic<int> Pending = { 0 };
+	std::mutex ContinuationMutex;
+	std::vector<FJob *> Continuations;
+
+	friend class FJobScheduler;
+};
+
+#endif
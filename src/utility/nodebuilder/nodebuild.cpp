@@ -43,11 +43,19 @@
 
 #include "doomdata.h"
 #include "nodebuild.h"
+#include "c_cvars.h"
+#include "jobsystem.h"
+
+CVAR(Bool, nodebuilder_mt, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
 
 const int MaxSegs = 64;
 const int SplitCost = 8;
 const int AAPreference = 16;
 
+// Candidates times segs in the set below which scoring is not worth
+// handing to other threads.
+const uint64_t MinParallelWork = 32768;
+
 #if 0
 #define D(x) x
 #else
@@ -444,6 +452,7 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 	int bestvalue;
 	uint32_t bestseg;
 	uint32_t seg;
+	unsigned int segsInSet = 0;
 	bool nosplitters = false;
 
 	bestvalue = 0;
@@ -453,9 +462,12 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 	stepleft = 0;
 
 	memset (&PlaneChecked[0], 0, PlaneChecked.Size());
+	Candidates.Clear ();
 
 	D(Printf (PRINT_LOG, "Processing set %d\n", set));
 
+	// Which segs get tried does not depend on their scores, so collect them
+	// first and score them all at once.
 	while (seg != UINT_MAX)
 	{
 		FPrivSeg *pseg = &Segs[seg];
@@ -473,31 +485,40 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 				}
 
 				stepleft = step;
-				SetNodeFromSeg (node, pseg);
-
-				int value = Heuristic (node, set, nosplit);
-
-				D(Printf (PRINT_LOG, "Seg %5d, ld %d (%5d,%5d)-(%5d,%5d) scores %d\n", seg, Segs[seg].linedef, node.x>>16, node.y>>16,
-					(node.x+node.dx)>>16, (node.y+node.dy)>>16, value));
-
-				if (value > bestvalue)
-				{
-					bestvalue = value;
-					bestseg = seg;
-				}
-				else if (value < 0)
-				{
-					nosplitters = true;
-				}
+				Candidates.Push (seg);
 			}
 		}
 
+		segsInSet++;
 		seg = pseg->next;
 	}
 
+	ScoreCandidates (set, segsInSet, nosplit);
+
+	for (unsigned int i = 0; i < Candidates.Size(); ++i)
+	{
+		int value = CandidateScores[i];
+
+		D(Printf (PRINT_LOG, "Seg %5d, ld %d scores %d\n", Candidates[i], Segs[Candidates[i]].linedef, value));
+
+		if (value > bestvalue)
+		{
+			bestvalue = value;
+			bestseg = Candidates[i];
+		}
+		else if (value < 0)
+		{
+			nosplitters = true;
+		}
+	}
+
 	if (bestseg == UINT_MAX)
 	{ // No lines split any others into two sets, so this is a convex region.
 	D(Printf (PRINT_LOG, "set %d, step %d, nosplit %d has no good splitter (%d)\n", set, step, nosplit, nosplitters));
+		if (Candidates.Size() > 0)
+		{ // Leave the node the way scoring them one after the other did.
+			SetNodeFromSeg (node, &Segs[Candidates.Last()]);
+		}
 		return nosplitters ? -1 : 0;
 	}
 
@@ -508,13 +529,58 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 	return 1;
 }
 
+// Scores every seg in Candidates as a splitter for the set. This is where
+// nearly all of the build time goes, since each candidate gets classified
+// against every seg in the set. Nothing the heuristic reads changes while
+// a set is being scored, so large sets are spread across the job system.
+// The scores land in CandidateScores in the same order as the candidates,
+// so the chosen splitter and thus the tree are the same either way.
+
+void FNodeBuilder::ScoreCandidates (uint32_t set, unsigned int segsInSet, bool nosplit)
+{
+	unsigned int count = Candidates.Size();
+	int numThreads = FJobSystem::NumThreads();
+
+	CandidateScores.Resize (count);
+
+	if (!nodebuilder_mt || numThreads <= 1 || count < 2 || (uint64_t)count * segsInSet < MinParallelWork)
+	{
+		node_t node;
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			SetNodeFromSeg (node, &Segs[Candidates[i]]);
+			CandidateScores[i] = Heuristic (node, set, nosplit);
+		}
+		return;
+	}
+
+	unsigned int numJobs = MIN<unsigned int> (count, numThreads * 4);
+	FJobGroup jobs;
+	for (unsigned int j = 0; j < numJobs; ++j)
+	{
+		unsigned int start = count * j / numJobs;
+		unsigned int end = count * (j + 1) / numJobs;
+		jobs.Run ([=]()
+		{
+			TArray<int> touched, colinear;
+			node_t node;
+			for (unsigned int i = start; i < end; ++i)
+			{
+				SetNodeFromSeg (node, &Segs[Candidates[i]]);
+				CandidateScores[i] = Heuristic (node, set, nosplit, touched, colinear);
+			}
+		});
+	}
+	jobs.Wait ();
+}
+
 // Given a splitter (node), returns a score based on how "good" the resulting
 // split in a set of segs is. Higher scores are better. -1 means this splitter
 // splits something it shouldn't and will only be returned if honorNoSplit is
 // true. A score of 0 means that the splitter does not split any of the segs
 // in the set.
 
-int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
+int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit, TArray<int> &touched, TArray<int> &colinear)
 {
 	// Set the initial score above 0 so that near vertex anti-weighting is less likely to produce a negative score.
 	int score = 1000000;
@@ -529,8 +595,8 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 	unsigned int max, m2, p, q;
 	double frac;
 
-	Touched.Clear ();
-	Colinear.Clear ();
+	touched.Clear ();
+	colinear.Clear ();
 
 	while (i != UINT_MAX)
 	{
@@ -556,32 +622,32 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 			{
 				if ((sidev[0] | sidev[1]) != 0)
 				{
-					max = Touched.Size();
+					max = touched.Size();
 					for (p = 0; p < max; ++p)
 					{
-						if (Touched[p] == test->loopnum)
+						if (touched[p] == test->loopnum)
 						{
 							break;
 						}
 					}
 					if (p == max)
 					{
-						Touched.Push (test->loopnum);
+						touched.Push (test->loopnum);
 					}
 				}
 				else
 				{
-					max = Colinear.Size();
+					max = colinear.Size();
 					for (p = 0; p < max; ++p)
 					{
-						if (Colinear[p] == test->loopnum)
+						if (colinear[p] == test->loopnum)
 						{
 							break;
 						}
 					}
 					if (p == max)
 					{
-						Colinear.Push (test->loopnum);
+						colinear.Push (test->loopnum);
 					}
 				}
 			}
@@ -698,8 +764,8 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 	// seg of that sector must be crossing the container's corner and does not
 	// actually split the container.
 
-	max = Touched.Size ();
-	m2 = Colinear.Size ();
+	max = touched.Size ();
+	m2 = colinear.Size ();
 
 	// If honorNoSplit is false, then both these lists will be empty.
 
@@ -712,10 +778,10 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 
 	for (p = 0; p < max; ++p)
 	{
-		int look = Touched[p];
+		int look = touched[p];
 		for (q = 0; q < m2; ++q)
 		{
-			if (look == Colinear[q])
+			if (look == colinear[q])
 			{
 				break;
 			}
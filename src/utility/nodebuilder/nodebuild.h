@@ -244,6 +244,9 @@ public:
 	void BuildMini(bool makeGLNodes);
 	void ExtractMini(FMiniBSP *bsp);
 
+	// Hash of the finished tree, for checking that two builds are identical.
+	uint32_t Checksum() const;
+
 	static angle_t PointToAngle (fixed_t dx, fixed_t dy);
 
 	//  < 0 : in front of line
@@ -267,6 +270,8 @@ private:
 
 	TArray<int> Touched;	// Loops a splitter touches on a vertex
 	TArray<int> Colinear;	// Loops with edges colinear to a splitter
+	TArray<uint32_t> Candidates;	// Splitters SelectSplitter wants scored
+	TArray<int> CandidateScores;
 	FEventTree Events;		// Vertices intersected by the current splitter
 
 	TArray<FSplitSharer> SplitSharers;	// Segs colinear with the current splitter
@@ -294,10 +299,16 @@ private:
 	void CreateSubsectorsForReal ();
 	bool CheckSubsector (uint32_t set, node_t &node, uint32_t &splitseg);
 	bool CheckSubsectorOverlappingSegs (uint32_t set, node_t &node, uint32_t &splitseg);
-	bool ShoveSegBehind (uint32_t set, node_t &node, uint32_t seg, uint32_t mate);	int SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg, int step, bool nosplit);
+	bool ShoveSegBehind (uint32_t set, node_t &node, uint32_t seg, uint32_t mate);
+	int SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg, int step, bool nosplit);
+	void ScoreCandidates (uint32_t set, unsigned int segsInSet, bool nosplit);
 	void SplitSegs (uint32_t set, node_t &node, uint32_t splitseg, uint32_t &outset0, uint32_t &outset1, unsigned int &count0, unsigned int &count1);
 	uint32_t SplitSeg (uint32_t segnum, int splitvert, int v1InFront);
-	int Heuristic (node_t &node, uint32_t set, bool honorNoSplit);
+	int Heuristic (node_t &node, uint32_t set, bool honorNoSplit, TArray<int> &touched, TArray<int> &colinear);
+	int Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
+	{
+		return Heuristic (node, set, honorNoSplit, Touched, Colinear);
+	}
 
 	// Returns:
 	//	0 = seg is in front
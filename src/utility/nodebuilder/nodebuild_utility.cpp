@@ -44,6 +44,7 @@
 #include <string.h>
 
 #include "nodebuild.h"
+#include "m_crc32.h"
 
 #include "po_man.h"
 #include "g_levellocals.h"
@@ -113,6 +114,34 @@ const int *FNodeBuilder::GetOldVertexTable()
 	return table;
 }
 
+// Only covers what the tree is made of, not the pointers that Extract fills
+// in later, so the result can be compared between separate builds.
+
+uint32_t FNodeBuilder::Checksum() const
+{
+	uint32_t crc = 0;
+	for (auto &node : Nodes)
+	{
+		int data[] = { node.x, node.y, node.dx, node.dy, node.intchildren[0], node.intchildren[1] };
+		crc = AddCRC32 (crc, (const uint8_t *)data, sizeof(data));
+	}
+	for (auto &seg : Segs)
+	{
+		int data[] = { seg.v1, seg.v2, seg.linedef, seg.sidedef, (int)seg.next };
+		crc = AddCRC32 (crc, (const uint8_t *)data, sizeof(data));
+	}
+	for (auto &vert : Vertices)
+	{
+		int data[] = { vert.x, vert.y };
+		crc = AddCRC32 (crc, (const uint8_t *)data, sizeof(data));
+	}
+	for (auto set : SubsectorSets)
+	{
+		crc = AddCRC32 (crc, (const uint8_t *)&set, sizeof(set));
+	}
+	return crc;
+}
+
 // For every sidedef in the map, create a corresponding seg.
 
 void FNodeBuilder::MakeSegsFromSides ()
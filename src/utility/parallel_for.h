@@ -25,45 +25,21 @@
 #ifndef PARALLEL_FOR_H_INCLUDED
 #define PARALLEL_FOR_H_INCLUDED
 
-#ifdef HAVE_PARALLEL_FOR
-
-#include <ppl.h>
+#include "jobsystem.h"
 
+// Every step becomes one job on the shared workers, so callers should pick
+// a step that makes the individual calls reasonably coarse.
 template <typename Index, typename Function>
 inline void parallel_for(const Index first, const Index last, const Index step, const Function& function)
 {
-	concurrency::parallel_for(first, last, step, function);
-}
-
-#elif defined HAVE_DISPATCH_APPLY
-
-#include <dispatch/dispatch.h>
-
-template <typename Index, typename Function>
-inline void parallel_for(const Index first, const Index last, const Index step, const Function& function)
-{
-	const dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
-
-	dispatch_apply((last - first) / step + 1, queue, ^(size_t slice)
-	{
-		function(slice * step);
-	});
-}
-
-#else // Generic loop with optional OpenMP parallelization
-
-template <typename Index, typename Function>
-inline void parallel_for(const Index first, const Index last, const Index step, const Function& function)
-{
-#pragma omp parallel for
+	FJobGroup jobs;
 	for (Index i = first; i < last; i += step)
 	{
-		function(i);
+		jobs.Run([=, &function]() { function(i); });
 	}
+	jobs.Wait();
 }
 
-#endif // HAVE_PARALLEL_FOR
-
 template <typename Index, typename Function>
 inline void parallel_for(const Index count, const Function& function)
 {
@@ -0,0 +1,64 @@
+# Starts the engine, runs one console command and checks what it printed to
+# the log.
+#
+# ENGINE, IWAD, WORKDIR, COMMAND and EXPECT, a regular expression the log must
+# match, must be set. If MAP is set, the command runs once MAP has started,
+# with TESTWAD and TESTPK3 loaded if they are set too. A log matching FAIL, if
+# set, fails the test. SETTINGS is a comma separated list of cvar=value pairs.
+#
+# Nothing is drawn unless DRAW is set. Then the engine runs under XVFB_RUN on
+# Mesa's software rasterizer, so that the frames come out the same on every
+# machine.
+
+file( REMOVE_RECURSE ${WORKDIR} )
+file( MAKE_DIRECTORY ${WORKDIR} )
+
+set( ARGS -iwad ${IWAD} -config ${WORKDIR}/test.ini -savedir ${WORKDIR}
+	-nosound -noautoload -skill 3 +logfile ${WORKDIR}/console.log )
+if( DRAW )
+	set( ENV{LIBGL_ALWAYS_SOFTWARE} 1 )
+	set( LAUNCHER ${XVFB_RUN} -a )
+	list( APPEND ARGS -width 640 -height 480 +vid_fullscreen 0 )
+else()
+	set( LAUNCHER )
+	list( APPEND ARGS -nodraw )
+endif()
+if( SETTINGS )
+	string( REPLACE "," ";" SETTINGS "${SETTINGS}" )
+	foreach( SETTING ${SETTINGS} )
+		string( REPLACE "=" ";" SETTING "${SETTING}" )
+		list( GET SETTING 0 NAME )
+		list( GET SETTING 1 VALUE )
+		list( APPEND ARGS +${NAME} ${VALUE} )
+	endforeach()
+endif()
+if( MAP )
+	if( TESTWAD )
+		list( APPEND ARGS -file ${TESTWAD} )
+	endif()
+	if( TESTPK3 )
+		list( APPEND ARGS -file ${TESTPK3} )
+	endif()
+	list( APPEND ARGS +map ${MAP} )
+	set( SCRIPT "+wait 2; ${COMMAND}; wait 2; quit" )
+else()
+	set( SCRIPT "+${COMMAND}; quit" )
+endif()
+
+# SCRIPT stays out of ARGS because its semicolons would split it into a list.
+execute_process( COMMAND ${LAUNCHER} ${ENGINE} ${ARGS} "${SCRIPT}"
+	OUTPUT_FILE ${WORKDIR}/output.log ERROR_FILE ${WORKDIR}/output.log
+	TIMEOUT 600 )
+if( NOT EXISTS ${WORKDIR}/console.log )
+	message( FATAL_ERROR "No log was written, see ${WORKDIR}/output.log" )
+endif()
+
+file( READ ${WORKDIR}/console.log LOG )
+if( FAIL AND LOG MATCHES "${FAIL}" )
+	message( FATAL_ERROR "${COMMAND} failed: ${CMAKE_MATCH_0}, see ${WORKDIR}/console.log" )
+endif()
+if( NOT LOG MATCHES "${EXPECT}" )
+	message( FATAL_ERROR "${COMMAND} did not print \"${EXPECT}\", see ${WORKDIR}/console.log" )
+endif()
+
+message( STATUS "${COMMAND} printed \"${CMAKE_MATCH_0}\"" )
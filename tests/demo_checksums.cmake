@@ -0,0 +1,79 @@
+# Records a demo on a test map with CVAR set to RECORD and plays it back
+# twice, with CVAR set to 0 and to 1. The world checksums written by
+# -checksums must be the same for every tic of the recording and both
+# playbacks.
+#
+# ENGINE, IWAD, TESTWAD and WORKDIR must be set. MAP defaults to TEST01,
+# CVAR to cl_parallelthinkers, RECORD to 0 and TICS, the length of the
+# recording, to 700.
+
+if( NOT MAP )
+	set( MAP TEST01 )
+endif()
+if( NOT CVAR )
+	set( CVAR cl_parallelthinkers )
+endif()
+if( NOT RECORD )
+	set( RECORD 0 )
+endif()
+if( NOT TICS )
+	set( TICS 700 )
+endif()
+
+file( REMOVE_RECURSE ${WORKDIR} )
+file( MAKE_DIRECTORY ${WORKDIR} )
+
+set( COMMON_ARGS -iwad ${IWAD} -file ${TESTWAD} -config ${WORKDIR}/test.ini
+	-savedir ${WORKDIR} -nodraw -nosound -noautoload -skill 3 )
+
+# The engine does not quit after a recording or a timedemo on its own terms,
+# so the exit codes are meaningless and only the written files are checked.
+execute_process( COMMAND ${ENGINE} ${COMMON_ARGS} -record ${WORKDIR}/test.lmp
+		-checksums ${WORKDIR}/record.txt +map ${MAP} +${CVAR} ${RECORD} "+wait ${TICS}; stop; wait 2; quit"
+	OUTPUT_FILE ${WORKDIR}/record.log ERROR_FILE ${WORKDIR}/record.log
+	TIMEOUT 600 )
+if( NOT EXISTS ${WORKDIR}/test.lmp )
+	message( FATAL_ERROR "No demo was recorded, see ${WORKDIR}/record.log" )
+endif()
+
+foreach( VALUE 0 1 )
+	execute_process( COMMAND ${ENGINE} ${COMMON_ARGS} -timedemo ${WORKDIR}/test.lmp
+			-checksums ${WORKDIR}/playback${VALUE}.txt +${CVAR} ${VALUE}
+		OUTPUT_FILE ${WORKDIR}/playback${VALUE}.log ERROR_FILE ${WORKDIR}/playback${VALUE}.log
+		TIMEOUT 600 )
+endforeach()
+
+set( REFERENCE )
+foreach( RUN record playback0 playback1 )
+	if( NOT EXISTS ${WORKDIR}/${RUN}.txt )
+		message( FATAL_ERROR "${RUN} wrote no checksums, see ${WORKDIR}/${RUN}.log" )
+	endif()
+	file( STRINGS ${WORKDIR}/${RUN}.txt SUMS )
+	list( LENGTH SUMS COUNT )
+	if( COUNT LESS ${TICS} )
+		message( FATAL_ERROR "${RUN} only checksummed ${COUNT} tics" )
+	endif()
+
+	# Recording and playback may run a few tics past each other at the end.
+	math( EXPR LAST "${TICS} - 1" )
+	set( PREFIX )
+	foreach( TIC RANGE ${LAST} )
+		list( GET SUMS ${TIC} SUM )
+		list( APPEND PREFIX ${SUM} )
+	endforeach()
+
+	if( NOT REFERENCE )
+		set( REFERENCE "${PREFIX}" )
+		set( REFERENCE_RUN ${RUN} )
+	elseif( NOT "${PREFIX}" STREQUAL "${REFERENCE}" )
+		foreach( TIC RANGE ${LAST} )
+			list( GET PREFIX ${TIC} A )
+			list( GET REFERENCE ${TIC} B )
+			if( NOT A STREQUAL B )
+				message( FATAL_ERROR "${RUN} differs from ${REFERENCE_RUN} at tic ${TIC}" )
+			endif()
+		endforeach()
+	endif()
+endforeach()
+
+message( STATUS "${TICS} tics match with ${CVAR} ${RECORD}, 0 and 1" )
@@ -0,0 +1,781 @@
+/*
+** maketestwad.cpp
+** Writes the maps used by the regression tests
+**
+**---------------------------------------------------------------------------
+** Copyright 2019 GZDoom maintainers and contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** Usage: maketestwad <output.wad> <output.pk3>
+**
+** TEST01 is a room with a grid of small sectors. An event handler keeps
+** movers, lights and scrollers running in all of them, so every thinker
+** list has enough entries for cl_parallelthinkers to split them into
+** batches.
+**
+** TEST02 has no REJECT lump, so the engine generates one. Monsters in
+** sealed rooms are rejected from seeing the player, the others can see
+** the player either directly or once a door has opened.
+**
+** TEST03 is an empty room for 'benchmodels BenchIQMModel <count>'. The
+** pk3 holds the animated IQM model, its MODELDEF and the actor, so a
+** scene with hundreds of skinned models can be set up with
+**
+**   gzdoom -file zdoomtest.wad zdoomtest.pk3 +map TEST03
+**   ] benchmodels BenchIQMModel 400
+**   ] bench
+**
+** TEST04 is a set of nested rooms for 'rejecttest', which checks the
+** fallback of the REJECT builder. Every room is only reachable through
+** the ones around it, so the fallback has to look further than the two
+** sectors next to the one it starts from.
+**
+** Nothing in the maps needs textures or IWAD actors, so they work with any
+** IWAD.
+**
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+struct Lump
+{
+	std::string Name;
+	std::string Data;
+};
+
+struct MapBuilder
+{
+	std::string Vertices, Lines, Sides, Sectors, Things;
+	int NumVertices = 0, NumSides = 0, NumSectors = 0;
+
+	int AddVertex(int x, int y)
+	{
+		char buf[80];
+		snprintf(buf, sizeof(buf), "vertex { x = %d.0; y = %d.0; }\n", x, y);
+		Vertices += buf;
+		return NumVertices++;
+	}
+
+	int AddSide(int sector)
+	{
+		char buf[160];
+		snprintf(buf, sizeof(buf), "sidedef { sector = %d; texturetop = \"-\"; texturebottom = \"-\"; texturemiddle = \"-\"; }\n", sector);
+		Sides += buf;
+		return NumSides++;
+	}
+
+	int AddSector(int floor, int ceiling, int tag)
+	{
+		char buf[200];
+		snprintf(buf, sizeof(buf), "sector { heightfloor = %d; heightceiling = %d; texturefloor = \"-\"; textureceiling = \"-\"; lightlevel = 160; id = %d; }\n", floor, ceiling, tag);
+		Sectors += buf;
+		return NumSectors++;
+	}
+
+	// Lines go clockwise so that the front side faces inward.
+	void AddBox(int x1, int y1, int x2, int y2, int inside, int outside)
+	{
+		int v[4] = { AddVertex(x1, y1), AddVertex(x1, y2), AddVertex(x2, y2), AddVertex(x2, y1) };
+		for (int i = 0; i < 4; i++)
+		{
+			char buf[160];
+			int front = AddSide(inside);
+			if (outside < 0)
+			{
+				snprintf(buf, sizeof(buf), "linedef { v1 = %d; v2 = %d; sidefront = %d; blocking = true; }\n", v[i], v[(i + 1) & 3], front);
+			}
+			else
+			{
+				int back = AddSide(outside);
+				snprintf(buf, sizeof(buf), "linedef { v1 = %d; v2 = %d; sidefront = %d; sideback = %d; twosided = true; }\n", v[i], v[(i + 1) & 3], front, back);
+			}
+			Lines += buf;
+		}
+	}
+
+	void AddThing(int x, int y, int type)
+	{
+		char buf[200];
+		snprintf(buf, sizeof(buf), "thing { x = %d.0; y = %d.0; type = %d; angle = 0; skill1 = true; skill2 = true; skill3 = true; skill4 = true; skill5 = true; single = true; }\n", x, y, type);
+		Things += buf;
+	}
+
+	void AddPlayerStart(int x, int y)
+	{
+		AddThing(x, y, 1);
+	}
+
+	std::string TextMap() const
+	{
+		return "namespace = \"zdoom\";\n" + Things + Vertices + Lines + Sides + Sectors;
+	}
+};
+
+//==========================================================================
+//
+// TEST01: thinker stress map
+//
+// Rows of 16 sectors, 32 units wide and 64 apart, two rows per tag:
+//   tag 1: perpetual platforms
+//   tag 2: crushing ceilings
+//   tag 3: doors, reopened every 175 tics
+//   tag 4: floors raised and lowered every 70 tics
+//   tag 5: lights only
+// All of them glow or strobe and scroll their floor.
+//
+//==========================================================================
+
+static const int COLUMNS = 16;
+static const int TAGS = 5;
+
+static std::string ThinkerTestMap()
+{
+	MapBuilder map;
+	int outer = map.AddSector(0, 256, 0);
+	map.AddBox(-256, -256, COLUMNS * 64 + 256, TAGS * 128 + 256, outer, -1);
+	map.AddPlayerStart(-128, -128);
+
+	static const int floors[TAGS] = { 64, 0, 0, 0, 0 };
+	static const int ceilings[TAGS] = { 256, 128, 0, 256, 256 };
+	for (int tag = 1; tag <= TAGS; tag++)
+	{
+		for (int row = 0; row < 2; row++)
+		{
+			int y = (tag - 1) * 128 + row * 64;
+			for (int col = 0; col < COLUMNS; col++)
+			{
+				int sec = map.AddSector(floors[tag - 1], ceilings[tag - 1], tag);
+				map.AddBox(col * 64, y, col * 64 + 32, y + 32, sec, outer);
+			}
+		}
+	}
+	return map.TextMap();
+}
+
+// Special numbers are from actionspecials.h.
+static const char ThinkerTestScript[] =
+	"class ThinkerTestHandler : EventHandler\n"
+	"{\n"
+	"	override void WorldLoaded(WorldEvent e)\n"
+	"	{\n"
+	"		Level.ExecuteSpecial(60, null, null, false, 1, 8, 35);		// Plat_PerpetualRaise\n"
+	"		Level.ExecuteSpecial(42, null, null, false, 2, 8, 10, 0);	// Ceiling_CrushAndRaise\n"
+	"		for (int tag = 1; tag <= 5; tag++)\n"
+	"		{\n"
+	"			if (tag & 1) Level.ExecuteSpecial(114, null, null, false, tag, 255, 64, 35);	// Light_Glow\n"
+	"			else Level.ExecuteSpecial(116, null, null, false, tag, 255, 64, 5, 10);		// Light_Strobe\n"
+	"			Level.ExecuteSpecial(223, null, null, false, tag, 4 + tag, 2, 0);			// Scroll_Floor\n"
+	"		}\n"
+	"	}\n"
+	"\n"
+	"	override void WorldTick()\n"
+	"	{\n"
+	"		if (Level.maptime % 175 == 0) Level.ExecuteSpecial(12, null, null, false, 3, 16, 20);		// Door_Raise\n"
+	"		if (Level.maptime % 140 == 0) Level.ExecuteSpecial(23, null, null, false, 4, 8, 64);		// Floor_RaiseByValue\n"
+	"		else if (Level.maptime % 140 == 70) Level.ExecuteSpecial(20, null, null, false, 4, 8, 64);	// Floor_LowerByValue\n"
+	"	}\n"
+	"}\n";
+
+static const char ThinkerTestMapInfo[] =
+	"map TEST01 \"Thinker test\"\n"
+	"{\n"
+	"	EventHandlers = \"ThinkerTestHandler\"\n"
+	"}\n";
+
+//==========================================================================
+//
+// TEST02: generated reject map
+//
+// The player's room holds a ring shaped door sector (tag 1) around a room
+// with one looker and has two lookers of its own. Four sealed rooms with a
+// looker each lie outside of it. The door opens after 175 tics.
+//
+//==========================================================================
+
+static const int LOOKER = 20000;
+
+static std::string RejectTestMap()
+{
+	MapBuilder map;
+	int room = map.AddSector(0, 128, 0);
+	map.AddBox(0, 0, 1024, 1024, room, -1);
+	map.AddPlayerStart(128, 128);
+	map.AddThing(896, 128, LOOKER);
+	map.AddThing(128, 896, LOOKER);
+
+	int door = map.AddSector(0, 0, 1);
+	map.AddBox(512, 512, 896, 896, door, room);
+	int inner = map.AddSector(0, 128, 0);
+	map.AddBox(544, 544, 864, 864, inner, door);
+	map.AddThing(704, 704, LOOKER);
+
+	for (int i = 0; i < 4; i++)
+	{
+		int x = 1280 + i * 384;
+		int sealed = map.AddSector(0, 128, 0);
+		map.AddBox(x, 0, x + 256, 256, sealed, -1);
+		map.AddThing(x + 128, 128, LOOKER);
+	}
+	return map.TextMap();
+}
+
+// The lookers have no attacks, so they only walk towards the player once
+// they saw them.
+static const char RejectTestScript[] =
+	"class RejectTestLooker : Actor\n"
+	"{\n"
+	"	Default\n"
+	"	{\n"
+	"		Monster;\n"
+	"		Radius 16;\n"
+	"		Height 56;\n"
+	"		Speed 8;\n"
+	"	}\n"
+	"	States\n"
+	"	{\n"
+	"	Spawn:\n"
+	"		TNT1 A 2 A_Look;\n"
+	"		Loop;\n"
+	"	See:\n"
+	"		TNT1 A 2 A_Chase;\n"
+	"		Loop;\n"
+	"	}\n"
+	"}\n"
+	"\n"
+	"class RejectTestHandler : EventHandler\n"
+	"{\n"
+	"	override void WorldTick()\n"
+	"	{\n"
+	"		if (Level.maptime == 175) Level.ExecuteSpecial(11, null, null, false, 1, 16);	// Door_Open\n"
+	"	}\n"
+	"}\n";
+
+static const char RejectTestMapInfo[] =
+	"DoomEdNums\n"
+	"{\n"
+	"	20000 = RejectTestLooker\n"
+	"}\n"
+	"\n"
+	"map TEST02 \"Reject test\"\n"
+	"{\n"
+	"	EventHandlers = \"RejectTestHandler\"\n"
+	"}\n";
+
+//==========================================================================
+//
+// TEST03: model benchmark map
+//
+// An empty room with the player at its west wall, facing into it, for
+// 'benchmodels BenchIQMModel <count>'.
+//
+//==========================================================================
+
+static std::string ModelTestMap()
+{
+	MapBuilder map;
+	int room = map.AddSector(0, 256, 0);
+	map.AddBox(0, 0, 2048, 2048, room, -1);
+	map.AddPlayerStart(64, 1024);
+	return map.TextMap();
+}
+
+static const char ModelTestMapInfo[] =
+	"map TEST03 \"Model test\"\n"
+	"{\n"
+	"}\n";
+
+//==========================================================================
+//
+// TEST04: nested rooms
+//
+// Eight rooms, each one inside the one before, and two sealed rooms next
+// to them, so that the reference of 'rejecttest' has both connected and
+// unconnected pairs.
+//
+//==========================================================================
+
+static const int NESTED_ROOMS = 8;
+
+static std::string NestedRoomsMap()
+{
+	MapBuilder map;
+	int outside = -1;
+	for (int i = 0; i < NESTED_ROOMS; i++)
+	{
+		int room = map.AddSector(0, 128, 0);
+		map.AddBox(i * 64, i * 64, 1024 - i * 64, 1024 - i * 64, room, outside);
+		outside = room;
+	}
+	map.AddPlayerStart(32, 32);
+
+	for (int i = 0; i < 2; i++)
+	{
+		int sealed = map.AddSector(0, 128, 0);
+		map.AddBox(1280 + i * 384, 0, 1536 + i * 384, 256, sealed, -1);
+	}
+	return map.TextMap();
+}
+
+static const char NestedRoomsMapInfo[] =
+	"map TEST04 \"Nested rooms\"\n"
+	"{\n"
+	"}\n";
+
+//==========================================================================
+//
+// BenchIQMModel
+//
+// A square column, 16 units wide and 64 high, with one joint at its base
+// and one halfway up. The upper half bends back and forth over 16 frames.
+// The lower vertices belong to the first joint, the middle ones to both and
+// the upper ones to the second, so every vertex shader path for skinning
+// gets used.
+//
+//==========================================================================
+
+static const int MODEL_FRAMES = 16;
+static const float MODEL_BEND = 0.3826834f;	// sin(22.5°), half of the largest bend angle
+
+struct IQMVertex
+{
+	float Pos[3];
+	float UV[2];
+	float Normal[3];
+	uint8_t Index[4];
+	uint8_t Weight[4];
+};
+
+static void Put16(std::string &out, uint32_t value)
+{
+	for (int i = 0; i < 2; i++) out += char(value >> (i * 8));
+}
+
+static void Put32(std::string &out, uint32_t value)
+{
+	for (int i = 0; i < 4; i++) out += char(value >> (i * 8));
+}
+
+static void PutFloat(std::string &out, float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, 4);
+	Put32(out, bits);
+}
+
+static std::string BenchModelIQM()
+{
+	std::vector<IQMVertex> verts;
+	std::vector<uint32_t> tris;
+
+	// The sides, counterclockwise seen from above, each with three rows of vertices.
+	static const float corners[5][2] = { { -8, -8 }, { 8, -8 }, { 8, 8 }, { -8, 8 }, { -8, -8 } };
+	for (int side = 0; side < 4; side++)
+	{
+		float dx = corners[side + 1][0] - corners[side][0];
+		float dy = corners[side + 1][1] - corners[side][1];
+		uint32_t base = (uint32_t)verts.size();
+		for (int row = 0; row < 3; row++)
+		{
+			for (int k = 0; k < 2; k++)
+			{
+				IQMVertex v = {};
+				v.Pos[0] = corners[side + k][0];
+				v.Pos[1] = corners[side + k][1];
+				v.Pos[2] = row * 32.f;
+				v.UV[0] = (side + k) / 4.f;
+				v.UV[1] = 1 - row / 2.f;
+				v.Normal[0] = dy / 16;
+				v.Normal[1] = -dx / 16;
+				v.Index[0] = row == 2;
+				v.Index[1] = 1;
+				v.Weight[0] = row == 1 ? 128 : 255;
+				v.Weight[1] = row == 1 ? 127 : 0;
+				verts.push_back(v);
+			}
+		}
+		for (uint32_t row = 0; row < 2; row++)
+		{
+			uint32_t a = base + row * 2;
+			tris.insert(tris.end(), { a, a + 1, a + 3, a, a + 3, a + 2 });
+		}
+	}
+
+	uint32_t top = (uint32_t)verts.size();
+	for (int k = 0; k < 4; k++)
+	{
+		IQMVertex v = {};
+		v.Pos[0] = corners[k][0];
+		v.Pos[1] = corners[k][1];
+		v.Pos[2] = 64;
+		v.UV[0] = (corners[k][0] + 8) / 16;
+		v.UV[1] = (corners[k][1] + 8) / 16;
+		v.Normal[2] = 1;
+		v.Index[0] = 1;
+		v.Weight[0] = 255;
+		verts.push_back(v);
+	}
+	tris.insert(tris.end(), { top, top + 1, top + 2, top, top + 2, top + 3 });
+
+	static const char text[] = "\0column\0root\0upper\0bend";
+	const uint32_t nameColumn = 1, nameRoot = 8, nameUpper = 13, nameAnim = 19;
+	std::string textdata(text, sizeof(text));
+	while (textdata.size() & 3) textdata += '\0';
+
+	const uint32_t numVerts = (uint32_t)verts.size();
+	const uint32_t numTris = (uint32_t)tris.size() / 3;
+	const uint32_t headerSize = 124;
+	const uint32_t ofsText = headerSize;
+	const uint32_t ofsMeshes = ofsText + (uint32_t)textdata.size();
+	const uint32_t ofsArrays = ofsMeshes + 24;
+	const uint32_t ofsPositions = ofsArrays + 5 * 20;
+	const uint32_t ofsUVs = ofsPositions + numVerts * 12;
+	const uint32_t ofsNormals = ofsUVs + numVerts * 8;
+	const uint32_t ofsIndices = ofsNormals + numVerts * 12;
+	const uint32_t ofsWeights = ofsIndices + numVerts * 4;
+	const uint32_t ofsTris = ofsWeights + numVerts * 4;
+	const uint32_t ofsJoints = ofsTris + numTris * 12;
+	const uint32_t ofsPoses = ofsJoints + 2 * 48;
+	const uint32_t ofsAnims = ofsPoses + 2 * 88;
+	const uint32_t ofsFrames = ofsAnims + 20;
+	const uint32_t fileSize = ofsFrames + MODEL_FRAMES * 2 * 2;
+
+	std::string out = std::string("INTERQUAKEMODEL", 16);
+	const uint32_t header[] =
+	{
+		2, fileSize, 0,
+		(uint32_t)textdata.size(), ofsText,
+		1, ofsMeshes,
+		5, numVerts, ofsArrays,
+		numTris, ofsTris, 0,
+		2, ofsJoints,
+		2, ofsPoses,
+		1, ofsAnims,
+		MODEL_FRAMES, 2, ofsFrames, 0,
+		0, 0,
+		0, 0,
+	};
+	for (uint32_t value : header) Put32(out, value);
+	out += textdata;
+
+	for (uint32_t value : { nameColumn, 0u, 0u, numVerts, 0u, numTris }) Put32(out, value);
+
+	// Type, flags, format (1 = unsigned byte, 7 = float), size, offset
+	const uint32_t arrays[5][5] =
+	{
+		{ 0, 0, 7, 3, ofsPositions },
+		{ 1, 0, 7, 2, ofsUVs },
+		{ 2, 0, 7, 3, ofsNormals },
+		{ 4, 0, 1, 4, ofsIndices },
+		{ 5, 0, 1, 4, ofsWeights },
+	};
+	for (auto &array : arrays) for (uint32_t value : array) Put32(out, value);
+
+	for (auto &v : verts) for (float f : v.Pos) PutFloat(out, f);
+	for (auto &v : verts) for (float f : v.UV) PutFloat(out, f);
+	for (auto &v : verts) for (float f : v.Normal) PutFloat(out, f);
+	for (auto &v : verts) out.append((const char *)v.Index, 4);
+	for (auto &v : verts) out.append((const char *)v.Weight, 4);
+	for (uint32_t index : tris) Put32(out, index);
+
+	// Joints: name, parent, translation, rotation, scale
+	const float base[2][10] =
+	{
+		{ 0, 0, 0, 0, 0, 0, 1, 1, 1, 1 },
+		{ 0, 0, 32, 0, 0, 0, 1, 1, 1, 1 },
+	};
+	Put32(out, nameRoot);
+	Put32(out, uint32_t(-1));
+	for (float f : base[0]) PutFloat(out, f);
+	Put32(out, nameUpper);
+	Put32(out, 0);
+	for (float f : base[1]) PutFloat(out, f);
+
+	// Poses: only the rotation around x and w of the upper joint are animated.
+	const float minW = sqrtf(1 - MODEL_BEND * MODEL_BEND);
+	Put32(out, uint32_t(-1));
+	Put32(out, 0);
+	for (float f : base[0]) PutFloat(out, f);
+	for (int i = 0; i < 10; i++) PutFloat(out, 0);
+
+	float offsets[10], scales[10] = {};
+	memcpy(offsets, base[1], sizeof(offsets));
+	offsets[3] = -MODEL_BEND;
+	offsets[6] = minW;
+	scales[3] = 2 * MODEL_BEND / 65535;
+	scales[6] = (1 - minW) / 65535;
+	Put32(out, 0);
+	Put32(out, (1 << 3) | (1 << 6));
+	for (float f : offsets) PutFloat(out, f);
+	for (float f : scales) PutFloat(out, f);
+
+	// One looping animation, name, first frame, frame count, frame rate, flags
+	Put32(out, nameAnim);
+	Put32(out, 0);
+	Put32(out, MODEL_FRAMES);
+	PutFloat(out, 17.5f);
+	Put32(out, 1);
+
+	auto quantize = [&](double value, int channel)
+	{
+		double q = (value - offsets[channel]) / scales[channel] + 0.5;
+		return uint32_t(q < 0 ? 0 : q > 65535 ? 65535 : q);
+	};
+	for (int f = 0; f < MODEL_FRAMES; f++)
+	{
+		double half = asin(MODEL_BEND) * sin(f * 6.283185307 / MODEL_FRAMES);
+		Put16(out, quantize(sin(half), 3));
+		Put16(out, quantize(cos(half), 6));
+	}
+	return out;
+}
+
+// The skin is a graphic from gzdoom.pk3. The actors start at a random frame
+// so that they are not all in the same pose.
+static const char ModelTestModelDef[] =
+	"Model BenchIQMModel\n"
+	"{\n"
+	"	Path \"models/bench\"\n"
+	"	Model 0 \"column.iqm\"\n"
+	"	Skin 0 \"ARTIBOX\"\n"
+	"\n"
+	"	FrameIndex BIQM A 0 0\n"
+	"	FrameIndex BIQM B 0 1\n"
+	"	FrameIndex BIQM C 0 2\n"
+	"	FrameIndex BIQM D 0 3\n"
+	"	FrameIndex BIQM E 0 4\n"
+	"	FrameIndex BIQM F 0 5\n"
+	"	FrameIndex BIQM G 0 6\n"
+	"	FrameIndex BIQM H 0 7\n"
+	"	FrameIndex BIQM I 0 8\n"
+	"	FrameIndex BIQM J 0 9\n"
+	"	FrameIndex BIQM K 0 10\n"
+	"	FrameIndex BIQM L 0 11\n"
+	"	FrameIndex BIQM M 0 12\n"
+	"	FrameIndex BIQM N 0 13\n"
+	"	FrameIndex BIQM O 0 14\n"
+	"	FrameIndex BIQM P 0 15\n"
+	"}\n";
+
+static const char ModelTestScript[] =
+	"version \"4.3\"\n"
+	"\n"
+	"class BenchIQMModel : Actor\n"
+	"{\n"
+	"	Default\n"
+	"	{\n"
+	"		Radius 8;\n"
+	"		Height 64;\n"
+	"	}\n"
+	"	States\n"
+	"	{\n"
+	"	Spawn:\n"
+	"		BIQM ABCDEFGHIJKLMNOP 2;\n"
+	"		Loop;\n"
+	"	}\n"
+	"	override void PostBeginPlay()\n"
+	"	{\n"
+	"		Super.PostBeginPlay();\n"
+	"		SetState(SpawnState + random(0, 15));\n"
+	"	}\n"
+	"}\n";
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static bool WriteWad(const char *filename, const std::vector<Lump> &lumps)
+{
+	FILE *f = fopen(filename, "wb");
+	if (f == nullptr)
+	{
+		return false;
+	}
+
+	uint32_t pos = 12;
+	std::vector<uint8_t> dir;
+	for (auto &lump : lumps)
+	{
+		uint8_t entry[16] = {};
+		uint32_t size = (uint32_t)lump.Data.size();
+		for (int i = 0; i < 4; i++)
+		{
+			entry[i] = uint8_t(pos >> (i * 8));
+			entry[4 + i] = uint8_t(size >> (i * 8));
+		}
+		strncpy((char *)entry + 8, lump.Name.c_str(), 8);
+		dir.insert(dir.end(), entry, entry + 16);
+		pos += size;
+	}
+
+	uint8_t header[12] = { 'P', 'W', 'A', 'D' };
+	uint32_t numlumps = (uint32_t)lumps.size();
+	for (int i = 0; i < 4; i++)
+	{
+		header[4 + i] = uint8_t(numlumps >> (i * 8));
+		header[8 + i] = uint8_t(pos >> (i * 8));
+	}
+
+	bool ok = fwrite(header, 1, 12, f) == 12;
+	for (auto &lump : lumps)
+	{
+		ok = ok && fwrite(lump.Data.data(), 1, lump.Data.size(), f) == lump.Data.size();
+	}
+	ok = ok && fwrite(dir.data(), 1, dir.size(), f) == dir.size();
+	return fclose(f) == 0 && ok;
+}
+
+//==========================================================================
+//
+// Writes an uncompressed zip. Models can only be found by their full
+// path, which WAD lumps do not have.
+//
+//==========================================================================
+
+static uint32_t Crc32(const std::string &data)
+{
+	uint32_t crc = 0xffffffff;
+	for (unsigned char c : data)
+	{
+		crc ^= c;
+		for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+	}
+	return ~crc;
+}
+
+static bool WritePk3(const char *filename, const std::vector<Lump> &files)
+{
+	std::string data, dir;
+	for (auto &file : files)
+	{
+		uint32_t crc = Crc32(file.Data);
+		uint32_t size = (uint32_t)file.Data.size();
+		uint32_t offset = (uint32_t)data.size();
+
+		// Version 1.0, no flags, stored, 1980-01-01 00:00
+		Put32(data, 0x04034b50);
+		Put16(data, 10);
+		Put16(data, 0);
+		Put16(data, 0);
+		Put16(data, 0);
+		Put16(data, 0x21);
+		Put32(data, crc);
+		Put32(data, size);
+		Put32(data, size);
+		Put16(data, (uint32_t)file.Name.size());
+		Put16(data, 0);
+		data += file.Name;
+		data += file.Data;
+
+		Put32(dir, 0x02014b50);
+		Put16(dir, 20);
+		Put16(dir, 10);
+		Put16(dir, 0);
+		Put16(dir, 0);
+		Put16(dir, 0);
+		Put16(dir, 0x21);
+		Put32(dir, crc);
+		Put32(dir, size);
+		Put32(dir, size);
+		Put16(dir, (uint32_t)file.Name.size());
+		for (int i = 0; i < 4; i++) Put16(dir, 0);	// extra, comment, disk, internal attributes
+		Put32(dir, 0);
+		Put32(dir, offset);
+		dir += file.Name;
+	}
+
+	std::string end;
+	Put32(end, 0x06054b50);
+	Put16(end, 0);
+	Put16(end, 0);
+	Put16(end, (uint32_t)files.size());
+	Put16(end, (uint32_t)files.size());
+	Put32(end, (uint32_t)dir.size());
+	Put32(end, (uint32_t)data.size());
+	Put16(end, 0);
+
+	FILE *f = fopen(filename, "wb");
+	if (f == nullptr)
+	{
+		return false;
+	}
+	std::string out = data + dir + end;
+	bool ok = fwrite(out.data(), 1, out.size(), f) == out.size();
+	return fclose(f) == 0 && ok;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc != 3)
+	{
+		fprintf(stderr, "Usage: %s <output.wad> <output.pk3>\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<Lump> lumps =
+	{
+		{ "TEST01", "" },
+		{ "TEXTMAP", ThinkerTestMap() },
+		{ "ENDMAP", "" },
+		{ "TEST02", "" },
+		{ "TEXTMAP", RejectTestMap() },
+		{ "ENDMAP", "" },
+		{ "TEST03", "" },
+		{ "TEXTMAP", ModelTestMap() },
+		{ "ENDMAP", "" },
+		{ "TEST04", "" },
+		{ "TEXTMAP", NestedRoomsMap() },
+		{ "ENDMAP", "" },
+		{ "MAPINFO", std::string(ThinkerTestMapInfo) + "\n" + RejectTestMapInfo + "\n" + ModelTestMapInfo + "\n" + NestedRoomsMapInfo },
+		{ "ZSCRIPT", "version \"4.3\"\n\n" + std::string(ThinkerTestScript) + "\n" + RejectTestScript },
+	};
+
+	std::vector<Lump> files =
+	{
+		{ "models/bench/column.iqm", BenchModelIQM() },
+		{ "modeldef.txt", ModelTestModelDef },
+		{ "zscript.txt", ModelTestScript },
+	};
+
+	if (!WriteWad(argv[1], lumps))
+	{
+		fprintf(stderr, "Could not write %s\n", argv[1]);
+		return 1;
+	}
+	if (!WritePk3(argv[2], files))
+	{
+		fprintf(stderr, "Could not write %s\n", argv[2]);
+		return 1;
+	}
+	return 0;
+}